@@ -0,0 +1,237 @@
+// RS02BusHealth.cpp — コントローラ状態の監視、バスオフ / 停止からの自動回復、回復後のモータ状態再送
+#include "RS02BusHealth.h"
+
+bool RS02BusHealth::begin(const RS02BusHealthConfig &cfg)
+{
+    _cfg = cfg;
+    _polled = false;
+    _outage = false;
+    return _bus.addListener(this);
+}
+
+void RS02BusHealth::end()
+{
+    stopTask();
+    _bus.removeListener(this);
+}
+
+void RS02BusHealth::resetStats()
+{
+    RS02BusGuard g(_bus);
+    _stats = RS02BusHealthStats();
+}
+
+const char *RS02BusHealth::stateName(RS02CanState s)
+{
+    switch (s)
+    {
+    case RS02CanState::Active:
+        return "active";
+    case RS02CanState::Warning:
+        return "warning";
+    case RS02CanState::Passive:
+        return "passive";
+    case RS02CanState::BusOff:
+        return "bus-off";
+    case RS02CanState::Recovering:
+        return "recovering";
+    case RS02CanState::Stopped:
+        return "stopped";
+    default:
+        return "unknown";
+    }
+}
+
+// ===== Frame tap =====
+void RS02BusHealth::onTxFrame(const RS02PrivFrame &f, bool ok)
+{
+    if (!ok)
+        _pollNow = true; // 送信失敗 → 次の service で状態を読む
+    if (_resending)
+    {
+        _resendFailed |= !ok;
+        return;
+    }
+    uint8_t id = rs02FrameDst(f.id);
+    if (id >= 128)
+        return;
+    // 送れなかったフレームもアプリの意図として残す
+    Motor &m = _m[id];
+    switch (rs02FrameType(f.id))
+    {
+    case RS02Type::ENABLE:
+        m.run = 1;
+        break;
+    case RS02Type::STOP:
+        m.run = 2;
+        m.hasSetpoint = false;
+        break;
+    case RS02Type::OP_CONTROL:
+        m.hasSetpoint = true;
+        m.spId = f.id;
+        memcpy(m.spData, f.data, 8);
+        break;
+    case RS02Type::WRITE_PARAM:
+    {
+        if (f.dlc < 8)
+            break;
+        uint16_t idx = (uint16_t)(f.data[0] | (f.data[1] << 8));
+        if (idx == RS02Idx::RUN_MODE)
+        {
+            m.hasMode = true;
+            m.mode = f.data[4];
+            m.hasSetpoint = false;
+        }
+        else if (idx == RS02Idx::SPD_REF || idx == RS02Idx::LOC_REF || idx == RS02Idx::IQ_REF)
+        {
+            m.hasSetpoint = true;
+            m.spId = f.id;
+            memcpy(m.spData, f.data, 8);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// ===== 監視 =====
+void RS02BusHealth::transition(const RS02CanStatus &st, uint32_t now)
+{
+    if (st.tec > _stats.maxTec)
+        _stats.maxTec = st.tec;
+    if (st.rec > _stats.maxRec)
+        _stats.maxRec = st.rec;
+    if (st.state != _st.state)
+    {
+        switch (st.state)
+        {
+        case RS02CanState::Warning:
+            _stats.warnings++;
+            break;
+        case RS02CanState::Passive:
+            _stats.passives++;
+            break;
+        case RS02CanState::BusOff:
+            _stats.busOffs++;
+            break;
+        case RS02CanState::Stopped:
+            _stats.stops++;
+            break;
+        default:
+            break;
+        }
+    }
+    _st = st;
+
+    if (down(st.state) && !_outage)
+    {
+        _outage = true;
+        _outageStartUs = now;
+        _stats.outages++;
+    }
+    else if (!down(st.state) && st.state != RS02CanState::Unknown && _outage)
+    {
+        // 再送が通らなければ（故障が続いていて再びバスオフへ向かう）送信不能のまま
+        if (_cfg.resendState && !resend())
+            return;
+        uint32_t us = micros() - _outageStartUs;
+        _outage = false;
+        _stats.recoveries++;
+        _stats.lastOutageUs = us;
+        _stats.totalOutageUs += us;
+        if (us > _stats.maxOutageUs)
+            _stats.maxOutageUs = us;
+    }
+}
+
+void RS02BusHealth::service()
+{
+    RS02BusGuard g(_bus);
+    uint32_t now = micros();
+    // 送信不能の間は毎回読む（回復までの時間を短く）
+    if (_polled && !_outage && !_pollNow && (now - _lastPollUs) < _cfg.pollMs * 1000UL)
+        return;
+    _polled = true;
+    _pollNow = false;
+    _lastPollUs = now;
+
+    RS02CanStatus st;
+    if (!_bus.canStatus(st))
+    {
+        _st = st;
+        return;
+    }
+    transition(st, now);
+
+    if (!_cfg.autoRecover || !down(st.state) || st.state == RS02CanState::Recovering)
+        return;
+    // 同じ状態のままなら retryMs ごと（MCP2515 の再初期化は即座に戻るので、故障中のバスオフ→再初期化の繰り返しを抑える）
+    // TWAI の BusOff → (recovery) → Stopped → start のように進んだ場合はすぐ次の操作
+    if (_stats.recoverCalls && st.state == _lastRecoverState && (now - _lastRecoverUs) < _cfg.retryMs * 1000UL)
+        return;
+    _stats.recoverCalls++;
+    _lastRecoverUs = now;
+    _lastRecoverState = st.state;
+    if (_bus.recoverBus() && _bus.canStatus(st))
+        transition(st, micros()); // MCP2515 の再初期化はその場で戻る
+}
+
+// 回復後: ランモード → enable / stop → 最後の目標値。1 フレームでも送れなければ false
+bool RS02BusHealth::resend()
+{
+    _resending = true;
+    _resendFailed = false;
+    for (uint8_t id = 0; id < 128; id++)
+    {
+        Motor &m = _m[id];
+        if (m.run == 0)
+            continue;
+        if (m.hasMode)
+        {
+            uint8_t v[4] = {m.mode, 0, 0, 0};
+            _bus.writeParamLE(id, RS02Idx::RUN_MODE, v);
+            _stats.resentFrames++;
+        }
+        if (m.run == 1)
+            _bus.enable(id);
+        else
+            _bus.stop(id, false);
+        _stats.resentFrames++;
+        if (m.run == 1 && m.hasSetpoint)
+        {
+            _bus.sendExt(m.spId, m.spData, 8);
+            _stats.resentFrames++;
+        }
+        if (_resendFailed)
+            break;
+    }
+    _resending = false;
+    return !_resendFailed;
+}
+
+// ===== Task =====
+bool RS02BusHealth::startTask(uint32_t periodMs, int core, UBaseType_t prio)
+{
+    if (_task.running())
+        return true;
+    _periodMs = periodMs ? periodMs : 1;
+    return _task.start(taskEntry, "rs02_health", this, prio, core);
+}
+
+void RS02BusHealth::stopTask()
+{
+    _task.stop();
+}
+
+void RS02BusHealth::taskEntry(void *arg)
+{
+    RS02BusHealth *self = static_cast<RS02BusHealth *>(arg);
+    TickType_t last = xTaskGetTickCount();
+    while (!self->_task.stopRequested())
+    {
+        self->service();
+        vTaskDelayUntil(&last, pdMS_TO_TICKS(self->_periodMs));
+    }
+    self->_task.exit();
+}
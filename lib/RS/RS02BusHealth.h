@@ -0,0 +1,99 @@
+#pragma once
+// RS02BusHealth.h — CAN コントローラの健全性監視（エラーアクティブ / パッシブ / バスオフ）と自動回復
+// service() でコントローラの状態を読み、バスオフ / 停止を見たら回復操作
+// （MCP2515: MCP_CAN::reinit, TWAI: twai_initiate_recovery → twai_start）を行う。
+// 送信できなかった期間（outage）を記録し、回復後は各モータのランモード / enable・stop / 最後の目標値を再送する
+// （再送が通った時点で回復とする。故障が続いていれば送信不能のまま回復操作を繰り返す）。
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "RS02PrivateBase.h"
+#include "RS02Task.h"
+
+struct RS02BusHealthConfig
+{
+    uint32_t pollMs = 10;     // 正常時に状態を読む間隔（MCP2515 は SPI 3 命令）。送信失敗を見たら次の service で読む
+    uint32_t retryMs = 20;    // 回復操作の再試行間隔（故障が続いている間）
+    bool autoRecover = true;
+    bool resendState = true;  // 回復後にモータ状態を再送
+};
+
+struct RS02BusHealthStats
+{
+    uint32_t warnings = 0;     // Warning に入った回数
+    uint32_t passives = 0;     // Passive
+    uint32_t busOffs = 0;      // BusOff
+    uint32_t stops = 0;        // Stopped（設定喪失など）
+    uint32_t recoverCalls = 0; // recoverBus() を呼んだ回数
+    uint32_t outages = 0;      // 送信不能（BusOff / Recovering / Stopped）になった回数
+    uint32_t recoveries = 0;   // そこから戻った回数
+    uint32_t resentFrames = 0;
+    uint32_t lastOutageUs = 0;
+    uint32_t maxOutageUs = 0;
+    uint32_t totalOutageUs = 0;
+    uint16_t maxTec = 0;
+    uint16_t maxRec = 0;
+};
+
+class RS02BusHealth : public RS02FrameListener
+{
+public:
+    explicit RS02BusHealth(RS02PrivateBase &bus) : _bus(bus) {}
+
+    bool begin(const RS02BusHealthConfig &cfg = RS02BusHealthConfig());
+    void end();
+
+    // 監視本体。startTask() 使用時は専用タスクから周期実行（手動呼び出しも可）
+    void service();
+    bool startTask(uint32_t periodMs = 5, int core = 0, UBaseType_t prio = 5);
+    void stopTask();
+
+    const RS02CanStatus &status() const { return _st; }
+    RS02CanState state() const { return _st.state; }
+    bool inOutage() const { return _outage; }
+    uint32_t outageUs() const { return _outage ? micros() - _outageStartUs : 0; } // 現在の送信不能期間
+    const RS02BusHealthStats &stats() const { return _stats; }
+    void resetStats();
+
+    static const char *stateName(RS02CanState s);
+
+    void onTxFrame(const RS02PrivFrame &f, bool ok) override;
+
+private:
+    // 回復後に再送するモータ状態（アプリが最後に送った内容）
+    struct Motor
+    {
+        uint8_t run = 0; // 0=不明, 1=enable, 2=stop
+        bool hasMode = false;
+        bool hasSetpoint = false;
+        uint8_t mode = 0;
+        unsigned long spId = 0;
+        uint8_t spData[8] = {0};
+    };
+
+    RS02PrivateBase &_bus;
+    RS02BusHealthConfig _cfg;
+    RS02BusHealthStats _stats;
+    RS02CanStatus _st;
+    Motor _m[128];
+    bool _polled = false;
+    bool _pollNow = false;
+    bool _outage = false;
+    bool _resending = false;
+    bool _resendFailed = false;
+    uint32_t _lastPollUs = 0;
+    uint32_t _lastRecoverUs = 0;
+    uint32_t _outageStartUs = 0;
+    RS02CanState _lastRecoverState = RS02CanState::Unknown;
+    RS02TaskSlot _task;
+    uint32_t _periodMs = 5;
+
+    static bool down(RS02CanState s)
+    {
+        return s == RS02CanState::BusOff || s == RS02CanState::Recovering || s == RS02CanState::Stopped;
+    }
+    void transition(const RS02CanStatus &st, uint32_t now);
+    bool resend();
+    static void taskEntry(void *arg);
+};
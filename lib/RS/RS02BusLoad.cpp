@@ -0,0 +1,251 @@
+// RS02BusLoad.cpp — バス負荷の集計
+#include "RS02BusLoad.h"
+
+namespace
+{
+    // SOF〜CRC のスタッフ数と CRC15 を1ビットずつ
+    struct BitStuffer
+    {
+        uint16_t crc = 0;
+        uint16_t n = 0;
+        uint16_t stuff = 0;
+        uint8_t last = 2;
+        uint8_t run = 0;
+
+        void put(uint8_t b, bool withCrc)
+        {
+            if (withCrc)
+            {
+                uint16_t nxt = (uint16_t)(b ^ ((crc >> 14) & 1));
+                crc = (uint16_t)((crc << 1) & 0x7FFF);
+                if (nxt)
+                    crc ^= 0x4599;
+            }
+            n++;
+            if (b == last)
+                run++;
+            else
+            {
+                last = b;
+                run = 1;
+            }
+            if (run == 5)
+            {
+                stuff++;
+                last = b ^ 1;
+                run = 1;
+            }
+        }
+        void putBits(uint32_t v, uint8_t width)
+        {
+            for (int i = width - 1; i >= 0; i--)
+                put((uint8_t)((v >> i) & 1), true);
+        }
+    };
+
+    constexpr uint8_t IFS_BITS = 3;
+}
+
+uint16_t RS02BusLoad::frameBits(unsigned long id, bool ext, uint8_t dlc, const uint8_t *data)
+{
+    uint8_t n = dlc > 8 ? 8 : dlc;
+    BitStuffer s;
+    s.putBits(0, 1); // SOF
+    if (ext)
+    {
+        s.putBits((id >> 18) & 0x7FF, 11);
+        s.putBits(1, 1); // SRR
+        s.putBits(1, 1); // IDE
+        s.putBits(id & 0x3FFFF, 18);
+        s.putBits(0, 1); // RTR
+        s.putBits(0, 2); // r1 r0
+    }
+    else
+    {
+        s.putBits(id & 0x7FF, 11);
+        s.putBits(0, 3); // RTR IDE r0
+    }
+    s.putBits(dlc & 0x0F, 4);
+    for (uint8_t i = 0; i < n; i++)
+        s.putBits(data[i], 8);
+    uint16_t crc = s.crc;
+    for (int i = 14; i >= 0; i--)
+        s.put((uint8_t)((crc >> i) & 1), false);
+    // CRC delimiter + ACK slot/delimiter + EOF7
+    return (uint16_t)(s.n + s.stuff + 1 + 2 + 7);
+}
+
+uint16_t RS02BusLoad::frameBitsWorst(bool ext, uint8_t dlc)
+{
+    uint16_t d = (uint16_t)(dlc > 8 ? 8 : dlc) * 8;
+    // スタッフ対象 (ext: 54+8s / std: 34+8s) の最悪 (n-1)/4
+    return ext ? (uint16_t)(d + 64 + (d + 53) / 4) : (uint16_t)(d + 44 + (d + 33) / 4);
+}
+
+void RS02BusLoad::setConfig(const RS02BusLoadConfig &cfg)
+{
+    RS02BusGuard g(_bus);
+    _cfg = cfg;
+    if (_cfg.bucketMs == 0)
+        _cfg.bucketMs = 1;
+    if (_cfg.bitrate == 0)
+        _cfg.bitrate = 1000000;
+    memset(_bBits, 0, sizeof(_bBits));
+    memset(_bFrames, 0, sizeof(_bFrames));
+    _bStarted = false;
+    _maxBucketBits = 0;
+}
+
+void RS02BusLoad::reset()
+{
+    RS02BusGuard g(_bus);
+    for (auto &c : _type)
+        c = RS02LoadCounter();
+    for (auto &c : _motor)
+        c = RS02LoadCounter();
+    _total = RS02LoadCounter();
+    _txFail = 0;
+    _rxLost = 0;
+    memset(_bBits, 0, sizeof(_bBits));
+    memset(_bFrames, 0, sizeof(_bFrames));
+    _bStarted = false;
+    _maxBucketBits = 0;
+}
+
+// ===== 集計 =====
+void RS02BusLoad::advance(uint32_t nowMs)
+{
+    uint32_t cur = nowMs / _cfg.bucketMs;
+    if (!_bStarted)
+    {
+        _bStarted = true;
+        _bIdx = cur;
+        return;
+    }
+    uint32_t gap = cur - _bIdx;
+    if (gap == 0)
+        return;
+    if (gap >= RS02_BUSLOAD_BUCKETS)
+    {
+        memset(_bBits, 0, sizeof(_bBits));
+        memset(_bFrames, 0, sizeof(_bFrames));
+    }
+    else
+    {
+        for (uint32_t i = 1; i <= gap; i++)
+        {
+            uint32_t k = (_bIdx + i) % RS02_BUSLOAD_BUCKETS;
+            _bBits[k] = 0;
+            _bFrames[k] = 0;
+        }
+    }
+    _bIdx = cur;
+}
+
+void RS02BusLoad::account(const RS02PrivFrame &f, bool tx, uint8_t motorId)
+{
+    uint16_t bits = (_cfg.exactStuffing ? frameBits(f.id, f.isExt, f.dlc, f.data) : frameBitsWorst(f.isExt, f.dlc)) + IFS_BITS;
+    uint8_t type = f.isExt ? rs02FrameType(f.id) : 0;
+
+    RS02LoadCounter *cs[3] = {&_total, &_type[type], motorId < 128 ? &_motor[motorId] : nullptr};
+    for (RS02LoadCounter *c : cs)
+    {
+        if (!c)
+            continue;
+        if (tx)
+            c->txFrames++;
+        else
+            c->rxFrames++;
+        c->bits += bits;
+    }
+
+    advance(millis());
+    uint32_t k = _bIdx % RS02_BUSLOAD_BUCKETS;
+    _bBits[k] += bits;
+    if (_bFrames[k] < 0xFFFF)
+        _bFrames[k]++;
+    if (_bBits[k] > _maxBucketBits)
+        _maxBucketBits = _bBits[k];
+}
+
+void RS02BusLoad::onTxFrame(const RS02PrivFrame &f, bool ok)
+{
+    if (!ok)
+    {
+        _txFail++;
+        return;
+    }
+    account(f, true, rs02FrameDst(f.id));
+}
+
+void RS02BusLoad::onRxLost(uint32_t n, uint32_t tUs)
+{
+    (void)tUs;
+    _rxLost += n;
+}
+
+void RS02BusLoad::onRxFrame(const RS02PrivFrame &f)
+{
+    uint8_t type = rs02FrameType(f.id);
+    // モータからの応答（Type0/2/17）は bit8-15 がモータID
+    bool reply = f.isExt && (type == RS02Type::GET_ID || type == RS02Type::FEEDBACK || type == RS02Type::READ_PARAM);
+    uint8_t motorId = !f.isExt ? 0xFF : (reply ? (uint8_t)((f.id >> 8) & 0xFF) : rs02FrameDst(f.id));
+    account(f, false, motorId);
+}
+
+// ===== 読み出し =====
+float RS02BusLoad::pctOf(uint64_t bits, uint32_t ms) const
+{
+    if (ms == 0)
+        return 0.0f;
+    // bits / (bitrate * ms/1000)
+    return (float)((double)bits * 100000.0 / ((double)_cfg.bitrate * (double)ms));
+}
+
+RS02BusLoadSnapshot RS02BusLoad::snapshot()
+{
+    RS02BusGuard g(_bus);
+    advance(millis());
+    RS02BusLoadSnapshot s;
+    uint64_t bits = 0;
+    uint32_t frames = 0;
+    uint32_t peak = 0;
+    for (uint16_t i = 0; i < RS02_BUSLOAD_BUCKETS; i++)
+    {
+        bits += _bBits[i];
+        frames += _bFrames[i];
+        if (_bBits[i] > peak)
+            peak = _bBits[i];
+    }
+    s.windowMs = (uint32_t)_cfg.bucketMs * RS02_BUSLOAD_BUCKETS;
+    s.utilPct = pctOf(bits, s.windowMs);
+    s.peakBucketPct = pctOf(peak, _cfg.bucketMs);
+    s.maxBucketPct = pctOf(_maxBucketBits, _cfg.bucketMs);
+    s.framesPerSec = (float)frames * 1000.0f / (float)s.windowMs;
+    s.txFrames = _total.txFrames;
+    s.rxFrames = _total.rxFrames;
+    s.txFail = _txFail;
+    s.rxLost = _rxLost;
+    s.bits = _total.bits;
+    return s;
+}
+
+RS02LoadCounter RS02BusLoad::byType(uint8_t type)
+{
+    RS02BusGuard g(_bus);
+    return _type[type & 0x1F];
+}
+
+RS02LoadCounter RS02BusLoad::byMotor(uint8_t motorId)
+{
+    RS02BusGuard g(_bus);
+    return _motor[motorId & 0x7F];
+}
+
+float RS02BusLoad::typeSharePct(uint8_t type)
+{
+    RS02BusGuard g(_bus);
+    if (_total.bits == 0)
+        return 0.0f;
+    return (float)((double)_type[type & 0x1F].bits * 100.0 / (double)_total.bits);
+}
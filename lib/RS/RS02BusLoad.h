@@ -0,0 +1,89 @@
+#pragma once
+// RS02BusLoad.h — バス負荷の集計（送受信の全フレームを通信タイプ別・モータ別に）
+// フレーム長はスタッフビット/CRC15 込みで計算（+ IFS 3bit）。1Mbps・拡張ID・8byte で約 130bit ≒ 7.7k フレーム/s。
+// bucketMs ごとのリングで直近 window の利用率と、1 バケット内の最大（バースト）を出す。
+// RS02FrameListener として readAny()/sendExt() の経路で動く（バス排他の内側）。
+
+#include <Arduino.h>
+#include "RS02PrivateBase.h"
+
+#ifndef RS02_BUSLOAD_BUCKETS
+#define RS02_BUSLOAD_BUCKETS 100
+#endif
+
+struct RS02BusLoadConfig
+{
+    uint32_t bitrate = 1000000;
+    uint16_t bucketMs = 10; // バースト検出の粒度。window = bucketMs * RS02_BUSLOAD_BUCKETS
+    bool exactStuffing = true; // false: 最悪値（スタッフ最大）で見積もる（計算が軽い）
+};
+
+struct RS02LoadCounter
+{
+    uint32_t txFrames = 0;
+    uint32_t rxFrames = 0;
+    uint64_t bits = 0; // IFS 込み
+};
+
+struct RS02BusLoadSnapshot
+{
+    float utilPct = 0.0f;       // 直近 window の平均
+    float peakBucketPct = 0.0f; // 直近 window 内で最大のバケット
+    float maxBucketPct = 0.0f;  // リセット以降で最大のバケット
+    float framesPerSec = 0.0f;  // 直近 window
+    uint32_t windowMs = 0;
+    uint32_t txFrames = 0;
+    uint32_t rxFrames = 0;
+    uint32_t txFail = 0; // 送信失敗（ビットには数えない）
+    uint32_t rxLost = 0; // 受信側 HW のあふれ検出回数（失ったフレームの下限。ビットには数えない）
+    uint64_t bits = 0;
+};
+
+class RS02BusLoad : public RS02FrameListener
+{
+public:
+    explicit RS02BusLoad(RS02PrivateBase &bus) : _bus(bus) {}
+
+    bool begin() { return _bus.addListener(this); }
+    void end() { _bus.removeListener(this); }
+
+    void setConfig(const RS02BusLoadConfig &cfg);
+    const RS02BusLoadConfig &config() const { return _cfg; }
+    void reset();
+
+    // 集計の読み出し（バス排他を取ってコピー）
+    RS02BusLoadSnapshot snapshot();
+    RS02LoadCounter byType(uint8_t type);
+    RS02LoadCounter byMotor(uint8_t motorId);
+    // 通信タイプ別の利用率 [%]（リセット以降の平均）
+    float typeSharePct(uint8_t type);
+
+    // SOF〜EOF のビット数（スタッフビット込み, IFS を含まない）
+    static uint16_t frameBits(unsigned long id, bool ext, uint8_t dlc, const uint8_t *data);
+    // スタッフ最大での見積もり
+    static uint16_t frameBitsWorst(bool ext, uint8_t dlc);
+
+    void onRxFrame(const RS02PrivFrame &f) override;
+    void onTxFrame(const RS02PrivFrame &f, bool ok) override;
+    void onRxLost(uint32_t n, uint32_t tUs) override;
+
+private:
+    RS02PrivateBase &_bus;
+    RS02BusLoadConfig _cfg;
+    RS02LoadCounter _type[32];
+    RS02LoadCounter _motor[128];
+    RS02LoadCounter _total;
+    uint32_t _txFail = 0;
+    uint32_t _rxLost = 0;
+
+    // バケット: ビット数とフレーム数
+    uint32_t _bBits[RS02_BUSLOAD_BUCKETS] = {};
+    uint16_t _bFrames[RS02_BUSLOAD_BUCKETS] = {};
+    uint32_t _bIdx = 0; // 現在バケットの通し番号（ms / bucketMs）
+    bool _bStarted = false;
+    uint32_t _maxBucketBits = 0;
+
+    void account(const RS02PrivFrame &f, bool tx, uint8_t motorId);
+    void advance(uint32_t nowMs);
+    float pctOf(uint64_t bits, uint32_t ms) const;
+};
@@ -0,0 +1,215 @@
+// RS02CanLog.cpp — candump 形式の記録
+#include "RS02CanLog.h"
+
+namespace
+{
+    int hexVal(char c)
+    {
+        if (c >= '0' && c <= '9')
+            return c - '0';
+        if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        return -1;
+    }
+}
+
+// ===== 整形/解析 =====
+size_t RS02CanLog::formatLine(const RS02CanLogEntry &e, const char *iface, bool markDir, char *buf, size_t n)
+{
+    static const char HEX_CHARS[] = "0123456789ABCDEF";
+    int k;
+    if (e.f.isExt)
+        k = snprintf(buf, n, "(%lu.%06lu) %s %08lX#", (unsigned long)(e.tsUs / 1000000ULL),
+                     (unsigned long)(e.tsUs % 1000000ULL), iface, (unsigned long)(e.f.id & 0x1FFFFFFF));
+    else
+        k = snprintf(buf, n, "(%lu.%06lu) %s %03lX#", (unsigned long)(e.tsUs / 1000000ULL),
+                     (unsigned long)(e.tsUs % 1000000ULL), iface, (unsigned long)(e.f.id & 0x7FF));
+    if (k < 0)
+        return 0;
+    size_t len = (size_t)k;
+    uint8_t dlc = e.f.dlc > 8 ? 8 : e.f.dlc;
+    if (len + dlc * 2 + (markDir ? 2 : 0) + 1 > n)
+        return 0;
+    for (uint8_t i = 0; i < dlc; i++)
+    {
+        buf[len++] = HEX_CHARS[e.f.data[i] >> 4];
+        buf[len++] = HEX_CHARS[e.f.data[i] & 0x0F];
+    }
+    if (markDir)
+    {
+        buf[len++] = ' ';
+        buf[len++] = e.tx ? 'T' : 'R';
+    }
+    buf[len] = 0;
+    return len;
+}
+
+bool RS02CanLog::parseLine(const char *line, RS02CanLogEntry &out)
+{
+    const char *p = line;
+    while (*p == ' ' || *p == '\t')
+        p++;
+    if (*p != '(')
+        return false;
+    p++;
+
+    // (sec.usec)
+    uint64_t sec = 0, usec = 0;
+    uint8_t usecDigits = 0;
+    if (*p < '0' || *p > '9')
+        return false;
+    while (*p >= '0' && *p <= '9')
+        sec = sec * 10 + (uint64_t)(*p++ - '0');
+    if (*p == '.')
+    {
+        p++;
+        while (*p >= '0' && *p <= '9')
+        {
+            if (usecDigits < 6)
+            {
+                usec = usec * 10 + (uint64_t)(*p - '0');
+                usecDigits++;
+            }
+            p++;
+        }
+        for (; usecDigits < 6; usecDigits++)
+            usec *= 10;
+    }
+    if (*p++ != ')')
+        return false;
+
+    // iface
+    while (*p == ' ')
+        p++;
+    while (*p && *p != ' ')
+        p++;
+    while (*p == ' ')
+        p++;
+
+    // ID#DATA
+    const char *idStart = p;
+    uint32_t id = 0;
+    while (hexVal(*p) >= 0)
+        id = (id << 4) | (uint32_t)hexVal(*p++);
+    size_t idLen = (size_t)(p - idStart);
+    if (*p++ != '#' || (idLen != 3 && idLen != 8))
+        return false;
+    if (*p == '#' || *p == 'R' || *p == 'r')
+        return false; // CAN FD / RTR
+
+    RS02CanLogEntry e;
+    e.tsUs = sec * 1000000ULL + usec;
+    e.f.isExt = (idLen == 8);
+    e.f.id = e.f.isExt ? (id & 0x1FFFFFFF) : (id & 0x7FF);
+    while (hexVal(p[0]) >= 0 && hexVal(p[1]) >= 0)
+    {
+        if (e.f.dlc >= 8)
+            return false;
+        e.f.data[e.f.dlc++] = (uint8_t)((hexVal(p[0]) << 4) | hexVal(p[1]));
+        p += 2;
+    }
+    while (*p == ' ')
+        p++;
+    e.tx = (*p == 'T');
+    out = e;
+    return true;
+}
+
+// ===== 記録 =====
+RS02CanLogRecorder::RS02CanLogRecorder(RS02PrivateBase &bus, const char *iface) : _bus(bus)
+{
+    strncpy(_iface, iface ? iface : "can0", sizeof(_iface) - 1);
+    _iface[sizeof(_iface) - 1] = 0;
+}
+
+uint64_t RS02CanLogRecorder::extend(uint32_t tsUs)
+{
+    if (!_tsStarted)
+    {
+        _tsStarted = true;
+        _lastTs = tsUs;
+        _extTs = tsUs;
+        return _extTs;
+    }
+    // 別タスクの送信で少し前後することがあるので符号付き差分で
+    int32_t d = (int32_t)(tsUs - _lastTs);
+    if (d < 0)
+        return _extTs + d;
+    _lastTs = tsUs;
+    _extTs += (uint32_t)d;
+    return _extTs;
+}
+
+void RS02CanLogRecorder::push(const RS02PrivFrame &f, bool tx)
+{
+    if (_paused)
+        return;
+    uint64_t ts = extend(f.tsUs) + _epochUs;
+    if (_count >= RS02_CANLOG_DEPTH)
+    {
+        _stats.dropped++;
+        return;
+    }
+    RS02CanLogEntry &e = _ring[_head];
+    e.f = f;
+    e.tsUs = ts;
+    e.tx = tx;
+    _head = (uint16_t)((_head + 1) % RS02_CANLOG_DEPTH);
+    _count++;
+    _stats.recorded++;
+}
+
+void RS02CanLogRecorder::onRxFrame(const RS02PrivFrame &f) { push(f, false); }
+
+void RS02CanLogRecorder::onTxFrame(const RS02PrivFrame &f, bool ok)
+{
+    if (!ok)
+    {
+        _stats.txFailed++;
+        return;
+    }
+    push(f, true);
+}
+
+// ===== 出力 =====
+size_t RS02CanLogRecorder::flush(Print &out, size_t maxLines)
+{
+    char line[64];
+    size_t n = 0;
+    while (maxLines == 0 || n < maxLines)
+    {
+        RS02CanLogEntry e;
+        {
+            RS02BusGuard g(_bus);
+            if (_count == 0)
+                break;
+            uint16_t tail = (uint16_t)((_head + RS02_CANLOG_DEPTH - _count) % RS02_CANLOG_DEPTH);
+            e = _ring[tail];
+            _count--;
+        }
+        // 整形と書き込みはバス排他の外で（SD 書き込みで送受信を止めない）
+        size_t len = RS02CanLog::formatLine(e, _iface, _markDir, line, sizeof(line) - 1);
+        if (len == 0)
+            continue;
+        line[len++] = '\n'; // candump と同じ LF 改行
+        out.write((const uint8_t *)line, len);
+        _stats.written++;
+        n++;
+    }
+    return n;
+}
+
+size_t RS02CanLogRecorder::pending()
+{
+    RS02BusGuard g(_bus);
+    return _count;
+}
+
+void RS02CanLogRecorder::clear()
+{
+    RS02BusGuard g(_bus);
+    _count = 0;
+    _head = 0;
+}
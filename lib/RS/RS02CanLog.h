@@ -0,0 +1,85 @@
+#pragma once
+// RS02CanLog.h — 送受信フレームの記録（candump -l / canplayer 互換のログ形式）
+//   (1697012345.123456) can0 0200FD01#0102030405060708 T
+// 末尾の T/R は送信/受信（canplayer は末尾を無視する。無い行は受信扱い）
+//
+// ・RS02CanLogRecorder: RS02FrameListener。バス排他の内側ではリングへ積むだけで、
+//   整形と出力は flush(Print&) で（loop から SD の File / Serial へ）
+// ・時刻は micros() を 64bit へ延長し、setEpochUs() の基準を足したもの（既定は起動からの秒）
+// 再生は RS02PrivateReplay（RS02PrivateReplay.h）
+
+#include <Arduino.h>
+#include "RS02PrivateBase.h"
+
+#ifndef RS02_CANLOG_DEPTH
+#define RS02_CANLOG_DEPTH 256
+#endif
+
+struct RS02CanLogEntry
+{
+    RS02PrivFrame f;
+    uint64_t tsUs = 0;
+    bool tx = false;
+};
+
+struct RS02CanLogStats
+{
+    uint32_t recorded = 0;
+    uint32_t written = 0;
+    uint32_t dropped = 0;  // リング満杯で捨てた数
+    uint32_t txFailed = 0; // 送信失敗（バスに出ていないので記録しない）
+};
+
+namespace RS02CanLog
+{
+    // 1 行を整形（改行なし）。書いた文字数、足りなければ 0
+    size_t formatLine(const RS02CanLogEntry &e, const char *iface, bool markDir, char *buf, size_t n);
+    // 1 行を解析。コメント/空行/RTR/CAN FD は false
+    bool parseLine(const char *line, RS02CanLogEntry &out);
+}
+
+class RS02CanLogRecorder : public RS02FrameListener
+{
+public:
+    explicit RS02CanLogRecorder(RS02PrivateBase &bus, const char *iface = "can0");
+
+    bool begin() { return _bus.addListener(this); }
+    void end() { _bus.removeListener(this); }
+
+    // ログ時刻の基準（UNIX 時刻 [us] など）。micros()=0 の時刻に相当
+    void setEpochUs(uint64_t epochUs) { _epochUs = epochUs; }
+    // 末尾の T/R を付けるか（既定 true）
+    void setMarkDirection(bool on) { _markDir = on; }
+    void setPaused(bool on) { _paused = on; }
+
+    // リングの中身を 1 行ずつ出力（最大 maxLines 行, 0=全部）。書いた行数
+    size_t flush(Print &out, size_t maxLines = 0);
+    size_t pending();
+    void clear();
+
+    const RS02CanLogStats &stats() const { return _stats; }
+
+    void onRxFrame(const RS02PrivFrame &f) override;
+    void onTxFrame(const RS02PrivFrame &f, bool ok) override;
+
+private:
+    RS02PrivateBase &_bus;
+    char _iface[16];
+    uint64_t _epochUs = 0;
+    bool _markDir = true;
+    bool _paused = false;
+
+    RS02CanLogEntry _ring[RS02_CANLOG_DEPTH];
+    uint16_t _head = 0; // 次に書く位置
+    uint16_t _count = 0;
+
+    // micros() の 64bit 延長
+    bool _tsStarted = false;
+    uint32_t _lastTs = 0;
+    uint64_t _extTs = 0;
+
+    RS02CanLogStats _stats;
+
+    void push(const RS02PrivFrame &f, bool tx);
+    uint64_t extend(uint32_t tsUs);
+};
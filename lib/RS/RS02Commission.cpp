@@ -0,0 +1,411 @@
+// RS02Commission.cpp — 対応表の解決（探索 + 衝突）、wave ごとの Type7 と応答確認、まとめての Type22
+#include "RS02Commission.h"
+
+bool RS02Commission::add(const RS02CommissionItem &it)
+{
+    if (_n >= RS02_COMMISSION_MAX || it.toId > 127)
+        return false;
+    _it[_n++] = it;
+    return true;
+}
+
+bool RS02Commission::addUid(uint64_t uid, uint8_t toId)
+{
+    RS02CommissionItem it;
+    it.uid = uid;
+    it.byUid = true;
+    it.toId = toId;
+    return add(it);
+}
+
+bool RS02Commission::addId(uint8_t fromId, uint8_t toId)
+{
+    if (fromId > 127)
+        return false;
+    RS02CommissionItem it;
+    it.fromId = fromId;
+    it.toId = toId;
+    return add(it);
+}
+
+uint8_t RS02Commission::run(const RS02CommissionConfig &cfg)
+{
+    RS02BusGuard g(_bus);
+    _cfg = cfg;
+    _cfg.scan.readInfo = false;
+    _stats = RS02CommissionStats();
+    for (uint8_t i = 0; i < _n; i++)
+    {
+        RS02CommissionItem &it = _it[i];
+        it.result = RS02CommissionResult::Pending;
+        it.oldId = it.viaId = 0xFF;
+        it.attempts = 0;
+        it.saved = false;
+        it.verifyUs = 0;
+        _wait[i] = _saveWait[i] = false;
+    }
+    uint32_t t0 = micros();
+    _scan.scan(_cfg.scan);
+    _stats.scanUs = micros() - t0;
+    _occ = _scan.found();
+    resolve();
+
+    if (!_bus.addListener(this))
+    {
+        for (uint8_t i = 0; i < _n; i++)
+            if (pending(i))
+                _it[i].result = RS02CommissionResult::SendFailed;
+    }
+    else
+    {
+        {
+            RS02AsyncSend async(_bus); // 送信完了を待たない（探索と同じ）
+            uint32_t t1 = micros();
+            apply();
+            _stats.applyUs = micros() - t1;
+            t1 = micros();
+            if (_cfg.save)
+                save();
+            _stats.saveUs = micros() - t1;
+        }
+        _bus.removeListener(this);
+    }
+
+    for (uint8_t i = 0; i < _n; i++)
+    {
+        if (_it[i].result == RS02CommissionResult::Ok)
+            _stats.ok++;
+        else if (_it[i].result != RS02CommissionResult::Unchanged)
+            _stats.failed++;
+    }
+    _stats.totalUs = micros() - t0;
+    return _stats.ok;
+}
+
+// 対応表の行を探索結果に結び付け、変えられない行を落とす
+void RS02Commission::resolve()
+{
+    using R = RS02CommissionResult;
+    for (uint8_t i = 0; i < _n; i++)
+    {
+        RS02CommissionItem &it = _it[i];
+        const RS02ScanEntry *e = it.byUid ? _scan.findUid(it.uid) : _scan.find(it.fromId);
+        if (!e)
+        {
+            it.result = R::NotFound;
+            continue;
+        }
+        it.oldId = e->id;
+        if (e->conflict)
+        {
+            it.result = R::SourceConflict;
+            continue;
+        }
+        it.uid = e->uid;
+        if (it.toId == it.oldId)
+            it.result = R::Unchanged;
+    }
+    // 同じモータ / 同じ新 ID が 2 行
+    for (uint8_t i = 0; i < _n; i++)
+        for (uint8_t j = i + 1; j < _n; j++)
+        {
+            RS02CommissionItem &a = _it[i], &b = _it[j];
+            bool va = pending(i) || a.result == R::Unchanged || a.result == R::Duplicate || a.result == R::TargetConflict;
+            bool vb = pending(j) || b.result == R::Unchanged || b.result == R::Duplicate || b.result == R::TargetConflict;
+            if (!va || !vb)
+                continue;
+            if (a.oldId == b.oldId)
+                a.result = b.result = R::Duplicate;
+            else if (a.toId == b.toId && a.result != R::Duplicate && b.result != R::Duplicate)
+                a.result = b.result = R::TargetConflict;
+        }
+    // 新 ID に動かないモータがいる（そのモータの行が落ちれば、その ID を待つ行も落ちる）
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (uint8_t i = 0; i < _n; i++)
+        {
+            if (!pending(i) || !_occ.has(_it[i].toId))
+                continue;
+            bool moves = false;
+            for (uint8_t j = 0; j < _n && !moves; j++)
+                moves = j != i && pending(j) && _it[j].oldId == _it[i].toId;
+            if (!moves)
+            {
+                _it[i].result = R::TargetBusy;
+                changed = true;
+            }
+        }
+    }
+}
+
+// 入れ替えの経由先: 誰もいなくて、どの行の新 ID でもない ID（上から）
+uint8_t RS02Commission::tempId() const
+{
+    for (uint8_t id = 127; id >= 1; id--)
+    {
+        if (_occ.has(id))
+            continue;
+        bool target = false;
+        for (uint8_t i = 0; i < _n && !target; i++)
+            target = pending(i) && _it[i].toId == id;
+        if (!target)
+            return id;
+    }
+    return 0xFF;
+}
+
+void RS02Commission::apply()
+{
+    for (uint8_t i = 0; i < _n; i++)
+    {
+        _cur[i] = _it[i].oldId;
+        _step[i] = 0xFF;
+    }
+    for (uint8_t guard = 0; guard < 2 * RS02_COMMISSION_MAX + 2; guard++)
+    {
+        bool any = false, wave = false;
+        for (uint8_t i = 0; i < _n; i++)
+        {
+            _wait[i] = false;
+            if (!pending(i))
+                continue;
+            any = true;
+            if (!_occ.has(_it[i].toId))
+            {
+                _step[i] = _it[i].toId;
+                _wait[i] = wave = true;
+            }
+        }
+        if (!any)
+            return;
+        if (!wave)
+        {
+            // 空く行が無い = 入れ替えの輪。まだ経由していない行を 1 つ空いている ID へ
+            uint8_t pick = 0xFF, tmp = tempId();
+            for (uint8_t i = 0; i < _n && pick == 0xFF; i++)
+                if (pending(i) && _it[i].viaId == 0xFF)
+                    pick = i;
+            if (pick == 0xFF || tmp == 0xFF)
+            {
+                for (uint8_t i = 0; i < _n; i++)
+                    if (pending(i))
+                        _it[i].result = RS02CommissionResult::TargetBusy; // 経由先に残る（viaId）
+                return;
+            }
+            _step[pick] = tmp;
+            _it[pick].viaId = tmp;
+            _wait[pick] = true;
+            _stats.cycles++;
+        }
+        applyWave();
+    }
+}
+
+// _wait の行へ Type7 を続けて送り、新 ID からの Type0 を待つ（来なければ問い合わせ + 送り直し）
+void RS02Commission::applyWave()
+{
+    _stats.waves++;
+    bool sent[RS02_COMMISSION_MAX] = {};
+    for (uint8_t i = 0; i < _n; i++)
+    {
+        if (!_wait[i])
+            continue;
+        _wait[i] = false;
+        waitSlot(_wait, _cfg.verifyTimeoutUs);
+        _sentUs[i] = micros();
+        _it[i].attempts++;
+        _stats.type7++;
+        sent[i] = _wait[i] = _bus.waitTxIdle() && _bus.setMotorId(_cur[i], _step[i]);
+    }
+    for (uint8_t r = 0;; r++)
+    {
+        listen(_wait, _cfg.verifyTimeoutUs);
+        bool retry[RS02_COMMISSION_MAX] = {}, left = false;
+        for (uint8_t i = 0; i < _n; i++)
+            left |= retry[i] = _wait[i];
+        if (!left || r >= _cfg.retries)
+            break;
+        for (uint8_t i = 0; i < _n; i++)
+        {
+            if (!retry[i] || !_wait[i])
+                continue;
+            // 動いたのに応答を取りこぼした場合は Type0 で、まだなら Type7 で
+            _wait[i] = false;
+            waitSlot(_wait, _cfg.verifyTimeoutUs);
+            _wait[i] = true;
+            _stats.pings++;
+            if (_bus.waitTxIdle())
+                _bus.ping(_step[i]);
+            _sentUs[i] = micros();
+            _it[i].attempts++;
+            _stats.type7++;
+            if (_bus.waitTxIdle())
+                _bus.setMotorId(_cur[i], _step[i]);
+        }
+    }
+    for (uint8_t i = 0; i < _n; i++)
+    {
+        if (!pending(i) || _step[i] == 0xFF)
+            continue;
+        if (!sent[i])
+            _it[i].result = RS02CommissionResult::SendFailed;
+        else if (_wait[i])
+        {
+            // どこにいるか分からないので両方ふさいでおく
+            _it[i].result = RS02CommissionResult::NoReply;
+            _occ.add(_step[i]);
+            _wait[i] = false;
+        }
+        else
+        {
+            _occ.remove(_cur[i]);
+            _occ.add(_step[i]);
+            _cur[i] = _step[i];
+            if (_cur[i] == _it[i].toId)
+                _it[i].result = RS02CommissionResult::Ok;
+        }
+        _step[i] = 0xFF;
+    }
+}
+
+void RS02Commission::save()
+{
+    for (uint8_t r = 0; r <= _cfg.retries; r++)
+    {
+        bool any = false;
+        for (uint8_t i = 0; i < _n; i++)
+        {
+            if (_it[i].result != RS02CommissionResult::Ok || _it[i].saved)
+                continue;
+            waitSlot(_saveWait, _cfg.saveTimeoutUs);
+            _sentUs[i] = micros();
+            _stats.saves++;
+            _saveWait[i] = _bus.waitTxIdle() && _bus.saveParams(_cur[i]);
+            any |= _saveWait[i];
+        }
+        if (!any)
+            return;
+        listen(_saveWait, _cfg.saveTimeoutUs);
+        for (uint8_t i = 0; i < _n; i++)
+            _saveWait[i] = false;
+    }
+}
+
+// 応答待ち（期限内のもの）が maxInFlight 未満になるまで受信する
+void RS02Commission::waitSlot(const bool *flags, uint32_t timeoutUs)
+{
+    for (;;)
+    {
+        uint32_t now = micros();
+        uint8_t n = 0;
+        for (uint8_t i = 0; i < _n; i++)
+            n += flags[i] && (uint32_t)(now - _sentUs[i]) < timeoutUs;
+        if (n < _cfg.maxInFlight)
+            return;
+        RS02PrivFrame f;
+        if (!_bus.readAny(f))
+            delayMicroseconds(20);
+    }
+}
+
+void RS02Commission::listen(bool *flags, uint32_t timeoutUs)
+{
+    uint32_t t0 = micros();
+    while ((uint32_t)(micros() - t0) < timeoutUs)
+    {
+        bool any = false;
+        for (uint8_t i = 0; i < _n && !any; i++)
+            any = flags[i];
+        if (!any)
+            return;
+        RS02PrivFrame f;
+        if (!_bus.readAny(f)) // 応答は onRxFrame で
+            delayMicroseconds(20);
+    }
+}
+
+void RS02Commission::onRxFrame(const RS02PrivFrame &f)
+{
+    if (!f.isExt || f.dlc < 8)
+        return;
+    uint8_t type = rs02FrameType(f.id);
+    uint8_t motor = (uint8_t)((f.id >> 8) & 0xFF);
+    if (type == RS02Type::GET_ID && rs02FrameDst(f.id) == 0xFE)
+    {
+        uint64_t uid = 0;
+        for (uint8_t i = 0; i < 8; i++)
+            uid |= (uint64_t)f.data[i] << (8 * i);
+        for (uint8_t i = 0; i < _n; i++)
+            if (_wait[i] && _step[i] == motor && _it[i].uid == uid)
+            {
+                _wait[i] = false;
+                _it[i].verifyUs = f.tsUs - _sentUs[i];
+            }
+        return;
+    }
+    if (type == RS02Type::FEEDBACK)
+    {
+        // Type22 の応答（送った後に新 ID から来た Type2）
+        for (uint8_t i = 0; i < _n; i++)
+            if (_saveWait[i] && _cur[i] == motor && (int32_t)(f.tsUs - _sentUs[i]) >= 0)
+            {
+                _saveWait[i] = false;
+                _it[i].saved = true;
+            }
+    }
+}
+
+const char *RS02Commission::resultName(RS02CommissionResult r)
+{
+    switch (r)
+    {
+    case RS02CommissionResult::Pending:
+        return "pending";
+    case RS02CommissionResult::Ok:
+        return "ok";
+    case RS02CommissionResult::Unchanged:
+        return "unchanged";
+    case RS02CommissionResult::NotFound:
+        return "not found";
+    case RS02CommissionResult::SourceConflict:
+        return "source id conflict";
+    case RS02CommissionResult::Duplicate:
+        return "duplicate row";
+    case RS02CommissionResult::TargetConflict:
+        return "target conflict";
+    case RS02CommissionResult::TargetBusy:
+        return "target busy";
+    case RS02CommissionResult::NoReply:
+        return "no reply";
+    case RS02CommissionResult::SendFailed:
+        return "send failed";
+    }
+    return "?";
+}
+
+void RS02Commission::print(Print &out) const
+{
+    out.printf("commission: %u ok, %u failed in %.1fms (scan %.1fms, apply %.1fms / %u wave(s), save %.1fms)\n", _stats.ok,
+               _stats.failed, _stats.totalUs / 1000.0f, _stats.scanUs / 1000.0f, _stats.applyUs / 1000.0f, _stats.waves,
+               _stats.saveUs / 1000.0f);
+    for (uint8_t i = 0; i < _n; i++)
+    {
+        const RS02CommissionItem &it = _it[i];
+        if (it.byUid)
+            out.printf("  uid %08lX%08lX", (unsigned long)(it.uid >> 32), (unsigned long)(uint32_t)it.uid);
+        else
+            out.printf("  id 0x%02X              ", it.fromId);
+        if (it.oldId <= 127)
+            out.printf("  0x%02X -> 0x%02X", it.oldId, it.toId);
+        else
+            out.printf("  ---- -> 0x%02X", it.toId);
+        out.printf("  %-18s", resultName(it.result));
+        if (it.viaId != 0xFF)
+            out.printf(" via 0x%02X", it.viaId);
+        if (it.result == RS02CommissionResult::Ok)
+            out.printf(" %5luus x%u%s", (unsigned long)it.verifyUs, it.attempts, it.saved ? " saved" : " NOT SAVED");
+        out.printf("\n");
+    }
+}
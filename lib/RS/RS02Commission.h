@@ -0,0 +1,125 @@
+#pragma once
+// RS02Commission.h — ID の一括変更（UID か今の ID → 新しい ID の対応表）
+// 1) RS02Scanner で探して、対応表の UID / 今の ID を実際のモータに結び付ける
+// 2) 衝突を調べる: 見つからない / 今の ID に 2 台いる / 同じ新 ID が 2 つ / 新 ID に動かないモータがいる → その行は変えない
+// 3) 新 ID が空いている行をまとめて Type7 で送り（wave, 応答待ちは maxInFlight 本まで重ねる）、
+//    新 ID から返る Type0（UID 入り）を受けて確認する。
+//    入れ替え（1→2, 2→1）のように空かない行は、空いている ID を経由して回す。
+//    応答が無ければ Type0 の問い合わせと Type7 を送り直す（retries 回まで）。一定間隔の読み戻しはしない
+// 4) 変えたモータに Type22 をまとめて送り、新 ID からの応答（Type2）で保存を確認する
+// 送信は完了を待たずに戻し、前のフレームが出るまでは受信を読む（応答が送信待ちのあいだに溜まらない）。
+// run() のあいだはバスを占有する。Type7 は運転中（Run）のモータには効かないので、先に止めておくこと。
+
+#include <Arduino.h>
+#include "RS02PrivateBase.h"
+#include "RS02Scanner.h"
+
+#ifndef RS02_COMMISSION_MAX
+#define RS02_COMMISSION_MAX 32
+#endif
+
+enum class RS02CommissionResult : uint8_t
+{
+    Pending = 0,
+    Ok,             // 変更して新 ID からの応答を確認
+    Unchanged,      // 今の ID = 新 ID
+    NotFound,       // UID / 今の ID のモータが見つからない
+    SourceConflict, // 今の ID に 2 台いる（ID では 1 台を選べない）
+    Duplicate,      // 同じモータが対応表に 2 回
+    TargetConflict, // 同じ新 ID が対応表に 2 回
+    TargetBusy,     // 新 ID に動かないモータがいる
+    NoReply,        // Type7 を送り直しても新 ID から応答が無い（運転中など）
+    SendFailed      // 送信できなかった
+};
+
+struct RS02CommissionItem
+{
+    // 入力
+    uint64_t uid = 0;      // byUid のとき
+    uint8_t fromId = 0xFF; // ID 指定のとき
+    uint8_t toId = 0;
+    bool byUid = false;
+    // 結果
+    RS02CommissionResult result = RS02CommissionResult::Pending;
+    uint8_t oldId = 0xFF; // 探索で見つけた ID
+    uint8_t viaId = 0xFF; // 入れ替えで経由した ID（0xFF=なし）
+    uint8_t attempts = 0; // Type7 の送信回数（経由込み）
+    bool saved = false;   // Type22 の応答を確認
+    uint32_t verifyUs = 0; // 最後の Type7 から新 ID の応答まで
+};
+
+struct RS02CommissionConfig
+{
+    RS02ScanConfig scan;            // 探索（readInfo は使わない）
+    uint32_t verifyTimeoutUs = 20000; // Type7 から新 ID の応答を待つ時間（1 回あたり）
+    uint8_t retries = 3;
+    uint8_t maxInFlight = 8;        // 応答待ちの上限（送信の合間に受信を読むので MCP2515 でも重ねられる）
+    bool save = true;               // Type22
+    uint32_t saveTimeoutUs = 20000;
+};
+
+struct RS02CommissionStats
+{
+    uint32_t totalUs = 0;
+    uint32_t scanUs = 0;
+    uint32_t applyUs = 0;
+    uint32_t saveUs = 0;
+    uint8_t waves = 0;
+    uint8_t cycles = 0;    // 空いている ID を経由して回した回数
+    uint16_t type7 = 0;
+    uint16_t pings = 0;
+    uint16_t saves = 0;
+    uint8_t ok = 0;
+    uint8_t failed = 0;
+};
+
+class RS02Commission : public RS02FrameListener
+{
+public:
+    explicit RS02Commission(RS02PrivateBase &bus) : _bus(bus), _scan(bus) {}
+
+    // 対応表（run の前に）。いっぱい / 新 ID が 0..127 でなければ false
+    void clear() { _n = 0; }
+    bool addUid(uint64_t uid, uint8_t toId);
+    bool addId(uint8_t fromId, uint8_t toId);
+
+    // 探索 → 衝突の確認 → 変更 → 保存。戻り値は Ok の行数
+    uint8_t run(const RS02CommissionConfig &cfg = RS02CommissionConfig());
+
+    uint8_t count() const { return _n; }
+    const RS02CommissionItem &item(uint8_t i) const { return _it[i]; }
+    const RS02CommissionStats &stats() const { return _stats; }
+    const RS02Scanner &scanner() const { return _scan; }
+    static const char *resultName(RS02CommissionResult r);
+
+    // 行ごとの結果と全体の時間
+    void print(Print &out) const;
+
+    void onRxFrame(const RS02PrivFrame &f) override;
+
+private:
+    RS02PrivateBase &_bus;
+    RS02Scanner _scan;
+    RS02CommissionConfig _cfg;
+    RS02CommissionStats _stats;
+    RS02CommissionItem _it[RS02_COMMISSION_MAX];
+    uint8_t _n = 0;
+
+    // run() 中の行ごとの状態
+    uint8_t _cur[RS02_COMMISSION_MAX];  // 今いる ID
+    uint8_t _step[RS02_COMMISSION_MAX]; // この wave の行き先
+    bool _wait[RS02_COMMISSION_MAX];    // 新 ID の Type0 待ち
+    bool _saveWait[RS02_COMMISSION_MAX];
+    uint32_t _sentUs[RS02_COMMISSION_MAX];
+    RS02MotorSet _occ; // モータがいる ID
+
+    bool add(const RS02CommissionItem &it);
+    void resolve();
+    bool pending(uint8_t i) const { return _it[i].result == RS02CommissionResult::Pending; }
+    uint8_t tempId() const;
+    void apply();
+    void applyWave();
+    void save();
+    void waitSlot(const bool *flags, uint32_t timeoutUs);
+    void listen(bool *flags, uint32_t timeoutUs);
+};
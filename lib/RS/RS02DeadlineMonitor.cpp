@@ -0,0 +1,260 @@
+// RS02DeadlineMonitor.cpp — 指令/帰還デッドライン監視とホスト heartbeat
+#include "RS02DeadlineMonitor.h"
+
+void RS02DeadlineMonitor::end()
+{
+    stopTask();
+    _bus.removeListener(this);
+}
+
+void RS02DeadlineMonitor::watch(uint8_t motorId, const RS02DeadlineConfig &cfg)
+{
+    if (motorId >= 128)
+        return;
+    RS02BusGuard g(_bus);
+    Motor &m = _m[motorId];
+    m.watched = true;
+    m.cfg = cfg;
+    m.cmdFired = m.fbFired = m.stopFired = false;
+}
+
+void RS02DeadlineMonitor::unwatch(uint8_t motorId)
+{
+    if (motorId >= 128)
+        return;
+    RS02BusGuard g(_bus);
+    _m[motorId].watched = false;
+}
+
+void RS02DeadlineMonitor::resetStats()
+{
+    RS02BusGuard g(_bus);
+    for (uint8_t i = 0; i < 128; i++)
+        _m[i].stats = RS02DeadlineMotorStats();
+    _host = RS02HostStats();
+}
+
+// ===== Host heartbeat =====
+void RS02DeadlineMonitor::heartbeat()
+{
+    RS02BusGuard g(_bus); // service()（監視タスク）と同じ値を触る
+    uint32_t now = micros();
+    if (_host.beats > 0)
+    {
+        uint32_t gap = now - _lastBeatUs;
+        _host.lastGapUs = gap;
+        if (gap > _host.maxGapUs)
+            _host.maxGapUs = gap;
+        uint8_t bin = 0;
+        for (uint32_t ms = gap / 1000; ms > 0 && bin < RS02_LOOP_HIST_BINS - 1; ms >>= 1)
+            bin++;
+        _host.hist[bin]++;
+    }
+    _host.beats++;
+    _lastBeatUs = now;
+    _hostStalled = false;
+}
+
+// ===== Frame tap =====
+void RS02DeadlineMonitor::onTxFrame(const RS02PrivFrame &f, bool ok)
+{
+    uint8_t type = rs02FrameType(f.id);
+    uint8_t id = rs02FrameDst(f.id);
+    if (id >= 128)
+        return;
+    Motor &m = _m[id];
+    if (m.ownPending && type == RS02Type::OP_CONTROL)
+    {
+        // 自分の ZeroRef（すぐ出ても後から pumpTx で出ても）。アプリの Type1 が出たなら差し替えられている
+        m.ownPending = false;
+        if (f.id == m.ownId && !memcmp(f.data, m.ownData, 8))
+            return;
+    }
+    if (_firing || !ok)
+        return;
+
+    if (type == RS02Type::STOP)
+    {
+        // アプリが止めたモータは指令途絶を監視しない
+        m.cmdSeen = false;
+        m.hasSetpoint = false;
+        return;
+    }
+    if (type != RS02Type::OP_CONTROL && type != RS02Type::ENABLE && type != RS02Type::WRITE_PARAM)
+        return;
+
+    if (m.cmdSeen)
+    {
+        uint32_t gap = f.tsUs - m.lastCmdUs;
+        if (gap > m.stats.maxCmdGapUs)
+            m.stats.maxCmdGapUs = gap;
+    }
+    m.cmdSeen = true;
+    m.lastCmdUs = f.tsUs;
+    m.cmdFired = m.stopFired = false;
+
+    bool sp = (type == RS02Type::OP_CONTROL);
+    if (type == RS02Type::WRITE_PARAM)
+    {
+        uint16_t idx = (uint16_t)f.data[0] | ((uint16_t)f.data[1] << 8);
+        sp = (idx == RS02Idx::SPD_REF || idx == RS02Idx::LOC_REF || idx == RS02Idx::IQ_REF);
+    }
+    if (sp)
+    {
+        m.hasSetpoint = true;
+        m.spId = f.id;
+        memcpy(m.spData, f.data, 8);
+    }
+}
+
+void RS02DeadlineMonitor::onRxFrame(const RS02PrivFrame &f)
+{
+    uint8_t type = rs02FrameType(f.id);
+    if (type != RS02Type::FEEDBACK && type != RS02Type::READ_PARAM)
+        return;
+    uint8_t id = (uint8_t)((f.id >> 8) & 0xFF); // 応答は bit8-15=モータID
+    if (id >= 128)
+        return;
+    Motor &m = _m[id];
+    if (m.fbSeen)
+    {
+        uint32_t gap = f.tsUs - m.lastFbUs;
+        if (gap > m.stats.maxFbGapUs)
+            m.stats.maxFbGapUs = gap;
+    }
+    m.fbSeen = true;
+    m.lastFbUs = f.tsUs;
+    m.fbFired = false;
+}
+
+// ===== 監視本体 =====
+void RS02DeadlineMonitor::service()
+{
+    RS02BusGuard g(_bus);
+    uint32_t now = micros();
+
+    if (_hostTimeoutUs && _host.beats > 0 && !_hostStalled && (now - _lastBeatUs) > _hostTimeoutUs)
+    {
+        _hostStalled = true;
+        _host.stalls++;
+        for (uint8_t id = 0; id < 128; id++)
+            if (_m[id].watched && _m[id].cmdSeen)
+                fire(id, _m[id], _hostAction, now);
+    }
+
+    for (uint8_t id = 0; id < 128; id++)
+    {
+        Motor &m = _m[id];
+        if (!m.watched)
+            continue;
+
+        if (m.cfg.cmdTimeoutMs && m.cmdSeen)
+        {
+            uint32_t gap = now - m.lastCmdUs;
+            uint32_t lim = m.cfg.cmdTimeoutMs * 1000UL;
+            if (gap > m.stats.maxCmdGapUs)
+                m.stats.maxCmdGapUs = gap;
+            if (gap > lim)
+            {
+                if (!m.cmdFired)
+                {
+                    m.cmdFired = true;
+                    m.stats.cmdMisses++;
+                    m.lastResendUs = now;
+                    fire(id, m, m.cfg.cmdAction, now);
+                }
+                else if (m.cfg.cmdAction == RS02DeadlineAction::Resend && (now - m.lastResendUs) >= lim)
+                {
+                    m.lastResendUs = now;
+                    fire(id, m, RS02DeadlineAction::Resend, now);
+                }
+                if (m.cfg.stopAfterMs && !m.stopFired && gap > m.cfg.stopAfterMs * 1000UL)
+                {
+                    m.stopFired = true;
+                    fire(id, m, RS02DeadlineAction::Stop, now);
+                }
+            }
+        }
+
+        if (m.cfg.fbTimeoutMs && m.fbSeen && !m.fbFired)
+        {
+            uint32_t gap = now - m.lastFbUs;
+            if (gap > m.cfg.fbTimeoutMs * 1000UL)
+            {
+                m.fbFired = true;
+                m.stats.fbMisses++;
+                fire(id, m, m.cfg.fbAction, now);
+            }
+        }
+    }
+}
+
+void RS02DeadlineMonitor::fire(uint8_t motorId, Motor &m, RS02DeadlineAction a, uint32_t now)
+{
+    (void)now;
+    if (a == RS02DeadlineAction::None)
+        return;
+    _firing = true;
+    m.stats.actions++;
+    switch (a)
+    {
+    case RS02DeadlineAction::Resend:
+        if (m.hasSetpoint)
+            _bus.sendExt(m.spId, m.spData, 8);
+        break;
+    case RS02DeadlineAction::ZeroRef:
+    {
+        if (!m.hasSetpoint)
+            break;
+        uint8_t type = rs02FrameType(m.spId);
+        if (type == RS02Type::OP_CONTROL)
+        {
+            // 速度0・Kp=0・トルク0、Kd は直前の値を維持して減速させる。
+            // opControl と同じく送信キューを通す（塞がれていても古い目標値を差し替えて後から出る）
+            float kd = (float)(((uint16_t)m.spData[6] << 8) | m.spData[7]) * 5.0f / 65535.0f;
+            m.ownId = RS02PrivateBase::opControlFrame(motorId, 0.0f, 0.0f, 0.0f, 0.0f, kd, m.ownData);
+            m.ownPending = true;
+            _bus.sendSetpoint(m.ownId, m.ownData, 8);
+            break;
+        }
+        uint16_t idx = (uint16_t)m.spData[0] | ((uint16_t)m.spData[1] << 8);
+        if (idx == RS02Idx::LOC_REF)
+            _bus.stop(motorId, false); // 位置指令の「ゼロ」は原点へ動くので停止で代用
+        else
+            _bus.writeFloatParam(motorId, idx, 0.0f);
+        break;
+    }
+    case RS02DeadlineAction::Stop:
+        _bus.stop(motorId, false);
+        break;
+    default:
+        break;
+    }
+    _firing = false;
+}
+
+// ===== 専用タスク =====
+bool RS02DeadlineMonitor::startTask(uint32_t periodMs, int core, UBaseType_t prio)
+{
+    if (_task.running())
+        return true;
+    _periodMs = periodMs ? periodMs : 1;
+    return _task.start(taskEntry, "rs02_deadline", this, prio, core);
+}
+
+void RS02DeadlineMonitor::stopTask()
+{
+    _task.stop();
+}
+
+void RS02DeadlineMonitor::taskEntry(void *arg)
+{
+    RS02DeadlineMonitor *self = static_cast<RS02DeadlineMonitor *>(arg);
+    TickType_t last = xTaskGetTickCount();
+    while (!self->_task.stopRequested())
+    {
+        self->service();
+        vTaskDelayUntil(&last, pdMS_TO_TICKS(self->_periodMs));
+    }
+    self->_task.exit();
+}
@@ -0,0 +1,119 @@
+#pragma once
+// RS02DeadlineMonitor.h — ホスト生存監視（heartbeat）+ モータ毎の指令/帰還デッドライン監視
+// loop() が readParamRaw の待ちや pushSprite で止まっても、専用タスクから
+// 「最終指令の再送 / 指令ゼロ化 / 停止」を実行する。デッドライン超過は統計に残す。
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "RS02PrivateBase.h"
+#include "RS02Task.h"
+
+enum class RS02DeadlineAction : uint8_t
+{
+    None = 0,
+    Resend = 1,  // 最後の指令フレームを再送（周期ごと）
+    ZeroRef = 2, // SPD_REF/IQ_REF=0、Type1 はゼロトルク（LOC_REF は停止に置換）
+    Stop = 3     // Type4
+};
+
+struct RS02DeadlineConfig
+{
+    uint32_t cmdTimeoutMs = 100;  // 最終指令からの許容時間（0=監視しない）
+    uint32_t fbTimeoutMs = 0;     // 最終帰還（Type2/Type17応答）からの許容時間（0=監視しない）
+    uint32_t stopAfterMs = 0;     // 指令途絶がこれを超えたら Stop へ格上げ（0=しない）
+    RS02DeadlineAction cmdAction = RS02DeadlineAction::ZeroRef;
+    RS02DeadlineAction fbAction = RS02DeadlineAction::Stop;
+};
+
+struct RS02DeadlineMotorStats
+{
+    uint32_t cmdMisses = 0;
+    uint32_t fbMisses = 0;
+    uint32_t actions = 0;
+    uint32_t maxCmdGapUs = 0;
+    uint32_t maxFbGapUs = 0;
+};
+
+// loop() 周期のヒストグラム（<1ms, <2ms, <4ms ... <512ms, それ以上）
+static constexpr uint8_t RS02_LOOP_HIST_BINS = 11;
+
+struct RS02HostStats
+{
+    uint32_t beats = 0;
+    uint32_t stalls = 0;     // hostTimeout 超過回数
+    uint32_t maxGapUs = 0;   // heartbeat 間隔の最大
+    uint32_t lastGapUs = 0;
+    uint32_t hist[RS02_LOOP_HIST_BINS] = {0};
+};
+
+class RS02DeadlineMonitor : public RS02FrameListener
+{
+public:
+    explicit RS02DeadlineMonitor(RS02PrivateBase &bus) : _bus(bus) {}
+
+    bool begin() { return _bus.addListener(this); }
+    void end();
+
+    // 監視対象の登録（最大 128）
+    void watch(uint8_t motorId, const RS02DeadlineConfig &cfg);
+    void unwatch(uint8_t motorId);
+
+    // ホスト（loop）生存: loop() 先頭で heartbeat() を呼ぶ
+    void setHostTimeout(uint32_t ms, RS02DeadlineAction action)
+    {
+        _hostTimeoutUs = ms * 1000UL;
+        _hostAction = action;
+    }
+    void heartbeat();
+
+    // 監視本体。startTask() 使用時は専用タスクから周期実行（手動呼び出しも可）
+    void service();
+    bool startTask(uint32_t periodMs = 5, int core = 0, UBaseType_t prio = 5);
+    void stopTask();
+
+    const RS02DeadlineMotorStats &stats(uint8_t motorId) const { return _m[motorId & 0x7F].stats; }
+    const RS02HostStats &hostStats() const { return _host; }
+    bool hostStalled() const { return _hostStalled; }
+    void resetStats();
+
+    void onRxFrame(const RS02PrivFrame &f) override;
+    void onTxFrame(const RS02PrivFrame &f, bool ok) override;
+
+private:
+    struct Motor
+    {
+        bool watched = false;
+        bool cmdSeen = false;
+        bool fbSeen = false;
+        bool hasSetpoint = false;
+        bool cmdFired = false;
+        bool fbFired = false;
+        bool stopFired = false;
+        RS02DeadlineConfig cfg;
+        uint32_t lastCmdUs = 0;
+        uint32_t lastFbUs = 0;
+        uint32_t lastResendUs = 0;
+        unsigned long spId = 0; // 最後の指令フレーム
+        uint8_t spData[8] = {0};
+        // ZeroRef の Type1（送信キューに入ると _firing の外で出る。出るまでアプリの指令と数えない）
+        bool ownPending = false;
+        uint32_t ownId = 0;
+        uint8_t ownData[8] = {0};
+        RS02DeadlineMotorStats stats;
+    };
+
+    RS02PrivateBase &_bus;
+    Motor _m[128];
+    RS02HostStats _host;
+    uint32_t _hostTimeoutUs = 0;
+    RS02DeadlineAction _hostAction = RS02DeadlineAction::Stop;
+    volatile uint32_t _lastBeatUs = 0;
+    volatile bool _hostStalled = false;
+    bool _firing = false; // 自身の送信を指令として数えない
+    RS02TaskSlot _task;
+    uint32_t _periodMs = 5;
+
+    void fire(uint8_t motorId, Motor &m, RS02DeadlineAction a, uint32_t now);
+    static void taskEntry(void *arg);
+};
@@ -0,0 +1,121 @@
+// RS02FaultSupervisor.cpp — Type2 故障ビット → 即時停止
+#include "RS02FaultSupervisor.h"
+
+void RS02FaultSupervisor::setGroup(uint8_t motorId, uint8_t group)
+{
+    if (motorId < 128)
+        _st[motorId].group = group;
+}
+
+void RS02FaultSupervisor::rearm(uint8_t motorId)
+{
+    if (motorId < 128)
+        _st[motorId].tripped = false;
+}
+
+void RS02FaultSupervisor::onRxFrame(const RS02PrivFrame &f)
+{
+    RS02Feedback fb;
+    if (!_bus.parseFeedback(f, fb) || fb.motorId >= 128)
+        return;
+
+    RS02FaultMotorState &s = _st[fb.motorId];
+    s.seen = true;
+    s.mode = fb.mode;
+    s.faultBits = fb.faultBits;
+    s.lastFeedbackUs = f.tsUs;
+
+    uint16_t hit = fb.faultBits & _cfg.tripMask;
+    if (hit == 0)
+    {
+        s.tripped = false; // 故障が消えたら再武装
+        return;
+    }
+    if (!s.tripped)
+        trip(fb.motorId, hit, f.tsUs);
+}
+
+void RS02FaultSupervisor::onTxDone(const RS02PrivFrame &f, bool ok)
+{
+    if (rs02FrameType(f.id) != RS02Type::STOP)
+        return;
+    uint8_t id = rs02FrameDst(f.id);
+    if (id >= 128 || !_st[id].stopPending)
+        return;
+    RS02FaultMotorState &s = _st[id];
+    s.stopPending = false;
+    _stopsPending--;
+    if (ok)
+    {
+        if (s.tripped) // グループで止めたモータは数えない
+            _lat.add(f.tsUs - s.stopRxUs);
+        return;
+    }
+    // 出る前に破棄された（別の緊急停止 / 取り消し）→ 後ろに積み直す
+    _resent++;
+    sendStop(id, false, s.tripped && _cfg.clearFault);
+}
+
+void RS02FaultSupervisor::trip(uint8_t motorId, uint16_t faultBits, uint32_t rxUs)
+{
+    RS02FaultMotorState &s = _st[motorId];
+    s.tripped = true;
+    s.tripCount++;
+    s.stopRxUs = rxUs;
+    _trips++;
+
+    // 故障モータを最初に止める（遅延計測はこの1フレーム）。
+    // 送信待ちの破棄は先の stop が全部出てから（2 台目の故障で 1 台目の Type4 を消さない）
+    if (_stopsPending && _bus.txIdle())
+    {
+        // 完了の通知を取りこぼしていても（完了待ちの溢れ）、HW が空なら全部出ている
+        for (uint8_t id = 0; id < 128; id++)
+            _st[id].stopPending = false;
+        _stopsPending = 0;
+    }
+    if (sendStop(motorId, _cfg.flushQueued && _stopsPending == 0, _cfg.clearFault))
+        _latSubmit.add(micros() - rxUs);
+
+    if (_cfg.stopGroup && s.group != 0)
+    {
+        for (uint8_t id = 0; id < 128; id++)
+        {
+            if (id == motorId || _st[id].group != s.group)
+                continue;
+            sendStop(id, false, false);
+        }
+    }
+
+    if (_cb)
+        _cb(motorId, faultBits, _cbCtx);
+}
+
+bool RS02FaultSupervisor::sendStop(uint8_t motorId, bool urgent, bool clearFault)
+{
+    // 同期送信のバックエンドは送信中に onTxDone が来るので先に印を付ける
+    RS02FaultMotorState &s = _st[motorId];
+    if (!s.stopPending)
+    {
+        s.stopPending = true;
+        _stopsPending++;
+    }
+    bool ok = urgent ? _bus.stopUrgent(motorId, clearFault) : _bus.stop(motorId, clearFault);
+    if (!ok && s.stopPending)
+    {
+        s.stopPending = false;
+        _stopsPending--;
+        s.tripped = false; // 故障モータなら次の故障フレームで送り直す
+    }
+    return ok;
+}
+
+void RS02FaultLatency::add(uint32_t us)
+{
+    if (count == 0 || us < minUs)
+        minUs = us;
+    if (us > maxUs)
+        maxUs = us;
+    lastUs = us;
+    sumUs += us;
+    count++;
+}
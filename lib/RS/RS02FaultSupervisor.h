@@ -0,0 +1,99 @@
+#pragma once
+// RS02FaultSupervisor.h — Type2 故障ビット監視 → 即時 stop()（受信経路で動作）
+// readAny() で受けた Type2 の faultBits が tripMask に掛かったら、
+// 送信待ちを破棄して当該モータ（またはグループ全体）へ Type4 を最優先で送る。
+// 先の Type4 がまだバスに出ていない間に別のモータが故障したら、破棄せず後ろに積む（先の Type4 を消さない）。
+
+#include <Arduino.h>
+#include "RS02PrivateBase.h"
+
+struct RS02FaultConfig
+{
+    // stop() の対象とする故障ビット（RS02Fault::*）。UNCALIBRATED は既定で対象外
+    uint16_t tripMask = RS02Fault::UNDERVOLTAGE | RS02Fault::OVERCURRENT | RS02Fault::OVERTEMP |
+                        RS02Fault::ENCODER | RS02Fault::OVERLOAD;
+    bool stopGroup = false;   // true: 同じグループのモータも全停止
+    bool clearFault = false;  // stop(id, clearFault)
+    bool flushQueued = true;  // 送信待ちフレームを破棄してから stop を送る
+};
+
+struct RS02FaultMotorState
+{
+    bool seen = false;        // Type2 受信済み
+    bool tripped = false;     // stop 送信済み（故障ビットが消えるまで再送しない）
+    bool stopPending = false; // 送った stop がまだバスに出ていない（onTxDone 待ち。グループ停止も）
+    uint8_t mode = 0;         // RS02MotorState::*
+    uint8_t group = 0;        // 0=グループなし
+    uint16_t faultBits = 0;   // 直近の故障ビット
+    uint16_t tripCount = 0;
+    uint32_t lastFeedbackUs = 0;
+    uint32_t stopRxUs = 0;    // stop のきっかけになった故障フレームの受信時刻
+};
+
+// 故障フレーム受信 → stop までの時間 [us]
+// latency(): バスに出るまで（onTxDone）。submitLatency(): HW に渡すまで（TWAI はキューに積んだ時点）
+struct RS02FaultLatency
+{
+    uint32_t count = 0;
+    uint32_t lastUs = 0;
+    uint32_t minUs = 0;
+    uint32_t maxUs = 0;
+    uint64_t sumUs = 0;
+    float avgUs() const { return count ? (float)sumUs / (float)count : 0.0f; }
+    void add(uint32_t us);
+};
+
+class RS02FaultSupervisor : public RS02FrameListener
+{
+public:
+    typedef void (*TripCallback)(uint8_t motorId, uint16_t faultBits, void *ctx);
+
+    explicit RS02FaultSupervisor(RS02PrivateBase &bus) : _bus(bus) {}
+
+    bool begin() { return _bus.addListener(this); }
+    void end() { _bus.removeListener(this); }
+
+    void setConfig(const RS02FaultConfig &cfg) { _cfg = cfg; }
+    const RS02FaultConfig &config() const { return _cfg; }
+
+    // グループ番号（1..255）。stopGroup 時は同じ番号のモータをまとめて停止
+    void setGroup(uint8_t motorId, uint8_t group);
+    void onTrip(TripCallback cb, void *ctx = nullptr)
+    {
+        _cb = cb;
+        _cbCtx = ctx;
+    }
+
+    bool tripped(uint8_t motorId) const { return motorId < 128 && _st[motorId].tripped; }
+    void rearm(uint8_t motorId);
+    const RS02FaultMotorState &state(uint8_t motorId) const { return _st[motorId & 0x7F]; }
+
+    const RS02FaultLatency &latency() const { return _lat; }
+    const RS02FaultLatency &submitLatency() const { return _latSubmit; }
+    void resetLatency()
+    {
+        _lat = RS02FaultLatency();
+        _latSubmit = RS02FaultLatency();
+    }
+    uint32_t tripCount() const { return _trips; }
+    // 送った stop が出る前に破棄された（送り直した）回数
+    uint32_t stopsResent() const { return _resent; }
+
+    void onRxFrame(const RS02PrivFrame &f) override;
+    void onTxDone(const RS02PrivFrame &f, bool ok) override;
+
+private:
+    RS02PrivateBase &_bus;
+    RS02FaultConfig _cfg;
+    RS02FaultMotorState _st[128];
+    RS02FaultLatency _lat;
+    RS02FaultLatency _latSubmit;
+    uint32_t _trips = 0;
+    uint32_t _resent = 0;
+    uint8_t _stopsPending = 0; // バスに出ていない stop（0 のときだけ送信待ちを破棄する）
+    TripCallback _cb = nullptr;
+    void *_cbCtx = nullptr;
+
+    void trip(uint8_t motorId, uint16_t faultBits, uint32_t rxUs);
+    bool sendStop(uint8_t motorId, bool urgent, bool clearFault);
+};
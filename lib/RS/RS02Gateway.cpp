@@ -0,0 +1,198 @@
+// RS02Gateway.cpp — フィルタ / レート制限 / 方向ごとのリング（1 生産者 1 消費者）で 2 バス間を転送
+#include "RS02Gateway.h"
+
+static_assert((RS02_GW_RING & (RS02_GW_RING - 1)) == 0, "RS02_GW_RING must be a power of 2");
+
+bool RS02Gateway::begin()
+{
+    if (_begun)
+        return true;
+    _tapA.owner = _tapB.owner = this;
+    _tapA.dir = RS02GwDir::AtoB;
+    _tapB.dir = RS02GwDir::BtoA;
+    if (!_a.addListener(&_tapA))
+        return false;
+    if (!_b.addListener(&_tapB))
+    {
+        _a.removeListener(&_tapA);
+        return false;
+    }
+    _begun = true;
+    return true;
+}
+
+void RS02Gateway::end()
+{
+    stopTask();
+    if (!_begun)
+        return;
+    _a.removeListener(&_tapA);
+    _b.removeListener(&_tapB);
+    _begun = false;
+}
+
+// ===== 設定 =====
+bool RS02Gateway::addFilter(RS02GwDir dir, const RS02GwFilter &f)
+{
+    Dir &d = _dir[(uint8_t)dir];
+    if (d.nFilter >= RS02_GW_FILTERS)
+        return false;
+    d.filter[d.nFilter++] = f;
+    return true;
+}
+
+void RS02Gateway::clearFilters(RS02GwDir dir) { _dir[(uint8_t)dir].nFilter = 0; }
+
+void RS02Gateway::setRateLimit(RS02GwDir dir, uint32_t fps, uint16_t burst)
+{
+    Dir &d = _dir[(uint8_t)dir];
+    d.fps = fps;
+    d.burst = burst ? burst : 1;
+    d.tokens = (uint64_t)d.burst * 1000000ULL; // 満タンから
+    d.tokenUs = micros();
+}
+
+uint16_t RS02Gateway::depth(RS02GwDir dir) const
+{
+    const Dir &d = _dir[(uint8_t)dir];
+    return (uint16_t)(__atomic_load_n(&d.head, __ATOMIC_ACQUIRE) - __atomic_load_n(&d.tail, __ATOMIC_ACQUIRE));
+}
+
+void RS02Gateway::resetStats()
+{
+    RS02BusGuard ga(_a);
+    RS02BusGuard gb(_b);
+    _dir[0].stats = RS02GatewayStats();
+    _dir[1].stats = RS02GatewayStats();
+}
+
+// ===== 受信側（生産者: 受けたバスの排他の内側）=====
+bool RS02Gateway::accept(const Dir &d, uint32_t id) const
+{
+    if (d.nFilter == 0)
+        return true;
+    for (uint8_t i = 0; i < d.nFilter; i++)
+        if (((id ^ d.filter[i].code) & d.filter[i].mask) == 0)
+            return true;
+    return false;
+}
+
+bool RS02Gateway::takeToken(Dir &d, uint32_t nowUs)
+{
+    if (d.fps == 0)
+        return true;
+    const uint64_t full = (uint64_t)d.burst * 1000000ULL;
+    d.tokens += (uint64_t)(uint32_t)(nowUs - d.tokenUs) * d.fps;
+    d.tokenUs = nowUs;
+    if (d.tokens > full)
+        d.tokens = full;
+    if (d.tokens < 1000000ULL)
+        return false;
+    d.tokens -= 1000000ULL;
+    return true;
+}
+
+void RS02Gateway::onRx(RS02GwDir dir, const RS02PrivFrame &f)
+{
+    Dir &d = _dir[(uint8_t)dir];
+    d.stats.rx++;
+    if (!f.isExt || !accept(d, f.id))
+    {
+        d.stats.filtered++;
+        return;
+    }
+    if (!takeToken(d, f.tsUs))
+    {
+        d.stats.rateDropped++;
+        return;
+    }
+    uint16_t head = d.head;
+    uint16_t used = (uint16_t)(head - __atomic_load_n(&d.tail, __ATOMIC_ACQUIRE));
+    if (used >= RS02_GW_RING)
+    {
+        d.stats.ringFull++;
+        return;
+    }
+    d.ring[head & (RS02_GW_RING - 1)] = f;
+    __atomic_store_n(&d.head, (uint16_t)(head + 1), __ATOMIC_RELEASE);
+    if (used + 1 > d.stats.maxDepth)
+        d.stats.maxDepth = used + 1;
+}
+
+// ===== 送信側（消費者）=====
+uint32_t RS02Gateway::forwardDir(Dir &d, RS02PrivateBase &to)
+{
+    uint32_t sent = 0;
+    uint16_t tail = d.tail;
+    uint16_t head = __atomic_load_n(&d.head, __ATOMIC_ACQUIRE);
+    while (tail != head)
+    {
+        const RS02PrivFrame &f = d.ring[tail & (RS02_GW_RING - 1)]; // 枠から直接送る
+        uint32_t age = micros() - f.tsUs;
+        if (age > _maxAgeUs)
+        {
+            d.stats.stale++;
+        }
+        else if (to.sendExt(f.id, f.data, f.dlc))
+        {
+            uint32_t us = micros() - f.tsUs;
+            d.stats.forwarded++;
+            d.stats.lastLatencyUs = us;
+            d.stats.totalLatencyUs += us;
+            if (us > d.stats.maxLatencyUs)
+                d.stats.maxLatencyUs = us;
+            sent++;
+        }
+        else
+        {
+            d.stats.txRetry++; // 送信キュー満杯など: 枠に残して次回
+            break;
+        }
+        tail++;
+        __atomic_store_n(&d.tail, tail, __ATOMIC_RELEASE);
+    }
+    return sent;
+}
+
+uint32_t RS02Gateway::forward()
+{
+    return forwardDir(_dir[(uint8_t)RS02GwDir::AtoB], _b) + forwardDir(_dir[(uint8_t)RS02GwDir::BtoA], _a);
+}
+
+uint32_t RS02Gateway::service()
+{
+    RS02PrivFrame f;
+    while (_a.readAny(f))
+    {
+    }
+    while (_b.readAny(f))
+    {
+    }
+    return forward();
+}
+
+// ===== Task =====
+bool RS02Gateway::startTask(uint32_t periodMs, int core, UBaseType_t prio)
+{
+    if (_task.running())
+        return true;
+    _periodMs = periodMs ? periodMs : 1;
+    return _task.start(taskEntry, "rs02_gw", this, prio, core);
+}
+
+void RS02Gateway::stopTask()
+{
+    _task.stop();
+}
+
+void RS02Gateway::taskEntry(void *arg)
+{
+    RS02Gateway *self = static_cast<RS02Gateway *>(arg);
+    TickType_t last = xTaskGetTickCount();
+    while (!self->_task.stopRequested())
+    {
+        self->service();
+        vTaskDelayUntil(&last, pdMS_TO_TICKS(self->_periodMs));
+    }
+    self->_task.exit();
+}
@@ -0,0 +1,120 @@
+#pragma once
+// RS02Gateway.h — 2 つの CAN コントローラ間のゲートウェイ（TWAI ⇔ MCP2515 など）
+// 片側で受けたフレームを ID フィルタ → レート制限 → 方向ごとのリングに置き、service() で反対側へ送る。
+// リングは 1 生産者（受信側バスの listener, バス排他の内側）/ 1 消費者（service）で、送信はリングの枠から直接
+// （受信時の 1 回のほかはコピーしない）。送れなければ枠に残して次の service で再送、maxAgeUs を過ぎたら捨てる。
+// 方向ごとに 受信 / フィルタ落ち / レート超過 / リング満杯 / 期限切れ / 転送 と、受信 → 送信の遅れを数える。
+// 転送するのは拡張フレーム（29bit）のみ。ゲートウェイ自身が送ったフレームは相手側の受信に戻らない（CAN の仕様）。
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "RS02PrivateBase.h"
+#include "RS02Task.h"
+
+#ifndef RS02_GW_RING
+#define RS02_GW_RING 64 // 方向ごとの枠数（2 のべき乗）
+#endif
+#ifndef RS02_GW_FILTERS
+#define RS02_GW_FILTERS 8
+#endif
+
+enum class RS02GwDir : uint8_t
+{
+    AtoB = 0,
+    BtoA = 1,
+};
+
+// (id & mask) == (code & mask) で通す。フィルタが 1 つも無い方向はすべて通す
+struct RS02GwFilter
+{
+    uint32_t code = 0;
+    uint32_t mask = 0;
+
+    // ホスト → モータ（dst = bit0-7）/ モータ → ホスト（送信元モータ = bit8-15）
+    static RS02GwFilter toMotor(uint8_t id) { return {id, 0xFFUL}; }
+    static RS02GwFilter fromMotor(uint8_t id) { return {(uint32_t)id << 8, 0xFF00UL}; }
+    // 通信タイプ（bit24-28）
+    static RS02GwFilter type(uint8_t t) { return {(uint32_t)(t & 0x1F) << 24, 0x1F000000UL}; }
+};
+
+struct RS02GatewayStats
+{
+    uint32_t rx = 0;          // 受信側で見たフレーム
+    uint32_t filtered = 0;    // フィルタ落ち（標準フレームを含む）
+    uint32_t rateDropped = 0; // レート制限で捨てた
+    uint32_t ringFull = 0;    // リング満杯で捨てた
+    uint32_t stale = 0;       // 送れないまま maxAgeUs を過ぎて捨てた
+    uint32_t forwarded = 0;
+    uint32_t txRetry = 0;     // 送信できず次の service へ持ち越した回数
+    uint16_t maxDepth = 0;    // リングの最大滞留
+    uint32_t lastLatencyUs = 0; // 受信（readAny）→ 反対側へ送信
+    uint32_t maxLatencyUs = 0;
+    uint64_t totalLatencyUs = 0; // 平均 = totalLatencyUs / forwarded
+};
+
+class RS02Gateway
+{
+public:
+    RS02Gateway(RS02PrivateBase &a, RS02PrivateBase &b) : _a(a), _b(b) {}
+    ~RS02Gateway() { end(); }
+
+    bool begin();
+    void end();
+
+    // フィルタ（begin 前後どちらでも。転送中に変えるときは service と同じタスクから）
+    bool addFilter(RS02GwDir dir, const RS02GwFilter &f);
+    void clearFilters(RS02GwDir dir);
+    // 方向ごとのレート制限（トークンバケット。fps=0 で無制限）
+    void setRateLimit(RS02GwDir dir, uint32_t fps, uint16_t burst = 16);
+    // 送れないフレームを持ち越す上限
+    void setMaxAgeUs(uint32_t us) { _maxAgeUs = us; }
+
+    // 両側の受信を読み（リングへ）、リングを反対側へ送る。戻り値は送ったフレーム数
+    uint32_t service();
+    // リングだけを送る（受信は別のタスク / 受信タスクが読む場合）
+    uint32_t forward();
+    bool startTask(uint32_t periodMs = 1, int core = 0, UBaseType_t prio = 5);
+    void stopTask();
+
+    uint16_t depth(RS02GwDir dir) const;
+    const RS02GatewayStats &stats(RS02GwDir dir) const { return _dir[(uint8_t)dir].stats; }
+    void resetStats();
+
+private:
+    class Tap : public RS02FrameListener
+    {
+    public:
+        RS02Gateway *owner = nullptr;
+        RS02GwDir dir = RS02GwDir::AtoB; // このバスで受けたフレームの行き先
+        void onRxFrame(const RS02PrivFrame &f) override { owner->onRx(dir, f); }
+    };
+    struct Dir
+    {
+        RS02PrivFrame ring[RS02_GW_RING];
+        uint16_t head = 0; // 生産者（listener）だけが進める
+        uint16_t tail = 0; // 消費者（forward）だけが進める
+        RS02GwFilter filter[RS02_GW_FILTERS];
+        uint8_t nFilter = 0;
+        uint32_t fps = 0;
+        uint16_t burst = 16;
+        uint64_t tokens = 0; // x1e6
+        uint32_t tokenUs = 0;
+        RS02GatewayStats stats;
+    };
+
+    RS02PrivateBase &_a;
+    RS02PrivateBase &_b;
+    Tap _tapA, _tapB;
+    Dir _dir[2];
+    bool _begun = false;
+    uint32_t _maxAgeUs = 10000;
+    RS02TaskSlot _task;
+    uint32_t _periodMs = 1;
+
+    void onRx(RS02GwDir dir, const RS02PrivFrame &f);
+    bool accept(const Dir &d, uint32_t id) const;
+    bool takeToken(Dir &d, uint32_t nowUs);
+    uint32_t forwardDir(Dir &d, RS02PrivateBase &to);
+    static void taskEntry(void *arg);
+};
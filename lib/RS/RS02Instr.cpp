@@ -0,0 +1,189 @@
+// RS02Instr.cpp — ホットパス計測（RS02_INSTR=0 のときは dump/handleCommand の案内のみ）
+#include "RS02Instr.h"
+
+#if defined(__linux__) && !defined(ARDUINO_ARCH_ESP32)
+#include <time.h>
+#endif
+
+namespace
+{
+#if RS02_INSTR
+    RS02InstrHist g_hist[RS02Probe::COUNT];
+    uint32_t g_counter[RS02Counter::COUNT];
+#if defined(ARDUINO_ARCH_ESP32)
+    uint32_t g_cpuMhz = 0;
+#endif
+
+    uint8_t bucketOf(uint32_t ns)
+    {
+        if (ns < 4)
+            return (uint8_t)ns;
+        uint8_t e = (uint8_t)(31 - __builtin_clz(ns)); // 2..31
+        uint8_t sub = (uint8_t)((ns >> (e - 2)) & 3);
+        return (uint8_t)((e - 1) * 4 + sub);
+    }
+#endif
+
+    const char *const PROBE_NAMES[RS02Probe::COUNT] = {
+        "begin", "sendExt", "readAny", "hwSend", "hwRead", "readParamRaw", "writeParam",
+        "opControl", "modeEntry", "idChange", "uiDraw", "user0", "user1"};
+    const char *const COUNTER_NAMES[RS02Counter::COUNT] = {
+        "txFail", "rxFrames", "paramTimeout", "paramSkipped", "urgent", "user0", "user1"};
+}
+
+// ===== ヒストグラム =====
+uint32_t RS02InstrHist::lowerBound(uint8_t b)
+{
+    if (b < 4)
+        return b;
+    uint8_t e = (uint8_t)(b / 4 + 1);
+    uint8_t sub = (uint8_t)(b % 4);
+    return (uint32_t)(4 + sub) << (e - 2);
+}
+
+uint32_t RS02InstrHist::percentileNs(float pct) const
+{
+    if (count == 0)
+        return 0;
+    uint32_t target = (uint32_t)((float)count * pct / 100.0f);
+    if (target >= count)
+        target = count - 1;
+    uint32_t acc = 0;
+    for (uint8_t b = 0; b < BUCKETS; b++)
+    {
+        acc += bucket[b];
+        if (acc > target)
+            return lowerBound(b);
+    }
+    return maxNs;
+}
+
+// ===== 時刻 =====
+uint32_t RS02Instr::nowTicks()
+{
+#if defined(ARDUINO_ARCH_ESP32)
+    return ESP.getCycleCount();
+#elif defined(__linux__)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+#else
+    return micros() * 1000UL;
+#endif
+}
+
+uint32_t RS02Instr::ticksToNs(uint32_t ticks)
+{
+#if defined(ARDUINO_ARCH_ESP32) && RS02_INSTR
+    if (g_cpuMhz == 0)
+        g_cpuMhz = getCpuFrequencyMhz();
+    return (uint32_t)((uint64_t)ticks * 1000ULL / g_cpuMhz);
+#else
+    return ticks; // Linux / その他は ns そのもの
+#endif
+}
+
+// ===== 記録 =====
+void RS02Instr::record(RS02Probe::Id probe, uint32_t ns)
+{
+#if RS02_INSTR
+    if (probe >= RS02Probe::COUNT)
+        return;
+    RS02InstrHist &h = g_hist[probe];
+    __atomic_fetch_add(&h.count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h.sumNs, (uint64_t)ns, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h.bucket[bucketOf(ns)], 1, __ATOMIC_RELAXED);
+    uint32_t m = __atomic_load_n(&h.maxNs, __ATOMIC_RELAXED);
+    while (ns > m && !__atomic_compare_exchange_n(&h.maxNs, &m, ns, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+#else
+    (void)probe;
+    (void)ns;
+#endif
+}
+
+void RS02Instr::count(RS02Counter::Id c, uint32_t n)
+{
+#if RS02_INSTR
+    if (c < RS02Counter::COUNT)
+        __atomic_fetch_add(&g_counter[c], n, __ATOMIC_RELAXED);
+#else
+    (void)c;
+    (void)n;
+#endif
+}
+
+void RS02Instr::reset()
+{
+#if RS02_INSTR
+    for (auto &h : g_hist)
+        h = RS02InstrHist();
+    for (auto &c : g_counter)
+        c = 0;
+#endif
+}
+
+const RS02InstrHist &RS02Instr::hist(RS02Probe::Id probe)
+{
+#if RS02_INSTR
+    return g_hist[probe < RS02Probe::COUNT ? probe : 0];
+#else
+    (void)probe;
+    static const RS02InstrHist empty;
+    return empty;
+#endif
+}
+
+uint32_t RS02Instr::counter(RS02Counter::Id c)
+{
+#if RS02_INSTR
+    return c < RS02Counter::COUNT ? g_counter[c] : 0;
+#else
+    (void)c;
+    return 0;
+#endif
+}
+
+const char *RS02Instr::probeName(RS02Probe::Id probe) { return probe < RS02Probe::COUNT ? PROBE_NAMES[probe] : "?"; }
+const char *RS02Instr::counterName(RS02Counter::Id c) { return c < RS02Counter::COUNT ? COUNTER_NAMES[c] : "?"; }
+
+// ===== 出力 =====
+void RS02Instr::dump(Print &out)
+{
+#if RS02_INSTR
+    out.printf("# rs02 instr [us]   %8s %9s %9s %9s %9s %9s\n", "count", "avg", "p50", "p90", "p99", "max");
+    for (uint8_t i = 0; i < RS02Probe::COUNT; i++)
+    {
+        const RS02InstrHist &h = g_hist[i];
+        if (h.count == 0)
+            continue;
+        out.printf("%-18s %8lu %9.2f %9.2f %9.2f %9.2f %9.2f\n", PROBE_NAMES[i], (unsigned long)h.count,
+                   (double)h.sumNs / (double)h.count / 1000.0, h.percentileNs(50.0f) / 1000.0,
+                   h.percentileNs(90.0f) / 1000.0, h.percentileNs(99.0f) / 1000.0, h.maxNs / 1000.0);
+    }
+    out.printf("# counters:");
+    for (uint8_t i = 0; i < RS02Counter::COUNT; i++)
+        out.printf(" %s=%lu", COUNTER_NAMES[i], (unsigned long)g_counter[i]);
+    out.printf("\n");
+#else
+    out.printf("# rs02 instr: disabled (build with -DRS02_INSTR=1)\n");
+#endif
+}
+
+bool RS02Instr::handleCommand(const char *line, Print &out)
+{
+    if (!line || strncmp(line, "instr", 5) != 0)
+        return false;
+    const char *arg = line + 5;
+    while (*arg == ' ')
+        arg++;
+    if (strncmp(arg, "reset", 5) == 0)
+    {
+        reset();
+        out.printf("# rs02 instr: reset\n");
+    }
+    else
+        dump(out);
+    return true;
+}
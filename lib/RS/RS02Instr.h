@@ -0,0 +1,114 @@
+#pragma once
+// RS02Instr.h — ホットパス計測（ビルドフラグ -DRS02_INSTR=1 のときだけ有効。既定は空マクロ）
+// ・RS02_INSTR_SCOPE(probe): スコープの所要時間をヒストグラムへ
+//   ESP32 は CPU サイクルカウンタ（240MHz で約 17.9s で一周）、Linux は CLOCK_MONOTONIC
+// ・ヒストグラムは固定メモリの log-linear（2 の冪ごとに 4 分割, 124 バケット）
+// ・RS02_INSTR_COUNT(counter, n): カウンタ
+// ・RS02Instr::dump(Serial) / handleCommand("instr" | "instr reset", Serial) でシリアル出力
+// 更新は __atomic（複数タスクから呼ばれてよい）
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#ifndef RS02_INSTR
+#define RS02_INSTR 0
+#endif
+
+namespace RS02Probe
+{
+    enum Id : uint8_t
+    {
+        BEGIN = 0,
+        SEND_EXT,
+        READ_ANY,
+        HW_SEND,
+        HW_READ,
+        READ_PARAM,
+        WRITE_PARAM,
+        OP_CONTROL,
+        MODE_ENTRY, // enter*/bringUp*/setRunMode
+        ID_CHANGE,  // setMotorId / setMotorIdViaParam
+        UI_DRAW,
+        USER0,
+        USER1,
+        COUNT
+    };
+}
+
+namespace RS02Counter
+{
+    enum Id : uint8_t
+    {
+        TX_FAIL = 0,
+        RX_FRAMES,
+        PARAM_TIMEOUT,
+        PARAM_SKIPPED, // readParamRaw 中に読み捨てた別フレーム
+        URGENT,
+        USER0,
+        USER1,
+        COUNT
+    };
+}
+
+struct RS02InstrHist
+{
+    static constexpr uint8_t BUCKETS = 124;
+    uint32_t count = 0;
+    uint32_t maxNs = 0;
+    uint64_t sumNs = 0;
+    uint32_t bucket[BUCKETS] = {};
+
+    // bucket の下限 [ns]
+    static uint32_t lowerBound(uint8_t b);
+    // 百分位点（バケット下限で返す）
+    uint32_t percentileNs(float pct) const;
+};
+
+class RS02Instr
+{
+public:
+    static bool enabled() { return RS02_INSTR != 0; }
+
+    static uint32_t nowTicks();
+    static uint32_t ticksToNs(uint32_t ticks);
+
+    static void record(RS02Probe::Id probe, uint32_t ns);
+    static void count(RS02Counter::Id c, uint32_t n = 1);
+    static void reset();
+
+    static const RS02InstrHist &hist(RS02Probe::Id probe);
+    static uint32_t counter(RS02Counter::Id c);
+    static const char *probeName(RS02Probe::Id probe);
+    static const char *counterName(RS02Counter::Id c);
+
+    // 表形式で出力（count / avg / p50 / p90 / p99 / max [us]）
+    static void dump(Print &out);
+    // "instr" = dump, "instr reset" = リセット。処理したら true
+    static bool handleCommand(const char *line, Print &out);
+};
+
+#if RS02_INSTR
+class RS02InstrScope
+{
+public:
+    explicit RS02InstrScope(RS02Probe::Id probe) : _probe(probe), _t0(RS02Instr::nowTicks()) {}
+    ~RS02InstrScope() { RS02Instr::record(_probe, RS02Instr::ticksToNs(RS02Instr::nowTicks() - _t0)); }
+
+private:
+    RS02Probe::Id _probe;
+    uint32_t _t0;
+};
+#define RS02_INSTR_CAT2(a, b) a##b
+#define RS02_INSTR_CAT(a, b) RS02_INSTR_CAT2(a, b)
+#define RS02_INSTR_SCOPE(probe) RS02InstrScope RS02_INSTR_CAT(_rs02Scope, __LINE__)(probe)
+#define RS02_INSTR_COUNT(c, n) RS02Instr::count((c), (n))
+#else
+#define RS02_INSTR_SCOPE(probe) \
+    do                          \
+    {                           \
+    } while (0)
+#define RS02_INSTR_COUNT(c, n) \
+    do                         \
+    {                          \
+    } while (0)
+#endif
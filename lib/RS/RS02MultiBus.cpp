@@ -0,0 +1,435 @@
+// RS02MultiBus.cpp — モータ → バスの振り分け、グループ送信（バス交互）、バスごとの受信
+#include "RS02MultiBus.h"
+
+RS02MultiBus::RS02MultiBus()
+{
+    for (uint8_t i = 0; i < 128; i++)
+        _busOf[i] = NO_BUS;
+}
+
+int8_t RS02MultiBus::addBus(RS02PrivateBase &bus)
+{
+    if (_nBus >= RS02_MAX_BUSES)
+        return NO_BUS;
+    uint8_t idx = _nBus;
+    _tap[idx].owner = this;
+    _tap[idx].idx = idx;
+    if (!bus.addListener(&_tap[idx]))
+        return NO_BUS;
+    _bus[idx] = &bus;
+    _nBus++;
+    return (int8_t)idx;
+}
+
+void RS02MultiBus::end()
+{
+    stopTasks();
+    for (uint8_t i = 0; i < _nBus; i++)
+        _bus[i]->removeListener(&_tap[i]);
+    _nBus = 0;
+}
+
+// ===== 割り当て =====
+bool RS02MultiBus::assign(uint8_t motorId, uint8_t busIdx)
+{
+    if (motorId >= 128 || busIdx >= _nBus)
+        return false;
+    unassign(motorId);
+    _busOf[motorId] = (int8_t)busIdx;
+    _set[busIdx].add(motorId);
+    return true;
+}
+
+void RS02MultiBus::assign(const RS02MotorSet &ids, uint8_t busIdx)
+{
+    for (uint8_t id = 0; id < 128; id++)
+        if (ids.has(id))
+            assign(id, busIdx);
+}
+
+void RS02MultiBus::balance(const uint8_t *ids, uint8_t n)
+{
+    if (_nBus == 0)
+        return;
+    for (uint8_t i = 0; i < n; i++)
+        assign(ids[i], (uint8_t)(i % _nBus));
+}
+
+void RS02MultiBus::unassign(uint8_t motorId)
+{
+    if (motorId >= 128 || _busOf[motorId] == NO_BUS)
+        return;
+    _set[_busOf[motorId]].remove(motorId);
+    _busOf[motorId] = NO_BUS;
+}
+
+RS02PrivateBase *RS02MultiBus::busFor(uint8_t motorId)
+{
+    int8_t b = busIndexOf(motorId);
+    return b == NO_BUS ? nullptr : _bus[b];
+}
+
+// ===== 個別コマンド =====
+bool RS02MultiBus::ping(uint8_t id)
+{
+    RS02PrivateBase *b = busFor(id);
+    return b && b->ping(id);
+}
+bool RS02MultiBus::enable(uint8_t id)
+{
+    RS02PrivateBase *b = busFor(id);
+    return b && b->enable(id);
+}
+bool RS02MultiBus::stop(uint8_t id, bool clearFault)
+{
+    RS02PrivateBase *b = busFor(id);
+    return b && b->stop(id, clearFault);
+}
+bool RS02MultiBus::setRunMode(uint8_t id, uint8_t runMode)
+{
+    RS02PrivateBase *b = busFor(id);
+    return b && b->setRunMode(id, runMode);
+}
+bool RS02MultiBus::opControl(uint8_t id, float torqueNm, float posRad, float velRadS, float kp, float kd)
+{
+    RS02PrivateBase *b = busFor(id);
+    return b && b->opControl(id, torqueNm, posRad, velRadS, kp, kd);
+}
+bool RS02MultiBus::velocityRef(uint8_t id, float spdRadS)
+{
+    RS02PrivateBase *b = busFor(id);
+    return b && b->velocityRef(id, spdRadS);
+}
+bool RS02MultiBus::cspLocRef(uint8_t id, float posRad)
+{
+    RS02PrivateBase *b = busFor(id);
+    return b && b->cspLocRef(id, posRad);
+}
+bool RS02MultiBus::ppLocRef(uint8_t id, float posRad)
+{
+    RS02PrivateBase *b = busFor(id);
+    return b && b->ppLocRef(id, posRad);
+}
+bool RS02MultiBus::currentIqRef(uint8_t id, float iqA)
+{
+    RS02PrivateBase *b = busFor(id);
+    return b && b->currentIqRef(id, iqA);
+}
+bool RS02MultiBus::writeParamLE(uint8_t id, uint16_t index, const uint8_t valueLE[4])
+{
+    RS02PrivateBase *b = busFor(id);
+    return b && b->writeParamLE(id, index, valueLE);
+}
+bool RS02MultiBus::readFloatParam(uint8_t id, uint16_t index, float &out)
+{
+    RS02PrivateBase *b = busFor(id);
+    return b && b->readFloatParam(id, index, out);
+}
+
+// ===== グループ =====
+uint8_t RS02MultiBus::interleave(const uint8_t *ids, uint8_t n, uint8_t *order) const
+{
+    // バスごとに ids 内の出現順を保ったまま 1 台ずつ取り出す
+    uint8_t next[RS02_MAX_BUSES] = {};
+    uint8_t k = 0;
+    bool more = true;
+    while (more)
+    {
+        more = false;
+        for (uint8_t b = 0; b < _nBus; b++)
+        {
+            while (next[b] < n && busIndexOf(ids[next[b]]) != (int8_t)b)
+                next[b]++;
+            if (next[b] < n)
+            {
+                order[k++] = next[b]++;
+                more = true;
+            }
+        }
+    }
+    return k; // 未割り当ては含まない
+}
+
+uint8_t RS02MultiBus::setToIds(const RS02MotorSet &ids, uint8_t *out) const
+{
+    uint8_t n = 0;
+    for (uint8_t id = 0; id < 128; id++)
+        if (ids.has(id))
+            out[n++] = id;
+    return n;
+}
+
+uint8_t RS02MultiBus::enable(const RS02MotorSet &ids)
+{
+    uint8_t list[128], order[128];
+    uint8_t n = interleave(list, setToIds(ids, list), order);
+    uint8_t ok = 0;
+    for (uint8_t i = 0; i < n; i++)
+    {
+        ok += enable(list[order[i]]);
+        drain(list[order[i]]);
+    }
+    return ok;
+}
+
+uint8_t RS02MultiBus::stop(const RS02MotorSet &ids, bool clearFault)
+{
+    uint8_t list[128], order[128];
+    uint8_t n = interleave(list, setToIds(ids, list), order);
+    uint8_t ok = 0;
+    for (uint8_t i = 0; i < n; i++)
+    {
+        ok += stop(list[order[i]], clearFault);
+        drain(list[order[i]]);
+    }
+    return ok;
+}
+
+uint8_t RS02MultiBus::stopUrgent(const RS02MotorSet &ids, bool clearFault)
+{
+    uint8_t list[128], order[128];
+    uint8_t n = interleave(list, setToIds(ids, list), order);
+    bool flushed[RS02_MAX_BUSES] = {};
+    uint8_t ok = 0;
+    for (uint8_t i = 0; i < n; i++)
+    {
+        uint8_t id = list[order[i]];
+        uint8_t b = (uint8_t)busIndexOf(id);
+        // 破棄は各バスの最初の 1 台だけ（2 台目以降で先に積んだ Type4 を消さない）
+        if (!flushed[b])
+        {
+            flushed[b] = true;
+            ok += _bus[b]->stopUrgent(id, clearFault);
+        }
+        else
+            ok += _bus[b]->stop(id, clearFault);
+        drain(id);
+    }
+    return ok;
+}
+
+uint8_t RS02MultiBus::setRunMode(const RS02MotorSet &ids, uint8_t runMode)
+{
+    uint8_t list[128], order[128];
+    uint8_t n = interleave(list, setToIds(ids, list), order);
+    uint8_t ok = 0;
+    for (uint8_t i = 0; i < n; i++)
+    {
+        ok += setRunMode(list[order[i]], runMode);
+        drain(list[order[i]]);
+    }
+    return ok;
+}
+
+uint8_t RS02MultiBus::setActiveReport(const RS02MotorSet &ids, bool enable)
+{
+    uint8_t list[128], order[128];
+    uint8_t n = interleave(list, setToIds(ids, list), order);
+    uint8_t ok = 0;
+    for (uint8_t i = 0; i < n; i++)
+    {
+        uint8_t id = list[order[i]];
+        ok += _bus[busIndexOf(id)]->setActiveReport(id, enable);
+        drain(id);
+    }
+    return ok;
+}
+
+uint8_t RS02MultiBus::opControl(const uint8_t *ids, const RS02OpCmd *cmd, uint8_t n)
+{
+    uint8_t order[128];
+    if (n > 128)
+        n = 128;
+    uint8_t m = interleave(ids, n, order);
+    uint8_t ok = 0;
+    for (uint8_t i = 0; i < m; i++)
+    {
+        const RS02OpCmd &c = cmd[order[i]];
+        ok += opControl(ids[order[i]], c.torqueNm, c.posRad, c.velRadS, c.kp, c.kd);
+        drain(ids[order[i]]);
+    }
+    return ok;
+}
+
+uint8_t RS02MultiBus::velocityRef(const uint8_t *ids, const float *spdRadS, uint8_t n)
+{
+    uint8_t order[128];
+    if (n > 128)
+        n = 128;
+    uint8_t m = interleave(ids, n, order);
+    uint8_t ok = 0;
+    for (uint8_t i = 0; i < m; i++)
+    {
+        ok += velocityRef(ids[order[i]], spdRadS[order[i]]);
+        drain(ids[order[i]]);
+    }
+    return ok;
+}
+
+uint8_t RS02MultiBus::cspLocRef(const uint8_t *ids, const float *posRad, uint8_t n)
+{
+    uint8_t order[128];
+    if (n > 128)
+        n = 128;
+    uint8_t m = interleave(ids, n, order);
+    uint8_t ok = 0;
+    for (uint8_t i = 0; i < m; i++)
+    {
+        ok += cspLocRef(ids[order[i]], posRad[order[i]]);
+        drain(ids[order[i]]);
+    }
+    return ok;
+}
+
+uint8_t RS02MultiBus::currentIqRef(const uint8_t *ids, const float *iqA, uint8_t n)
+{
+    uint8_t order[128];
+    if (n > 128)
+        n = 128;
+    uint8_t m = interleave(ids, n, order);
+    uint8_t ok = 0;
+    for (uint8_t i = 0; i < m; i++)
+    {
+        ok += currentIqRef(ids[order[i]], iqA[order[i]]);
+        drain(ids[order[i]]);
+    }
+    return ok;
+}
+
+// ===== 受信 =====
+// グループ送信の 1 台ごとに、そのバスの受信を読む（MCP2515 の受信 2 面 / TWAI の受信キューを送信中にあふれさせない）
+void RS02MultiBus::drain(uint8_t motorId)
+{
+    RS02PrivFrame f;
+    RS02PrivateBase *b = busFor(motorId);
+    if (b)
+        while (b->readAny(f))
+            ;
+}
+
+bool RS02MultiBus::readAny(RS02PrivFrame &out, uint8_t *busIdx)
+{
+    for (uint8_t k = 0; k < _nBus; k++)
+    {
+        uint8_t b = (uint8_t)((_rr + k) % _nBus);
+        if (_bus[b]->readAny(out))
+        {
+            _rr = (uint8_t)((b + 1) % _nBus); // 次は隣のバスから（1 本に偏らない）
+            if (busIdx)
+                *busIdx = b;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t RS02MultiBus::service()
+{
+    RS02PrivFrame f;
+    uint32_t n = 0;
+    for (uint8_t b = 0; b < _nBus; b++)
+        while (_bus[b]->readAny(f))
+            n++;
+    return n;
+}
+
+void RS02MultiBus::onRx(uint8_t idx, const RS02PrivFrame &f)
+{
+    RS02MultiBusStats &s = _stats[idx];
+    s.rxFrames++;
+    if (!f.isExt)
+        return;
+    // 応答の送り元は bit8-15
+    uint8_t src = (uint8_t)((f.id >> 8) & 0xFF);
+    if (src < 128 && _busOf[src] != NO_BUS && _busOf[src] != (int8_t)idx)
+        s.stray++;
+    RS02Feedback fb;
+    if (!_bus[idx]->parseFeedback(f, fb) || fb.motorId >= 128)
+        return;
+    s.feedback++;
+    // 担当バスで受けたものだけ残す（feedback() は担当バスの排他で読む。別のバスの排他では書かない）
+    if (_busOf[fb.motorId] != (int8_t)idx)
+        return;
+    _fb[fb.motorId] = fb;
+    uint32_t now = micros();
+    _fbUs[fb.motorId] = now ? now : 1;
+}
+
+void RS02MultiBus::onTx(uint8_t idx, const RS02PrivFrame &f, bool ok)
+{
+    (void)f;
+    RS02MultiBusStats &s = _stats[idx];
+    if (ok)
+        s.txFrames++;
+    else
+        s.txFail++;
+}
+
+bool RS02MultiBus::feedback(uint8_t id, RS02Feedback &out, uint32_t *ageUs)
+{
+    RS02PrivateBase *b = busFor(id);
+    if (!b)
+        return false;
+    RS02BusGuard g(*b);
+    if (_fbUs[id] == 0)
+        return false;
+    out = _fb[id];
+    if (ageUs)
+        *ageUs = micros() - _fbUs[id];
+    return true;
+}
+
+void RS02MultiBus::resetStats()
+{
+    for (uint8_t b = 0; b < _nBus; b++)
+    {
+        RS02BusGuard g(*_bus[b]);
+        _stats[b] = RS02MultiBusStats();
+    }
+}
+
+// ===== Task =====
+bool RS02MultiBus::startTasks(uint32_t periodMs, int core, UBaseType_t prio)
+{
+    _periodMs = periodMs ? periodMs : 1;
+    for (uint8_t b = 0; b < _nBus; b++)
+    {
+        TaskCtx &t = _task[b];
+        if (t.slot.running())
+            continue;
+        t.owner = this;
+        t.idx = b;
+        if (!t.slot.start(taskEntry, "rs02_bus", &t, prio, core))
+        {
+            stopTasks();
+            return false;
+        }
+    }
+    return true;
+}
+
+void RS02MultiBus::stopTasks()
+{
+    // 全部に要求してから待つ
+    for (uint8_t b = 0; b < RS02_MAX_BUSES; b++)
+        if (_task[b].slot.running())
+            _task[b].slot.requestStop();
+    for (uint8_t b = 0; b < RS02_MAX_BUSES; b++)
+        _task[b].slot.join();
+}
+
+void RS02MultiBus::taskEntry(void *arg)
+{
+    TaskCtx *t = static_cast<TaskCtx *>(arg);
+    RS02MultiBus *self = t->owner;
+    RS02PrivateBase *bus = self->_bus[t->idx];
+    TickType_t last = xTaskGetTickCount();
+    RS02PrivFrame f;
+    while (!t->slot.stopRequested())
+    {
+        while (bus->readAny(f))
+            ;
+        vTaskDelayUntil(&last, pdMS_TO_TICKS(self->_periodMs));
+    }
+    t->slot.exit();
+}
@@ -0,0 +1,139 @@
+#pragma once
+// RS02MultiBus.h — 複数の CAN バス（MCP2515 x2, TWAI + MCP2515 など）にモータを振り分けて使う
+// ・モータ ID → バスの表で、個別コマンドは担当バスへ、応答はバスごとに受けて最新の Type2 を保持
+// ・グループ API はバスを交互に送る（片方のバスの送信待ちで、もう片方を遊ばせない）
+// ・service() で全バスの受信 / 送信キューを回す。startTasks() ならバスごとの専用タスク
+// 各バスで送信キュー（setTxQueue）を有効にすると、送信完了を待たずに次のバスへ進める（MCP2515 は setTxWait(0)）。
+// 故障監視 / デッドライン監視などはバスごとに付ける（bus(i) を渡す）。
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "RS02PrivateBase.h"
+#include "RS02Task.h"
+
+#ifndef RS02_MAX_BUSES
+#define RS02_MAX_BUSES 4
+#endif
+
+// Type1 の 1 台分
+struct RS02OpCmd
+{
+    float torqueNm = 0.0f;
+    float posRad = 0.0f;
+    float velRadS = 0.0f;
+    float kp = 0.0f;
+    float kd = 0.0f;
+};
+
+struct RS02MultiBusStats
+{
+    uint32_t txFrames = 0;
+    uint32_t txFail = 0;
+    uint32_t rxFrames = 0;
+    uint32_t feedback = 0; // Type2
+    uint32_t stray = 0;    // 別のバスに割り当てたモータからの応答（配線 / 割り当て違い）
+};
+
+class RS02MultiBus
+{
+public:
+    static constexpr int8_t NO_BUS = -1;
+
+    RS02MultiBus();
+    ~RS02MultiBus() { end(); }
+
+    // バスを登録（begin() 済みのもの）。戻り値はバス番号（失敗時 NO_BUS）
+    int8_t addBus(RS02PrivateBase &bus);
+    void end();
+
+    // 割り当て（未割り当てのモータへのコマンドは false）
+    bool assign(uint8_t motorId, uint8_t busIdx);
+    void assign(const RS02MotorSet &ids, uint8_t busIdx);
+    // ids を台数が均等になるように各バスへ順に割り当てる
+    void balance(const uint8_t *ids, uint8_t n);
+    void unassign(uint8_t motorId);
+    int8_t busIndexOf(uint8_t motorId) const { return motorId < 128 ? _busOf[motorId] : NO_BUS; }
+    RS02PrivateBase *busFor(uint8_t motorId);
+    RS02PrivateBase &bus(uint8_t busIdx) { return *_bus[busIdx]; }
+    uint8_t busCount() const { return _nBus; }
+    const RS02MotorSet &motors(uint8_t busIdx) const { return _set[busIdx]; }
+
+    // ===== 個別コマンド（担当バスへ）=====
+    bool ping(uint8_t id);
+    bool enable(uint8_t id);
+    bool stop(uint8_t id, bool clearFault);
+    bool setRunMode(uint8_t id, uint8_t runMode);
+    bool opControl(uint8_t id, float torqueNm, float posRad, float velRadS, float kp, float kd);
+    bool velocityRef(uint8_t id, float spdRadS);
+    bool cspLocRef(uint8_t id, float posRad);
+    bool ppLocRef(uint8_t id, float posRad);
+    bool currentIqRef(uint8_t id, float iqA);
+    bool writeParamLE(uint8_t id, uint16_t index, const uint8_t valueLE[4]);
+    bool readFloatParam(uint8_t id, uint16_t index, float &out);
+
+    // ===== グループ（複数バスにまたがる）。戻り値は送れた台数 =====
+    // 1 台送るごとにそのバスの受信を読む（応答は listener / feedback() へ。readAny では返らない）
+    uint8_t enable(const RS02MotorSet &ids);
+    uint8_t stop(const RS02MotorSet &ids, bool clearFault);
+    uint8_t stopUrgent(const RS02MotorSet &ids, bool clearFault); // 全バスの送信待ちを破棄して Type4
+    uint8_t setRunMode(const RS02MotorSet &ids, uint8_t runMode);
+    uint8_t setActiveReport(const RS02MotorSet &ids, bool enable);
+    uint8_t opControl(const uint8_t *ids, const RS02OpCmd *cmd, uint8_t n);
+    uint8_t velocityRef(const uint8_t *ids, const float *spdRadS, uint8_t n);
+    uint8_t cspLocRef(const uint8_t *ids, const float *posRad, uint8_t n);
+    uint8_t currentIqRef(const uint8_t *ids, const float *iqA, uint8_t n);
+
+    // ===== 受信 =====
+    // バスを順に見て 1 フレーム（busIdx に受けたバス）。最新 Type2 の保持は readAny / service / タスクのどれでも
+    bool readAny(RS02PrivFrame &out, uint8_t *busIdx = nullptr);
+    // 全バスの受信を読み捨てる（送信キューも回る）。戻り値は読んだフレーム数
+    uint32_t service();
+    // バスごとの受信タスク（periodMs ごとに読み切る）
+    bool startTasks(uint32_t periodMs = 1, int core = 0, UBaseType_t prio = 5);
+    void stopTasks();
+
+    // 最新の Type2（ageUs: 受信からの経過）
+    bool feedback(uint8_t id, RS02Feedback &out, uint32_t *ageUs = nullptr);
+    uint32_t feedbackUs(uint8_t id) const { return id < 128 ? _fbUs[id] : 0; } // 受信時刻（micros, 0=未受信）
+
+    const RS02MultiBusStats &stats(uint8_t busIdx) const { return _stats[busIdx]; }
+    void resetStats();
+
+private:
+    // バスごとの送受信タップ（どのバスのフレームか分かるように 1 バス 1 つ）
+    class Tap : public RS02FrameListener
+    {
+    public:
+        RS02MultiBus *owner = nullptr;
+        uint8_t idx = 0;
+        void onRxFrame(const RS02PrivFrame &f) override { owner->onRx(idx, f); }
+        void onTxFrame(const RS02PrivFrame &f, bool ok) override { owner->onTx(idx, f, ok); }
+    };
+    struct TaskCtx
+    {
+        RS02MultiBus *owner = nullptr;
+        uint8_t idx = 0;
+        RS02TaskSlot slot;
+    };
+
+    RS02PrivateBase *_bus[RS02_MAX_BUSES] = {};
+    Tap _tap[RS02_MAX_BUSES];
+    TaskCtx _task[RS02_MAX_BUSES];
+    RS02MotorSet _set[RS02_MAX_BUSES];
+    RS02MultiBusStats _stats[RS02_MAX_BUSES];
+    uint8_t _nBus = 0;
+    uint8_t _rr = 0; // readAny の開始バス
+    int8_t _busOf[128];
+    RS02Feedback _fb[128];
+    uint32_t _fbUs[128] = {};
+    uint32_t _periodMs = 1;
+
+    void onRx(uint8_t idx, const RS02PrivFrame &f);
+    void onTx(uint8_t idx, const RS02PrivFrame &f, bool ok);
+    // ids を バス0, バス1, … の順に 1 台ずつ交互に並べ替える（order に ids の添字）
+    uint8_t interleave(const uint8_t *ids, uint8_t n, uint8_t *order) const;
+    uint8_t setToIds(const RS02MotorSet &ids, uint8_t *out) const;
+    void drain(uint8_t motorId);
+    static void taskEntry(void *arg);
+};
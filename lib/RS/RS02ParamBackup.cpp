@@ -0,0 +1,690 @@
+// RS02ParamBackup.cpp — index 表、スナップショットの符号化（CRC32 付き）、Type17 / Type18 / Type22 を重ねて送る dump / restore
+#include "RS02ParamBackup.h"
+
+// ===== 表 =====
+bool RS02ParamList::add(uint16_t index, RS02ParamType type, bool restore)
+{
+    if (find(index))
+        return true;
+    if (_n >= RS02_PARAM_MAX)
+        return false;
+    _s[_n++] = RS02ParamSpec{index, type, restore};
+    return true;
+}
+
+uint16_t RS02ParamList::addRange(uint16_t first, uint16_t last, RS02ParamType type, bool restore)
+{
+    uint16_t n = 0;
+    for (uint32_t i = first; i <= last; i++)
+    {
+        if (find((uint16_t)i))
+            continue;
+        if (!add((uint16_t)i, type, restore))
+            break;
+        n++;
+    }
+    return n;
+}
+
+const RS02ParamSpec *RS02ParamList::find(uint16_t index) const
+{
+    for (uint16_t i = 0; i < _n; i++)
+        if (_s[i].index == index)
+            return &_s[i];
+    return nullptr;
+}
+
+RS02ParamList RS02ParamList::standard()
+{
+    using T = RS02ParamType;
+    RS02ParamList l;
+    // 設定（書き戻す）
+    l.add(RS02Idx::RUN_MODE, T::U8);
+    l.add(RS02Idx::LIMIT_TORQUE, T::F32);
+    l.add(RS02Idx::LIMIT_SPD, T::F32);
+    l.add(RS02Idx::LIMIT_CUR, T::F32);
+    l.add(RS02Idx::CUR_KP, T::F32);
+    l.add(RS02Idx::CUR_KI, T::F32);
+    l.add(RS02Idx::SPD_KP, T::F32);
+    l.add(RS02Idx::SPD_KI, T::F32);
+    l.add(RS02Idx::LOC_KP, T::F32);
+    l.add(RS02Idx::ACC_RAD, T::F32);
+    l.add(RS02Idx::LIMIT_CUR_OLD, T::F32);
+    l.add(RS02Idx::CAN_MASTER, T::U16);
+    l.add(RS02Idx::IDX_EPSCAN_TIME, T::U16);
+    // 読むだけ: 指令値（書き戻すと動き出す）/ センサ値 / ID（ID は RS02Commission で）
+    l.add(RS02Idx::IQ_REF, T::F32, false);
+    l.add(RS02Idx::SPD_REF, T::F32, false);
+    l.add(RS02Idx::LOC_REF, T::F32, false);
+    l.add(RS02Idx::MECH_POS, T::F32, false);
+    l.add(RS02Idx::MECH_VEL, T::F32, false);
+    l.add(RS02Idx::IDX_ROTATION, T::F32, false);
+    l.add(RS02Idx::IDX_MODPOS, T::F32, false);
+    l.add(RS02Idx::IDX_MECH_ANGLE_ROT, T::F32, false);
+    l.add(RS02Idx::CAN_ID, T::U8, false);
+    return l;
+}
+
+// ===== スナップショット =====
+bool RS02ParamValue::sameValue(const uint8_t other[4]) const
+{
+    uint8_t w = type == RS02ParamType::U8 ? 1 : type == RS02ParamType::U16 ? 2 : 4;
+    return memcmp(v, other, w) == 0;
+}
+
+const RS02ParamValue *RS02ParamMotor::find(uint16_t index) const
+{
+    for (uint16_t i = 0; i < n; i++)
+        if (p[i].index == index)
+            return &p[i];
+    return nullptr;
+}
+
+const RS02ParamMotor *RS02ParamSnapshot::findUid(uint64_t uid) const
+{
+    for (uint8_t i = 0; i < _n; i++)
+        if (_m[i].uid == uid)
+            return &_m[i];
+    return nullptr;
+}
+
+RS02ParamMotor *RS02ParamSnapshot::addMotor(uint64_t uid, uint8_t id)
+{
+    if (_n >= RS02_PARAM_MOTORS)
+        return nullptr;
+    RS02ParamMotor &m = _m[_n++];
+    m.uid = uid;
+    m.id = id;
+    m.fw = 0;
+    m.n = 0;
+    return &m;
+}
+
+uint32_t RS02ParamSnapshot::crc32(const uint8_t *p, size_t n, uint32_t crc)
+{
+    // CRC-32（IEEE, 反転あり）。表を持たないビットごとの計算（数 KB なので十分）
+    crc = ~crc;
+    while (n--)
+    {
+        crc ^= *p++;
+        for (uint8_t b = 0; b < 8; b++)
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1)));
+    }
+    return ~crc;
+}
+
+static constexpr size_t SNAP_HEAD = 8, SNAP_MOTOR = 16, SNAP_ENTRY = 8, SNAP_CRC = 4;
+
+static void putLE(uint8_t *p, uint64_t v, uint8_t n)
+{
+    for (uint8_t i = 0; i < n; i++)
+        p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint64_t getLE(const uint8_t *p, uint8_t n)
+{
+    uint64_t v = 0;
+    for (uint8_t i = 0; i < n; i++)
+        v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+size_t RS02ParamSnapshot::encodedSize() const
+{
+    size_t n = SNAP_HEAD + SNAP_CRC;
+    for (uint8_t i = 0; i < _n; i++)
+        n += SNAP_MOTOR + (size_t)_m[i].n * SNAP_ENTRY;
+    return n;
+}
+
+size_t RS02ParamSnapshot::encode(uint8_t *buf, size_t cap) const
+{
+    size_t need = encodedSize();
+    if (!buf || cap < need)
+        return 0;
+    uint8_t *p = buf;
+    p[0] = 'R';
+    p[1] = 'S';
+    p[2] = 'P';
+    p[3] = 'B';
+    p[4] = VERSION;
+    p[5] = _n;
+    p[6] = p[7] = 0;
+    p += SNAP_HEAD;
+    for (uint8_t i = 0; i < _n; i++)
+    {
+        const RS02ParamMotor &m = _m[i];
+        putLE(p, m.uid, 8);
+        putLE(p + 8, m.fw, 4);
+        p[12] = m.id;
+        p[13] = 0;
+        putLE(p + 14, m.n, 2);
+        p += SNAP_MOTOR;
+        for (uint16_t k = 0; k < m.n; k++)
+        {
+            const RS02ParamValue &v = m.p[k];
+            putLE(p, v.index, 2);
+            p[2] = (uint8_t)v.type;
+            p[3] = v.restore ? 1 : 0;
+            memcpy(p + 4, v.v, 4);
+            p += SNAP_ENTRY;
+        }
+    }
+    putLE(p, crc32(buf, (size_t)(p - buf)), 4);
+    return need;
+}
+
+bool RS02ParamSnapshot::decode(const uint8_t *buf, size_t len)
+{
+    _n = 0;
+    if (!buf || len < SNAP_HEAD + SNAP_CRC || memcmp(buf, "RSPB", 4) != 0 || buf[4] != VERSION)
+        return false;
+    if (crc32(buf, len - SNAP_CRC) != (uint32_t)getLE(buf + len - SNAP_CRC, 4))
+        return false;
+    uint8_t nm = buf[5];
+    if (nm > RS02_PARAM_MOTORS)
+        return false;
+    const uint8_t *p = buf + SNAP_HEAD, *end = buf + len - SNAP_CRC;
+    for (uint8_t i = 0; i < nm; i++)
+    {
+        if ((size_t)(end - p) < SNAP_MOTOR)
+            break;
+        RS02ParamMotor &m = _m[i];
+        m.uid = getLE(p, 8);
+        m.fw = (uint32_t)getLE(p + 8, 4);
+        m.id = p[12];
+        m.n = (uint16_t)getLE(p + 14, 2);
+        p += SNAP_MOTOR;
+        if (m.n > RS02_PARAM_MAX || (size_t)(end - p) < (size_t)m.n * SNAP_ENTRY)
+            break;
+        for (uint16_t k = 0; k < m.n; k++)
+        {
+            RS02ParamValue &v = m.p[k];
+            v.index = (uint16_t)getLE(p, 2);
+            v.type = (RS02ParamType)(p[2] & 3);
+            v.restore = (p[3] & 1) != 0;
+            memcpy(v.v, p + 4, 4);
+            p += SNAP_ENTRY;
+        }
+        _n++;
+    }
+    if (_n != nm || p != end)
+    {
+        _n = 0;
+        return false;
+    }
+    return true;
+}
+
+void RS02ParamSnapshot::print(Print &out) const
+{
+    out.printf("snapshot v%u: %u motor(s), %u bytes\n", VERSION, _n, (unsigned)encodedSize());
+    for (uint8_t i = 0; i < _n; i++)
+    {
+        const RS02ParamMotor &m = _m[i];
+        out.printf("  id 0x%02X uid %08lX%08lX fw %08lX  %u param(s)\n", m.id, (unsigned long)(m.uid >> 32),
+                   (unsigned long)(uint32_t)m.uid, (unsigned long)m.fw, m.n);
+        for (uint16_t k = 0; k < m.n; k++)
+        {
+            const RS02ParamValue &v = m.p[k];
+            out.printf("    %04X %c ", v.index, v.restore ? 'w' : 'r');
+            if (v.type == RS02ParamType::F32)
+                out.printf("%g\n", (double)v.f());
+            else
+                out.printf("%lu\n", (unsigned long)v.u());
+        }
+    }
+}
+
+// ===== dump / restore =====
+uint8_t RS02ParamBackup::prepare(const RS02ParamBackupConfig &cfg)
+{
+    _cfg = cfg;
+    _cfg.scan.readInfo = false;
+    _stats = RS02ParamBackupStats();
+    _nk = 0;
+    memset(_kOf, 0xFF, sizeof(_kOf));
+    uint32_t t0 = micros();
+    uint8_t n = _scan.scan(_cfg.scan);
+    _stats.scanUs = micros() - t0;
+    return n;
+}
+
+uint8_t RS02ParamBackup::addTarget(uint8_t id)
+{
+    uint8_t k = _nk++;
+    _id[k] = id;
+    _kOf[id] = k;
+    _nIdx[k] = 0;
+    _ackWait[k] = false;
+    return k;
+}
+
+bool RS02ParamBackup::begin()
+{
+    return _bus.addListener(this);
+}
+
+void RS02ParamBackup::end()
+{
+    _bus.removeListener(this);
+}
+
+uint8_t RS02ParamBackup::dump(const RS02ParamList &list, RS02ParamSnapshot &out, const RS02ParamBackupConfig &cfg)
+{
+    RS02BusGuard g(_bus);
+    uint32_t t0 = micros();
+    out.clear();
+    uint8_t found = prepare(cfg);
+    for (uint8_t i = 0; i < found; i++)
+    {
+        const RS02ScanEntry &e = _scan.entry(i);
+        if (e.conflict || !out.addMotor(e.uid, e.id))
+        {
+            _stats.skipped++; // 同じ ID に 2 台だと応答が混ざる
+            continue;
+        }
+        uint8_t k = addTarget(e.id);
+        for (uint16_t j = 0; j < list.count(); j++)
+            _idx[k][_nIdx[k]++] = list.spec(j).index;
+        if (_cfg.fwIndex && _nIdx[k] < RS02_PARAM_MAX)
+            _idx[k][_nIdx[k]++] = _cfg.fwIndex; // 最後の 1 つは FW の版
+    }
+    if (_nk && begin())
+    {
+        {
+            RS02AsyncSend async(_bus); // 送信完了を待たない（探索と同じ）
+            uint32_t t1 = micros();
+            readAll();
+            _stats.readUs = micros() - t1;
+        }
+        end();
+    }
+    for (uint8_t k = 0; k < _nk; k++)
+    {
+        RS02ParamMotor &m = out.motor(k);
+        for (uint16_t j = 0; j < _nIdx[k]; j++)
+        {
+            if (_st[k][j] == ST_ERR)
+                _stats.unsupported++;
+            if (_st[k][j] != ST_OK)
+                continue;
+            if (j >= list.count())
+            {
+                memcpy(&m.fw, _val[k][j], 4); // LE
+                continue;
+            }
+            RS02ParamValue &v = m.p[m.n++];
+            v.index = _idx[k][j];
+            v.type = list.spec(j).type;
+            v.restore = list.spec(j).restore;
+            memcpy(v.v, _val[k][j], 4);
+        }
+    }
+    _stats.motors = _nk;
+    _stats.totalUs = micros() - t0;
+    return _nk;
+}
+
+uint8_t RS02ParamBackup::restore(const RS02ParamSnapshot &snap, const RS02ParamBackupConfig &cfg)
+{
+    using R = RS02RestoreResult;
+    RS02BusGuard g(_bus);
+    uint32_t t0 = micros();
+    prepare(cfg);
+    uint8_t src[RS02_PARAM_MOTORS]; // 対象 → スナップショットのモータ
+    _nRes = snap.count();
+    for (uint8_t i = 0; i < _nRes; i++)
+    {
+        const RS02ParamMotor &m = snap.motor(i);
+        RS02RestoreItem &r = _res[i];
+        r = RS02RestoreItem();
+        r.uid = m.uid;
+        const RS02ScanEntry *e = _scan.findUid(m.uid);
+        if (!e && _cfg.matchById)
+            e = _scan.find(m.id);
+        if (!e)
+        {
+            r.result = R::NotFound;
+            continue;
+        }
+        r.id = e->id;
+        if (e->conflict || _kOf[e->id] != 0xFF)
+        {
+            r.result = R::Conflict;
+            continue;
+        }
+        uint8_t k = addTarget(e->id);
+        src[k] = i;
+        for (uint16_t j = 0; j < m.n; j++)
+            if (m.p[j].restore)
+                _idx[k][_nIdx[k]++] = m.p[j].index;
+    }
+    if (_nk && begin())
+    {
+        {
+            RS02AsyncSend async(_bus); // 送信完了を待たない（探索と同じ）
+            // 1) 今の値
+            uint32_t t1 = micros();
+            readAll();
+            _stats.readUs = micros() - t1;
+            // 2) 違う index に印（ST_WAIT = 書く）
+            for (uint8_t k = 0; k < _nk; k++)
+            {
+                RS02RestoreItem &r = _res[src[k]];
+                const RS02ParamMotor &m = snap.motor(src[k]);
+                bool replied = false;
+                for (uint16_t j = 0; j < _nIdx[k]; j++)
+                {
+                    replied |= _st[k][j] != ST_NONE;
+                    if (_st[k][j] == ST_ERR)
+                        _stats.unsupported++;
+                    if (_st[k][j] != ST_OK)
+                        continue;
+                    if (!m.find(_idx[k][j])->sameValue(_val[k][j]))
+                    {
+                        _st[k][j] = ST_WAIT;
+                        r.differ++;
+                    }
+                }
+                _stats.differ += r.differ;
+                if (!replied && _nIdx[k])
+                    r.result = R::NoReply;
+                else if (!r.differ)
+                    r.result = R::Unchanged;
+            }
+            // 3) Type18 → 4) Type22
+            t1 = micros();
+            writeAll(snap, src);
+            _stats.writeUs = micros() - t1;
+            t1 = micros();
+            if (_cfg.save)
+                saveAll(src);
+            _stats.saveUs = micros() - t1;
+            // 5) 書いた index を読み直す
+            if (_cfg.verify)
+            {
+                for (uint8_t k = 0; k < _nk; k++)
+                {
+                    uint16_t n = 0;
+                    if (_res[src[k]].result == R::Pending)
+                        for (uint16_t j = 0; j < _nIdx[k]; j++)
+                            if (_st[k][j] == ST_WAIT)
+                                _idx[k][n++] = _idx[k][j];
+                    _nIdx[k] = n;
+                }
+                t1 = micros();
+                readAll();
+                _stats.readUs += micros() - t1;
+                for (uint8_t k = 0; k < _nk; k++)
+                {
+                    const RS02ParamMotor &m = snap.motor(src[k]);
+                    for (uint16_t j = 0; j < _nIdx[k]; j++)
+                        if (_st[k][j] != ST_OK || !m.find(_idx[k][j])->sameValue(_val[k][j]))
+                        {
+                            _stats.verifyFails++;
+                            _res[src[k]].result = R::VerifyFailed;
+                        }
+                }
+            }
+        }
+        end();
+    }
+    uint8_t ok = 0;
+    for (uint8_t i = 0; i < _nRes; i++)
+    {
+        RS02RestoreItem &r = _res[i];
+        if (r.result == R::Pending)
+            r.result = R::Ok;
+        ok += r.result == R::Ok || r.result == R::Unchanged;
+    }
+    _stats.motors = _nk;
+    _stats.totalUs = micros() - t0;
+    return ok;
+}
+
+void RS02ParamBackup::pump()
+{
+    RS02PrivFrame f;
+    if (!_bus.readAny(f)) // 応答は onRxFrame で
+        delayMicroseconds(20);
+}
+
+// 全対象の _idx を Type17 で読む（RS02ParamPipeline。maxInFlight 本まで重ねる）
+void RS02ParamBackup::readAll()
+{
+    _rMax = 0;
+    for (uint8_t k = 0; k < _nk; k++)
+    {
+        memset(_st[k], ST_NONE, _nIdx[k]);
+        if (_nIdx[k] > _rMax)
+            _rMax = _nIdx[k];
+    }
+    _rk = 0;
+    _rj = 0;
+    RS02ParamPipelineConfig pc;
+    pc.maxInFlight = _cfg.maxInFlight;
+    pc.timeoutUs = _cfg.timeoutUs;
+    pc.retries = _cfg.retries;
+    _pipe.run(*this, pc);
+    _stats.reads += _pipe.stats().reads;
+    _stats.replies += _pipe.stats().replies;
+    _stats.timeouts += _pipe.stats().timeouts;
+}
+
+// 要求は index の順にモータを先に回す（同じモータへ続けない）
+bool RS02ParamBackup::nextRead(uint8_t &motorId, uint16_t &index, uint16_t &tag)
+{
+    while (_rj < _rMax)
+    {
+        uint8_t k = _rk;
+        uint16_t j = _rj;
+        if (++_rk >= _nk)
+        {
+            _rk = 0;
+            _rj++;
+        }
+        if (j < _nIdx[k])
+        {
+            motorId = _id[k];
+            index = _idx[k][j];
+            tag = j;
+            return true;
+        }
+    }
+    return false;
+}
+
+void RS02ParamBackup::onRead(uint8_t motorId, uint16_t tag, RS02ParamRead r, const uint8_t *data)
+{
+    uint8_t k = _kOf[motorId];
+    if (r == RS02ParamRead::Ok)
+    {
+        memcpy(_val[k][tag], data, 4);
+        _st[k][tag] = ST_OK;
+    }
+    else if (r == RS02ParamRead::Error)
+        _st[k][tag] = ST_ERR;
+}
+
+// ST_WAIT の index を Type18 で。1 台 1 本ずつ Type2 を待ち、モータをまたいで maxInFlight 本まで重ねる
+void RS02ParamBackup::writeAll(const RS02ParamSnapshot &snap, const uint8_t *src)
+{
+    uint16_t cur[RS02_PARAM_MOTORS] = {};
+    uint8_t tries[RS02_PARAM_MOTORS] = {};
+    bool busy[RS02_PARAM_MOTORS] = {};
+    for (;;)
+    {
+        bool left = false;
+        uint8_t inFlight = 0;
+        for (uint8_t k = 0; k < _nk; k++)
+            inFlight += busy[k];
+        for (uint8_t k = 0; k < _nk; k++)
+        {
+            RS02RestoreItem &r = _res[src[k]];
+            if (r.result != RS02RestoreResult::Pending)
+                continue;
+            if (busy[k])
+            {
+                if (_ackWait[k] && (uint32_t)(micros() - _ackUs[k]) < _cfg.timeoutUs)
+                {
+                    left = true;
+                    continue;
+                }
+                busy[k] = false;
+                inFlight--;
+                if (!_ackWait[k])
+                {
+                    // 確認が取れたので次の index へ
+                    r.written++;
+                    cur[k]++;
+                    tries[k] = 0;
+                }
+                else if (tries[k] > _cfg.retries)
+                {
+                    _ackWait[k] = false;
+                    r.result = RS02RestoreResult::NoReply;
+                    continue;
+                }
+            }
+            while (cur[k] < _nIdx[k] && _st[k][cur[k]] != ST_WAIT)
+                cur[k]++;
+            if (cur[k] >= _nIdx[k])
+                continue;
+            left = true;
+            if (inFlight >= _cfg.maxInFlight)
+                continue;
+            const RS02ParamValue *v = snap.motor(src[k]).find(_idx[k][cur[k]]);
+            tries[k]++;
+            _stats.writes++;
+            busy[k] = _ackWait[k] = true; // 送れなかったときもタイムアウトで送り直す
+            inFlight++;
+            _ackUs[k] = micros();
+            if (_bus.waitTxIdle())
+            {
+                _ackUs[k] = micros();
+                _bus.writeParamLE(_id[k], v->index, v->v);
+            }
+        }
+        if (!left)
+            return;
+        pump();
+    }
+}
+
+// 書いたモータに Type22 を 1 回ずつ（Type2 で確認）
+void RS02ParamBackup::saveAll(const uint8_t *src)
+{
+    uint8_t tries[RS02_PARAM_MOTORS] = {};
+    bool busy[RS02_PARAM_MOTORS] = {};
+    for (;;)
+    {
+        bool left = false;
+        uint8_t inFlight = 0;
+        for (uint8_t k = 0; k < _nk; k++)
+            inFlight += busy[k];
+        for (uint8_t k = 0; k < _nk; k++)
+        {
+            RS02RestoreItem &r = _res[src[k]];
+            if (r.result != RS02RestoreResult::Pending || !r.written || r.saved)
+                continue;
+            if (busy[k])
+            {
+                if (_ackWait[k] && (uint32_t)(micros() - _ackUs[k]) < _cfg.timeoutUs)
+                {
+                    left = true;
+                    continue;
+                }
+                busy[k] = false;
+                inFlight--;
+                if (!_ackWait[k])
+                {
+                    r.saved = true;
+                    continue;
+                }
+                if (tries[k] > _cfg.retries)
+                {
+                    _ackWait[k] = false;
+                    r.result = RS02RestoreResult::NoReply;
+                    continue;
+                }
+            }
+            left = true;
+            if (inFlight >= _cfg.maxInFlight)
+                continue;
+            tries[k]++;
+            _stats.saves++;
+            busy[k] = _ackWait[k] = true;
+            inFlight++;
+            _ackUs[k] = micros();
+            if (_bus.waitTxIdle())
+            {
+                _ackUs[k] = micros();
+                _bus.saveParams(_id[k]);
+            }
+        }
+        if (!left)
+            return;
+        pump();
+    }
+}
+
+void RS02ParamBackup::onRxFrame(const RS02PrivFrame &f)
+{
+    if (!f.isExt || f.dlc < 8)
+        return;
+    uint8_t type = rs02FrameType(f.id);
+    uint8_t motor = (uint8_t)((f.id >> 8) & 0xFF);
+    if (motor >= 128 || _kOf[motor] == 0xFF)
+        return;
+    uint8_t k = _kOf[motor];
+    if (type == RS02Type::FEEDBACK)
+    {
+        // Type18 / Type22 の応答（送った後に来た Type2）
+        if (_ackWait[k] && (int32_t)(f.tsUs - _ackUs[k]) >= 0)
+            _ackWait[k] = false;
+        return;
+    }
+    _pipe.onReply(f);
+}
+
+const char *RS02ParamBackup::resultName(RS02RestoreResult r)
+{
+    switch (r)
+    {
+    case RS02RestoreResult::Pending:
+        return "pending";
+    case RS02RestoreResult::Ok:
+        return "ok";
+    case RS02RestoreResult::Unchanged:
+        return "unchanged";
+    case RS02RestoreResult::NotFound:
+        return "not found";
+    case RS02RestoreResult::Conflict:
+        return "id conflict";
+    case RS02RestoreResult::NoReply:
+        return "no reply";
+    case RS02RestoreResult::VerifyFailed:
+        return "verify failed";
+    }
+    return "?";
+}
+
+void RS02ParamBackup::print(Print &out) const
+{
+    out.printf("restore: %u motor(s), %u differ, %u Type18, %u Type22 in %.1fms (scan %.1fms, read %.1fms, write %.1fms, "
+               "save %.1fms)\n",
+               _nRes, _stats.differ, _stats.writes, _stats.saves, _stats.totalUs / 1000.0f, _stats.scanUs / 1000.0f,
+               _stats.readUs / 1000.0f, _stats.writeUs / 1000.0f, _stats.saveUs / 1000.0f);
+    for (uint8_t i = 0; i < _nRes; i++)
+    {
+        const RS02RestoreItem &r = _res[i];
+        out.printf("  uid %08lX%08lX", (unsigned long)(r.uid >> 32), (unsigned long)(uint32_t)r.uid);
+        if (r.id <= 127)
+            out.printf("  id 0x%02X", r.id);
+        else
+            out.printf("  id ----");
+        out.printf("  %-13s %2u differ, %2u written%s\n", resultName(r.result), r.differ, r.written,
+                   r.saved ? ", saved" : "");
+    }
+}
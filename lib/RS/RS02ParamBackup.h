@@ -0,0 +1,237 @@
+#pragma once
+// RS02ParamBackup.h — パラメータ表のバックアップ / 復元（Type17 を重ねて読む → バイナリのスナップショット）
+// dump: 見つかったモータ（RS02Scanner）ごとに index 表を Type17 で読む。全モータ・全 index の要求を
+//       maxInFlight 本まで重ねて送り（RS02ParamPipeline）、応答は bit8-15 のモータ ID と index エコーで振り分ける。
+//       失敗応答（その FW に無い index）は記録しない。表は RS02ParamList で差し替え / 範囲で足せる
+// restore: スナップショットのモータを UID で見つけ（ID が変わっていてもよい）、今の値を読んで
+//       違う index（restore 指定のものだけ）に Type18 を重ねて送り、最後に Type22 を 1 回。読み直して確かめる
+// どちらもバスを占有する。Type18 / Type22 の確認は Type2 の応答なので、アクティブレポートは止めておくこと。
+//
+// 形式（LE, 版 1）: 'R' 'S' 'P' 'B' | 版(1) | モータ数(1) | 0(2)
+//                  モータごと: UID(8) | FW(4) | ID(1) | 0(1) | 個数(2) | 個数 x [index(2) 型(1) フラグ(1) 値(4)]
+//                  末尾に CRC32（先頭から）
+
+#include <Arduino.h>
+#include "RS02PrivateBase.h"
+#include "RS02Scanner.h"
+
+#ifndef RS02_PARAM_MAX
+#define RS02_PARAM_MAX 96 // 1 台あたりの index 数（表の上限も同じ）
+#endif
+#ifndef RS02_PARAM_MOTORS
+#define RS02_PARAM_MOTORS 16 // スナップショットに入るモータ数
+#endif
+
+enum class RS02ParamType : uint8_t
+{
+    U8 = 0,
+    U16,
+    U32,
+    F32
+};
+
+struct RS02ParamSpec
+{
+    uint16_t index;
+    RS02ParamType type;
+    bool restore; // 復元で書き戻すか（センサ値 / 指令値 / CAN_ID は false）
+};
+
+// 読む index の表
+class RS02ParamList
+{
+public:
+    void clear() { _n = 0; }
+    // 同じ index は足さない。いっぱいなら false
+    bool add(uint16_t index, RS02ParamType type, bool restore = true);
+    // first..last を全部（その FW に無い index は dump で落ちる）。足した数
+    uint16_t addRange(uint16_t first, uint16_t last, RS02ParamType type, bool restore = true);
+
+    uint16_t count() const { return _n; }
+    const RS02ParamSpec &spec(uint16_t i) const { return _s[i]; }
+    const RS02ParamSpec *find(uint16_t index) const;
+
+    // RS02Idx の index（MECH_POS などのセンサ値, 指令値, CAN_ID は読むだけ）
+    static RS02ParamList standard();
+
+private:
+    RS02ParamSpec _s[RS02_PARAM_MAX];
+    uint16_t _n = 0;
+};
+
+struct RS02ParamValue
+{
+    uint16_t index = 0;
+    RS02ParamType type = RS02ParamType::F32;
+    bool restore = false;
+    uint8_t v[4] = {}; // LE
+
+    float f() const
+    {
+        float x;
+        memcpy(&x, v, 4);
+        return x;
+    }
+    uint32_t u() const { return (uint32_t)v[0] | ((uint32_t)v[1] << 8) | ((uint32_t)v[2] << 16) | ((uint32_t)v[3] << 24); }
+    // 型の幅だけ比べる（U8 / U16 の上位バイトは見ない）
+    bool sameValue(const uint8_t other[4]) const;
+};
+
+struct RS02ParamMotor
+{
+    uint64_t uid = 0;
+    uint32_t fw = 0; // fwIndex で読んだ値（0=読んでいない）
+    uint8_t id = 0;  // dump したときの ID
+    uint16_t n = 0;
+    RS02ParamValue p[RS02_PARAM_MAX];
+
+    const RS02ParamValue *find(uint16_t index) const;
+};
+
+class RS02ParamSnapshot
+{
+public:
+    static constexpr uint8_t VERSION = 1;
+
+    void clear() { _n = 0; }
+    uint8_t count() const { return _n; }
+    const RS02ParamMotor &motor(uint8_t i) const { return _m[i]; }
+    RS02ParamMotor &motor(uint8_t i) { return _m[i]; }
+    const RS02ParamMotor *findUid(uint64_t uid) const;
+    // いっぱいなら nullptr
+    RS02ParamMotor *addMotor(uint64_t uid, uint8_t id);
+
+    // バイナリ形式（上のコメント）。encode は書いたバイト数（足りなければ 0）
+    size_t encodedSize() const;
+    size_t encode(uint8_t *buf, size_t cap) const;
+    // 印 / 版 / 長さ / CRC が合わなければ false（中身は空になる）
+    bool decode(const uint8_t *buf, size_t len);
+
+    // モータごとの index = 値
+    void print(Print &out) const;
+
+    static uint32_t crc32(const uint8_t *p, size_t n, uint32_t crc = 0);
+
+private:
+    RS02ParamMotor _m[RS02_PARAM_MOTORS];
+    uint8_t _n = 0;
+};
+
+struct RS02ParamBackupConfig
+{
+    RS02ScanConfig scan;        // 探索（readInfo は使わない）
+    uint8_t maxInFlight = 8;    // 応答待ちの上限（送信の合間に受信を読むので MCP2515 でも重ねられる）
+    uint32_t timeoutUs = 20000; // 1 要求の応答待ち
+    uint8_t retries = 1;
+    uint16_t fwIndex = 0;       // FW の版を読む index（0=読まない。実機の表に合わせる）
+    bool save = true;           // restore: 書いたモータに Type22
+    bool verify = true;         // restore: 書いた index を読み直す
+    bool matchById = false;     // restore: UID が見つからなければ同じ ID のモータへ（別の個体へ写す）
+};
+
+struct RS02ParamBackupStats
+{
+    uint32_t totalUs = 0;
+    uint32_t scanUs = 0;
+    uint32_t readUs = 0; // Type17（restore では今の値 + 読み直し）
+    uint32_t writeUs = 0;
+    uint32_t saveUs = 0;
+    uint8_t motors = 0;
+    uint16_t reads = 0; // Type17 要求（再送込み）
+    uint16_t replies = 0;
+    uint16_t unsupported = 0; // 失敗応答（その FW に無い index）
+    uint16_t timeouts = 0;
+    uint16_t differ = 0; // restore: 違っていた index
+    uint16_t writes = 0; // Type18（再送込み）
+    uint16_t saves = 0;
+    uint16_t verifyFails = 0;
+    uint8_t skipped = 0; // 同じ ID に 2 台 / 入りきらない
+};
+
+enum class RS02RestoreResult : uint8_t
+{
+    Pending = 0,
+    Ok,          // 書いて（保存して）読み直しも一致
+    Unchanged,   // 違う値が無かった
+    NotFound,    // UID（matchById なら ID も）のモータが居ない
+    Conflict,    // その ID に 2 台いる
+    NoReply,     // 読み出し / 書き込み / 保存の応答が無い
+    VerifyFailed // 読み直した値が違う（読み出し専用 / 範囲外など）
+};
+
+struct RS02RestoreItem
+{
+    uint64_t uid = 0;
+    uint8_t id = 0xFF; // 見つけた ID
+    RS02RestoreResult result = RS02RestoreResult::Pending;
+    uint16_t differ = 0;
+    uint16_t written = 0;
+    bool saved = false;
+};
+
+class RS02ParamBackup : public RS02FrameListener, public RS02ParamReader
+{
+public:
+    explicit RS02ParamBackup(RS02PrivateBase &bus) : _bus(bus), _scan(bus), _pipe(bus) {}
+
+    // 探索して見つかったモータの表を読む。戻り値は入ったモータ数
+    uint8_t dump(const RS02ParamList &list, RS02ParamSnapshot &out,
+                 const RS02ParamBackupConfig &cfg = RS02ParamBackupConfig());
+    // スナップショットへ戻す。戻り値は Ok + Unchanged のモータ数（結果は restoreItem）
+    uint8_t restore(const RS02ParamSnapshot &snap, const RS02ParamBackupConfig &cfg = RS02ParamBackupConfig());
+
+    const RS02ParamBackupStats &stats() const { return _stats; }
+    const RS02Scanner &scanner() const { return _scan; }
+    uint8_t restoreCount() const { return _nRes; }
+    const RS02RestoreItem &restoreItem(uint8_t i) const { return _res[i]; }
+    static const char *resultName(RS02RestoreResult r);
+
+    // 直前の restore のモータごとの結果と全体の時間
+    void print(Print &out) const;
+
+    void onRxFrame(const RS02PrivFrame &f) override;
+    // 表の読み出し（RS02ParamPipeline から）
+    bool nextRead(uint8_t &motorId, uint16_t &index, uint16_t &tag) override;
+    void onRead(uint8_t motorId, uint16_t tag, RS02ParamRead r, const uint8_t *data) override;
+
+private:
+    enum : uint8_t
+    {
+        ST_NONE = 0,
+        ST_OK,
+        ST_ERR,
+        ST_WAIT
+    };
+    RS02PrivateBase &_bus;
+    RS02Scanner _scan;
+    RS02ParamPipeline _pipe;
+    RS02ParamBackupConfig _cfg;
+    RS02ParamBackupStats _stats;
+    RS02RestoreItem _res[RS02_PARAM_MOTORS];
+    uint8_t _nRes = 0;
+
+    // 対象ごとの index 表と読んだ値
+    uint8_t _nk = 0;
+    uint8_t _id[RS02_PARAM_MOTORS];
+    uint8_t _kOf[128]; // ID → 対象（0xFF=なし）
+    uint16_t _nIdx[RS02_PARAM_MOTORS];
+    uint16_t _idx[RS02_PARAM_MOTORS][RS02_PARAM_MAX];
+    uint8_t _val[RS02_PARAM_MOTORS][RS02_PARAM_MAX][4];
+    uint8_t _st[RS02_PARAM_MOTORS][RS02_PARAM_MAX];
+    // readAll の次の要求（_idx[_rk][_rj]）
+    uint8_t _rk = 0;
+    uint16_t _rj = 0;
+    uint16_t _rMax = 0;
+    // Type18 / Type22 は Type2 で確認（1 台 1 本）
+    bool _ackWait[RS02_PARAM_MOTORS];
+    uint32_t _ackUs[RS02_PARAM_MOTORS];
+
+    uint8_t prepare(const RS02ParamBackupConfig &cfg);
+    bool begin();
+    void end();
+    uint8_t addTarget(uint8_t id);
+    void readAll();
+    void writeAll(const RS02ParamSnapshot &snap, const uint8_t *src);
+    void saveAll(const uint8_t *src);
+    void pump();
+};
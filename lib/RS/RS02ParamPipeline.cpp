@@ -0,0 +1,87 @@
+// RS02ParamPipeline.cpp — Type17 を重ねて送り、応答をモータ ID と index で振り分ける
+#include "RS02ParamPipeline.h"
+
+void RS02ParamPipeline::run(RS02ParamReader &reader, const RS02ParamPipelineConfig &cfg)
+{
+    RS02BusGuard g(_bus);
+    _reader = &reader;
+    _cfg = cfg;
+    if (_cfg.maxInFlight < 1)
+        _cfg.maxInFlight = 1;
+    if (_cfg.maxInFlight > RS02_PARAM_INFLIGHT)
+        _cfg.maxInFlight = RS02_PARAM_INFLIGHT;
+    _stats = RS02ParamPipelineStats();
+    _nReq = 0;
+    bool more = true;
+    while (more || _nReq)
+    {
+        while (more && _nReq < _cfg.maxInFlight)
+        {
+            // 先に積んでから送る（送信待ちのあいだに応答が来ても onReply は印を付けるだけで詰めない）
+            Req &r = _req[_nReq];
+            if (!(more = reader.nextRead(r.id, r.index, r.tag)))
+                break;
+            _nReq++;
+            r.tries = 0;
+            if (!send(r))
+            {
+                uint8_t id = r.id;
+                r.id = DONE;
+                _stats.timeouts++;
+                reader.onRead(id, r.tag, RS02ParamRead::Timeout, nullptr);
+            }
+        }
+        RS02PrivFrame f;
+        if (!_bus.readAny(f)) // 応答は持ち主の onRxFrame → onReply で
+            delayMicroseconds(20);
+        uint32_t now = micros();
+        for (uint8_t i = 0; i < _nReq;)
+        {
+            Req &r = _req[i];
+            if (r.id != DONE &&
+                ((uint32_t)(now - r.sentUs) < _cfg.timeoutUs || (r.tries <= _cfg.retries && send(r))))
+            {
+                i++;
+                continue;
+            }
+            if (r.id != DONE)
+            {
+                _stats.timeouts++;
+                reader.onRead(r.id, r.tag, RS02ParamRead::Timeout, nullptr);
+            }
+            _req[i] = _req[--_nReq];
+        }
+    }
+    _reader = nullptr;
+}
+
+bool RS02ParamPipeline::send(Req &r)
+{
+    uint8_t d[8] = {(uint8_t)(r.index & 0xFF), (uint8_t)(r.index >> 8), 0, 0, 0, 0, 0, 0};
+    unsigned long id = ((unsigned long)RS02Type::READ_PARAM << 24) | ((unsigned long)_bus.masterId() << 16) | r.id;
+    r.tries++;
+    r.sentUs = micros();
+    _stats.reads++;
+    return _bus.waitTxIdle() && _bus.sendExt(id, d, 8);
+}
+
+void RS02ParamPipeline::onReply(const RS02PrivFrame &f)
+{
+    if (!_reader || !f.isExt || f.dlc < 8 || rs02FrameType(f.id) != RS02Type::READ_PARAM)
+        return;
+    uint8_t motor = (uint8_t)((f.id >> 8) & 0xFF);
+    uint16_t index = (uint16_t)f.data[0] | ((uint16_t)f.data[1] << 8);
+    for (uint8_t i = 0; i < _nReq; i++)
+    {
+        Req &r = _req[i];
+        if (r.id != motor || r.index != index)
+            continue;
+        _stats.replies++;
+        r.id = DONE; // 詰めるのは run で
+        if ((f.id >> 16) & 0xFF) // bit16-23: 0=成功
+            _reader->onRead(motor, r.tag, RS02ParamRead::Error, nullptr);
+        else
+            _reader->onRead(motor, r.tag, RS02ParamRead::Ok, &f.data[4]);
+        return;
+    }
+}
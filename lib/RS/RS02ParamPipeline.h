@@ -0,0 +1,77 @@
+#pragma once
+// RS02ParamPipeline.h — Type17 の読み出しを重ねて送る（RS02Scanner の情報 / RS02ParamBackup の表で共用）
+// 要求は RS02ParamReader::nextRead から順に取り、応答を待たずに maxInFlight 本まで送る。
+// 応答は bit8-15 のモータ ID と index エコーで振り分け（持ち主の onRxFrame から onReply を呼ぶ）、
+// timeoutUs を過ぎたら retries 回まで送り直す。バスを占有し、RS02AsyncSend の内側で使う
+
+#include <Arduino.h>
+#include "RS02PrivateBase.h"
+
+#ifndef RS02_PARAM_INFLIGHT
+#define RS02_PARAM_INFLIGHT 16 // maxInFlight の上限
+#endif
+
+enum class RS02ParamRead : uint8_t
+{
+    Ok = 0,
+    Error,  // 失敗応答（未知 index など）
+    Timeout // 応答なし（送れなかったときも）
+};
+
+struct RS02ParamPipelineConfig
+{
+    uint8_t maxInFlight = 2; // 応答待ちの上限
+    uint32_t timeoutUs = 20000;
+    uint8_t retries = 1;
+};
+
+struct RS02ParamPipelineStats
+{
+    uint16_t reads = 0; // 要求（再送込み）
+    uint16_t replies = 0;
+    uint16_t timeouts = 0;
+};
+
+// 読む (モータ ID, index) の列と結果の受け取り先
+class RS02ParamReader
+{
+public:
+    virtual ~RS02ParamReader() {}
+    // 次の要求（tag は結果に付けて返す）。false: もう無い
+    virtual bool nextRead(uint8_t &motorId, uint16_t &index, uint16_t &tag) = 0;
+    // 結果（data は Ok のときだけ, LE 4byte）。応答は受信の中から呼ぶ
+    virtual void onRead(uint8_t motorId, uint16_t tag, RS02ParamRead r, const uint8_t *data) = 0;
+};
+
+class RS02ParamPipeline
+{
+public:
+    explicit RS02ParamPipeline(RS02PrivateBase &bus) : _bus(bus) {}
+
+    // reader の要求が尽きて応答もそろう（タイムアウトする）まで。stats() は呼ぶたびに 0 から
+    void run(RS02ParamReader &reader, const RS02ParamPipelineConfig &cfg);
+    // 受信フレーム（Type17 応答以外は無視）
+    void onReply(const RS02PrivFrame &f);
+    const RS02ParamPipelineStats &stats() const { return _stats; }
+
+private:
+    struct Req
+    {
+        uint8_t id;
+        uint8_t tries;
+        uint16_t index;
+        uint16_t tag;
+        uint32_t sentUs;
+    };
+
+    static constexpr uint8_t DONE = 0xFF; // Req::id: 応答済み（run が詰める）
+
+    RS02PrivateBase &_bus;
+    RS02ParamReader *_reader = nullptr;
+    RS02ParamPipelineConfig _cfg;
+    RS02ParamPipelineStats _stats;
+    Req _req[RS02_PARAM_INFLIGHT];
+    uint8_t _nReq = 0;
+
+    bool send(Req &r);
+};
@@ -0,0 +1,609 @@
+// RS02PrivateBase.cpp — プロトコル本体（Type17応答dstを緩和: targetIdもOK / mechPos=0x7019, mechVel=0x701B）
+#include "RS02PrivateBase.h"
+#include "RS02Instr.h"
+#include <math.h>
+
+// ===== Listener =====
+bool RS02PrivateBase::addListener(RS02FrameListener *l)
+{
+    RS02BusGuard g(*this);
+    if (!l || _nListeners >= RS02_MAX_LISTENERS)
+        return false;
+    for (uint8_t i = 0; i < _nListeners; i++)
+        if (_listeners[i] == l)
+            return true;
+    _listeners[_nListeners++] = l;
+    return true;
+}
+void RS02PrivateBase::removeListener(RS02FrameListener *l)
+{
+    RS02BusGuard g(*this);
+    for (uint8_t i = 0; i < _nListeners; i++)
+    {
+        if (_listeners[i] != l)
+            continue;
+        for (uint8_t j = i + 1; j < _nListeners; j++)
+            _listeners[j - 1] = _listeners[j];
+        _listeners[--_nListeners] = nullptr;
+        return;
+    }
+}
+void RS02PrivateBase::notifyTx(unsigned long id, const uint8_t *payload, uint8_t len, bool ok)
+{
+    if (_nListeners == 0)
+        return;
+    RS02PrivFrame f;
+    f.id = id;
+    f.dlc = len > 8 ? 8 : len;
+    memcpy(f.data, payload, f.dlc);
+    f.isExt = true;
+    f.tsUs = micros();
+    if (ok)
+    {
+        // 完了待ちに積む（listener が送る前に。溢れたら古い方を黙って捨てる: 未完了数は HW が数えているので位置はずれない）
+        if (_txdCount >= RS02_TXDONE_DEPTH)
+        {
+            _txdHead = (uint8_t)((_txdHead + 1) % RS02_TXDONE_DEPTH);
+            _txdCount--;
+        }
+        TxDoneSlot &s = _txd[(_txdHead + _txdCount) % RS02_TXDONE_DEPTH];
+        s.id = (uint32_t)id;
+        s.len = f.dlc;
+        memcpy(s.data, f.data, f.dlc);
+        _txdCount++;
+    }
+    for (uint8_t i = 0; i < _nListeners; i++)
+        _listeners[i]->onTxFrame(f, ok);
+    if (ok)
+        txDonePoll();
+}
+void RS02PrivateBase::notifyTxDone(const TxDoneSlot &s, bool ok)
+{
+    RS02PrivFrame f;
+    f.id = s.id;
+    f.dlc = s.len;
+    memcpy(f.data, s.data, s.len);
+    f.isExt = true;
+    f.tsUs = micros();
+    for (uint8_t i = 0; i < _nListeners; i++)
+        _listeners[i]->onTxDone(f, ok);
+}
+void RS02PrivateBase::txDonePoll()
+{
+    // 1 つ取り出してから通知（listener が送ると後ろに積まれる）
+    while (_txdCount && _txdCount > hwTxPending())
+    {
+        TxDoneSlot s = _txd[_txdHead];
+        _txdHead = (uint8_t)((_txdHead + 1) % RS02_TXDONE_DEPTH);
+        _txdCount--;
+        notifyTxDone(s, true);
+    }
+}
+void RS02PrivateBase::txDoneDrop()
+{
+    uint16_t pending = hwTxPending();
+    while (_txdCount > pending)
+    {
+        _txdCount--;
+        TxDoneSlot s = _txd[(_txdHead + _txdCount) % RS02_TXDONE_DEPTH];
+        notifyTxDone(s, false);
+    }
+}
+void RS02PrivateBase::notifyRxLost(uint32_t n)
+{
+    uint32_t t = micros();
+    for (uint8_t i = 0; i < _nListeners; i++)
+        _listeners[i]->onRxLost(n, t);
+}
+
+// ===== 低レベル =====
+bool RS02PrivateBase::sendExt(unsigned long id, const uint8_t *payload, uint8_t len)
+{
+    RS02_INSTR_SCOPE(RS02Probe::SEND_EXT);
+    RS02BusGuard g(*this);
+    if (_txqCount || _txInflight)
+        txqOnDirectSend(id, payload, len);
+    bool ok = hwSend(id, payload, len);
+    if (!ok)
+        RS02_INSTR_COUNT(RS02Counter::TX_FAIL, 1);
+    notifyTx(id, payload, len, ok);
+    return ok;
+}
+bool RS02PrivateBase::sendUrgent(unsigned long id, const uint8_t *payload, uint8_t len)
+{
+    RS02BusGuard g(*this);
+    RS02_INSTR_COUNT(RS02Counter::URGENT, 1);
+    txqClear();
+    txDonePoll();
+    hwFlushTx();
+    txDoneDrop();
+    return sendExt(id, payload, len);
+}
+bool RS02PrivateBase::canStatus(RS02CanStatus &out)
+{
+    RS02BusGuard g(*this);
+    out = RS02CanStatus();
+    return hwStatus(out);
+}
+bool RS02PrivateBase::recoverBus()
+{
+    RS02BusGuard g(*this);
+    return hwRecover();
+}
+bool RS02PrivateBase::readAny(RS02PrivFrame &out)
+{
+    RS02_INSTR_SCOPE(RS02Probe::READ_ANY);
+    RS02BusGuard g(*this);
+    pumpTx();
+    if (_txdCount)
+        txDonePoll();
+    out.tsUs = 0;
+    if (!hwRead(out))
+        return false;
+    RS02_INSTR_COUNT(RS02Counter::RX_FRAMES, 1);
+    if (out.dlc > 8) // バックエンドに依らず data[8] の範囲に
+        out.dlc = 8;
+    if (out.tsUs == 0)
+        out.tsUs = micros();
+    if (_pw.active && !_pw.got)
+        matchParamReply(out);
+    for (uint8_t i = 0; i < _nListeners; i++)
+        _listeners[i]->onRxFrame(out);
+    return true;
+}
+
+// ===== Type0/3/4 =====
+bool RS02PrivateBase::ping(uint8_t targetId)
+{
+    uint8_t d[8] = {0};
+    auto id = buildExId(0x00, da2_master(), targetId);
+    return sendExt(id, d, 8);
+}
+bool RS02PrivateBase::enable(uint8_t targetId)
+{
+    uint8_t d[8] = {0};
+    auto id = buildExId(0x03, da2_master(), targetId);
+    return sendExt(id, d, 8);
+}
+bool RS02PrivateBase::stop(uint8_t targetId, bool clearFault)
+{
+    uint8_t d[8] = {0};
+    if (clearFault)
+    {
+        d[0] = 0x00;
+        d[1] = 0x01;
+    }
+    auto id = buildExId(0x04, da2_master(), targetId);
+    return sendExt(id, d, 8);
+}
+bool RS02PrivateBase::stopUrgent(uint8_t targetId, bool clearFault)
+{
+    uint8_t d[8] = {0};
+    if (clearFault)
+    {
+        d[0] = 0x00;
+        d[1] = 0x01;
+    }
+    auto id = buildExId(0x04, da2_master(), targetId);
+    return sendUrgent(id, d, 8);
+}
+
+bool RS02PrivateBase::setMotorId(uint8_t currentId, uint8_t newId)
+{
+    RS02_INSTR_SCOPE(RS02Probe::ID_CHANGE);
+    // Type7: mode=0x07, DataArea2 = [newId:high][hostId:low], dst=currentId
+    uint8_t d[8] = {0};
+    auto id = buildExId(0x07, ((uint16_t)newId << 8) | _hostId, currentId);
+    return sendExt(id, d, 8);
+}
+
+bool RS02PrivateBase::saveParams(uint8_t targetId)
+{
+    // Type22: 保存。データ内容は仕様上ダミーでOK（01..08を送る例）
+    uint8_t d[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    auto id = buildExId(0x16, ((uint16_t)_hostId << 8) | targetId, targetId);
+    return sendExt(id, d, 8);
+}
+
+bool RS02PrivateBase::setMotorIdViaParam(uint8_t targetId, uint8_t newId, bool save)
+{
+    RS02_INSTR_SCOPE(RS02Probe::ID_CHANGE);
+    // 0x200A = CAN_ID (uint8)
+    uint8_t v[4] = {newId, 0, 0, 0};
+    bool ok = writeParamLE(targetId, RS02Idx::CAN_ID, v); // Type18
+    if (ok && save)
+        ok &= saveParams(targetId); // Type22（必要に応じて）
+    return ok;
+}
+
+// ===== Param Write/Read (index=LE) =====
+bool RS02PrivateBase::writeParamLE(uint8_t targetId, uint16_t index, const uint8_t valueLE[4])
+{
+    RS02_INSTR_SCOPE(RS02Probe::WRITE_PARAM);
+    uint8_t d[8] = {0};
+    d[0] = (uint8_t)(index & 0xFF);
+    d[1] = (uint8_t)(index >> 8);
+    d[4] = valueLE[0];
+    d[5] = valueLE[1];
+    d[6] = valueLE[2];
+    d[7] = valueLE[3];
+    auto id = buildExId(0x12, da2_master(), targetId);
+    return sendExt(id, d, 8);
+}
+bool RS02PrivateBase::writeFloatParam(uint8_t targetId, uint16_t index, float value)
+{
+    uint8_t v[4];
+    packF32LE(value, v);
+    return writeParamLE(targetId, index, v);
+}
+// 目標値（*Ref）: 送信キュー有効時は差し替え/期限切れの対象
+bool RS02PrivateBase::writeSetpointParam(uint8_t targetId, uint16_t index, float value)
+{
+    RS02_INSTR_SCOPE(RS02Probe::WRITE_PARAM);
+    uint8_t d[8] = {0};
+    d[0] = (uint8_t)(index & 0xFF);
+    d[1] = (uint8_t)(index >> 8);
+    packF32LE(value, &d[4]);
+    auto id = buildExId(0x12, da2_master(), targetId);
+    return sendSetpoint(id, d, 8);
+}
+bool RS02PrivateBase::readParamRaw(uint8_t targetId, uint16_t index, uint8_t out4LE[4])
+{
+    RS02_INSTR_SCOPE(RS02Probe::READ_PARAM);
+    uint32_t t0 = millis();
+    // 応答の受け口を登録してから要求を送る（応答は readAny の経路で埋まる: 自分で読んでも受信タスクが読んでも）
+    // 受け口は 1 つ。別のタスクが待っている間は空くのを待つ
+    for (;;)
+    {
+        {
+            RS02BusGuard g(*this);
+            if (!_pw.active)
+            {
+                _pw.active = true;
+                _pw.got = false;
+                _pw.target = targetId;
+                _pw.index = index;
+                break;
+            }
+        }
+        if ((millis() - t0) >= 300)
+            return false;
+        delay(1);
+    }
+
+    // 要求送信
+    uint8_t d[8] = {0};
+    d[0] = (uint8_t)(index & 0xFF);
+    d[1] = (uint8_t)(index >> 8);
+    auto rid = buildExId(0x11, da2_master(), targetId);
+    bool ok = sendExt(rid, d, 8);
+
+    // 応答待ち（バスは readAny の 1 回ごとにだけ取る。待つ間もデッドライン監視などが送れる）
+    RS02PrivFrame f;
+    bool got = false;
+    while (ok && (millis() - t0) < 300)
+    {
+        {
+            RS02BusGuard g(*this);
+            if (_pw.got)
+            {
+                memcpy(out4LE, _pw.data, 4);
+                got = true;
+                break;
+            }
+        }
+        if (!readAny(f))
+            delay(1);
+        else if (!_pw.got)
+            RS02_INSTR_COUNT(RS02Counter::PARAM_SKIPPED, 1);
+    }
+    {
+        RS02BusGuard g(*this);
+        if (!got && _pw.got) // 最後の readAny で届いた
+        {
+            memcpy(out4LE, _pw.data, 4);
+            got = true;
+        }
+        _pw.active = false;
+    }
+    if (ok && !got)
+        RS02_INSTR_COUNT(RS02Counter::PARAM_TIMEOUT, 1);
+    return got;
+}
+// readAny から（バス排他の内側）: 待っている Type17 応答か
+void RS02PrivateBase::matchParamReply(const RS02PrivFrame &f)
+{
+    uint8_t type = (uint8_t)((f.id >> 24) & 0x1F);
+    if (type != 0x11 || !f.isExt || f.dlc < 8)
+        return;
+
+    // ★ 応答dstが targetId（モータID）で来る個体も許可
+    uint8_t dst = (uint8_t)(f.id & 0xFF);
+    if (!(dst == _hostId || dst == 0x00 || dst == 0xFF || dst == 0xFE || dst == _pw.target))
+        return;
+
+    // indexエコー（LE/BEどちらでも一致でOK）
+    uint16_t idxLE = (uint16_t)f.data[0] | ((uint16_t)f.data[1] << 8);
+    uint16_t idxBE = (uint16_t)f.data[1] | ((uint16_t)f.data[0] << 8);
+    if (idxLE != _pw.index && idxBE != _pw.index)
+        return;
+
+    memcpy(_pw.data, &f.data[4], 4);
+    _pw.got = true;
+}
+bool RS02PrivateBase::readFloatParam(uint8_t targetId, uint16_t index, float &out)
+{
+    uint8_t le[4];
+    if (!readParamRaw(targetId, index, le))
+        return false;
+    memcpy(&out, le, 4);
+    return true;
+}
+
+// ===== Protocol / Report =====
+bool RS02PrivateBase::switchProtocol(uint8_t targetId, uint8_t fcmd)
+{
+    uint8_t d[8] = {1, 2, 3, 4, 5, 6, fcmd, 0};
+    auto id = buildExId(0x19, da2_master(), targetId);
+    return sendExt(id, d, 8);
+}
+bool RS02PrivateBase::setActiveReport(uint8_t targetId, bool enableFlag)
+{
+    uint8_t d[8] = {1, 2, 3, 4, 5, 6, (uint8_t)(enableFlag ? 1 : 0), 0};
+    auto id = buildExId(0x18, da2_master(), targetId);
+    return sendExt(id, d, 8);
+}
+bool RS02PrivateBase::setReportIntervalTicks(uint8_t targetId, uint16_t ticks)
+{
+    uint8_t v[4] = {(uint8_t)(ticks & 0xFF), (uint8_t)(ticks >> 8), 0, 0};
+    return writeParamLE(targetId, RS02Idx::IDX_EPSCAN_TIME, v);
+}
+
+// ===== Operation Control (Type1 only DA2=torque) =====
+bool RS02PrivateBase::opControl(uint8_t targetId, float torqueNm, float posRad, float velRadS, float kp, float kd)
+{
+    RS02_INSTR_SCOPE(RS02Probe::OP_CONTROL);
+    uint8_t d[8];
+    uint32_t id = opControlFrame(targetId, torqueNm, posRad, velRadS, kp, kd, d);
+    return sendSetpoint(id, d, 8);
+}
+
+uint32_t RS02PrivateBase::opControlFrame(uint8_t targetId, float torqueNm, float posRad, float velRadS, float kp, float kd,
+                                         uint8_t out[8])
+{
+    const float P_MIN = -12.57f, P_MAX = 12.57f, V_MIN = -44.0f, V_MAX = 44.0f, KP_MIN = 0.0f, KP_MAX = 500.0f, KD_MIN = 0.0f, KD_MAX = 5.0f, T_MIN = -17.0f, T_MAX = 17.0f;
+    uint16_t uP = float_to_uint(posRad, P_MIN, P_MAX);
+    uint16_t uV = float_to_uint(velRadS, V_MIN, V_MAX);
+    uint16_t uKP = float_to_uint(kp, KP_MIN, KP_MAX);
+    uint16_t uKD = float_to_uint(kd, KD_MIN, KD_MAX);
+    uint16_t uT = float_to_uint(torqueNm, T_MIN, T_MAX);
+    packU16BE(uP, &out[0]);
+    packU16BE(uV, &out[2]);
+    packU16BE(uKP, &out[4]);
+    packU16BE(uKD, &out[6]);
+    return buildExId(0x01, uT, targetId); // Type1のみDA2=トルク
+}
+
+// ===== Type2 parse =====
+bool RS02PrivateBase::parseFeedback(const RS02PrivFrame &f, RS02Feedback &out)
+{
+    if (((f.id >> 24) & 0x1F) != 0x02 || f.dlc < 8)
+        return false;
+    out.motorId = (uint8_t)((f.id >> 8) & 0xFF); // bit8-15=モータID（bit0-7はホストID）
+    out.faultBits = (uint16_t)((f.id >> 16) & 0x3F);
+    out.mode = (uint8_t)((f.id >> 22) & 0x03);
+    uint16_t uP = ((uint16_t)f.data[0] << 8) | f.data[1];
+    uint16_t uV = ((uint16_t)f.data[2] << 8) | f.data[3];
+    uint16_t uT = ((uint16_t)f.data[4] << 8) | f.data[5];
+    uint16_t uC = ((uint16_t)f.data[6] << 8) | f.data[7];
+    out.angleRad = uint_to_float(uP, -12.57f, 12.57f);
+    out.velRadS = uint_to_float(uV, -44.0f, 44.0f);
+    out.torqueNm = uint_to_float(uT, -17.0f, 17.0f);
+    out.tempC = (float)uC * 0.1f;
+    return true;
+}
+
+// ===== Run mode =====
+bool RS02PrivateBase::setRunMode(uint8_t targetId, uint8_t runMode)
+{
+    RS02_INSTR_SCOPE(RS02Probe::MODE_ENTRY);
+    uint8_t v[4] = {runMode, 0, 0, 0};
+    return writeParamLE(targetId, RS02Idx::RUN_MODE, v);
+}
+bool RS02PrivateBase::readRunMode(uint8_t targetId, uint8_t &outMode)
+{
+    uint8_t le[4] = {0};
+    if (!readParamRaw(targetId, RS02Idx::RUN_MODE, le))
+        return false;
+    outMode = le[0];
+    return true;
+}
+
+// ===== Velocity =====
+bool RS02PrivateBase::enterVelocity(uint8_t targetId, float limitCurA, float accRadS2, float spdKp, float spdKi)
+{
+    RS02_INSTR_SCOPE(RS02Probe::MODE_ENTRY);
+    uint8_t rm[4] = {2, 0, 0, 0};
+    bool ok = writeParamLE(targetId, RS02Idx::RUN_MODE, rm);
+    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_CUR, limitCurA);
+    ok &= writeFloatParam(targetId, RS02Idx::ACC_RAD, accRadS2);
+    if (!isnan(spdKp))
+        ok &= writeFloatParam(targetId, RS02Idx::SPD_KP, spdKp);
+    if (!isnan(spdKi))
+        ok &= writeFloatParam(targetId, RS02Idx::SPD_KI, spdKi);
+    return ok;
+}
+bool RS02PrivateBase::velocityRef(uint8_t targetId, float spdRadS)
+{
+    return writeSetpointParam(targetId, RS02Idx::SPD_REF, spdRadS);
+}
+bool RS02PrivateBase::enterVelocityStrict(uint8_t targetId, float limitTorqueNm, float limitCurA, float accRadS2, float spdKp, float spdKi)
+{
+    RS02_INSTR_SCOPE(RS02Probe::MODE_ENTRY);
+    bool ok = stop(targetId, true);
+    delay(100);
+    uint8_t rm[4] = {2, 0, 0, 0};
+    ok &= writeParamLE(targetId, RS02Idx::RUN_MODE, rm);
+    delay(50);
+    ok &= enable(targetId);
+    delay(50);
+    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_TORQUE, limitTorqueNm);
+    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_CUR, limitCurA);
+    ok &= writeFloatParam(targetId, RS02Idx::ACC_RAD, accRadS2);
+    if (!isnan(spdKp))
+        ok &= writeFloatParam(targetId, RS02Idx::SPD_KP, spdKp);
+    if (!isnan(spdKi))
+        ok &= writeFloatParam(targetId, RS02Idx::SPD_KI, spdKi);
+    return ok;
+}
+bool RS02PrivateBase::bringUpVelocityPerSpec(uint8_t targetId, float limitCurA, float accRadS2, float spdRadS)
+{
+    RS02_INSTR_SCOPE(RS02Probe::MODE_ENTRY);
+    bool ok = true;
+    uint8_t rm[4] = {2, 0, 0, 0};
+    ok &= writeParamLE(targetId, RS02Idx::RUN_MODE, rm);
+    delay(50);
+    ok &= enable(targetId);
+    delay(50);
+    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_CUR, limitCurA);
+    ok &= writeFloatParam(targetId, RS02Idx::ACC_RAD, accRadS2);
+    ok &= writeFloatParam(targetId, RS02Idx::SPD_REF, spdRadS);
+    return ok;
+}
+
+// ===== PP =====
+bool RS02PrivateBase::enterPP(uint8_t targetId, float limitSpdRadS, float locKp)
+{
+    RS02_INSTR_SCOPE(RS02Probe::MODE_ENTRY);
+    uint8_t rm[4] = {1, 0, 0, 0};
+    bool ok = writeParamLE(targetId, RS02Idx::RUN_MODE, rm);
+    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_SPD, limitSpdRadS);
+    if (!isnan(locKp))
+        ok &= writeFloatParam(targetId, RS02Idx::LOC_KP, locKp);
+    return ok;
+}
+bool RS02PrivateBase::ppLocRef(uint8_t targetId, float posRad)
+{
+    return writeSetpointParam(targetId, RS02Idx::LOC_REF, posRad);
+}
+bool RS02PrivateBase::bringUpPPPerSpec(uint8_t targetId, float limitSpdRadS, float posRad)
+{
+    RS02_INSTR_SCOPE(RS02Probe::MODE_ENTRY);
+    bool ok = true;
+    uint8_t rm[4] = {1, 0, 0, 0};
+    ok &= writeParamLE(targetId, RS02Idx::RUN_MODE, rm);
+    delay(50);
+    ok &= enable(targetId);
+    delay(50);
+    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_SPD, limitSpdRadS);
+    ok &= writeFloatParam(targetId, RS02Idx::LOC_REF, posRad);
+    return ok;
+}
+
+// ===== Current =====
+bool RS02PrivateBase::enterCurrent(uint8_t targetId, float limitTorqueNm, float curKp, float curKi)
+{
+    RS02_INSTR_SCOPE(RS02Probe::MODE_ENTRY);
+    uint8_t rm[4] = {3, 0, 0, 0};
+    bool ok = writeParamLE(targetId, RS02Idx::RUN_MODE, rm);
+    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_TORQUE, limitTorqueNm);
+    if (!isnan(curKp))
+        ok &= writeFloatParam(targetId, RS02Idx::CUR_KP, curKp);
+    if (!isnan(curKi))
+        ok &= writeFloatParam(targetId, RS02Idx::CUR_KI, curKi);
+    return ok;
+}
+bool RS02PrivateBase::currentIqRef(uint8_t targetId, float iqA)
+{
+    return writeSetpointParam(targetId, RS02Idx::IQ_REF, iqA); // 0x7006
+}
+bool RS02PrivateBase::bringUpCurrentPerSpec(uint8_t targetId, float iqA)
+{
+    RS02_INSTR_SCOPE(RS02Probe::MODE_ENTRY);
+    bool ok = true;
+    uint8_t rm[4] = {3, 0, 0, 0};
+    ok &= writeParamLE(targetId, RS02Idx::RUN_MODE, rm);
+    delay(50);
+    ok &= enable(targetId);
+    delay(50);
+    ok &= writeFloatParam(targetId, RS02Idx::IQ_REF, iqA);
+    return ok;
+}
+
+// ===== CSP =====
+bool RS02PrivateBase::enterCSP(uint8_t targetId, float limitSpdRadS, float limitCurA, float locKp)
+{
+    RS02_INSTR_SCOPE(RS02Probe::MODE_ENTRY);
+    uint8_t rm[4] = {5, 0, 0, 0};
+    bool ok = writeParamLE(targetId, RS02Idx::RUN_MODE, rm);
+    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_SPD, limitSpdRadS);
+    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_CUR, limitCurA);
+    if (!isnan(locKp))
+        ok &= writeFloatParam(targetId, RS02Idx::LOC_KP, locKp);
+    return ok;
+}
+bool RS02PrivateBase::cspLocRef(uint8_t targetId, float posRad)
+{
+    return writeSetpointParam(targetId, RS02Idx::LOC_REF, posRad);
+}
+bool RS02PrivateBase::bringUpCSPPerSpec(uint8_t targetId, float limitSpdRadS, float posRad)
+{
+    RS02_INSTR_SCOPE(RS02Probe::MODE_ENTRY);
+    bool ok = true;
+    uint8_t rm[4] = {5, 0, 0, 0};
+    ok &= writeParamLE(targetId, RS02Idx::RUN_MODE, rm);
+    delay(50);
+    ok &= enable(targetId);
+    delay(50);
+    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_SPD, limitSpdRadS);
+    ok &= writeFloatParam(targetId, RS02Idx::LOC_REF, posRad);
+    return ok;
+}
+bool RS02PrivateBase::enterCSP_simple(uint8_t targetId, float limitSpdRadS)
+{
+    RS02_INSTR_SCOPE(RS02Probe::MODE_ENTRY);
+    uint8_t rm[4] = {5, 0, 0, 0};
+    if (!writeParamLE(targetId, RS02Idx::RUN_MODE, rm))
+        return false;
+    if (!writeFloatParam(targetId, RS02Idx::LIMIT_SPD, limitSpdRadS))
+        return false;
+    delay(5);
+    return enable(targetId);
+}
+bool RS02PrivateBase::enterCSP_robust(uint8_t targetId, float limitSpdRadS, float limitCurA, float locKp)
+{
+    RS02_INSTR_SCOPE(RS02Probe::MODE_ENTRY);
+    bool ok = stop(targetId, true);
+    delay(100);
+    uint8_t rm5[4] = {5, 0, 0, 0};
+    ok &= writeParamLE(targetId, RS02Idx::RUN_MODE, rm5);
+    delay(30);
+    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_SPD, limitSpdRadS);
+    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_CUR, limitCurA);
+    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_CUR_OLD, limitCurA);
+    if (!isnan(locKp))
+        ok &= writeFloatParam(targetId, RS02Idx::LOC_KP, locKp);
+    ok &= enable(targetId);
+    delay(50);
+    ok &= writeParamLE(targetId, RS02Idx::RUN_MODE, rm5);
+    delay(30);
+    uint8_t cur = 0xFF;
+    if (readRunMode(targetId, cur) && cur != 5)
+        return false;
+    return ok;
+}
+
+// ===== 無限回転（パラメータ合成; 使えないFWあり）=====
+bool RS02PrivateBase::getInfiniteByParams(uint8_t targetId, double &turns, double &angleRad)
+{
+    float rotA = 0.0f, rotB = 0.0f, mod = 0.0f;
+    bool okA = readFloatParam(targetId, RS02Idx::IDX_ROTATION, rotA);
+    bool okB = readFloatParam(targetId, RS02Idx::IDX_MECH_ANGLE_ROT, rotB);
+    bool okM = readFloatParam(targetId, RS02Idx::IDX_MODPOS, mod);
+    if (!okM)
+        return false;
+    float rot = okB ? rotB : (okA ? rotA : 0.0f);
+    turns = (double)llround((double)rot);
+    angleRad = turns * TWO_PI + (double)mod;
+    return (okA || okB);
+}
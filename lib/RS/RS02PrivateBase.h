@@ -0,0 +1,289 @@
+#pragma once
+// RS02PrivateBase.h — RS02 プライベートプロトコル本体（バックエンド非依存）
+// バックエンド（MCP2515: RS02PrivateCAN / TWAI: RS02PrivateTWAI / SocketCAN / Replay）は hwSend/hwRead が必須。
+// 送信待ちの破棄・送信完了の確認・取り消し・非同期送信（hwFlushTx / hwTxIdle / hwTxPending / hwAbortTx / hwSetTxAsync）と
+// コントローラ状態・回復（hwStatus / hwRecover）は任意（既定は何もしない / false）
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <math.h>
+#include <stdint.h>
+#include "RS02Types.h"
+
+#ifndef RS02_MAX_LISTENERS
+#define RS02_MAX_LISTENERS 8
+#endif
+
+#ifndef RS02_TXQ_DEPTH
+#define RS02_TXQ_DEPTH 16
+#endif
+
+#ifndef RS02_TXDONE_DEPTH
+#define RS02_TXDONE_DEPTH 32 // onTxDone を待つフレーム数（これより古い未完了分は通知しない）
+#endif
+
+#ifndef RS02_TX_WAIT_US
+#define RS02_TX_WAIT_US 5000 // waitTxIdle: 前の送信が出るまで待つ上限
+#endif
+
+class RS02PrivateBase
+{
+public:
+    explicit RS02PrivateBase(uint8_t hostId) : _hostId(hostId) { _busMutex = xSemaphoreCreateRecursiveMutex(); }
+    virtual ~RS02PrivateBase()
+    {
+        if (_busMutex)
+            vSemaphoreDelete(_busMutex);
+    }
+
+    virtual bool begin() = 0;
+    void setMasterId(uint8_t mid) { _masterId = mid; } // 既定=0xFD
+    uint8_t masterId() const { return _masterId; }
+    uint8_t hostId() const { return _hostId; }
+
+    // 送受信の排他（別タスクから送る場合。sendExt/readAny は内部で取得済み）
+    void lockBus()
+    {
+        if (_busMutex)
+            xSemaphoreTakeRecursive(_busMutex, portMAX_DELAY);
+    }
+    void unlockBus()
+    {
+        if (_busMutex)
+            xSemaphoreGiveRecursive(_busMutex);
+    }
+
+    // 送受信フレームの通知先（故障監視など）
+    bool addListener(RS02FrameListener *l);
+    void removeListener(RS02FrameListener *l);
+
+    // Motor CAN ID change (Type7: immediate)
+    bool setMotorId(uint8_t currentId, uint8_t newId);
+
+    // Motor CAN ID change via param 0x200A (Type18) + optional save (Type22)
+    bool setMotorIdViaParam(uint8_t targetId, uint8_t newId, bool save);
+
+    // Save all parameters (Type22)
+    bool saveParams(uint8_t targetId);
+
+    // 低レベル
+    bool sendExt(unsigned long id, const uint8_t *payload, uint8_t len);
+    bool readAny(RS02PrivFrame &out);
+    // 送信待ちを破棄してから送る（緊急停止用）
+    bool sendUrgent(unsigned long id, const uint8_t *payload, uint8_t len);
+
+    // コントローラの状態（TEC/REC, バスオフ）と回復操作（MCP2515: 再初期化, TWAI: recovery → start）
+    bool canStatus(RS02CanStatus &out);
+    bool recoverBus();
+
+    // 目標値の送信キュー（既定は無効 = sendSetpoint は sendExt と同じ）
+    // 有効時は (dst, 通信タイプ, Type18 の index) ごとに最新の 1 フレームだけを持ち、HW には 1 フレームずつ渡す。
+    // 送信は pumpTx()（readAny / sendSetpoint からも呼ぶ）。期限切れは送らず、送信中なら取り消す
+    void setTxQueue(const RS02TxQueueConfig &cfg);
+    const RS02TxQueueConfig &txQueueConfig() const { return _txqCfg; }
+    bool sendSetpoint(unsigned long id, const uint8_t *payload, uint8_t len, uint32_t deadlineUs = 0);
+    void pumpTx();
+    uint8_t txQueued() const { return _txqCount; }
+    // HW に送信待ちが無いか（送信キュー有効時は送信完了を待たずに戻るので、続けて送る前の確認に）
+    bool txIdle();
+    // 前の送信がバスに出るまで受信を読んで待つ（出なければ false）。送信完了を待たない区間で続けて送る前に
+    bool waitTxIdle(uint32_t us = RS02_TX_WAIT_US);
+    // 送信完了を待たない区間（RS02AsyncSend から。入れ子可, 送信キューの設定は変えない）
+    void beginAsyncSend();
+    void endAsyncSend();
+    const RS02TxQueueStats &txQueueStats() const { return _txqStats; }
+    void resetTxQueueStats() { _txqStats = RS02TxQueueStats(); }
+
+    // 基本コマンド
+    bool ping(uint8_t targetId);                  // Type0
+    bool enable(uint8_t targetId);                // Type3
+    bool stop(uint8_t targetId, bool clearFault); // Type4
+    bool stopUrgent(uint8_t targetId, bool clearFault);
+
+    // パラメータR/W（index=LE）
+    bool writeParamLE(uint8_t targetId, uint16_t index, const uint8_t valueLE[4]);
+    bool writeFloatParam(uint8_t targetId, uint16_t index, float value);
+    bool readParamRaw(uint8_t targetId, uint16_t index, uint8_t out4LE[4]);
+    bool readFloatParam(uint8_t targetId, uint16_t index, float &out);
+
+    // プロトコル/レポート
+    bool switchProtocol(uint8_t targetId, uint8_t fcmd); // Type25
+    bool setActiveReport(uint8_t targetId, bool enable); // Type24
+    bool setReportIntervalTicks(uint8_t targetId, uint16_t ticks);
+
+    // Operation Control（Type1のみDA2=トルク）
+    bool opControl(uint8_t targetId, float torqueNm, float posRad, float velRadS, float kp, float kd);
+    // Type1 のフレームだけ作る（ID を返す）。送信キューを通さずに sendExt で送るとき用
+    static uint32_t opControlFrame(uint8_t targetId, float torqueNm, float posRad, float velRadS, float kp, float kd,
+                                   uint8_t out[8]);
+
+    // 受信解析 Type2
+    bool parseFeedback(const RS02PrivFrame &f, RS02Feedback &out);
+
+    // ランモード
+    bool setRunMode(uint8_t targetId, uint8_t runMode);
+    bool readRunMode(uint8_t targetId, uint8_t &outMode);
+
+    // ===== Velocity / PP / Current / CSP =====
+    bool enterVelocity(uint8_t targetId, float limitCurA, float accRadS2, float spdKp = NAN, float spdKi = NAN);
+    bool velocityRef(uint8_t targetId, float spdRadS);
+    bool enterVelocityStrict(uint8_t targetId, float limitTorqueNm, float limitCurA, float accRadS2, float spdKp = NAN, float spdKi = NAN);
+    bool bringUpVelocityPerSpec(uint8_t targetId, float limitCurA, float accRadS2, float spdRadS);
+
+    bool enterPP(uint8_t targetId, float limitSpdRadS, float locKp = NAN);
+    bool ppLocRef(uint8_t targetId, float posRad);
+    bool bringUpPPPerSpec(uint8_t targetId, float limitSpdRadS, float posRad);
+
+    bool enterCurrent(uint8_t targetId, float limitTorqueNm, float curKp = NAN, float curKi = NAN);
+    bool currentIqRef(uint8_t targetId, float iqA);
+    bool bringUpCurrentPerSpec(uint8_t targetId, float iqA);
+
+    bool enterCSP(uint8_t targetId, float limitSpdRadS, float limitCurA, float locKp = NAN);
+    bool cspLocRef(uint8_t targetId, float posRad);
+    bool bringUpCSPPerSpec(uint8_t targetId, float limitSpdRadS, float posRad);
+    bool enterCSP_simple(uint8_t targetId, float limitSpdRadS);
+    bool enterCSP_robust(uint8_t targetId, float limitSpdRadS, float limitCurA, float locKp = NAN);
+
+    // 無限回転（パラメータ合成: FWにより未更新の個体もある）
+    bool getInfiniteByParams(uint8_t targetId, double &turns, double &angleRad);
+
+protected:
+    // バックエンド実装
+    virtual bool hwSend(unsigned long id, const uint8_t *payload, uint8_t len) = 0;
+    virtual bool hwRead(RS02PrivFrame &out) = 0;
+    // 未送信フレームの破棄（HWキューを持たないバックエンドは何もしない）
+    virtual void hwFlushTx() {}
+    // 送信キュー用: HW に送信待ちが無いか / 送信中フレームの取り消し（できたら true）/ 送信完了を待たない送信
+    virtual bool hwTxIdle() { return true; }
+    // HW に渡して未完了のフレーム数（渡した順に完了する前提。送信完了を待つバックエンドは 0 のまま）
+    virtual uint16_t hwTxPending() { return 0; }
+    virtual bool hwAbortTx() { return false; }
+    virtual void hwSetTxAsync(bool async) { (void)async; }
+    // コントローラ状態 / 回復操作（対応しないバックエンドは false）
+    virtual bool hwStatus(RS02CanStatus &out)
+    {
+        (void)out;
+        return false;
+    }
+    virtual bool hwRecover() { return false; }
+    // 受信あふれの通知（hwRead から。バス排他の内側）
+    void notifyRxLost(uint32_t n);
+
+    uint8_t _hostId = 0x00;
+    uint8_t _masterId = 0xFD;
+
+    inline uint16_t da2_master() const { return ((uint16_t)_masterId << 8) | 0x00; }
+    static inline uint32_t buildExId(uint8_t type5, uint16_t da2, uint8_t dst)
+    {
+        return ((uint32_t)(type5 & 0x1F) << 24) | ((uint32_t)da2 << 8) | (uint32_t)dst;
+    }
+
+    // パック/演算
+    static inline void packU16BE(uint16_t v, uint8_t *p)
+    {
+        p[0] = (uint8_t)(v >> 8);
+        p[1] = (uint8_t)(v);
+    }
+    static inline uint16_t unpackU16BE(const uint8_t *p) { return ((uint16_t)p[0] << 8) | p[1]; }
+    static inline void packF32LE(float f, uint8_t *p)
+    {
+        uint32_t u;
+        memcpy(&u, &f, 4);
+        p[0] = u;
+        p[1] = u >> 8;
+        p[2] = u >> 16;
+        p[3] = u >> 24;
+    }
+
+    static inline uint16_t float_to_uint(float x, float x_min, float x_max)
+    {
+        float cl = (x < x_min) ? x_min : (x > x_max ? x_max : x);
+        return (uint16_t)((cl - x_min) * 65535.0f / (x_max - x_min));
+    }
+    static inline float uint_to_float(uint16_t x, float x_min, float x_max)
+    {
+        return ((float)x) * (x_max - x_min) / 65535.0f + x_min;
+    }
+
+private:
+    SemaphoreHandle_t _busMutex = nullptr;
+    RS02FrameListener *_listeners[RS02_MAX_LISTENERS] = {};
+    uint8_t _nListeners = 0;
+
+    void notifyTx(unsigned long id, const uint8_t *payload, uint8_t len, bool ok);
+
+    // readParamRaw の応答待ち: readAny の経路（受信タスクでも）で埋める。待つ間はバスを保持しない
+    struct ParamWait
+    {
+        bool active;
+        bool got;
+        uint8_t target;
+        uint16_t index;
+        uint8_t data[4];
+    };
+    ParamWait _pw = {};
+    void matchParamReply(const RS02PrivFrame &f);
+
+    // 送信完了の通知（onTxDone）: 渡した順に持ち、hwTxPending() が減った分を古い方から完了にする
+    struct TxDoneSlot
+    {
+        uint32_t id;
+        uint8_t len;
+        uint8_t data[8];
+    };
+    TxDoneSlot _txd[RS02_TXDONE_DEPTH];
+    uint8_t _txdHead = 0;
+    uint8_t _txdCount = 0;
+    void txDonePoll();
+    void txDoneDrop(); // hwFlushTx / hwAbortTx の後: 消えた新しい方を ok=false で
+    void notifyTxDone(const TxDoneSlot &s, bool ok);
+    bool writeSetpointParam(uint8_t targetId, uint16_t index, float value);
+
+    // 送信キュー（RS02PrivateTxQueue.cpp）
+    struct TxSlot
+    {
+        uint32_t id;
+        uint32_t key;
+        uint32_t tUs;
+        uint32_t deadlineUs;
+        uint8_t len;
+        uint8_t data[8];
+    };
+    RS02TxQueueConfig _txqCfg;
+    RS02TxQueueStats _txqStats;
+    TxSlot _txq[RS02_TXQ_DEPTH];
+    uint8_t _txqHead = 0;
+    uint8_t _txqCount = 0;
+    bool _txInflight = false;       // キューから HW に渡したフレームが未完了
+    bool _txInflightShared = false; // その後ろに sendExt のフレームがある（取り消すと巻き込む）
+    uint32_t _txInflightDue = 0;
+    uint8_t _asyncDepth = 0; // beginAsyncSend の入れ子
+
+    static uint32_t txKey(unsigned long id, const uint8_t *payload, uint8_t len);
+    void txqDropDst(uint8_t dst);
+    void txqClear();
+    void txqOnDirectSend(unsigned long id, const uint8_t *payload, uint8_t len);
+};
+
+// スコープ内でバスを占有
+class RS02BusGuard
+{
+public:
+    explicit RS02BusGuard(RS02PrivateBase &bus) : _bus(bus) { _bus.lockBus(); }
+    ~RS02BusGuard() { _bus.unlockBus(); }
+
+private:
+    RS02PrivateBase &_bus;
+};
+
+// スコープ内は送信完了を待たずに戻す（続けて送る前に waitTxIdle）。抜けるときは送信が出るまで受信を読む
+class RS02AsyncSend
+{
+public:
+    explicit RS02AsyncSend(RS02PrivateBase &bus) : _bus(bus) { _bus.beginAsyncSend(); }
+    ~RS02AsyncSend() { _bus.endAsyncSend(); }
+
+private:
+    RS02PrivateBase &_bus;
+};
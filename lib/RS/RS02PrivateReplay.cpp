@@ -0,0 +1,146 @@
+// RS02PrivateReplay.cpp — 記録ログの再生
+#include "RS02PrivateReplay.h"
+#include "RS02Instr.h"
+
+// ===== 読み出し元 =====
+bool RS02CanLogStreamSource::readLine(char *buf, size_t n)
+{
+    size_t len = 0;
+    bool any = false;
+    for (;;)
+    {
+        int c = _s.read();
+        if (c < 0)
+            break;
+        any = true;
+        if (c == '\n')
+            break;
+        if (c == '\r')
+            continue;
+        if (len + 1 < n)
+            buf[len++] = (char)c;
+    }
+    buf[len] = 0;
+    return any;
+}
+
+bool RS02CanLogTextSource::readLine(char *buf, size_t n)
+{
+    if (!_p || *_p == 0)
+        return false;
+    size_t len = 0;
+    while (*_p && *_p != '\n')
+    {
+        if (*_p != '\r' && len + 1 < n)
+            buf[len++] = *_p;
+        _p++;
+    }
+    if (*_p == '\n')
+        _p++;
+    buf[len] = 0;
+    return true;
+}
+
+// ===== 再生 =====
+void RS02PrivateReplay::fetch()
+{
+    char line[96];
+    _hasNext = false;
+    while (_src.readLine(line, sizeof(line)))
+    {
+        if (RS02CanLog::parseLine(line, _next))
+        {
+            _hasNext = true;
+            return;
+        }
+        _stats.badLines++;
+    }
+}
+
+void RS02PrivateReplay::rebase(uint64_t logUs)
+{
+    _baseLogUs = logUs;
+    _baseNowUs = micros();
+}
+
+bool RS02PrivateReplay::due(uint64_t logUs) const
+{
+    if (_cfg.speed <= 0.0f || logUs <= _baseLogUs)
+        return true;
+    double elapsed = (double)(uint32_t)(micros() - _baseNowUs) * (double)_cfg.speed;
+    return elapsed >= (double)(logUs - _baseLogUs);
+}
+
+bool RS02PrivateReplay::begin()
+{
+    RS02_INSTR_SCOPE(RS02Probe::BEGIN);
+    _stats = RS02ReplayStats();
+    fetch();
+    if (!_hasNext)
+        return false;
+    rebase(_next.tsUs);
+    return true;
+}
+
+bool RS02PrivateReplay::hwSend(unsigned long id, const uint8_t *payload, uint8_t len)
+{
+    RS02_INSTR_SCOPE(RS02Probe::HW_SEND);
+    _stats.txSent++;
+    if (!_cfg.syncOnTx)
+        return true;
+    if (!_hasNext || !_next.tx)
+    {
+        _stats.txUnexpected++;
+        return true;
+    }
+
+    if (_cfg.compareTx)
+    {
+        uint8_t n = len > 8 ? 8 : len;
+        bool same = _next.f.isExt && (_next.f.id == (id & 0x1FFFFFFF)) && _next.f.dlc == n &&
+                    memcmp(_next.f.data, payload, n) == 0;
+        if (same)
+            _stats.txMatched++;
+        else
+        {
+            if (_stats.txMismatch == 0)
+            {
+                _mmExpected = _next;
+                _mmSent = RS02PrivFrame();
+                _mmSent.id = id;
+                _mmSent.dlc = n;
+                _mmSent.isExt = true;
+                memcpy(_mmSent.data, payload, n);
+            }
+            _stats.txMismatch++;
+        }
+    }
+    // 送信した時点をログ上の送信時刻に合わせる
+    rebase(_next.tsUs);
+    fetch();
+    return true;
+}
+
+bool RS02PrivateReplay::hwRead(RS02PrivFrame &out)
+{
+    RS02_INSTR_SCOPE(RS02Probe::HW_READ);
+    while (_hasNext)
+    {
+        if (_next.tx)
+        {
+            if (_cfg.syncOnTx)
+                return false;
+            _stats.txSkipped++;
+            fetch();
+            continue;
+        }
+        if (!due(_next.tsUs))
+            return false;
+        out = _next.f;
+        out.tsUs = 0; // readAny で micros() を入れる
+        _stats.rxFed++;
+        fetch();
+        return true;
+    }
+    return false;
+}
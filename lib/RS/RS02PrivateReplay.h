@@ -0,0 +1,109 @@
+#pragma once
+// RS02PrivateReplay.h — 記録ログ（RS02CanLog / candump -l 形式）を readAny へ流す再生用バックエンド
+// 現場で取ったログを机上で同じ順序・同じ間隔でライブラリに通すためのもの
+//
+// ・speed: 1=記録どおりの間隔, 10=10倍速, 0=待たない（決定的なテスト向け）
+// ・syncOnTx: ログ上の送信（T 行）に来たら、ライブラリが送信するまで後続の受信を出さない。
+//   送信した時点を基準に時間軸を合わせ直す（応答までの遅れを保つ）
+// ・compareTx: 送信内容をログの T 行と比べ、一致/不一致を数える
+// T/R の無い行（candump の生ログ）は全部受信として流す。送信を別タスクから出すコードは順序が揺れるので
+// syncOnTx=false で使う
+
+#include <Arduino.h>
+#include "RS02PrivateBase.h"
+#include "RS02CanLog.h"
+
+// ログの読み出し元（1 行ずつ）
+class RS02CanLogSource
+{
+public:
+    virtual ~RS02CanLogSource() {}
+    // 改行を除いた 1 行。終端なら false
+    virtual bool readLine(char *buf, size_t n) = 0;
+};
+
+// Stream（SD の File / Serial）から
+class RS02CanLogStreamSource : public RS02CanLogSource
+{
+public:
+    explicit RS02CanLogStreamSource(Stream &s) : _s(s) {}
+    bool readLine(char *buf, size_t n) override;
+
+private:
+    Stream &_s;
+};
+
+// メモリ上のテキスト（PROGMEM 不可）から
+class RS02CanLogTextSource : public RS02CanLogSource
+{
+public:
+    explicit RS02CanLogTextSource(const char *text) : _p(text) {}
+    bool readLine(char *buf, size_t n) override;
+
+private:
+    const char *_p;
+};
+
+struct RS02ReplayConfig
+{
+    float speed = 1.0f;
+    bool syncOnTx = true;
+    bool compareTx = true;
+};
+
+struct RS02ReplayStats
+{
+    uint32_t rxFed = 0;        // readAny へ渡した受信
+    uint32_t txSent = 0;       // ライブラリが送信した数
+    uint32_t txMatched = 0;    // ログの T 行と一致
+    uint32_t txMismatch = 0;   // T 行と内容が違う（消費はする）
+    uint32_t txUnexpected = 0; // T 行でない位置での送信（syncOnTx 時）
+    uint32_t txSkipped = 0;    // syncOnTx=false で読み飛ばした T 行
+    uint32_t badLines = 0;     // 解析できなかった行（コメント/空行を含む）
+};
+
+class RS02PrivateReplay : public RS02PrivateBase
+{
+public:
+    RS02PrivateReplay(uint8_t hostId, RS02CanLogSource &src) : RS02PrivateBase(hostId), _src(src) {}
+
+    // 先頭を読んで時間軸を現在時刻に合わせる。ログが空なら false
+    bool begin() override;
+    void setConfig(const RS02ReplayConfig &cfg) { _cfg = cfg; }
+    const RS02ReplayConfig &config() const { return _cfg; }
+
+    // ログを最後まで流し終えた
+    bool done() const { return !_hasNext; }
+    // ログ上の送信待ち（syncOnTx）
+    bool waitingForTx() const { return _hasNext && _next.tx && _cfg.syncOnTx; }
+    // 次に出す行（done() なら無効）
+    const RS02CanLogEntry &next() const { return _next; }
+
+    const RS02ReplayStats &stats() const { return _stats; }
+    // 最初の不一致（txMismatch > 0 のとき）：ログ側と実際の送信
+    const RS02CanLogEntry &firstMismatchExpected() const { return _mmExpected; }
+    const RS02PrivFrame &firstMismatchSent() const { return _mmSent; }
+
+protected:
+    bool hwSend(unsigned long id, const uint8_t *payload, uint8_t len) override;
+    bool hwRead(RS02PrivFrame &out) override;
+
+private:
+    RS02CanLogSource &_src;
+    RS02ReplayConfig _cfg;
+    RS02ReplayStats _stats;
+
+    RS02CanLogEntry _next;
+    bool _hasNext = false;
+
+    // 時間軸: ログ時刻 _baseLogUs が micros()=_baseNowUs に対応
+    uint64_t _baseLogUs = 0;
+    uint32_t _baseNowUs = 0;
+
+    RS02CanLogEntry _mmExpected;
+    RS02PrivFrame _mmSent;
+
+    void fetch();
+    bool due(uint64_t logUs) const;
+    void rebase(uint64_t logUs);
+};
@@ -0,0 +1,237 @@
+// RS02PrivateSocketCAN.cpp — Linux SocketCAN 向け 送受信
+#include "RS02PrivateSocketCAN.h"
+#include "RS02Instr.h"
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <net/if.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+
+RS02PrivateSocketCAN::RS02PrivateSocketCAN(uint8_t hostId, const char *ifname) : RS02PrivateBase(hostId)
+{
+    strncpy(_ifname, ifname ? ifname : "can0", sizeof(_ifname) - 1);
+    _ifname[sizeof(_ifname) - 1] = 0;
+}
+
+RS02PrivateSocketCAN::~RS02PrivateSocketCAN() { end(); }
+
+bool RS02PrivateSocketCAN::begin()
+{
+    RS02_INSTR_SCOPE(RS02Probe::BEGIN);
+    end();
+    _fd = socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_RAW);
+    if (_fd < 0)
+        return false;
+
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    memcpy(ifr.ifr_name, _ifname, sizeof(_ifname)); // _ifname は IFNAMSIZ で終端済み
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    bool ok = ioctl(_fd, SIOCGIFINDEX, &ifr) == 0;
+    if (ok)
+    {
+        addr.can_ifindex = ifr.ifr_ifindex;
+        ok = bind(_fd, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+    }
+    ok = ok && applyFilter() && applyTimestamps();
+
+    if (ok)
+    {
+        _ep = epoll_create1(EPOLL_CLOEXEC);
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = _fd;
+        ok = _ep >= 0 && epoll_ctl(_ep, EPOLL_CTL_ADD, _fd, &ev) == 0;
+    }
+    if (!ok)
+        end();
+    return ok;
+}
+
+void RS02PrivateSocketCAN::end()
+{
+    if (_ep >= 0)
+        close(_ep);
+    if (_fd >= 0)
+        close(_fd);
+    _ep = -1;
+    _fd = -1;
+}
+
+// ===== フィルタ / タイムスタンプ =====
+bool RS02PrivateSocketCAN::setMotorFilter(const RS02MotorSet &ids)
+{
+    _filter = ids;
+    return _fd < 0 || applyFilter();
+}
+
+bool RS02PrivateSocketCAN::applyFilter()
+{
+    struct can_filter flt[128];
+    int n = 0;
+    for (uint8_t id = 0; id < 128; id++)
+    {
+        if (!_filter.has(id))
+            continue;
+        // 応答はすべて bit8-15 にモータID（Type0/2/17）。拡張IDのみ
+        flt[n].can_id = CAN_EFF_FLAG | ((canid_t)id << 8);
+        flt[n].can_mask = CAN_EFF_FLAG | CAN_RTR_FLAG | 0xFF00;
+        n++;
+    }
+    if (n == 0)
+    {
+        // 全受信（拡張ID/標準ID とも。標準IDは hwRead で捨てる）
+        flt[0].can_id = 0;
+        flt[0].can_mask = 0;
+        n = 1;
+    }
+    return setsockopt(_fd, SOL_CAN_RAW, CAN_RAW_FILTER, flt, (socklen_t)(n * sizeof(flt[0]))) == 0;
+}
+
+bool RS02PrivateSocketCAN::enableTimestamps(bool hw)
+{
+    _tsOn = true;
+    _tsHw = hw;
+    return _fd < 0 || applyTimestamps();
+}
+
+bool RS02PrivateSocketCAN::applyTimestamps()
+{
+    if (!_tsOn)
+        return true;
+    int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    if (_tsHw)
+        flags |= SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE;
+    if (setsockopt(_fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == 0)
+        return true;
+    // ハードウェア非対応ならソフトウェア時刻のみ
+    flags &= ~(SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE);
+    return setsockopt(_fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == 0;
+}
+
+bool RS02PrivateSocketCAN::waitRx(uint32_t timeoutMs)
+{
+    if (_ep < 0)
+        return false;
+    struct epoll_event ev;
+    int n;
+    do
+        n = epoll_wait(_ep, &ev, 1, (int)timeoutMs);
+    while (n < 0 && errno == EINTR);
+    return n > 0;
+}
+
+// ===== 送受信 =====
+bool RS02PrivateSocketCAN::hwSend(unsigned long id, const uint8_t *payload, uint8_t len)
+{
+    RS02_INSTR_SCOPE(RS02Probe::HW_SEND);
+    if (_fd < 0)
+        return false;
+    if (len > 8)
+        len = 8;
+    struct can_frame fr;
+    memset(&fr, 0, sizeof(fr));
+    fr.can_id = CAN_EFF_FLAG | (id & CAN_EFF_MASK); // 29bit
+    fr.can_dlc = len;
+    memcpy(fr.data, payload, len);
+
+    uint32_t t0 = millis();
+    for (;;)
+    {
+        ssize_t w = write(_fd, &fr, sizeof(fr));
+        if (w == (ssize_t)sizeof(fr))
+        {
+            _stats.txFrames++;
+            return true;
+        }
+        // 送信キュー満杯（ENOBUFS）/ ソケットバッファ満杯（EAGAIN）は待って再送
+        if (w < 0 && (errno == ENOBUFS || errno == EAGAIN || errno == EINTR) && millis() - t0 < _txTimeoutMs)
+        {
+            _stats.txRetry++;
+            if (errno == EAGAIN)
+            {
+                struct pollfd p = {_fd, POLLOUT, 0};
+                poll(&p, 1, 1);
+            }
+            else if (errno == ENOBUFS)
+                delay(1); // qdisc 満杯は POLLOUT で起きないので時間で待つ
+            continue;
+        }
+        _stats.txFail++;
+        return false;
+    }
+}
+
+bool RS02PrivateSocketCAN::hwRead(RS02PrivFrame &out)
+{
+    RS02_INSTR_SCOPE(RS02Probe::HW_READ);
+    if (_fd < 0)
+        return false;
+    for (;;)
+    {
+        struct can_frame fr;
+        struct iovec iov = {&fr, sizeof(fr)};
+        alignas(struct cmsghdr) char ctrl[CMSG_SPACE(sizeof(struct scm_timestamping))];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = _tsOn ? ctrl : nullptr;
+        msg.msg_controllen = _tsOn ? sizeof(ctrl) : 0;
+
+        ssize_t r = recvmsg(_fd, &msg, MSG_DONTWAIT);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r < (ssize_t)sizeof(fr))
+            return false; // EAGAIN など: 受信なし
+
+        if ((fr.can_id & (CAN_ERR_FLAG | CAN_RTR_FLAG)) || !(fr.can_id & CAN_EFF_FLAG))
+        {
+            _stats.rxDropped++;
+            continue;
+        }
+        out.id = fr.can_id & CAN_EFF_MASK;
+        out.dlc = fr.can_dlc > 8 ? 8 : fr.can_dlc;
+        memcpy(out.data, fr.data, out.dlc);
+        out.isExt = true;
+        _stats.rxFrames++;
+
+        // SO_TIMESTAMPING: ts[0]=ソフトウェア(CLOCK_REALTIME), ts[2]=ハードウェア生値
+        for (struct cmsghdr *c = _tsOn ? CMSG_FIRSTHDR(&msg) : nullptr; c; c = CMSG_NXTHDR(&msg, c))
+        {
+            if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SO_TIMESTAMPING)
+                continue;
+            struct scm_timestamping ts;
+            memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+            uint64_t sw = (uint64_t)ts.ts[0].tv_sec * 1000000000ULL + (uint64_t)ts.ts[0].tv_nsec;
+            uint64_t hw = (uint64_t)ts.ts[2].tv_sec * 1000000000ULL + (uint64_t)ts.ts[2].tv_nsec;
+            _lastTsNs = (_tsHw && hw) ? hw : sw;
+            if (sw)
+            {
+                // カーネル受信時刻を micros() 基準へ（経過分を差し引く）
+                struct timespec now;
+                clock_gettime(CLOCK_REALTIME, &now);
+                uint64_t nowNs = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+                uint32_t ageUs = nowNs > sw ? (uint32_t)((nowNs - sw) / 1000ULL) : 0;
+                out.tsUs = micros() - ageUs;
+            }
+        }
+        return true;
+    }
+}
+
+#endif // __linux__
@@ -0,0 +1,69 @@
+#pragma once
+// RS02PrivateSocketCAN.h — Linux SocketCAN（CAN_RAW, 拡張ID）向け RS02 プライベートプロトコル実装
+// 依存: Linux（<linux/can.h>）。Arduino 互換層は native/ArduinoShim（実時間モード）
+// プロトコル本体は RS02PrivateBase（本クラスは SocketCAN の送受信のみ）
+//
+// ・受信はノンブロッキング（readAny は待たない）。待つときは waitRx()（epoll）か fd() を自前のループへ
+// ・setMotorFilter() でカーネル側フィルタ（CAN_RAW_FILTER: 応答 bit8-15 = モータID）
+// ・enableTimestamps() で SO_TIMESTAMPING（tsUs は micros() 基準へ換算）
+// 動作確認は vcan + モータシミュレータ（tools/native_socketcan）
+
+#if defined(__linux__)
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "RS02PrivateBase.h"
+
+struct RS02SocketCANStats
+{
+    uint32_t rxFrames = 0;
+    uint32_t rxDropped = 0; // エラーフレーム/RTR/標準ID など捨てた数
+    uint32_t txFrames = 0;
+    uint32_t txRetry = 0; // 送信バッファ満杯で待った回数
+    uint32_t txFail = 0;
+};
+
+class RS02PrivateSocketCAN : public RS02PrivateBase
+{
+public:
+    explicit RS02PrivateSocketCAN(uint8_t hostId, const char *ifname = "can0");
+    ~RS02PrivateSocketCAN();
+
+    bool begin() override;
+    void end();
+
+    // カーネル側受信フィルタ（空集合=全受信）。begin 前後どちらでも可
+    bool setMotorFilter(const RS02MotorSet &ids);
+    // SO_TIMESTAMPING を有効化（hw=true: NIC のハードウェア時刻も要求）
+    bool enableTimestamps(bool hw = false);
+    // 受信待ち（epoll）。読めるフレームがあれば true
+    bool waitRx(uint32_t timeoutMs);
+    // 送信バッファ満杯時に待つ上限（既定 50ms: TWAI と同じ）
+    void setTxTimeoutMs(uint32_t ms) { _txTimeoutMs = ms; }
+
+    int fd() const { return _fd; }
+    const char *ifname() const { return _ifname; }
+    // 直近の受信時刻（SO_TIMESTAMPING 有効時, ns。hw 有効ならハードウェア時刻優先, 0=なし）
+    uint64_t lastRxTimestampNs() const { return _lastTsNs; }
+    const RS02SocketCANStats &stats() const { return _stats; }
+
+protected:
+    bool hwSend(unsigned long id, const uint8_t *payload, uint8_t len) override;
+    bool hwRead(RS02PrivFrame &out) override;
+
+private:
+    char _ifname[16];
+    int _fd = -1;
+    int _ep = -1;
+    bool _tsOn = false;
+    bool _tsHw = false;
+    uint32_t _txTimeoutMs = 50;
+    uint64_t _lastTsNs = 0;
+    RS02MotorSet _filter;
+    RS02SocketCANStats _stats;
+
+    bool applyFilter();
+    bool applyTimestamps();
+};
+
+#endif // __linux__
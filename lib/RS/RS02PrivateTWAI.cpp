@@ -1,410 +1,266 @@
-// RS02PrivateTWAI.cpp — ESP32 TWAI(内蔵CAN)向け 実装
+// RS02PrivateTWAI.cpp — ESP32 TWAI(内蔵CAN)向け 送受信
 #include "RS02PrivateTWAI.h"
-#include <math.h>
+#include "RS02Instr.h"
 
 bool RS02PrivateTWAI::begin()
 {
+    RS02_INSTR_SCOPE(RS02Probe::BEGIN);
     twai_general_config_t g_config = TWAI_GENERAL_CONFIG_DEFAULT((gpio_num_t)_txPin, (gpio_num_t)_rxPin, TWAI_MODE_NORMAL);
+    g_config.rx_queue_len = _rxQueueLen;
+    g_config.tx_queue_len = _txQueueLen;
     twai_filter_config_t f_config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
     if (twai_driver_install(&g_config, &_timing, &f_config) != ESP_OK)
         return false;
     if (twai_start() != ESP_OK)
         return false;
+    twai_status_info_t st;
+    bool ok = twai_get_status_info(&st) == ESP_OK;
+    _lostSeen = ok ? st.rx_missed_count + st.rx_overrun_count : 0;
+    _txFailedSeen = ok ? st.tx_failed_count : 0;
+    _txHead = _txCount = 0;
     return true;
 }
 
-bool RS02PrivateTWAI::sendExt(unsigned long id, const uint8_t *payload, uint8_t len)
+bool RS02PrivateTWAI::hwSend(unsigned long id, const uint8_t *payload, uint8_t len)
 {
+    RS02_INSTR_SCOPE(RS02Probe::HW_SEND);
     if (len > 8)
         len = 8;
     twai_message_t msg = {};
     msg.identifier = id & 0x1FFFFFFF; // 29bit
-    msg.flags = TWAI_MSG_FLAG_EXTD;
+    msg.flags = TWAI_MSG_FLAG_EXTD | (_txSingleShot ? TWAI_MSG_FLAG_SS : 0);
     msg.data_length_code = len;
     memcpy(msg.data, payload, len);
-    return twai_transmit(&msg, pdMS_TO_TICKS(50)) == ESP_OK;
+    if (_txCount)
+        pollStatus(); // 先に完了を回収（送信待ち数を正しく）
+    esp_err_t r = twai_transmit(&msg, _txAsync ? 0 : pdMS_TO_TICKS(_txTimeoutMs));
+    if (r != ESP_OK)
+    {
+        if (r == ESP_ERR_TIMEOUT)
+            _txStats.queueFull++;
+        return false;
+    }
+    _txStats.submitted++;
+    if (_txCount < RS02_TWAI_TX_TRACK)
+    {
+        _txT[(_txHead + _txCount) % RS02_TWAI_TX_TRACK] = micros();
+        _txCount++;
+    }
+    if (_txCount > _txStats.maxPending)
+        _txStats.maxPending = _txCount;
+    return true;
 }
 
-bool RS02PrivateTWAI::readAny(RS02PrivFrame &out)
+bool RS02PrivateTWAI::hwRead(RS02PrivFrame &out)
 {
+    RS02_INSTR_SCOPE(RS02Probe::HW_READ);
     twai_message_t msg = {};
     esp_err_t r = twai_receive(&msg, 0);
     if (r != ESP_OK)
+    {
+        pollStatus(); // 読み切ったところで取りこぼし / 送信完了を確認
         return false;
-    out.id = msg.identifier;
-    out.dlc = (uint8_t)msg.data_length_code;
-    memcpy(out.data, msg.data, out.dlc);
+    }
     out.isExt = (msg.flags & TWAI_MSG_FLAG_EXTD) != 0;
+    out.id = msg.identifier & (out.isExt ? 0x1FFFFFFFUL : 0x7FFUL);
+    // DLC 9..15（TWAI_MSG_FLAG_DLC_NON_COMP）はデータ 8 バイト
+    out.dlc = msg.data_length_code > 8 ? 8 : (uint8_t)msg.data_length_code;
+    memcpy(out.data, msg.data, out.dlc);
     return true;
 }
 
-// ===== Type0/3/4 =====
-bool RS02PrivateTWAI::ping(uint8_t targetId)
-{
-    uint8_t d[8] = {0};
-    auto id = buildExId(0x00, da2_master(), targetId);
-    return sendExt(id, d, 8);
-}
-bool RS02PrivateTWAI::enable(uint8_t targetId)
-{
-    uint8_t d[8] = {0};
-    auto id = buildExId(0x03, da2_master(), targetId);
-    return sendExt(id, d, 8);
-}
-bool RS02PrivateTWAI::stop(uint8_t targetId, bool clearFault)
-{
-    uint8_t d[8] = {0};
-    if (clearFault)
-    {
-        d[0] = 0x00;
-        d[1] = 0x01;
-    }
-    auto id = buildExId(0x04, da2_master(), targetId);
-    return sendExt(id, d, 8);
-}
-
-bool RS02PrivateTWAI::setMotorId(uint8_t currentId, uint8_t newId)
-{
-    // Type7: mode=0x07, DataArea2 = [newId:high][hostId:low], dst=currentId
-    uint8_t d[8] = {0};
-    auto id = buildExId(0x07, ((uint16_t)newId << 8) | _hostId, currentId);
-    return sendExt(id, d, 8);
-}
-
-bool RS02PrivateTWAI::saveParams(uint8_t targetId)
+bool RS02PrivateTWAI::pollStatus(twai_status_info_t *out)
 {
-    // Type22: 保存。データ内容は仕様上ダミーでOK（01..08を送る例）
-    uint8_t d[8] = {1, 2, 3, 4, 5, 6, 7, 8};
-    auto id = buildExId(0x16, ((uint16_t)_hostId << 8) | targetId, targetId);
-    return sendExt(id, d, 8);
-}
-
-bool RS02PrivateTWAI::setMotorIdViaParam(uint8_t targetId, uint8_t newId, bool save)
-{
-    // 0x200A = CAN_ID (uint8)
-    uint8_t v[4] = {newId, 0, 0, 0};
-    bool ok = writeParamLE(targetId, 0x200A, v); // Type18
-    if (ok && save)
-        ok &= saveParams(targetId); // Type22（必要に応じて）
-    return ok;
+    twai_status_info_t st;
+    if (twai_get_status_info(&st) != ESP_OK)
+        return false;
+    checkRxLost(st);
+    trackTx(st);
+    if (out)
+        *out = st;
+    return true;
 }
 
-// ===== Param Write/Read (index=LE) =====
-bool RS02PrivateTWAI::writeParamLE(uint8_t targetId, uint16_t index, const uint8_t valueLE[4])
-{
-    uint8_t d[8] = {0};
-    d[0] = (uint8_t)(index & 0xFF);
-    d[1] = (uint8_t)(index >> 8);
-    d[4] = valueLE[0];
-    d[5] = valueLE[1];
-    d[6] = valueLE[2];
-    d[7] = valueLE[3];
-    auto id = buildExId(0x12, da2_master(), targetId);
-    return sendExt(id, d, 8);
-}
-bool RS02PrivateTWAI::writeFloatParam(uint8_t targetId, uint16_t index, float value)
+void RS02PrivateTWAI::checkRxLost(const twai_status_info_t &st)
 {
-    uint8_t v[4];
-    packF32LE(value, v);
-    return writeParamLE(targetId, index, v);
+    uint32_t lost = st.rx_missed_count + st.rx_overrun_count - _lostSeen;
+    if (!lost)
+        return;
+    _lostSeen += lost;
+    _lastLostUs = micros();
+    _rxStats.rxMissed += lost;
+    notifyRxLost(lost);
 }
-bool RS02PrivateTWAI::readParamRaw(uint8_t targetId, uint16_t index, uint8_t out4LE[4])
-{
-    // 要求送信
-    uint8_t d[8] = {0};
-    d[0] = (uint8_t)(index & 0xFF);
-    d[1] = (uint8_t)(index >> 8);
-    auto rid = buildExId(0x11, da2_master(), targetId);
-    if (!sendExt(rid, d, 8))
-        return false;
 
-    // 応答待ち
-    RS02PrivFrame f;
-    uint32_t t0 = millis();
-    while ((millis() - t0) < 300)
+void RS02PrivateTWAI::trackTx(const twai_status_info_t &st)
+{
+    uint32_t failed = st.tx_failed_count - _txFailedSeen;
+    _txFailedSeen = st.tx_failed_count;
+    _txStats.failed += failed;
+    if (st.msgs_to_tx >= _txCount)
+        return;
+    // 渡した順に完了する: 古い方から done 個。失敗した分は遅れに数えない
+    uint16_t done = (uint16_t)(_txCount - st.msgs_to_tx);
+    if (st.state != TWAI_STATE_RUNNING)
+    {
+        dropTx(done); // バスオフ / 停止で消えた
+        return;
+    }
+    uint32_t now = micros();
+    for (uint16_t i = 0; i < done; i++)
     {
-        if (!readAny(f))
+        uint32_t us = now - _txT[_txHead];
+        _txHead = (_txHead + 1) % RS02_TWAI_TX_TRACK;
+        _txCount--;
+        if (failed)
         {
-            delay(1);
+            failed--;
             continue;
         }
-        uint8_t type = (uint8_t)((f.id >> 24) & 0x1F);
-        if (type != 0x11)
-            continue;
-
-        // ★ 応答dstが targetId（モータID）で来る個体も許可
-        uint8_t dst = (uint8_t)(f.id & 0xFF);
-        if (!(dst == _hostId || dst == 0x00 || dst == 0xFF || dst == 0xFE || dst == targetId))
-            continue;
-
-        // indexエコー（LE/BEどちらでも一致でOK）
-        uint16_t idxLE = (uint16_t)f.data[0] | ((uint16_t)f.data[1] << 8);
-        uint16_t idxBE = (uint16_t)f.data[1] | ((uint16_t)f.data[0] << 8);
-        if (idxLE != index && idxBE != index)
-            continue;
-
-        out4LE[0] = f.data[4];
-        out4LE[1] = f.data[5];
-        out4LE[2] = f.data[6];
-        out4LE[3] = f.data[7];
-        return true;
+        _txStats.completed++;
+        _txStats.lastLatencyUs = us;
+        _txStats.totalLatencyUs += us;
+        if (us > _txStats.maxLatencyUs)
+            _txStats.maxLatencyUs = us;
     }
-    return false;
-}
-bool RS02PrivateTWAI::readFloatParam(uint8_t targetId, uint16_t index, float &out)
-{
-    uint8_t le[4];
-    if (!readParamRaw(targetId, index, le))
-        return false;
-    memcpy(&out, le, 4);
-    return true;
 }
 
-// ===== Protocol / Report =====
-bool RS02PrivateTWAI::switchProtocol(uint8_t targetId, uint8_t fcmd)
-{
-    uint8_t d[8] = {1, 2, 3, 4, 5, 6, fcmd, 0};
-    auto id = buildExId(0x19, da2_master(), targetId);
-    return sendExt(id, d, 8);
-}
-bool RS02PrivateTWAI::setActiveReport(uint8_t targetId, bool enableFlag)
+void RS02PrivateTWAI::dropTx(uint16_t n)
 {
-    uint8_t d[8] = {1, 2, 3, 4, 5, 6, (uint8_t)(enableFlag ? 1 : 0), 0};
-    auto id = buildExId(0x18, da2_master(), targetId);
-    return sendExt(id, d, 8);
-}
-bool RS02PrivateTWAI::setReportIntervalTicks(uint8_t targetId, uint16_t ticks)
-{
-    uint8_t v[4] = {(uint8_t)(ticks & 0xFF), (uint8_t)(ticks >> 8), 0, 0};
-    return writeParamLE(targetId, RS02Idx::IDX_EPSCAN_TIME, v);
+    // 送信待ちの新しい方（キューの後ろ）から消える
+    if (n > _txCount)
+        n = _txCount;
+    _txCount -= n;
+    if (!_txCount)
+        _txHead = 0;
+    _txStats.dropped += n;
 }
 
-// ===== Operation Control (Type1 only DA2=torque) =====
-bool RS02PrivateTWAI::opControl(uint8_t targetId, float torqueNm, float posRad, float velRadS, float kp, float kd)
+void RS02PrivateTWAI::pollTx()
 {
-    const float P_MIN = -12.57f, P_MAX = 12.57f, V_MIN = -44.0f, V_MAX = 44.0f, KP_MIN = 0.0f, KP_MAX = 500.0f, KD_MIN = 0.0f, KD_MAX = 5.0f, T_MIN = -17.0f, T_MAX = 17.0f;
-    uint16_t uP = float_to_uint(posRad, P_MIN, P_MAX);
-    uint16_t uV = float_to_uint(velRadS, V_MIN, V_MAX);
-    uint16_t uKP = float_to_uint(kp, KP_MIN, KP_MAX);
-    uint16_t uKD = float_to_uint(kd, KD_MIN, KD_MAX);
-    uint16_t uT = float_to_uint(torqueNm, T_MIN, T_MAX);
-    uint8_t d[8];
-    packU16BE(uP, &d[0]);
-    packU16BE(uV, &d[2]);
-    packU16BE(uKP, &d[4]);
-    packU16BE(uKD, &d[6]);
-    auto id = buildExId(0x01, uT, targetId); // Type1のみDA2=トルク
-    return sendExt(id, d, 8);
+    RS02BusGuard g(*this);
+    pollStatus();
 }
 
-// ===== Type2 parse =====
-bool RS02PrivateTWAI::parseFeedback(const RS02PrivFrame &f, RS02Feedback &out)
+void RS02PrivateTWAI::hwFlushTx()
 {
-    if (((f.id >> 24) & 0x1F) != 0x02 || f.dlc < 8)
-        return false;
-    out.motorId = (uint8_t)(f.id & 0xFF);
-    out.faultBits = (uint16_t)((f.id >> 16) & 0x3F);
-    out.mode = (uint8_t)((f.id >> 22) & 0x03);
-    uint16_t uP = ((uint16_t)f.data[0] << 8) | f.data[1];
-    uint16_t uV = ((uint16_t)f.data[2] << 8) | f.data[3];
-    uint16_t uT = ((uint16_t)f.data[4] << 8) | f.data[5];
-    uint16_t uC = ((uint16_t)f.data[6] << 8) | f.data[7];
-    out.angleRad = uint_to_float(uP, -12.57f, 12.57f);
-    out.velRadS = uint_to_float(uV, -44.0f, 44.0f);
-    out.torqueNm = uint_to_float(uT, -17.0f, 17.0f);
-    out.tempC = (float)uC * 0.1f;
-    return true;
+    // ドライバTXキューに残った指令を捨てる（送信中の1フレームは止まらない）
+    pollStatus();
+    twai_clear_transmit_queue();
+    twai_status_info_t st;
+    if (twai_get_status_info(&st) == ESP_OK && st.msgs_to_tx < _txCount)
+        dropTx((uint16_t)(_txCount - st.msgs_to_tx));
 }
 
-// ===== Run mode =====
-bool RS02PrivateTWAI::setRunMode(uint8_t targetId, uint8_t runMode)
-{
-    uint8_t v[4] = {runMode, 0, 0, 0};
-    return writeParamLE(targetId, RS02Idx::RUN_MODE, v);
-}
-bool RS02PrivateTWAI::readRunMode(uint8_t targetId, uint8_t &outMode)
+bool RS02PrivateTWAI::hwTxIdle()
 {
-    uint8_t le[4] = {0};
-    if (!readParamRaw(targetId, RS02Idx::RUN_MODE, le))
-        return false;
-    outMode = le[0];
-    return true;
+    // 送信中の 1 フレームも msgs_to_tx に入る。取り消しはできない（hwAbortTx は既定の false）
+    twai_status_info_t st;
+    if (!pollStatus(&st))
+        return true;
+    return st.msgs_to_tx == 0;
 }
 
-// ===== Velocity =====
-bool RS02PrivateTWAI::enterVelocity(uint8_t targetId, float limitCurA, float accRadS2, float spdKp, float spdKi)
+uint16_t RS02PrivateTWAI::hwTxPending()
 {
-    uint8_t rm[4] = {2, 0, 0, 0};
-    bool ok = writeParamLE(targetId, RS02Idx::RUN_MODE, rm);
-    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_CUR, limitCurA);
-    ok &= writeFloatParam(targetId, RS02Idx::ACC_RAD, accRadS2);
-    if (!isnan(spdKp))
-        ok &= writeFloatParam(targetId, RS02Idx::SPD_KP, spdKp);
-    if (!isnan(spdKi))
-        ok &= writeFloatParam(targetId, RS02Idx::SPD_KI, spdKi);
-    return ok;
-}
-bool RS02PrivateTWAI::velocityRef(uint8_t targetId, float spdRadS)
-{
-    return writeFloatParam(targetId, RS02Idx::SPD_REF, spdRadS);
-}
-bool RS02PrivateTWAI::enterVelocityStrict(uint8_t targetId, float limitTorqueNm, float limitCurA, float accRadS2, float spdKp, float spdKi)
-{
-    bool ok = stop(targetId, true);
-    delay(100);
-    uint8_t rm[4] = {2, 0, 0, 0};
-    ok &= writeParamLE(targetId, RS02Idx::RUN_MODE, rm);
-    delay(50);
-    ok &= enable(targetId);
-    delay(50);
-    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_TORQUE, limitTorqueNm);
-    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_CUR, limitCurA);
-    ok &= writeFloatParam(targetId, RS02Idx::ACC_RAD, accRadS2);
-    if (!isnan(spdKp))
-        ok &= writeFloatParam(targetId, RS02Idx::SPD_KP, spdKp);
-    if (!isnan(spdKi))
-        ok &= writeFloatParam(targetId, RS02Idx::SPD_KI, spdKi);
-    return ok;
-}
-bool RS02PrivateTWAI::bringUpVelocityPerSpec(uint8_t targetId, float limitCurA, float accRadS2, float spdRadS)
-{
-    bool ok = true;
-    uint8_t rm[4] = {2, 0, 0, 0};
-    ok &= writeParamLE(targetId, RS02Idx::RUN_MODE, rm);
-    delay(50);
-    ok &= enable(targetId);
-    delay(50);
-    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_CUR, limitCurA);
-    ok &= writeFloatParam(targetId, RS02Idx::ACC_RAD, accRadS2);
-    ok &= writeFloatParam(targetId, RS02Idx::SPD_REF, spdRadS);
-    return ok;
+    pollStatus();
+    return _txCount;
 }
 
-// ===== PP =====
-bool RS02PrivateTWAI::enterPP(uint8_t targetId, float limitSpdRadS, float locKp)
+bool RS02PrivateTWAI::hwStatus(RS02CanStatus &out)
 {
-    uint8_t rm[4] = {1, 0, 0, 0};
-    bool ok = writeParamLE(targetId, RS02Idx::RUN_MODE, rm);
-    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_SPD, limitSpdRadS);
-    if (!isnan(locKp))
-        ok &= writeFloatParam(targetId, RS02Idx::LOC_KP, locKp);
-    return ok;
-}
-bool RS02PrivateTWAI::ppLocRef(uint8_t targetId, float posRad)
-{
-    return writeFloatParam(targetId, RS02Idx::LOC_REF, posRad);
-}
-bool RS02PrivateTWAI::bringUpPPPerSpec(uint8_t targetId, float limitSpdRadS, float posRad)
-{
-    bool ok = true;
-    uint8_t rm[4] = {1, 0, 0, 0};
-    ok &= writeParamLE(targetId, RS02Idx::RUN_MODE, rm);
-    delay(50);
-    ok &= enable(targetId);
-    delay(50);
-    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_SPD, limitSpdRadS);
-    ok &= writeFloatParam(targetId, RS02Idx::LOC_REF, posRad);
-    return ok;
+    twai_status_info_t st;
+    if (twai_get_status_info(&st) != ESP_OK)
+        return false;
+    out.tec = (uint16_t)st.tx_error_counter;
+    out.rec = (uint16_t)st.rx_error_counter;
+    switch (st.state)
+    {
+    case TWAI_STATE_BUS_OFF:
+        out.state = RS02CanState::BusOff;
+        break;
+    case TWAI_STATE_RECOVERING:
+        out.state = RS02CanState::Recovering;
+        break;
+    case TWAI_STATE_STOPPED:
+        out.state = RS02CanState::Stopped;
+        break;
+    default:
+        if (out.tec >= 128 || out.rec >= 128)
+            out.state = RS02CanState::Passive;
+        else if (out.tec >= 96 || out.rec >= 96)
+            out.state = RS02CanState::Warning;
+        else
+            out.state = RS02CanState::Active;
+        break;
+    }
+    return true;
 }
 
-// ===== Current =====
-bool RS02PrivateTWAI::enterCurrent(uint8_t targetId, float limitTorqueNm, float curKp, float curKi)
+bool RS02PrivateTWAI::hwRecover()
 {
-    uint8_t rm[4] = {3, 0, 0, 0};
-    bool ok = writeParamLE(targetId, RS02Idx::RUN_MODE, rm);
-    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_TORQUE, limitTorqueNm);
-    if (!isnan(curKp))
-        ok &= writeFloatParam(targetId, RS02Idx::CUR_KP, curKp);
-    if (!isnan(curKi))
-        ok &= writeFloatParam(targetId, RS02Idx::CUR_KI, curKi);
-    return ok;
-}
-bool RS02PrivateTWAI::currentIqRef(uint8_t targetId, float iqA)
-{
-    return writeFloatParam(targetId, RS02Idx::IQ_REF, iqA); // 0x7006
-}
-bool RS02PrivateTWAI::bringUpCurrentPerSpec(uint8_t targetId, float iqA)
-{
-    bool ok = true;
-    uint8_t rm[4] = {3, 0, 0, 0};
-    ok &= writeParamLE(targetId, RS02Idx::RUN_MODE, rm);
-    delay(50);
-    ok &= enable(targetId);
-    delay(50);
-    ok &= writeFloatParam(targetId, RS02Idx::IQ_REF, iqA);
-    return ok;
+    // バスオフ → recovery（128x11bit 後に STOPPED）→ start
+    twai_status_info_t st;
+    if (!pollStatus(&st)) // 止まっている間に消えた送信待ちもここで回収
+        return false;
+    if (st.state == TWAI_STATE_BUS_OFF)
+    {
+        bool ok = twai_initiate_recovery() == ESP_OK;
+        pollStatus(); // 回復の開始で送信待ちは消える
+        return ok;
+    }
+    if (st.state == TWAI_STATE_STOPPED)
+        return twai_start() == ESP_OK;
+    return st.state == TWAI_STATE_RUNNING;
 }
 
-// ===== CSP =====
-bool RS02PrivateTWAI::enterCSP(uint8_t targetId, float limitSpdRadS, float limitCurA, float locKp)
-{
-    uint8_t rm[4] = {5, 0, 0, 0};
-    bool ok = writeParamLE(targetId, RS02Idx::RUN_MODE, rm);
-    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_SPD, limitSpdRadS);
-    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_CUR, limitCurA);
-    if (!isnan(locKp))
-        ok &= writeFloatParam(targetId, RS02Idx::LOC_KP, locKp);
-    return ok;
-}
-bool RS02PrivateTWAI::cspLocRef(uint8_t targetId, float posRad)
+// ===== 受信タスク =====
+bool RS02PrivateTWAI::startRxTask(uint32_t idleMs, int core, UBaseType_t prio)
 {
-    return writeFloatParam(targetId, RS02Idx::LOC_REF, posRad);
-}
-bool RS02PrivateTWAI::bringUpCSPPerSpec(uint8_t targetId, float limitSpdRadS, float posRad)
-{
-    bool ok = true;
-    uint8_t rm[4] = {5, 0, 0, 0};
-    ok &= writeParamLE(targetId, RS02Idx::RUN_MODE, rm);
-    delay(50);
-    ok &= enable(targetId);
-    delay(50);
-    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_SPD, limitSpdRadS);
-    ok &= writeFloatParam(targetId, RS02Idx::LOC_REF, posRad);
-    return ok;
-}
-bool RS02PrivateTWAI::enterCSP_simple(uint8_t targetId, float limitSpdRadS)
-{
-    uint8_t rm[4] = {5, 0, 0, 0};
-    if (!writeParamLE(targetId, RS02Idx::RUN_MODE, rm))
-        return false;
-    if (!writeFloatParam(targetId, RS02Idx::LIMIT_SPD, limitSpdRadS))
+    if (_rxTask.running())
+        return true;
+    const uint32_t alerts = TWAI_ALERT_RX_DATA | TWAI_ALERT_RX_QUEUE_FULL | TWAI_ALERT_RX_FIFO_OVERRUN |
+                            TWAI_ALERT_TX_SUCCESS | TWAI_ALERT_TX_FAILED;
+    if (twai_reconfigure_alerts(alerts, nullptr) != ESP_OK)
+        return false; // ドライバ未インストール（begin 前）
+    _rxIdleMs = idleMs ? idleMs : 1;
+    if (!_rxTask.start(rxTaskEntry, "rs02_twai_rx", this, prio, core))
+    {
+        twai_reconfigure_alerts(TWAI_ALERT_NONE, nullptr);
         return false;
-    delay(5);
-    return enable(targetId);
+    }
+    return true;
 }
-bool RS02PrivateTWAI::enterCSP_robust(uint8_t targetId, float limitSpdRadS, float limitCurA, float locKp)
+
+void RS02PrivateTWAI::stopRxTask()
 {
-    bool ok = stop(targetId, true);
-    delay(100);
-    uint8_t rm5[4] = {5, 0, 0, 0};
-    ok &= writeParamLE(targetId, RS02Idx::RUN_MODE, rm5);
-    delay(30);
-    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_SPD, limitSpdRadS);
-    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_CUR, limitCurA);
-    ok &= writeFloatParam(targetId, RS02Idx::LIMIT_CUR_OLD, limitCurA);
-    if (!isnan(locKp))
-        ok &= writeFloatParam(targetId, RS02Idx::LOC_KP, locKp);
-    ok &= enable(targetId);
-    delay(50);
-    ok &= writeParamLE(targetId, RS02Idx::RUN_MODE, rm5);
-    delay(30);
-    uint8_t cur = 0xFF;
-    if (readRunMode(targetId, cur) && cur != 5)
-        return false;
-    return ok;
+    if (!_rxTask.running())
+        return;
+    _rxTask.stop();
+    twai_reconfigure_alerts(TWAI_ALERT_NONE, nullptr);
 }
 
-// ===== 無限回転（パラメータ合成; 使えないFWあり）=====
-bool RS02PrivateTWAI::getInfiniteByParams(uint8_t targetId, double &turns, double &angleRad)
+void RS02PrivateTWAI::rxTaskEntry(void *arg)
 {
-    float rotA = 0.0f, rotB = 0.0f, mod = 0.0f;
-    bool okA = readFloatParam(targetId, RS02Idx::IDX_ROTATION, rotA);
-    bool okB = readFloatParam(targetId, RS02Idx::IDX_MECH_ANGLE_ROT, rotB);
-    bool okM = readFloatParam(targetId, RS02Idx::IDX_MODPOS, mod);
-    if (!okM)
-        return false;
-    float rot = okB ? rotB : (okA ? rotA : 0.0f);
-    turns = (double)llround((double)rot);
-    angleRad = turns * TWO_PI + (double)mod;
-    return (okA || okB);
+    RS02PrivateTWAI *self = static_cast<RS02PrivateTWAI *>(arg);
+    while (!self->_rxTask.stopRequested())
+    {
+        uint32_t alerts = 0;
+        twai_read_alerts(&alerts, pdMS_TO_TICKS(self->_rxIdleMs));
+        RS02BusGuard g(*self);
+        RS02TwaiRxStats &s = self->_rxStats;
+        s.wakeups++;
+        if (alerts & TWAI_ALERT_RX_QUEUE_FULL)
+            s.queueFull++;
+        if (alerts & TWAI_ALERT_RX_FIFO_OVERRUN)
+            s.fifoOverrun++;
+        twai_status_info_t st;
+        if (self->pollStatus(&st) && st.msgs_to_rx > s.maxBacklog)
+            s.maxBacklog = (uint16_t)st.msgs_to_rx;
+        // タイムアウトでも readAny を呼ぶ（送信キューを回す / 取りこぼしの確認）
+        RS02PrivFrame f;
+        while (self->readAny(f))
+            s.frames++;
+    }
+    self->_rxTask.exit();
 }
@@ -1,175 +1,134 @@
 #pragma once
 // RS02PrivateTWAI.h — ESP32 TWAI(内蔵CAN)向け RS02 プライベートプロトコル実装
 // 依存: Arduino, driver/twai.h（ESP-IDF）
+// プロトコル本体は RS02PrivateBase（本クラスは TWAI の送受信のみ）
+// 受信は readAny のポーリング（既定）か、startRxTask() の専用タスク（アラートで起きて読み切り、listener へ）。
+// 取りこぼし（rx_missed_count / rx_overrun_count の増分）は rxStats() に数え、listener の onRxLost で知らせる
+// 送信は既定でキュー満杯なら最大 50ms 待つ。setTxTimeoutMs(0) で待たずに返す（満杯なら false）。
+// 渡したフレームの完了 / 失敗（msgs_to_tx / tx_failed_count の変化。受信タスクは TX_SUCCESS / TX_FAILED で起きる）を
+// 追って、送信待ち数と 1 フレームごとの送信遅れ（渡してから完了まで）を txStats() に出す
 
 #include <Arduino.h>
 #include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <driver/twai.h>
+#include "RS02PrivateBase.h"
+#include "RS02Task.h"
 
-namespace RS02Idx
-{
-    // ランモード/制御
-    static constexpr uint16_t RUN_MODE = 0x7005; // u8: 0=Operation,1=PP,2=Velocity,3=Current,5=CSP
-    // 指令/上限
-    static constexpr uint16_t SPD_REF = 0x700A;      // f32: rad/s
-    static constexpr uint16_t LIMIT_TORQUE = 0x700B; // f32: Nm
-    static constexpr uint16_t IQ_REF = 0x7006;       // f32: A（Currentのq軸電流）
-    static constexpr uint16_t LOC_REF = 0x7016;      // f32: rad
-    static constexpr uint16_t LIMIT_SPD = 0x7017;    // f32: rad/s
-    static constexpr uint16_t LIMIT_CUR = 0x7018;    // f32: A（新系）
-    // センサ実測（TWAI動作実績に合わせる）
-    static constexpr uint16_t MECH_POS = 0x7019; // f32: 機械角 [rad]
-    static constexpr uint16_t MECH_VEL = 0x701B; // f32: 角速度 [rad/s]
-    // ゲイン
-    static constexpr uint16_t SPD_KP = 0x701C;  // f32
-    static constexpr uint16_t SPD_KI = 0x701D;  // f32
-    static constexpr uint16_t LOC_KP = 0x701E;  // f32
-    static constexpr uint16_t ACC_RAD = 0x7022; // f32: rad/s^2
-    static constexpr uint16_t CUR_KP = 0x7010;  // f32
-    static constexpr uint16_t CUR_KI = 0x7011;  // f32
-    // 旧系（個体差対策）
-    static constexpr uint16_t LIMIT_CUR_OLD = 0x2019; // f32: A
-    // 診断
-    static constexpr uint16_t CAN_MASTER = 0x200B; // u16
-    // （備考）一部FWで死んでいることがある:
-    static constexpr uint16_t IDX_ROTATION = 0x3014;       // f32
-    static constexpr uint16_t IDX_MODPOS = 0x3015;         // f32
-    static constexpr uint16_t IDX_MECH_ANGLE_ROT = 0x3036; // f32
-    static constexpr uint16_t IDX_EPSCAN_TIME = 0x5001;    // u16 (仮)
-}
-
-struct RS02PrivFrame
+// 完了を追えるフレーム数（送信キュー長 + 送信中 1 枠。setQueueLength の送信はこれ - 1 まで）
+#ifndef RS02_TWAI_TX_TRACK
+#define RS02_TWAI_TX_TRACK 64
+#endif
+
+struct RS02TwaiRxStats
 {
-    unsigned long id = 0;
-    uint8_t dlc = 0;
-    uint8_t data[8] = {0};
-    bool isExt = false;
+    uint32_t wakeups = 0;     // 受信タスクの起床（アラート / タイムアウト）
+    uint32_t frames = 0;      // 受信タスクが読んだフレーム
+    uint32_t queueFull = 0;   // TWAI_ALERT_RX_QUEUE_FULL（受信タスク使用時のみ）
+    uint32_t fifoOverrun = 0; // TWAI_ALERT_RX_FIFO_OVERRUN（同上）
+    uint32_t rxMissed = 0;    // 取りこぼしたフレーム数（ドライバのキュー満杯 + HW FIFO あふれ）
+    uint16_t maxBacklog = 0;  // 起床時点でドライバ受信キューに溜まっていた最大数
 };
 
-struct RS02Feedback
+struct RS02TwaiTxStats
 {
-    uint8_t motorId = 0;
-    uint16_t faultBits = 0;
-    uint8_t mode = 0;
-    float angleRad = 0.0f;
-    float velRadS = 0.0f;
-    float torqueNm = 0.0f;
-    float tempC = 0.0f;
+    uint32_t submitted = 0;     // ドライバに渡せた
+    uint32_t queueFull = 0;     // キュー満杯で渡せなかった（待ち時間内に空かなかった）
+    uint32_t completed = 0;     // 送信完了（ACK あり）
+    uint32_t failed = 0;        // 送信失敗（tx_failed_count の増分: 単発送信のエラー / ACK なし）
+    uint32_t dropped = 0;       // 送信前に破棄（送信待ちの破棄 / バスオフ回復）
+    uint16_t maxPending = 0;    // 送信待ち（送信中を含む）の最大
+    uint32_t lastLatencyUs = 0; // 渡してから完了を検出するまで
+    uint32_t maxLatencyUs = 0;
+    uint64_t totalLatencyUs = 0; // 平均 = totalLatencyUs / completed
 };
 
-class RS02PrivateTWAI
+class RS02PrivateTWAI : public RS02PrivateBase
 {
 public:
     explicit RS02PrivateTWAI(uint8_t hostId,
                              int twaiTxPin,
                              int twaiRxPin,
                              const twai_timing_config_t &timing = TWAI_TIMING_CONFIG_1MBITS())
-        : _hostId(hostId), _txPin(twaiTxPin), _rxPin(twaiRxPin), _timing(timing) {}
-
-    bool begin();
-    void setMasterId(uint8_t mid) { _masterId = mid; } // 既定=0xFD
-    uint8_t masterId() const { return _masterId; }
-    uint8_t hostId() const { return _hostId; }
-
-    // Motor CAN ID change (Type7: immediate)
-    bool setMotorId(uint8_t currentId, uint8_t newId);
-
-    // Motor CAN ID change via param 0x200A (Type18) + optional save (Type22)
-    bool setMotorIdViaParam(uint8_t targetId, uint8_t newId, bool save);
-
-    // Save all parameters (Type22)
-    bool saveParams(uint8_t targetId);
-
-    // 低レベル
-    bool sendExt(unsigned long id, const uint8_t *payload, uint8_t len);
-    bool readAny(RS02PrivFrame &out);
-
-    // 基本コマンド
-    bool ping(uint8_t targetId);                  // Type0
-    bool enable(uint8_t targetId);                // Type3
-    bool stop(uint8_t targetId, bool clearFault); // Type4
-
-    // パラメータR/W（index=LE）
-    bool writeParamLE(uint8_t targetId, uint16_t index, const uint8_t valueLE[4]);
-    bool writeFloatParam(uint8_t targetId, uint16_t index, float value);
-    bool readParamRaw(uint8_t targetId, uint16_t index, uint8_t out4LE[4]);
-    bool readFloatParam(uint8_t targetId, uint16_t index, float &out);
-
-    // プロトコル/レポート
-    bool switchProtocol(uint8_t targetId, uint8_t fcmd); // Type25
-    bool setActiveReport(uint8_t targetId, bool enable); // Type24
-    bool setReportIntervalTicks(uint8_t targetId, uint16_t ticks);
-
-    // Operation Control（Type1のみDA2=トルク）
-    bool opControl(uint8_t targetId, float torqueNm, float posRad, float velRadS, float kp, float kd);
-
-    // 受信解析 Type2
-    bool parseFeedback(const RS02PrivFrame &f, RS02Feedback &out);
-
-    // ランモード
-    bool setRunMode(uint8_t targetId, uint8_t runMode);
-    bool readRunMode(uint8_t targetId, uint8_t &outMode);
-
-    // ===== Velocity / PP / Current / CSP =====
-    bool enterVelocity(uint8_t targetId, float limitCurA, float accRadS2, float spdKp = NAN, float spdKi = NAN);
-    bool velocityRef(uint8_t targetId, float spdRadS);
-    bool enterVelocityStrict(uint8_t targetId, float limitTorqueNm, float limitCurA, float accRadS2, float spdKp = NAN, float spdKi = NAN);
-    bool bringUpVelocityPerSpec(uint8_t targetId, float limitCurA, float accRadS2, float spdRadS);
-
-    bool enterPP(uint8_t targetId, float limitSpdRadS, float locKp = NAN);
-    bool ppLocRef(uint8_t targetId, float posRad);
-    bool bringUpPPPerSpec(uint8_t targetId, float limitSpdRadS, float posRad);
-
-    bool enterCurrent(uint8_t targetId, float limitTorqueNm, float curKp = NAN, float curKi = NAN);
-    bool currentIqRef(uint8_t targetId, float iqA);
-    bool bringUpCurrentPerSpec(uint8_t targetId, float iqA);
+        : RS02PrivateBase(hostId), _txPin(twaiTxPin), _rxPin(twaiRxPin), _timing(timing) {}
 
-    bool enterCSP(uint8_t targetId, float limitSpdRadS, float limitCurA, float locKp = NAN);
-    bool cspLocRef(uint8_t targetId, float posRad);
-    bool bringUpCSPPerSpec(uint8_t targetId, float limitSpdRadS, float posRad);
-    bool enterCSP_simple(uint8_t targetId, float limitSpdRadS);
-    bool enterCSP_robust(uint8_t targetId, float limitSpdRadS, float limitCurA, float locKp = NAN);
+    ~RS02PrivateTWAI() override { stopRxTask(); }
 
-    // 無限回転（パラメータ合成: FWにより未更新の個体もある）
-    bool getInfiniteByParams(uint8_t targetId, double &turns, double &angleRad);
+    bool begin() override;
+    // ドライバのキュー長（begin 前に。既定 5/5 = TWAI_GENERAL_CONFIG_DEFAULT。モータ数が多いと受信 5 では溢れる）
+    void setQueueLength(uint16_t rxLen, uint16_t txLen)
+    {
+        _rxQueueLen = rxLen ? rxLen : 1;
+        _txQueueLen = txLen < RS02_TWAI_TX_TRACK ? txLen : RS02_TWAI_TX_TRACK - 1;
+    }
+    // モータ数からキュー長を決める（begin 前に）。受信 = 1 周期に 1 台 2 フレーム（応答 + レポート）+ 8、送信 = 台数 + 1
+    void setQueueForMotors(uint8_t motors) { setQueueLength((uint16_t)motors * 2 + 8, (uint16_t)motors + 1); }
+    uint16_t rxQueueLength() const { return _rxQueueLen; }
+    uint16_t txQueueLength() const { return _txQueueLen; }
+
+    // 送信キューが満杯のときに待つ時間（既定 50ms）。0 = 待たない（制御ループ向け。溢れた分は txStats().queueFull）
+    // 目標値の送信キュー（setTxQueue）を有効にすると常に 0
+    void setTxTimeoutMs(uint32_t ms) { _txTimeoutMs = ms; }
+    uint32_t txTimeoutMs() const { return _txTimeoutMs; }
+    // 単発送信（TWAI_MSG_FLAG_SS）: エラー / ACK なしでも再送しない（古い指令を送り直さない）。失敗は txStats().failed
+    void setTxSingleShot(bool on) { _txSingleShot = on; }
+
+    // 送信待ち（ドライバに渡して未完了, 送信中を含む）。完了の回収は送信 / 受信 / 受信タスクのたびに行う
+    uint16_t txPending() const { return _txCount; }
+    // 完了を今すぐ回収する（送受信をしない間に txStats を見るとき）
+    void pollTx();
+    const RS02TwaiTxStats &txStats() const { return _txStats; }
+    void resetTxStats() { _txStats = RS02TwaiTxStats(); }
+
+    // 受信タスク（begin 後に）。twai_read_alerts で受信 / あふれ / 送信完了を待ち、起きたらバスを取って readAny で読み切る
+    // （フレームは listener へ。readAny を呼ぶ側には残らない）。idleMs は受信が無くても送信キューを回す間隔
+    bool startRxTask(uint32_t idleMs = 10, int core = 0, UBaseType_t prio = 6);
+    void stopRxTask();
+    bool rxTaskRunning() const { return _rxTask.running(); }
+
+    const RS02TwaiRxStats &rxStats() const { return _rxStats; }
+    void resetRxStats() { _rxStats = RS02TwaiRxStats(); }
+    // 最後に取りこぼしを検出した micros()（0 = 未検出）
+    uint32_t lastRxLostUs() const { return _lastLostUs; }
+
+protected:
+    bool hwSend(unsigned long id, const uint8_t *payload, uint8_t len) override;
+    bool hwRead(RS02PrivFrame &out) override;
+    void hwFlushTx() override;
+    bool hwTxIdle() override;
+    uint16_t hwTxPending() override;
+    void hwSetTxAsync(bool async) override { _txAsync = async; }
+    bool hwStatus(RS02CanStatus &out) override;
+    bool hwRecover() override;
 
 private:
-    uint8_t _hostId = 0x00;
-    uint8_t _masterId = 0xFD;
     int _txPin;
     int _rxPin;
     twai_timing_config_t _timing;
-
-    inline uint16_t da2_master() const { return ((uint16_t)_masterId << 8) | 0x00; }
-    static inline uint32_t buildExId(uint8_t type5, uint16_t da2, uint8_t dst)
-    {
-        return ((uint32_t)(type5 & 0x1F) << 24) | ((uint32_t)da2 << 8) | (uint32_t)dst;
-    }
-
-    // パック/演算
-    static inline void packU16BE(uint16_t v, uint8_t *p)
-    {
-        p[0] = (uint8_t)(v >> 8);
-        p[1] = (uint8_t)(v);
-    }
-    static inline uint16_t unpackU16BE(const uint8_t *p) { return ((uint16_t)p[0] << 8) | p[1]; }
-    static inline void packF32LE(float f, uint8_t *p)
-    {
-        uint32_t u;
-        memcpy(&u, &f, 4);
-        p[0] = u;
-        p[1] = u >> 8;
-        p[2] = u >> 16;
-        p[3] = u >> 24;
-    }
-
-    static inline uint16_t float_to_uint(float x, float x_min, float x_max)
-    {
-        float cl = (x < x_min) ? x_min : (x > x_max ? x_max : x);
-        return (uint16_t)((cl - x_min) * 65535.0f / (x_max - x_min));
-    }
-    static inline float uint_to_float(uint16_t x, float x_min, float x_max)
-    {
-        return ((float)x) * (x_max - x_min) / 65535.0f + x_min;
-    }
+    uint16_t _rxQueueLen = 5;
+    uint16_t _txQueueLen = 5;
+
+    RS02TwaiRxStats _rxStats;
+    uint32_t _lostSeen = 0;
+    uint32_t _lastLostUs = 0;
+    RS02TaskSlot _rxTask;
+    uint32_t _rxIdleMs = 10;
+
+    // 送信完了の追跡（渡した順に完了する: 時刻のリング）
+    RS02TwaiTxStats _txStats;
+    uint32_t _txTimeoutMs = 50;
+    bool _txAsync = false;
+    bool _txSingleShot = false;
+    uint32_t _txT[RS02_TWAI_TX_TRACK];
+    uint16_t _txHead = 0;
+    uint16_t _txCount = 0;
+    uint32_t _txFailedSeen = 0;
+
+    // 状態を 1 回読んで 取りこぼし / 送信完了 を回収
+    bool pollStatus(twai_status_info_t *out = nullptr);
+    void checkRxLost(const twai_status_info_t &st);
+    void trackTx(const twai_status_info_t &st);
+    void dropTx(uint16_t n);
+    static void rxTaskEntry(void *arg);
 };
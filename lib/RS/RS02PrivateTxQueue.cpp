@@ -0,0 +1,202 @@
+// RS02PrivateTxQueue.cpp — 目標値の送信キュー（差し替え / 期限切れ破棄 / 送信中の取り消し）と送信完了を待たない区間
+// 混雑で送れなかった古い目標値を後から送るより、最新値だけを期限内に届ける。
+// HW には 1 フレームずつ渡す（TWAI キューや MCP2515 の 3 面に積むと取り消せない古い値が残る）
+#include "RS02PrivateBase.h"
+#include "RS02Instr.h"
+
+// (dst, 通信タイプ) + Type18 は index。Type1 の DA2（トルク）は値なのでキーに含めない
+uint32_t RS02PrivateBase::txKey(unsigned long id, const uint8_t *payload, uint8_t len)
+{
+    uint32_t key = (uint32_t)id & 0x1F0000FFUL;
+    if (rs02FrameType(id) == RS02Type::WRITE_PARAM && len >= 2)
+        key |= (uint32_t)(payload[0] | (payload[1] << 8)) << 8;
+    return key;
+}
+
+void RS02PrivateBase::setTxQueue(const RS02TxQueueConfig &cfg)
+{
+    RS02BusGuard g(*this);
+    if (!cfg.enabled)
+        txqClear();
+    _txqCfg = cfg;
+    if (_txqCfg.deadlineUs == 0)
+        _txqCfg.deadlineUs = 1;
+    hwSetTxAsync(_txqCfg.enabled || _asyncDepth);
+}
+
+bool RS02PrivateBase::txIdle()
+{
+    RS02BusGuard g(*this);
+    if (_txdCount)
+        txDonePoll();
+    return hwTxIdle();
+}
+
+bool RS02PrivateBase::waitTxIdle(uint32_t us)
+{
+    uint32_t t0 = micros();
+    while (!txIdle())
+    {
+        if ((uint32_t)(micros() - t0) >= us)
+            return false;
+        RS02PrivFrame f;
+        if (!readAny(f)) // 受信はリスナーへ
+            delayMicroseconds(5);
+    }
+    return true;
+}
+
+void RS02PrivateBase::beginAsyncSend()
+{
+    RS02BusGuard g(*this);
+    if (_asyncDepth++ == 0)
+        hwSetTxAsync(true);
+}
+
+void RS02PrivateBase::endAsyncSend()
+{
+    RS02BusGuard g(*this);
+    if (_asyncDepth == 0)
+        return;
+    if (_asyncDepth == 1)
+        waitTxIdle();
+    if (--_asyncDepth == 0)
+        hwSetTxAsync(_txqCfg.enabled); // 送信キューが有効なら非同期のまま
+}
+
+void RS02PrivateBase::txqClear()
+{
+    _txqStats.dropped += _txqCount;
+    _txqHead = 0;
+    _txqCount = 0;
+    _txInflight = false;
+}
+
+void RS02PrivateBase::txqDropDst(uint8_t dst)
+{
+    // 残すものを詰め直す（順序は保つ）
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < _txqCount; i++)
+    {
+        const TxSlot &s = _txq[(_txqHead + i) % RS02_TXQ_DEPTH];
+        if (rs02FrameDst(s.id) == dst)
+        {
+            _txqStats.dropped++;
+            continue;
+        }
+        _txq[(_txqHead + n) % RS02_TXQ_DEPTH] = s;
+        n++;
+    }
+    _txqCount = n;
+}
+
+// sendExt から: 停止 / ID 変更 / ランモード書き込みの前に、そのモータ宛ての古い目標値を捨てる
+void RS02PrivateBase::txqOnDirectSend(unsigned long id, const uint8_t *payload, uint8_t len)
+{
+    if (_txInflight)
+        _txInflightShared = true;
+    uint8_t type = rs02FrameType(id);
+    bool drop = type == RS02Type::STOP || type == RS02Type::SET_ID;
+    if (type == RS02Type::WRITE_PARAM && len >= 2)
+        drop = (uint16_t)(payload[0] | (payload[1] << 8)) == RS02Idx::RUN_MODE;
+    if (drop && _txqCount)
+        txqDropDst(rs02FrameDst(id));
+}
+
+bool RS02PrivateBase::sendSetpoint(unsigned long id, const uint8_t *payload, uint8_t len, uint32_t deadlineUs)
+{
+    if (!_txqCfg.enabled)
+        return sendExt(id, payload, len);
+
+    RS02BusGuard g(*this);
+    if (len > 8)
+        len = 8;
+    uint32_t key = txKey(id, payload, len);
+    _txqStats.queued++;
+
+    TxSlot *slot = nullptr;
+    for (uint8_t i = 0; i < _txqCount; i++)
+    {
+        TxSlot &s = _txq[(_txqHead + i) % RS02_TXQ_DEPTH];
+        if (s.key == key)
+        {
+            slot = &s; // 位置はそのまま（他モータより先に出る順番は変えない）
+            _txqStats.superseded++;
+            break;
+        }
+    }
+    if (!slot)
+    {
+        if (_txqCount >= RS02_TXQ_DEPTH)
+        {
+            _txqHead = (uint8_t)((_txqHead + 1) % RS02_TXQ_DEPTH);
+            _txqCount--;
+            _txqStats.dropped++;
+        }
+        slot = &_txq[(_txqHead + _txqCount) % RS02_TXQ_DEPTH];
+        _txqCount++;
+        if (_txqCount > _txqStats.maxDepth)
+            _txqStats.maxDepth = _txqCount;
+    }
+    slot->id = (uint32_t)id;
+    slot->key = key;
+    slot->tUs = micros();
+    slot->deadlineUs = deadlineUs ? deadlineUs : _txqCfg.deadlineUs;
+    slot->len = len;
+    memcpy(slot->data, payload, len);
+
+    pumpTx();
+    return true;
+}
+
+void RS02PrivateBase::pumpTx()
+{
+    if (!_txqCfg.enabled || (!_txInflight && _txqCount == 0))
+        return;
+    RS02BusGuard g(*this);
+    uint32_t now = micros();
+
+    if (_txInflight)
+    {
+        if (hwTxIdle())
+            _txInflight = false;
+        else if ((int32_t)(now - _txInflightDue) >= 0)
+        {
+            // 後ろに sendExt のフレームがあると一緒に消えるので取り消さない
+            if (!_txInflightShared && hwAbortTx())
+            {
+                _txqStats.aborted++;
+                txDoneDrop();
+            }
+            else
+                _txqStats.late++;
+            _txInflight = false;
+        }
+    }
+
+    while (_txqCount)
+    {
+        const TxSlot &s = _txq[_txqHead];
+        if ((uint32_t)(now - s.tUs) < s.deadlineUs)
+            break;
+        _txqStats.expired++;
+        _txqHead = (uint8_t)((_txqHead + 1) % RS02_TXQ_DEPTH);
+        _txqCount--;
+    }
+    if (_txInflight || _txqCount == 0 || !hwTxIdle())
+        return;
+
+    TxSlot s = _txq[_txqHead];
+    _txqHead = (uint8_t)((_txqHead + 1) % RS02_TXQ_DEPTH);
+    _txqCount--;
+    bool ok = hwSend(s.id, s.data, s.len);
+    if (!ok)
+        RS02_INSTR_COUNT(RS02Counter::TX_FAIL, 1);
+    notifyTx(s.id, s.data, s.len, ok);
+    if (!ok)
+        return;
+    _txqStats.sent++;
+    _txInflight = true;
+    _txInflightShared = false;
+    _txInflightDue = s.tUs + s.deadlineUs;
+}
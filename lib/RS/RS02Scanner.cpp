@@ -0,0 +1,199 @@
+// RS02Scanner.cpp — Type0 の一斉送信と応答の収集、見つかったモータの Type17 読み出し（重ねて送る）
+#include "RS02Scanner.h"
+
+uint8_t RS02Scanner::scan(const RS02ScanConfig &cfg)
+{
+    RS02BusGuard g(_bus);
+    _cfg = cfg;
+    if (_cfg.lastId > 127)
+        _cfg.lastId = 127;
+    if (_cfg.nInfo > RS02_SCAN_INFO)
+        _cfg.nInfo = RS02_SCAN_INFO;
+    _stats = RS02ScanStats();
+    _found.clear();
+    _n = 0;
+    memset(_pingUs, 0, sizeof(_pingUs));
+    if (!_bus.addListener(this))
+        return 0;
+    uint32_t t0 = micros();
+    {
+        RS02AsyncSend async(_bus); // 送信完了を待たない（待つあいだは waitTxIdle で受信を読む）
+
+        // 1) 範囲の全 ID へ Type0。送信の合間に届いた応答を読む（受信バッファを溜めない）
+        for (uint16_t id = _cfg.firstId; id <= _cfg.lastId; id++)
+        {
+            _pingUs[id] = micros();
+            _stats.pings++;
+            if (!_bus.waitTxIdle() || !_bus.ping((uint8_t)id))
+                _stats.pingFails++;
+            while (pump())
+            {
+            }
+        }
+        // 2) 最後の送信から listenUs だけ応答を待つ（台数が分かっていればそろった時点で終わり）
+        uint32_t tLast = micros();
+        while ((uint32_t)(micros() - tLast) < _cfg.listenUs)
+        {
+            if (_cfg.expect && _n >= _cfg.expect)
+                break;
+            if (!pump())
+                delayMicroseconds(20);
+        }
+        _stats.pingUs = micros() - t0;
+
+        // 3) 見つかったモータの情報
+        uint32_t t1 = micros();
+        if (_cfg.readInfo && _cfg.nInfo)
+            readInfo();
+        _stats.infoUs = micros() - t1;
+    }
+    _bus.removeListener(this);
+    sortFound();
+    _stats.totalUs = micros() - t0;
+    return _n;
+}
+
+bool RS02Scanner::pump()
+{
+    RS02PrivFrame f;
+    return _bus.readAny(f); // 応答は onRxFrame で
+}
+
+void RS02Scanner::sortFound()
+{
+    _n = 0;
+    for (uint8_t id = 0; id < 128; id++)
+        if (_found.has(id))
+            _order[_n++] = id;
+}
+
+// Type17 を maxInFlight 本まで重ねて送り、応答かタイムアウトで次を送る
+void RS02Scanner::readInfo()
+{
+    sortFound(); // 読むのはこの時点で見つかっているモータ
+    _nInfoIds = _n;
+    _infoNext = 0;
+    RS02ParamPipelineConfig pc;
+    pc.maxInFlight = _cfg.maxInFlight;
+    pc.timeoutUs = _cfg.infoTimeoutUs;
+    pc.retries = _cfg.infoRetries;
+    _pipe.run(*this, pc);
+    _stats.infoReads = _pipe.stats().reads;
+    _stats.infoReplies = _pipe.stats().replies;
+    _stats.infoTimeouts = _pipe.stats().timeouts;
+}
+
+// モータを先に回す（同じモータへの要求を続けない）
+bool RS02Scanner::nextRead(uint8_t &motorId, uint16_t &index, uint16_t &tag)
+{
+    if (!_nInfoIds || _infoNext >= (uint16_t)_nInfoIds * _cfg.nInfo)
+        return false;
+    motorId = _order[_infoNext % _nInfoIds];
+    tag = _infoNext / _nInfoIds;
+    index = _cfg.info[tag];
+    _infoNext++;
+    return true;
+}
+
+void RS02Scanner::onRead(uint8_t motorId, uint16_t tag, RS02ParamRead r, const uint8_t *data)
+{
+    RS02ScanEntry &e = _e[motorId];
+    if (r == RS02ParamRead::Ok)
+    {
+        memcpy(e.info[tag], data, 4);
+        e.infoOk |= (uint8_t)(1u << tag);
+    }
+    else if (r == RS02ParamRead::Error)
+        e.infoErr |= (uint8_t)(1u << tag);
+}
+
+void RS02Scanner::onRxFrame(const RS02PrivFrame &f)
+{
+    if (!f.isExt || f.dlc < 8)
+        return;
+    uint8_t type = rs02FrameType(f.id);
+    uint8_t motor = (uint8_t)((f.id >> 8) & 0xFF);
+    if (motor >= 128)
+        return;
+    if (type == RS02Type::GET_ID && rs02FrameDst(f.id) == 0xFE)
+    {
+        uint64_t uid = 0;
+        for (uint8_t i = 0; i < 8; i++)
+            uid |= (uint64_t)f.data[i] << (8 * i);
+        _stats.replies++;
+        RS02ScanEntry &e = _e[motor];
+        if (!_found.has(motor))
+        {
+            e = RS02ScanEntry();
+            e.id = motor;
+            e.uid = uid;
+            e.replyUs = _pingUs[motor] ? f.tsUs - _pingUs[motor] : 0;
+            _found.add(motor);
+            _n++;
+        }
+        else if (uid != e.uid && !e.conflict)
+        {
+            e.conflict = true;
+            e.uidAlt = uid;
+            _stats.conflicts++;
+        }
+        return;
+    }
+    _pipe.onReply(f);
+}
+
+const RS02ScanEntry *RS02Scanner::find(uint8_t motorId) const
+{
+    return motorId < 128 && _found.has(motorId) ? &_e[motorId] : nullptr;
+}
+
+const RS02ScanEntry *RS02Scanner::findUid(uint64_t uid) const
+{
+    for (uint8_t i = 0; i < _n; i++)
+    {
+        const RS02ScanEntry &e = entry(i);
+        if (e.uid == uid || (e.conflict && e.uidAlt == uid))
+            return &e;
+    }
+    return nullptr;
+}
+
+const char *RS02Scanner::modelName(const RS02ScanEntry &e) const
+{
+    for (uint8_t i = 0; i < _cfg.nInfo; i++)
+    {
+        if (_cfg.info[i] != RS02Idx::LIMIT_TORQUE || !(e.infoOk & (1u << i)))
+            continue;
+        float t = e.infoF(i);
+        if (t > 12.0f)
+            return "RS02";
+        if (t > 0.0f)
+            return "RS05";
+    }
+    return "?";
+}
+
+void RS02Scanner::print(Print &out) const
+{
+    out.printf("scan %u-%u: %u motor(s) in %.1fms (ping %.1fms, info %.1fms), %u conflict(s)\n", _cfg.firstId,
+               _cfg.lastId, _n, _stats.totalUs / 1000.0f, _stats.pingUs / 1000.0f, _stats.infoUs / 1000.0f,
+               _stats.conflicts);
+    for (uint8_t i = 0; i < _n; i++)
+    {
+        const RS02ScanEntry &e = entry(i);
+        out.printf("  id 0x%02X uid %08lX%08lX %5luus %-4s", e.id, (unsigned long)(e.uid >> 32), (unsigned long)(uint32_t)e.uid,
+                   (unsigned long)e.replyUs, modelName(e));
+        for (uint8_t k = 0; k < _cfg.nInfo; k++)
+        {
+            if (!(e.infoOk & (1u << k)))
+                out.printf(" %04X=%s", _cfg.info[k], (e.infoErr & (1u << k)) ? "err" : "--");
+            else if (_cfg.info[k] >= 0x7000 && _cfg.info[k] != RS02Idx::RUN_MODE)
+                out.printf(" %04X=%.2f", _cfg.info[k], e.infoF(k));
+            else
+                out.printf(" %04X=%lu", _cfg.info[k], (unsigned long)e.infoU(k));
+        }
+        if (e.conflict)
+            out.printf("  CONFLICT uid %08lX%08lX", (unsigned long)(e.uidAlt >> 32), (unsigned long)(uint32_t)e.uidAlt);
+        out.printf("\n");
+    }
+}
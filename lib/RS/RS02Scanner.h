@@ -0,0 +1,113 @@
+#pragma once
+// RS02Scanner.h — バス上のモータ探索（ID 0..127 へ Type0 を続けて送り、応答をまとめて受ける）
+// 1 ID ずつ送って応答を待つ（Type17 0x200A の 300ms タイムアウト × 居ない ID の数）のではなく、
+// 範囲の全 ID へ Type0 をバスの空きだけで送り、最後の送信から listenUs だけ待って応答（Type0: MCU UID）を集める。
+// 見つかったモータには続けて Type17 で情報（既定: マスターID / トルク上限 / 電流上限 / ランモード）を
+// maxInFlight 本まで重ねて読む（RS02ParamPipeline。応答は bit8-15 のモータ ID と index エコーで振り分け）。
+// scan() のあいだはバスを占有する（他タスクの送受信は待たされる。数十 ms 程度）。
+// 送信は完了を待たずに戻し（RS02AsyncSend）、前のフレームが出るまでは受信を読む（waitTxIdle）。
+// 応答の遅いモータの Type0 が送信待ちのあいだに続けて届いても、MCP2515 の受信 2 面を溢れさせない。
+// 同じ ID から別の UID が返った場合は conflict（ID の重複）として残す。
+
+#include <Arduino.h>
+#include "RS02PrivateBase.h"
+#include "RS02ParamPipeline.h"
+
+#ifndef RS02_SCAN_INFO
+#define RS02_SCAN_INFO 4
+#endif
+
+struct RS02ScanConfig
+{
+    uint8_t firstId = 0;
+    uint8_t lastId = 127;
+    uint32_t listenUs = 5000;  // 最後の Type0 から応答を待つ時間
+    uint8_t expect = 0;        // 見つかる台数が分かっていれば（そろった時点で待ちを打ち切る, 0=待ち切る）
+    bool readInfo = true;      // 見つかったモータの Type17 読み出し
+    uint8_t nInfo = 4;
+    uint16_t info[RS02_SCAN_INFO] = {RS02Idx::CAN_MASTER, RS02Idx::LIMIT_TORQUE, RS02Idx::LIMIT_CUR, RS02Idx::RUN_MODE};
+    uint8_t maxInFlight = 2;   // 応答待ちの Type17 の上限（MCP2515 の受信 2 面に合わせる。TWAI なら増やせる）
+    uint32_t infoTimeoutUs = 20000;
+    uint8_t infoRetries = 1;
+};
+
+struct RS02ScanEntry
+{
+    uint8_t id = 0;
+    uint64_t uid = 0;       // Type0 応答のデータ 8byte（LE）
+    uint64_t uidAlt = 0;    // 同じ ID から返った別の UID（conflict のとき）
+    bool conflict = false;
+    uint32_t replyUs = 0;   // その ID への Type0 送信から応答まで
+    uint8_t infoOk = 0;     // bit i: info[i] を読めた
+    uint8_t infoErr = 0;    // bit i: 応答が失敗（未知 index など）
+    uint8_t info[RS02_SCAN_INFO][4] = {}; // 読んだ値（LE 4byte）
+
+    float infoF(uint8_t i) const
+    {
+        float f;
+        memcpy(&f, info[i], 4);
+        return f;
+    }
+    uint32_t infoU(uint8_t i) const
+    {
+        return (uint32_t)info[i][0] | ((uint32_t)info[i][1] << 8) | ((uint32_t)info[i][2] << 16) | ((uint32_t)info[i][3] << 24);
+    }
+};
+
+struct RS02ScanStats
+{
+    uint32_t totalUs = 0; // scan() 全体
+    uint32_t pingUs = 0;  // Type0 の送信〜待ち終わり
+    uint32_t infoUs = 0;  // Type17 の読み出し
+    uint16_t pings = 0;
+    uint16_t pingFails = 0; // 送信失敗（ACK なし等）
+    uint16_t replies = 0;   // Type0 応答
+    uint16_t infoReads = 0; // Type17 要求（再送込み）
+    uint16_t infoReplies = 0;
+    uint16_t infoTimeouts = 0;
+    uint8_t conflicts = 0;
+};
+
+class RS02Scanner : public RS02FrameListener, public RS02ParamReader
+{
+public:
+    explicit RS02Scanner(RS02PrivateBase &bus) : _bus(bus), _pipe(bus) {}
+
+    // 探索して見つかった台数を返す（結果は entry() / find() で、ID の小さい順）
+    uint8_t scan(const RS02ScanConfig &cfg = RS02ScanConfig());
+    uint8_t count() const { return _n; }
+    const RS02ScanEntry &entry(uint8_t i) const { return _e[_order[i]]; }
+    const RS02ScanEntry *find(uint8_t motorId) const;
+    const RS02ScanEntry *findUid(uint64_t uid) const;
+    const RS02MotorSet &found() const { return _found; }
+    const RS02ScanStats &stats() const { return _stats; }
+    const RS02ScanConfig &config() const { return _cfg; }
+
+    // 機種の目安（LIMIT_TORQUE を読んでいれば。既定値 RS02=17Nm / RS05=5.5Nm から。書き換えてあれば当てにならない）
+    const char *modelName(const RS02ScanEntry &e) const;
+
+    // 見つかったモータの表（ID / UID / 応答時間 / info）
+    void print(Print &out) const;
+
+    void onRxFrame(const RS02PrivFrame &f) override;
+    // 情報の読み出し（RS02ParamPipeline から）
+    bool nextRead(uint8_t &motorId, uint16_t &index, uint16_t &tag) override;
+    void onRead(uint8_t motorId, uint16_t tag, RS02ParamRead r, const uint8_t *data) override;
+
+private:
+    RS02PrivateBase &_bus;
+    RS02ParamPipeline _pipe;
+    RS02ScanConfig _cfg;
+    RS02ScanStats _stats;
+    RS02ScanEntry _e[128];
+    RS02MotorSet _found;
+    uint8_t _order[128];
+    uint8_t _n = 0;
+    uint32_t _pingUs[128];
+    uint8_t _nInfoIds = 0; // readInfo: _order の先頭から
+    uint16_t _infoNext = 0;
+
+    bool pump();
+    void sortFound();
+    void readInfo();
+};
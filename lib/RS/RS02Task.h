@@ -0,0 +1,49 @@
+#pragma once
+// RS02Task.h — 専用タスクの起動 / 停止（TWAI 受信・監視・バス健全性・複数バス・ゲートウェイで共用）
+// タスクは最後に exit() でハンドルを nullptr にし（release）、停止側は running() を acquire で読んで待つ。
+// 停止要求も同じく __atomic で渡す（タスク側は stopRequested() をループ条件に）
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+struct RS02TaskSlot
+{
+    TaskHandle_t handle = nullptr;
+    bool stopReq = false;
+
+    bool running() const { return __atomic_load_n(&handle, __ATOMIC_ACQUIRE) != nullptr; }
+    bool stopRequested() const { return __atomic_load_n(&stopReq, __ATOMIC_ACQUIRE); }
+
+    // 動いていれば何もせず true
+    bool start(TaskFunction_t fn, const char *name, void *arg, UBaseType_t prio, int core)
+    {
+        if (running())
+            return true;
+        __atomic_store_n(&stopReq, false, __ATOMIC_RELEASE);
+        if (xTaskCreatePinnedToCore(fn, name, 4096, arg, prio, &handle, core) == pdPASS)
+            return true;
+        __atomic_store_n(&handle, (TaskHandle_t) nullptr, __ATOMIC_RELEASE);
+        return false;
+    }
+    void requestStop() { __atomic_store_n(&stopReq, true, __ATOMIC_RELEASE); }
+    // タスクが exit() するまで待つ（タスク自身から呼ばないこと）
+    void join()
+    {
+        while (running())
+            delay(1);
+    }
+    void stop()
+    {
+        if (!running())
+            return;
+        requestStop();
+        join();
+    }
+    // タスク関数の最後で（戻らない）
+    void exit()
+    {
+        __atomic_store_n(&handle, (TaskHandle_t) nullptr, __ATOMIC_RELEASE);
+        vTaskDelete(NULL);
+    }
+};
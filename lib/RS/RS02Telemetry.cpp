@@ -0,0 +1,67 @@
+// RS02Telemetry.cpp — 最新 Type2 の保持（受信経路）と読み出し（バス排他でコピー）
+#include "RS02Telemetry.h"
+
+void RS02Telemetry::watch(uint8_t motorId)
+{
+    RS02BusGuard g(_bus);
+    _watch.add(motorId);
+}
+
+void RS02Telemetry::watch(const RS02MotorSet &ids)
+{
+    RS02BusGuard g(_bus);
+    for (int i = 0; i < 4; i++)
+        _watch.bits[i] |= ids.bits[i];
+}
+
+void RS02Telemetry::unwatch(uint8_t motorId)
+{
+    RS02BusGuard g(_bus);
+    _watch.remove(motorId);
+}
+
+uint8_t RS02Telemetry::list(uint8_t *ids, uint8_t max) const
+{
+    uint8_t n = 0;
+    for (uint8_t id = 0; id < 128 && n < max; id++)
+        if (_watch.has(id))
+            ids[n++] = id;
+    return n;
+}
+
+bool RS02Telemetry::get(uint8_t motorId, RS02TelemetrySample &out)
+{
+    if (motorId >= 128)
+        return false;
+    RS02BusGuard g(_bus);
+    if (_s[motorId].rxUs == 0)
+        return false;
+    out = _s[motorId];
+    return true;
+}
+
+bool RS02Telemetry::get(uint8_t motorId, RS02Feedback &out, uint32_t *ageUs)
+{
+    RS02TelemetrySample s;
+    if (!get(motorId, s))
+        return false;
+    out = s.fb;
+    if (ageUs)
+        *ageUs = micros() - s.rxUs;
+    return true;
+}
+
+void RS02Telemetry::onRxFrame(const RS02PrivFrame &f)
+{
+    RS02Feedback fb;
+    if (!f.isExt || !_bus.parseFeedback(f, fb) || fb.motorId >= 128)
+        return;
+    if (!_watch.empty() && !_watch.has(fb.motorId))
+        return;
+    RS02TelemetrySample &s = _s[fb.motorId];
+    s.fb = fb;
+    s.rxUs = f.tsUs ? f.tsUs : 1;
+    s.frames++;
+    __atomic_store_n(&s.seq, s.seq + 1, __ATOMIC_RELEASE);
+    _frames++;
+}
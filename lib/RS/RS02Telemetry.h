@@ -0,0 +1,47 @@
+#pragma once
+// RS02Telemetry.h — モータごとの最新 Type2（モード / 角度 / 速度 / トルク / 温度 / 故障ビット）と受信時刻の共有置き場
+// RS02FrameListener として readAny() の経路（バス排他の内側）で更新する。表示やログはここから読むだけで、
+// 画面のタイルや行の数が増えてもバスの通信は増えない（Type17 で個別に読まない）。
+// seq(id) は Type2 を受けるたびに増えるので、表示側は前回の seq と比べて変わったモータだけ描き直せる。
+
+#include <Arduino.h>
+#include "RS02PrivateBase.h"
+
+struct RS02TelemetrySample
+{
+    RS02Feedback fb;
+    uint32_t rxUs = 0;   // 受信時刻（micros, 0=未受信）
+    uint32_t seq = 0;    // 受信ごとに +1
+    uint32_t frames = 0; // 受信した Type2 の数
+};
+
+class RS02Telemetry : public RS02FrameListener
+{
+public:
+    explicit RS02Telemetry(RS02PrivateBase &bus) : _bus(bus) {}
+
+    bool begin() { return _bus.addListener(this); }
+    void end() { _bus.removeListener(this); }
+
+    // 見るモータ（何も登録しなければ全 ID）
+    void watch(uint8_t motorId);
+    void watch(const RS02MotorSet &ids);
+    void unwatch(uint8_t motorId);
+    const RS02MotorSet &watched() const { return _watch; }
+    // 登録済みのモータ ID を小さい順に（戻り値は個数）
+    uint8_t list(uint8_t *ids, uint8_t max) const;
+
+    // 最新の Type2（バス排他を取ってコピー）。未受信なら false
+    bool get(uint8_t motorId, RS02TelemetrySample &out);
+    bool get(uint8_t motorId, RS02Feedback &out, uint32_t *ageUs = nullptr);
+    uint32_t seq(uint8_t motorId) const { return motorId < 128 ? __atomic_load_n(&_s[motorId].seq, __ATOMIC_ACQUIRE) : 0; }
+    uint32_t frames() const { return _frames; }
+
+    void onRxFrame(const RS02PrivFrame &f) override;
+
+private:
+    RS02PrivateBase &_bus;
+    RS02MotorSet _watch; // 空 = 全 ID
+    RS02TelemetrySample _s[128];
+    uint32_t _frames = 0;
+};
@@ -0,0 +1,183 @@
+#pragma once
+// RS02Types.h — RS02/RS05 プライベートプロトコル共通定義（MCP2515/TWAI 両バックエンドで共有）
+
+#include <stdint.h>
+#include <string.h>
+
+namespace RS02Idx
+{
+    // ランモード/制御
+    static constexpr uint16_t RUN_MODE = 0x7005; // u8: 0=Operation,1=PP,2=Velocity,3=Current,5=CSP
+    // 指令/上限
+    static constexpr uint16_t SPD_REF = 0x700A;      // f32: rad/s
+    static constexpr uint16_t LIMIT_TORQUE = 0x700B; // f32: Nm
+    static constexpr uint16_t IQ_REF = 0x7006;       // f32: A（Currentのq軸電流）
+    static constexpr uint16_t LOC_REF = 0x7016;      // f32: rad
+    static constexpr uint16_t LIMIT_SPD = 0x7017;    // f32: rad/s
+    static constexpr uint16_t LIMIT_CUR = 0x7018;    // f32: A（新系）
+    // センサ実測（TWAI動作実績に合わせる）
+    static constexpr uint16_t MECH_POS = 0x7019; // f32: 機械角 [rad]
+    static constexpr uint16_t MECH_VEL = 0x701B; // f32: 角速度 [rad/s]
+    // ゲイン
+    static constexpr uint16_t SPD_KP = 0x701C;  // f32
+    static constexpr uint16_t SPD_KI = 0x701D;  // f32
+    static constexpr uint16_t LOC_KP = 0x701E;  // f32
+    static constexpr uint16_t ACC_RAD = 0x7022; // f32: rad/s^2
+    static constexpr uint16_t CUR_KP = 0x7010;  // f32
+    static constexpr uint16_t CUR_KI = 0x7011;  // f32
+    // 旧系（個体差対策）
+    static constexpr uint16_t LIMIT_CUR_OLD = 0x2019; // f32: A
+    // 診断
+    static constexpr uint16_t CAN_ID = 0x200A;     // u8: 保存後の再起動で反映
+    static constexpr uint16_t CAN_MASTER = 0x200B; // u16
+    // （備考）一部FWで死んでいることがある:
+    static constexpr uint16_t IDX_ROTATION = 0x3014;       // f32
+    static constexpr uint16_t IDX_MODPOS = 0x3015;         // f32
+    static constexpr uint16_t IDX_MECH_ANGLE_ROT = 0x3036; // f32
+    static constexpr uint16_t IDX_EPSCAN_TIME = 0x5001;    // u16 (仮)
+}
+
+// 通信タイプ（拡張ID bit24-28）
+namespace RS02Type
+{
+    static constexpr uint8_t GET_ID = 0x00;        // Type0
+    static constexpr uint8_t OP_CONTROL = 0x01;    // Type1
+    static constexpr uint8_t FEEDBACK = 0x02;      // Type2
+    static constexpr uint8_t ENABLE = 0x03;        // Type3
+    static constexpr uint8_t STOP = 0x04;          // Type4
+    static constexpr uint8_t SET_ID = 0x07;        // Type7
+    static constexpr uint8_t READ_PARAM = 0x11;    // Type17
+    static constexpr uint8_t WRITE_PARAM = 0x12;   // Type18
+    static constexpr uint8_t SAVE_PARAMS = 0x16;   // Type22
+    static constexpr uint8_t ACTIVE_REPORT = 0x18; // Type24
+    static constexpr uint8_t PROTOCOL = 0x19;      // Type25
+}
+
+// Type2 故障ビット（ID bit16-21 → RS02Feedback::faultBits の bit0-5）
+namespace RS02Fault
+{
+    static constexpr uint16_t UNDERVOLTAGE = 0x01;  // bit16: 低電圧
+    static constexpr uint16_t OVERCURRENT = 0x02;   // bit17: 過電流
+    static constexpr uint16_t OVERTEMP = 0x04;      // bit18: 過温度
+    static constexpr uint16_t ENCODER = 0x08;       // bit19: 磁気エンコーダ故障
+    static constexpr uint16_t OVERLOAD = 0x10;      // bit20: 過負荷/ストール
+    static constexpr uint16_t UNCALIBRATED = 0x20;  // bit21: 未キャリブレーション
+    static constexpr uint16_t ALL = 0x3F;
+}
+
+// Type2 モードビット（ID bit22-23 → RS02Feedback::mode）
+namespace RS02MotorState
+{
+    static constexpr uint8_t RESET = 0; // 停止（Reset）
+    static constexpr uint8_t CALI = 1;  // キャリブレーション中
+    static constexpr uint8_t RUN = 2;   // 運転（Motor）
+}
+
+struct RS02PrivFrame
+{
+    unsigned long id = 0;
+    uint8_t dlc = 0;
+    uint8_t data[8] = {0};
+    bool isExt = false;
+    uint32_t tsUs = 0; // 受信/送信時刻 micros()
+};
+
+struct RS02Feedback
+{
+    uint8_t motorId = 0;
+    uint16_t faultBits = 0;
+    uint8_t mode = 0;
+    float angleRad = 0.0f;
+    float velRadS = 0.0f;
+    float torqueNm = 0.0f;
+    float tempC = 0.0f;
+};
+
+// 拡張IDの分解
+static inline uint8_t rs02FrameType(unsigned long id) { return (uint8_t)((id >> 24) & 0x1F); }
+static inline uint8_t rs02FrameDst(unsigned long id) { return (uint8_t)(id & 0xFF); }
+
+// モータID集合（0..127 のビットマスク）
+struct RS02MotorSet
+{
+    uint32_t bits[4] = {0, 0, 0, 0};
+
+    void add(uint8_t id)
+    {
+        if (id < 128)
+            bits[id >> 5] |= (1UL << (id & 31));
+    }
+    void remove(uint8_t id)
+    {
+        if (id < 128)
+            bits[id >> 5] &= ~(1UL << (id & 31));
+    }
+    bool has(uint8_t id) const { return id < 128 && (bits[id >> 5] & (1UL << (id & 31))) != 0; }
+    bool empty() const { return (bits[0] | bits[1] | bits[2] | bits[3]) == 0; }
+    void clear() { bits[0] = bits[1] = bits[2] = bits[3] = 0; }
+};
+
+// CAN コントローラの状態（RS02PrivateBase::canStatus）
+enum class RS02CanState : uint8_t
+{
+    Unknown = 0,    // バックエンドが状態を返さない
+    Active,         // エラーアクティブ
+    Warning,        // TEC/REC >= 96
+    Passive,        // TEC/REC >= 128（送信はできる）
+    BusOff,         // TEC > 255: 送信不可
+    Recovering,     // バスオフからの回復中
+    Stopped         // 停止 / 設定が失われた（MCP2515 が通常モードでない等）
+};
+
+struct RS02CanStatus
+{
+    RS02CanState state = RS02CanState::Unknown;
+    uint16_t tec = 0;
+    uint16_t rec = 0;
+};
+
+// 目標値の送信キュー（RS02PrivateBase::setTxQueue）
+// 同じ (モータ, 種類) の未送信フレームは新しい値で差し替え、期限を過ぎたものは送らずに捨てる
+struct RS02TxQueueConfig
+{
+    bool enabled = false;
+    uint32_t deadlineUs = 5000; // 要求からこの時間で送れなければ捨てる（送信中なら取り消し）
+};
+
+struct RS02TxQueueStats
+{
+    uint32_t queued = 0;     // sendSetpoint の回数
+    uint32_t sent = 0;       // HW に渡した
+    uint32_t superseded = 0; // 未送信のまま新しい値に差し替え
+    uint32_t expired = 0;    // 期限切れで送らずに破棄
+    uint32_t aborted = 0;    // 送信中に期限切れ → HW で取り消し
+    uint32_t late = 0;       // 送信中に期限切れ、取り消せずに遅れて出た（TWAI 等）
+    uint32_t dropped = 0;    // キューあふれ / 停止・モード変更・緊急停止で破棄
+    uint8_t maxDepth = 0;
+};
+
+// 送受信フレームの通知先（RS02PrivateBase::addListener で登録）
+class RS02FrameListener
+{
+public:
+    virtual ~RS02FrameListener() {}
+    virtual void onRxFrame(const RS02PrivFrame &f) { (void)f; }
+    virtual void onTxFrame(const RS02PrivFrame &f, bool ok)
+    {
+        (void)f;
+        (void)ok;
+    }
+    // HW に渡したフレームがバスに出た（ok=false: 出る前に破棄 / 取り消し）。f.tsUs は完了を見つけた時刻
+    // 送信完了を待つバックエンド（MCP2515 の既定など）は onTxFrame の直後。TWAI は送信 / 受信のたびに回収
+    virtual void onTxDone(const RS02PrivFrame &f, bool ok)
+    {
+        (void)f;
+        (void)ok;
+    }
+    // 受信側 HW のあふれを検出（MCP2515 の RX0OVR/RX1OVR 等）。n は検出回数 = 失ったフレームの下限
+    virtual void onRxLost(uint32_t n, uint32_t tUs)
+    {
+        (void)n;
+        (void)tUs;
+    }
+};
@@ -0,0 +1,99 @@
+// RS02UiCells.cpp — テキストセルの差分描画（変更検出と統計）
+#include "RS02UiCells.h"
+#include <string.h>
+
+int RS02UiCells::add(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+    if (_n >= RS02_UI_CELLS)
+        return -1;
+    Cell &c = _cell[_n];
+    c.rect.x = x;
+    c.rect.y = y;
+    c.rect.w = w;
+    c.rect.h = h;
+    c.color = color;
+    c.dirty = true;
+    c.text[0] = 0;
+    return _n++;
+}
+
+bool RS02UiCells::vprintf(uint8_t cell, const char *fmt, va_list ap)
+{
+    char buf[RS02_UI_TEXT];
+    vsnprintf(buf, sizeof(buf), fmt, ap);
+    return set(cell, buf);
+}
+
+bool RS02UiCells::printf(uint8_t cell, const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    bool changed = vprintf(cell, fmt, ap);
+    va_end(ap);
+    return changed;
+}
+
+bool RS02UiCells::set(uint8_t cell, const char *text)
+{
+    if (cell >= _n)
+        return false;
+    Cell &c = _cell[cell];
+    if (strncmp(c.text, text, sizeof(c.text) - 1) == 0)
+    {
+        if (!c.dirty)
+            _stats.cellsSkipped++;
+        return false;
+    }
+    size_t n = strnlen(text, sizeof(c.text) - 1);
+    memcpy(c.text, text, n);
+    c.text[n] = 0;
+    c.dirty = true;
+    return true;
+}
+
+bool RS02UiCells::setColor(uint8_t cell, uint16_t color)
+{
+    if (cell >= _n || _cell[cell].color == color)
+        return false;
+    _cell[cell].color = color;
+    _cell[cell].dirty = true;
+    return true;
+}
+
+void RS02UiCells::invalidate()
+{
+    for (uint8_t i = 0; i < _n; i++)
+        _cell[i].dirty = true;
+}
+
+uint8_t RS02UiCells::dirtyCount() const
+{
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < _n; i++)
+        n += _cell[i].dirty;
+    return n;
+}
+
+void RS02UiCells::finishFrame(uint8_t drawn, uint32_t px, uint32_t us)
+{
+    _stats.frames++;
+    _stats.cellsDrawn += drawn;
+    _stats.pixelsPushed += px;
+    _stats.lastPixels = px;
+    _stats.lastFrameUs = us;
+    _stats.totalFrameUs += us;
+    if (us > _stats.maxFrameUs)
+        _stats.maxFrameUs = us;
+}
+
+void RS02UiCells::dump(Print &out, uint32_t fullPx) const
+{
+    const RS02UiStats &s = _stats;
+    double pxPerFrame = s.frames ? (double)s.pixelsPushed / s.frames : 0.0;
+    out.printf("# rs02 ui: frames=%lu cells=%lu skipped=%lu px/frame=%.0f", (unsigned long)s.frames,
+               (unsigned long)s.cellsDrawn, (unsigned long)s.cellsSkipped, pxPerFrame);
+    if (fullPx)
+        out.printf(" (%.1f%% of full)", 100.0 * pxPerFrame / fullPx);
+    out.printf(" us/frame=%.0f max=%lu\n", s.frames ? (double)s.totalFrameUs / s.frames : 0.0,
+               (unsigned long)s.maxFrameUs);
+}
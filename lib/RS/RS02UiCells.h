@@ -0,0 +1,96 @@
+#pragma once
+// RS02UiCells.h — モニタ画面の差分描画（変わったテキストセルだけを描き直して、その矩形だけをパネルへ送る）
+// セル = 画面上の矩形 + 表示中の文字列 + 色。printf で内容を更新し、前回と同じなら何もしない（dirty にしない）。
+// render(draw) が dirty なセルごとに draw(セル番号, 矩形, 文字列, 色) を呼び、送ったピクセル数と 1 フレームの所要時間を数える。
+// 描画そのもの（M5GFX の行キャンバス → pushImageDMA など）は呼び出し側。ライブラリは GFX に依存しない。
+
+#include <Arduino.h>
+#include <stdarg.h>
+
+#ifndef RS02_UI_CELLS
+#define RS02_UI_CELLS 16
+#endif
+#ifndef RS02_UI_TEXT
+#define RS02_UI_TEXT 96 // 1 セルの最大文字数（終端込み）
+#endif
+
+struct RS02UiRect
+{
+    int16_t x = 0;
+    int16_t y = 0;
+    int16_t w = 0;
+    int16_t h = 0;
+};
+
+struct RS02UiStats
+{
+    uint32_t frames = 0;       // render の呼び出し（dirty が無くても数える）
+    uint32_t cellsDrawn = 0;
+    uint32_t cellsSkipped = 0; // 更新されたが内容が同じだったセル
+    uint64_t pixelsPushed = 0;
+    uint32_t lastPixels = 0;   // 直近フレームで送ったピクセル数
+    uint32_t lastFrameUs = 0;  // 直近フレームの render 所要時間（描画 + 転送開始）
+    uint32_t maxFrameUs = 0;
+    uint64_t totalFrameUs = 0; // 平均 = totalFrameUs / frames
+};
+
+class RS02UiCells
+{
+public:
+    // セルを追加（戻り値: セル番号, いっぱいなら -1）。新しいセルは dirty
+    int add(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color = 0xFFFF);
+    uint8_t count() const { return _n; }
+    const RS02UiRect &rect(uint8_t cell) const { return _cell[cell].rect; }
+
+    // 内容の更新。前回と同じなら false（描き直さない）
+    bool printf(uint8_t cell, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+    bool vprintf(uint8_t cell, const char *fmt, va_list ap);
+    bool set(uint8_t cell, const char *text);
+    bool setColor(uint8_t cell, uint16_t color);
+    const char *text(uint8_t cell) const { return _cell[cell].text; }
+
+    // 画面全体を描き直したあと（背景 / 他の画面から戻った）: 全セルを dirty に
+    void invalidate();
+    bool dirty(uint8_t cell) const { return _cell[cell].dirty; }
+    uint8_t dirtyCount() const;
+
+    // dirty なセルごとに draw(cell, rect, text, color) を呼んで dirty を落とす。戻り値は描いたセル数
+    template <class Draw>
+    uint8_t render(Draw draw)
+    {
+        uint32_t t0 = micros();
+        uint8_t drawn = 0;
+        uint32_t px = 0;
+        for (uint8_t i = 0; i < _n; i++)
+        {
+            Cell &c = _cell[i];
+            if (!c.dirty)
+                continue;
+            draw(i, (const RS02UiRect &)c.rect, (const char *)c.text, c.color);
+            c.dirty = false;
+            drawn++;
+            px += (uint32_t)c.rect.w * (uint32_t)c.rect.h;
+        }
+        finishFrame(drawn, px, micros() - t0);
+        return drawn;
+    }
+
+    const RS02UiStats &stats() const { return _stats; }
+    void resetStats() { _stats = RS02UiStats(); }
+    // 全面転送との比較を含めてシリアルへ（fullPx = 画面の全ピクセル数, 0 なら比較なし）
+    void dump(Print &out, uint32_t fullPx = 0) const;
+
+private:
+    struct Cell
+    {
+        RS02UiRect rect;
+        uint16_t color = 0xFFFF;
+        bool dirty = true;
+        char text[RS02_UI_TEXT] = {};
+    };
+    Cell _cell[RS02_UI_CELLS];
+    uint8_t _n = 0;
+    RS02UiStats _stats;
+
+    void finishFrame(uint8_t drawn, uint32_t px, uint32_t us);
+};
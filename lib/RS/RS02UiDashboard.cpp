@@ -0,0 +1,107 @@
+// RS02UiDashboard.cpp — タイルの配置と、テレメトリからの文字列作成（変わったタイルだけ）
+#include "RS02UiDashboard.h"
+
+void RS02UiDashboard::layout(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t cols, uint8_t rows)
+{
+    _x = x;
+    _y = y;
+    _cols = cols ? cols : 1;
+    _rows = rows ? rows : 1;
+    _tw = (int16_t)(w / _cols);
+    _th = (int16_t)(h / _rows);
+}
+
+bool RS02UiDashboard::add(uint8_t motorId)
+{
+    if (_n >= RS02_DASH_TILES || _n >= (uint16_t)_cols * _rows)
+        return false;
+    int16_t col = (int16_t)(_n % _cols), row = (int16_t)(_n / _cols);
+    // 1px の隙間を空けて、隣のタイルの描き直しに掛からないように
+    int cell = _cells.add((int16_t)(_x + col * _tw), (int16_t)(_y + row * _th), (int16_t)(_tw - 1), (int16_t)(_th - 1),
+                          _cfg.colorNone);
+    if (cell < 0)
+        return false;
+    Tile &t = _tile[_n++];
+    t = Tile();
+    t.id = motorId;
+    t.cell = (int8_t)cell;
+    return true;
+}
+
+uint8_t RS02UiDashboard::addWatched()
+{
+    uint8_t ids[128];
+    uint8_t n = _tm.list(ids, sizeof(ids));
+    uint8_t added = 0;
+    for (uint8_t i = 0; i < n; i++)
+        added += add(ids[i]);
+    return added;
+}
+
+uint8_t RS02UiDashboard::update()
+{
+    uint8_t changed = 0;
+    for (uint8_t i = 0; i < _n; i++)
+        changed += format(_tile[i]);
+    return changed;
+}
+
+static const char *stateName(uint8_t mode)
+{
+    switch (mode)
+    {
+    case RS02MotorState::RESET:
+        return "RST";
+    case RS02MotorState::CALI:
+        return "CAL";
+    case RS02MotorState::RUN:
+        return "RUN";
+    }
+    return "?";
+}
+
+bool RS02UiDashboard::format(Tile &t)
+{
+    uint32_t seq = _tm.seq(t.id);
+    RS02TelemetrySample s;
+    bool have = seq != 0 && _tm.get(t.id, s);
+    int32_t age = -1;
+    if (have)
+    {
+        uint32_t us = micros() - s.rxUs;
+        if (us >= _cfg.staleUs)
+            age = (int32_t)(us / 1000000UL);
+    }
+    // 新しい Type2 も鮮度の変化も無ければ文字列を作らない
+    if (seq == t.seq && age == t.age)
+        return false;
+    t.seq = seq;
+    t.age = age;
+
+    char buf[RS02_UI_TEXT];
+    uint16_t color;
+    if (!have)
+    {
+        snprintf(buf, sizeof(buf), "%02X --\n\n\n\nno data", t.id);
+        color = _cfg.colorNone;
+    }
+    else
+    {
+        const RS02Feedback &fb = s.fb;
+        char fresh[16];
+        if (age < 0)
+            snprintf(fresh, sizeof(fresh), "ok");
+        else
+            snprintf(fresh, sizeof(fresh), "stale %lds", (long)age);
+        if (fb.faultBits)
+            snprintf(buf, sizeof(buf), "%02X %s F%02X\na%+8.2f\nv%+8.2f\nt%+6.2f %3.0fC\n%s", t.id, stateName(fb.mode),
+                     fb.faultBits, fb.angleRad, fb.velRadS, fb.torqueNm, fb.tempC, fresh);
+        else
+            snprintf(buf, sizeof(buf), "%02X %s\na%+8.2f\nv%+8.2f\nt%+6.2f %3.0fC\n%s", t.id, stateName(fb.mode),
+                     fb.angleRad, fb.velRadS, fb.torqueNm, fb.tempC, fresh);
+        color = fb.faultBits ? _cfg.colorFault : (age >= 0 ? _cfg.colorStale : _cfg.colorOk);
+    }
+    bool changed = _cells.set((uint8_t)t.cell, buf);
+    changed |= _cells.setColor((uint8_t)t.cell, color);
+    return changed;
+}
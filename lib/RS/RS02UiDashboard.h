@@ -0,0 +1,66 @@
+#pragma once
+// RS02UiDashboard.h — 複数モータのダッシュボード（モータ 1 台 = 1 タイル）
+// タイルは RS02Telemetry の最新 Type2 から作る（モード / 角度 / 速度 / トルク / 温度 / 故障ビット / 受信からの経過）。
+// 表示のためにバスへ何も送らないので、タイルが 16 枚でも 1 枚でも通信量は同じ。
+// update() は Type2 の seq と鮮度（fresh / stale の秒数）が変わったタイルだけ文字列を作り直し、
+// 描画は RS02UiCells で文字列か色が変わったタイルだけ（render に渡す関数で）。
+
+#include <Arduino.h>
+#include "RS02Telemetry.h"
+#include "RS02UiCells.h"
+
+#define RS02_DASH_TILES RS02_UI_CELLS
+
+struct RS02DashConfig
+{
+    uint32_t staleUs = 100000;   // これより古い Type2 は stale（灰色, 経過秒を表示）
+    uint16_t colorOk = 0xFFFF;   // 白
+    uint16_t colorStale = 0x7BEF; // 灰
+    uint16_t colorFault = 0xF800; // 赤（故障ビットあり）
+    uint16_t colorNone = 0x4208; // 暗い灰（未受信）
+};
+
+class RS02UiDashboard
+{
+public:
+    explicit RS02UiDashboard(RS02Telemetry &tm) : _tm(tm) {}
+
+    // タイルを並べる範囲と列 / 行の数（add の前に）
+    void layout(int16_t x, int16_t y, int16_t w, int16_t h, uint8_t cols, uint8_t rows);
+    void setConfig(const RS02DashConfig &cfg) { _cfg = cfg; }
+    // タイルの追加（左上から横へ）。いっぱいなら false
+    bool add(uint8_t motorId);
+    // RS02Telemetry に watch 登録したモータをすべて（戻り値は追加した枚数）
+    uint8_t addWatched();
+    uint8_t tiles() const { return _n; }
+    uint8_t motorAt(uint8_t tile) const { return _tile[tile].id; }
+
+    // テレメトリからタイルの文字列 / 色を更新（バスの通信なし）。戻り値は内容が変わったタイル数
+    uint8_t update();
+    template <class Draw>
+    uint8_t render(Draw draw)
+    {
+        return _cells.render(draw);
+    }
+    // 画面全体を描き直したあと
+    void invalidate() { _cells.invalidate(); }
+    RS02UiCells &cells() { return _cells; }
+
+private:
+    struct Tile
+    {
+        uint8_t id = 0;
+        int8_t cell = -1;
+        uint32_t seq = 0xFFFFFFFF; // 最後に文字列を作ったときの seq
+        int32_t age = -2;          // 同（-1 = fresh, 0.. = stale の秒, -2 = 未作成）
+    };
+    RS02Telemetry &_tm;
+    RS02DashConfig _cfg;
+    RS02UiCells _cells;
+    Tile _tile[RS02_DASH_TILES];
+    uint8_t _n = 0;
+    int16_t _x = 0, _y = 0, _tw = 80, _th = 56;
+    uint8_t _cols = 4, _rows = 4;
+
+    bool format(Tile &t);
+};
@@ -0,0 +1,136 @@
+// RS02UiPlot.cpp — スクロールプロットの間引き（列ごとの min / max）と自動スケール
+#include "RS02UiPlot.h"
+
+bool RS02UiPlot::begin(int16_t w, int16_t h, uint16_t samplesPerColumn)
+{
+    if (w <= 0 || w > RS02_PLOT_COLS || h <= 1)
+        return false;
+    _w = w;
+    _h = h;
+    _spc = samplesPerColumn ? samplesPerColumn : 1;
+    _accN = 0;
+    _head = 0;
+    _drawn = 0;
+    _full = true;
+    for (Trace &t : _tr)
+        t.acc = {INFINITY, -INFINITY};
+    return true;
+}
+
+int RS02UiPlot::addTrace(uint16_t color)
+{
+    if (_nTrace >= RS02_PLOT_TRACES)
+        return -1;
+    _tr[_nTrace] = Trace();
+    _tr[_nTrace].color = color;
+    _full = true;
+    return _nTrace++;
+}
+
+void RS02UiPlot::setRange(uint8_t trace, float lo, float hi)
+{
+    if (trace >= _nTrace || !(hi > lo))
+        return;
+    _tr[trace].autoScale = false;
+    _tr[trace].lo = lo;
+    _tr[trace].hi = hi;
+    _full = true;
+}
+
+void RS02UiPlot::setAutoScale(uint8_t trace, bool on)
+{
+    if (trace >= _nTrace)
+        return;
+    _tr[trace].autoScale = on;
+    _full = true;
+}
+
+void RS02UiPlot::resetStats()
+{
+    _stats = RS02PlotStats();
+}
+
+// ===== 生産者 =====
+void RS02UiPlot::addSample(const float *v)
+{
+    for (uint8_t i = 0; i < _nTrace; i++)
+    {
+        if (!isfinite(v[i]))
+            continue;
+        Span &a = _tr[i].acc;
+        if (v[i] < a.mn)
+            a.mn = v[i];
+        if (v[i] > a.mx)
+            a.mx = v[i];
+    }
+    _stats.samples++;
+    if (++_accN < _spc)
+        return;
+    uint32_t head = _head;
+    Span *col = _col[head % RING];
+    for (uint8_t i = 0; i < _nTrace; i++)
+    {
+        col[i] = _tr[i].acc;
+        _tr[i].acc = {INFINITY, -INFINITY};
+    }
+    _accN = 0;
+    _stats.columns++;
+    __atomic_store_n(&_head, head + 1, __ATOMIC_RELEASE);
+}
+
+// ===== 消費者 =====
+// 表示中の列の範囲がスケールからはみ出す / スケールの 40% 未満に縮んだら、上下 10% の余白を付けて合わせ直す
+bool RS02UiPlot::autoScale(uint32_t head)
+{
+    uint32_t vis = head < (uint32_t)_w ? head : (uint32_t)_w;
+    bool changed = false;
+    for (uint8_t i = 0; i < _nTrace; i++)
+    {
+        Trace &t = _tr[i];
+        if (!t.autoScale)
+            continue;
+        float mn = INFINITY, mx = -INFINITY;
+        for (uint32_t c = head - vis; c != head; c++)
+        {
+            const Span &s = _col[c % RING][i];
+            if (s.mn < mn)
+                mn = s.mn;
+            if (s.mx > mx)
+                mx = s.mx;
+        }
+        if (!(mn <= mx))
+            continue;
+        float pad = (mx - mn) * 0.1f;
+        float minPad = fmaxf(fabsf(mx), fabsf(mn)) * 0.05f + 1e-3f; // 一定値でも潰れない幅
+        if (pad < minPad)
+            pad = minPad;
+        if (mn >= t.lo && mx <= t.hi && (t.hi - t.lo) * 0.4f <= (mx - mn) + 2.0f * pad)
+            continue;
+        t.lo = mn - pad;
+        t.hi = mx + pad;
+        changed = true;
+    }
+    if (changed)
+        _stats.rescales++;
+    return changed;
+}
+
+int16_t RS02UiPlot::yOf(const Trace &t, float v) const
+{
+    float r = (v - t.lo) / (t.hi - t.lo);
+    int32_t y = (int32_t)lroundf((float)(_h - 1) * (1.0f - r));
+    if (y < 0)
+        y = 0;
+    if (y > _h - 1)
+        y = _h - 1;
+    return (int16_t)y;
+}
+
+void RS02UiPlot::finishFrame(uint32_t us)
+{
+    _stats.frames++;
+    _stats.lastFrameUs = us;
+    _stats.totalFrameUs += us;
+    if (us > _stats.maxFrameUs)
+        _stats.maxFrameUs = us;
+}
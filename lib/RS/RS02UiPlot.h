@@ -0,0 +1,154 @@
+#pragma once
+// RS02UiPlot.h — 画面上のスクロールプロット（最大 4 本, トレースごとに自動スケール）
+// サンプルは samplesPerColumn 個ごとに 1 列（1 ピクセル幅）へ間引くが、列には min / max を残すので
+// 間引きで 1 サンプルだけのスパイクが消えることはない。
+// 描画は新しい列の分だけキャンバスを左へスクロールして右端に描く（全体の描き直しはスケールが変わったときだけ）。
+// addSample（生産者: Type2 の listener など, バス排他の内側）と render（消費者: 描画ループ）は別タスクでよい
+// （完成した列だけを __atomic の head で渡す）。
+// render の Canvas は M5Canvas（LGFX_Sprite）と同じ fillRect / drawFastVLine / scroll を持つ型。
+
+#include <Arduino.h>
+#include <math.h>
+
+#ifndef RS02_PLOT_COLS
+#define RS02_PLOT_COLS 320 // 最大幅（列）
+#endif
+#ifndef RS02_PLOT_TRACES
+#define RS02_PLOT_TRACES 4
+#endif
+
+struct RS02PlotStats
+{
+    uint32_t samples = 0;
+    uint32_t columns = 0;     // 完成した列
+    uint32_t frames = 0;      // render の呼び出し
+    uint32_t scrolled = 0;    // スクロールで描いたフレーム
+    uint32_t fullRedraws = 0; // 全体を描き直したフレーム（初回 / 自動スケール / invalidate / 描画が追いつかない）
+    uint32_t rescales = 0;
+    uint32_t lastFrameUs = 0;
+    uint32_t maxFrameUs = 0;
+    uint64_t totalFrameUs = 0; // 平均 = totalFrameUs / frames
+};
+
+class RS02UiPlot
+{
+public:
+    // 幅 w（<= RS02_PLOT_COLS）x 高さ h, samplesPerColumn サンプルで 1 列
+    bool begin(int16_t w, int16_t h, uint16_t samplesPerColumn = 1);
+    // トレースの追加（戻り値: 番号, いっぱいなら -1）。addSample の値はこの順
+    int addTrace(uint16_t color);
+    uint8_t traces() const { return _nTrace; }
+    // 固定範囲（自動スケールを止める）/ 自動スケール（既定）
+    void setRange(uint8_t trace, float lo, float hi);
+    void setAutoScale(uint8_t trace, bool on);
+    void setBackground(uint16_t color) { _bg = color; }
+
+    // 1 時刻ぶん（トレースの数だけ）。NaN / inf は飛ばす
+    void addSample(const float *v);
+
+    // 次の render で全体を描き直す（キャンバスを他で描いた / 消したとき）
+    void invalidate() { _full = true; }
+    float lo(uint8_t trace) const { return _tr[trace].lo; }
+    float hi(uint8_t trace) const { return _tr[trace].hi; }
+    int16_t width() const { return _w; }
+    int16_t height() const { return _h; }
+
+    // 新しい列を描く。戻り値は描いた列数（全体の描き直しなら表示中の全列）
+    template <class Canvas>
+    uint16_t render(Canvas &g)
+    {
+        uint32_t t0 = micros();
+        uint32_t head = __atomic_load_n(&_head, __ATOMIC_ACQUIRE);
+        uint32_t fresh = head - _drawn;
+        bool full = _full || fresh >= (uint32_t)_w;
+        if (autoScale(head))
+            full = true;
+        uint16_t drawn = 0;
+        if (full)
+        {
+            g.fillRect(0, 0, _w, _h, _bg);
+            uint32_t vis = head < (uint32_t)_w ? head : (uint32_t)_w;
+            for (uint32_t c = head - vis; c != head; c++)
+                drawColumn(g, c, _w - (int16_t)(head - c));
+            drawn = (uint16_t)vis;
+            _stats.fullRedraws++;
+            _full = false;
+        }
+        else if (fresh)
+        {
+            g.scroll(-(int16_t)fresh, 0);
+            g.fillRect(_w - (int16_t)fresh, 0, (int16_t)fresh, _h, _bg);
+            for (uint32_t c = _drawn; c != head; c++)
+                drawColumn(g, c, _w - (int16_t)(head - c));
+            drawn = (uint16_t)fresh;
+            _stats.scrolled++;
+        }
+        _drawn = head;
+        finishFrame(micros() - t0);
+        return drawn;
+    }
+
+    const RS02PlotStats &stats() const { return _stats; }
+    void resetStats();
+
+private:
+    // 列は描画中に生産者が先へ進んでも上書きされないよう、幅より少し多く持つ
+    static constexpr uint32_t RING = RS02_PLOT_COLS + 8;
+
+    struct Span
+    {
+        float mn;
+        float mx;
+    };
+    struct Trace
+    {
+        uint16_t color = 0xFFFF;
+        bool autoScale = true;
+        float lo = -1.0f;
+        float hi = 1.0f;
+        Span acc = {INFINITY, -INFINITY}; // 作りかけの列（生産者のみ）
+    };
+
+    Span _col[RING][RS02_PLOT_TRACES];
+    Trace _tr[RS02_PLOT_TRACES];
+    uint8_t _nTrace = 0;
+    int16_t _w = 0;
+    int16_t _h = 0;
+    uint16_t _spc = 1;
+    uint16_t _accN = 0;
+    uint16_t _bg = 0x0000;
+    uint32_t _head = 0;  // 完成した列の数（生産者だけが進める）
+    uint32_t _drawn = 0; // 描いた列の数（消費者のみ）
+    bool _full = true;
+    RS02PlotStats _stats;
+
+    bool autoScale(uint32_t head);
+    int16_t yOf(const Trace &t, float v) const;
+    void finishFrame(uint32_t us);
+
+    // 列 c を x に。前の列とつながるよう縦線を前の列の範囲まで伸ばす
+    template <class Canvas>
+    void drawColumn(Canvas &g, uint32_t c, int16_t x)
+    {
+        for (uint8_t i = 0; i < _nTrace; i++)
+        {
+            Span s = _col[c % RING][i];
+            if (!(s.mn <= s.mx))
+                continue; // 値が無い列
+            if (c > 0)
+            {
+                const Span &p = _col[(c - 1) % RING][i];
+                if (p.mn <= p.mx)
+                {
+                    if (p.mn > s.mx)
+                        s.mx = p.mn;
+                    if (p.mx < s.mn)
+                        s.mn = p.mx;
+                }
+            }
+            int16_t yTop = yOf(_tr[i], s.mx);
+            int16_t yBot = yOf(_tr[i], s.mn);
+            g.drawFastVLine(x, yTop, yBot - yTop + 1, _tr[i].color);
+        }
+    }
+};
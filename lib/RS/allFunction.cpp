@@ -7,6 +7,11 @@
 #include <stdarg.h>
 #include <math.h>
 #include "RS02PrivateCAN.h"
+#include "RS02DeadlineMonitor.h"
+#include "RS02BusLoad.h"
+#include "RS02Instr.h"
+#include "RS02UiCells.h"
+#include "RS02UiPlot.h"
 
 #define CAN_CS_PIN 6
 #define CAN_BAUD CAN_1000KBPS
@@ -17,10 +22,37 @@ constexpr uint8_t MOTOR_ID = 0x7E;
 
 MCP_CAN CAN(CAN_CS_PIN);
 RS02PrivateCAN RS(CAN, HOST_ID);
+RS02DeadlineMonitor DM(RS); // loop停止時の指令ゼロ化（シリアル "dm on" で有効）
+RS02BusLoad BL(RS);         // バス負荷（タイプ別/モータ別）
 
 // ===== UI =====
 M5Canvas spr(&M5.Display);
 const int W = 320, H = 240, PAD = 6;
+// モニタの値の行は差分描画: 変わった行だけを行キャンバスに描いて、その矩形だけ DMA で送る
+RS02UiCells UI;
+M5Canvas lineSpr[2] = {M5Canvas(&M5.Display), M5Canvas(&M5.Display)}; // 交互に使う（前の DMA 中に次を描く）
+uint8_t lineCur = 0;
+int monRow[7];
+// モニタ下段: Type2（位置 / 速度 / トルク）のスクロールプロット。60fps でスクロールして DMA で送る
+const int PLOT_X = 6, PLOT_Y = 176, PLOT_W = W - 12, PLOT_H = 52;
+RS02UiPlot PLOT;
+M5Canvas plotSpr(&M5.Display);
+bool plotOnScreen = false;
+uint32_t nextPlotMs = 0;
+
+// Type2 をプロットへ（readAny の経路, バス排他の内側）
+class PlotFeed : public RS02FrameListener
+{
+public:
+    void onRxFrame(const RS02PrivFrame &f) override
+    {
+        RS02Feedback fb;
+        if (!f.isExt || !RS.parseFeedback(f, fb) || fb.motorId != MOTOR_ID)
+            return;
+        float v[3] = {fb.angleRad, fb.velRadS, fb.torqueNm};
+        PLOT.addSample(v);
+    }
+} plotFeed;
 
 enum class Mode : uint8_t
 {
@@ -32,6 +64,8 @@ enum class Mode : uint8_t
 Mode curMode = Mode::Velocity;
 bool monitorOn = true;
 uint32_t nextMonUpdate = 0;
+// デッドライン監視は既定で無効（デモは指令を流し続けないので、有効にするとデモの後 150ms でゼロ化される）
+bool dmOn = false;
 
 // ===== Angle∞ アンラップ =====
 struct AngleTracker
@@ -104,6 +138,37 @@ static void printLine(int row, const char *fmt, ...)
     spr.setTextColor(WHITE, BLACK);
     spr.print(buf);
 }
+static void pushFull()
+{
+    spr.pushSprite(0, 0);
+    UI.invalidate(); // 全面を送ったのでモニタの行もプロットも次回描き直す
+    plotOnScreen = false;
+}
+static void pushCell(uint8_t cell, const RS02UiRect &r, const char *text, uint16_t color)
+{
+    (void)cell;
+    M5Canvas &c = lineSpr[lineCur];
+    lineCur ^= 1;
+    c.fillScreen(BLACK);
+    c.setCursor(0, 2);
+    c.setTextColor(color, BLACK);
+    c.print(text);
+    M5.Display.pushImageDMA(r.x, r.y, r.w, r.h, (const lgfx::swap565_t *)c.getBuffer());
+}
+static void plotTick()
+{
+    RS02PrivFrame f;
+    while (RS.readAny(f)) // Type2 → plotFeed
+    {
+    }
+    M5.Display.waitDMA(); // 前のフレームの転送が終わってからキャンバスを動かす
+    if (PLOT.render(plotSpr) == 0 && plotOnScreen)
+        return;
+    M5.Display.startWrite();
+    M5.Display.pushImageDMA(PLOT_X, PLOT_Y, PLOT_W, PLOT_H, (const lgfx::swap565_t *)plotSpr.getBuffer());
+    M5.Display.endWrite();
+    plotOnScreen = true;
+}
 static bool readU8(uint8_t node, uint16_t idx, uint8_t &out)
 {
     uint8_t le[4] = {0};
@@ -131,7 +196,7 @@ static void drawMonitorFrame()
 {
     drawLayout();
     printLine(0, "MONITOR — mechPos(0x7019)/mechVel(0x701B) polling");
-    spr.pushSprite(0, 0);
+    pushFull();
 }
 static void monitorTick()
 {
@@ -158,28 +223,77 @@ static void monitorTick()
     (void)readF32(MOTOR_ID, RS02Idx::LIMIT_TORQUE, limTq);
     (void)readF32(MOTOR_ID, RS02Idx::ACC_RAD, acc);
 
-    printLine(1, "Mode=%u(%s)  Vel=%.3f%s rad/s",
+    // ここから関数末尾までが描画（uiDraw）
+    RS02_INSTR_SCOPE(RS02Probe::UI_DRAW);
+    UI.printf(monRow[1], "Mode=%u(%s)  Vel=%.3f%s rad/s",
               run, modeName(curMode), vel, okVel ? "" : "?");
 
     if (gAngle.has)
     {
         double turns = gAngle.accRad / (2.0 * M_PI);
         double deg = gAngle.accRad * (180.0 / M_PI);
-        printLine(2, "Angle∞: pos=%.3f%s  ->  turns=%.1f  rad=%.3f  deg=%.1f",
+        UI.printf(monRow[2], "Angle∞: pos=%.3f%s  ->  turns=%.1f  rad=%.3f  deg=%.1f",
                   pos, okPos ? "" : "?", turns, gAngle.accRad, deg);
     }
     else
     {
-        printLine(2, "Angle∞: -- (waiting mechPos 0x7019)");
+        UI.printf(monRow[2], "Angle∞: -- (waiting mechPos 0x7019)");
     }
 
-    printLine(3, "Refs : loc=%.3f  spd=%.3f  iq=%.3f", locRef, spdRef, iqRef);
-    printLine(4, "Limit: I=%.1f IO=%.1f T=%.1f S=%.1f  acc=%.1f", limCur, limCurOld, limTq, limSpd, acc);
+    UI.printf(monRow[3], "Refs : loc=%.3f  spd=%.3f  iq=%.3f", locRef, spdRef, iqRef);
+    UI.printf(monRow[4], "Limit: I=%.1f IO=%.1f T=%.1f S=%.1f  acc=%.1f", limCur, limCurOld, limTq, limSpd, acc);
 
-    spr.pushSprite(0, 0);
+    RS02BusLoadSnapshot bl = BL.snapshot();
+    UI.printf(monRow[5], "Bus  : %.1f%% (10ms peak %.1f%%, max %.1f%%)  %.0f f/s  lost %lu",
+              bl.utilPct, bl.peakBucketPct, bl.maxBucketPct, bl.framesPerSec, (unsigned long)bl.rxLost);
+    UI.printf(monRow[6], "Share: T1 %.0f%%  T2 %.0f%%  T17 %.0f%%  T18 %.0f%%",
+              BL.typeSharePct(RS02Type::OP_CONTROL), BL.typeSharePct(RS02Type::FEEDBACK),
+              BL.typeSharePct(RS02Type::READ_PARAM), BL.typeSharePct(RS02Type::WRITE_PARAM));
+
+    M5.Display.startWrite();
+    UI.render(pushCell);
+    M5.Display.endWrite();
 }
 
 // ===== Demo（B）=====
+// ===== デッドライン監視 =====
+// 指令が 150ms 途絶したら SPD_REF/IQ_REF=0、1s で停止。loop が 500ms 止まっても停止
+static void dmWatch(bool on)
+{
+    if (on)
+    {
+        RS02DeadlineConfig dc;
+        dc.cmdTimeoutMs = 150;
+        dc.stopAfterMs = 1000;
+        dc.cmdAction = RS02DeadlineAction::ZeroRef;
+        DM.watch(MOTOR_ID, dc);
+        DM.setHostTimeout(500, RS02DeadlineAction::Stop);
+    }
+    else
+    {
+        DM.unwatch(MOTOR_ID);
+        DM.setHostTimeout(0, RS02DeadlineAction::Stop);
+    }
+}
+
+// デモは delay で指令を間引き、loop も止めるので、その間は監視を外す
+struct DemoPause
+{
+    DemoPause()
+    {
+        if (dmOn)
+            dmWatch(false);
+    }
+    ~DemoPause()
+    {
+        if (dmOn)
+        {
+            DM.heartbeat();
+            dmWatch(true);
+        }
+    }
+};
+
 static void doVelocityDemo()
 {
     drawLayout();
@@ -209,7 +323,7 @@ static void doVelocityDemo()
         delay(20);
     }
     printLine(row++, "spd_ref(700A)=%.1f x10 : %s", SPD_REF, okSpd ? "OK" : "NG");
-    spr.pushSprite(0, 0);
+    pushFull();
 }
 static void doPPDemo()
 {
@@ -233,7 +347,7 @@ static void doPPDemo()
     delay(150);
     ok &= RS.writeFloatParam(MOTOR_ID, RS02Idx::LOC_REF, 0.0f);
     printLine(row++, "loc_ref step: ->%.2f ->0.00 : %s", LOC_STEP, ok ? "OK" : "NG");
-    spr.pushSprite(0, 0);
+    pushFull();
 }
 static void doCurrentDemo()
 {
@@ -264,7 +378,7 @@ static void doCurrentDemo()
     delay(300);
     ok &= RS.currentIqRef(MOTOR_ID, 0.0f);
     printLine(row++, "iq_ref sweep ±%.2f A : %s", IQ, ok ? "OK" : "NG");
-    spr.pushSprite(0, 0);
+    pushFull();
 }
 static void doCSPDemo()
 {
@@ -282,7 +396,7 @@ static void doCSPDemo()
     delay(180);
     okRef &= RS.cspLocRef(MOTOR_ID, P2);
     printLine(row++, "loc_ref(7016): 1.57 -> 0.00 : %s", okRef ? "OK" : "NG");
-    spr.pushSprite(0, 0);
+    pushFull();
 }
 
 // ===== Arduino lifecycle =====
@@ -296,6 +410,21 @@ void setup()
     spr.createSprite(W, H);
     spr.setTextWrap(false, false);
     spr.setTextSize(1);
+    for (M5Canvas &c : lineSpr)
+    {
+        c.setColorDepth(16); // パネルと同じ形式のまま DMA で送る
+        c.createSprite(W - 12, 18);
+        c.setTextWrap(false, false);
+        c.setTextSize(1);
+    }
+    for (int row = 1; row <= 6; row++) // printLine と同じ位置（0 行目は見出しで全面描画側）
+        monRow[row] = UI.add(6, 46 + row * 18 - 2, W - 12, 18);
+    plotSpr.setColorDepth(16);
+    plotSpr.createSprite(PLOT_W, PLOT_H);
+    PLOT.begin(PLOT_W, PLOT_H, 8); // Type2 8 個で 1 列（min / max を残す）
+    PLOT.addTrace(GREEN);          // 位置
+    PLOT.addTrace(CYAN);           // 速度
+    PLOT.addTrace(RED);            // トルク
 
     SPI.begin();
 
@@ -310,20 +439,78 @@ void setup()
             delay(1000);
     }
     CAN.setMode(MCP_NORMAL);
+    CAN.setFastIO(1); // 送受信を READ STATUS + LOAD TX/RTS, READ RX にまとめる
     RS.begin();
     RS.setMasterId(0xFD);
+    BL.begin();
+    RS.addListener(&plotFeed);
 
     // 任意：Type2を有効化（出ない個体もあるが無害）
     RS.setActiveReport(MOTOR_ID, true);
     RS.setReportIntervalTicks(MOTOR_ID, 1);
 
+    // デッドライン監視のタスクは常に回す（監視対象は "dm on" で登録）
+    DM.begin();
+    DM.startTask(5);
+
     drawLayout();
     printLine(0, "READY. Mode=%s  (A:Monitor / B:Demo / C:Next)", modeName(curMode));
-    spr.pushSprite(0, 0);
+    pushFull();
+}
+
+// シリアル 1 行コマンド（"instr" / "instr reset" / "ui" / "ui reset" / "dm on" / "dm off" / "dm"）
+static void serialTick()
+{
+    static char line[32];
+    static uint8_t n = 0;
+    while (Serial.available() > 0)
+    {
+        char c = (char)Serial.read();
+        if (c == '\r' || c == '\n')
+        {
+            if (n == 0)
+                continue;
+            line[n] = 0;
+            n = 0;
+            if (strncmp(line, "ui", 2) == 0) // "ui" / "ui reset": 差分描画とプロットの統計（reset は表示してから 0 に）
+            {
+                UI.dump(Serial, (uint32_t)W * H);
+                const RS02PlotStats &p = PLOT.stats();
+                Serial.printf("# rs02 plot: frames=%lu scroll=%lu full=%lu rescale=%lu us/frame=%.0f max=%lu\n",
+                              (unsigned long)p.frames, (unsigned long)p.scrolled, (unsigned long)p.fullRedraws,
+                              (unsigned long)p.rescales, p.frames ? (double)p.totalFrameUs / p.frames : 0.0,
+                              (unsigned long)p.maxFrameUs);
+                if (strstr(line, "reset"))
+                {
+                    UI.resetStats();
+                    PLOT.resetStats();
+                }
+            }
+            else if (strncmp(line, "dm", 2) == 0) // "dm on" / "dm off": デッドライン監視, "dm": 統計
+            {
+                if (strstr(line, "on") || strstr(line, "off"))
+                {
+                    dmOn = strstr(line, "on") != nullptr;
+                    DM.heartbeat();
+                    dmWatch(dmOn);
+                }
+                const RS02DeadlineMotorStats &m = DM.stats(MOTOR_ID);
+                const RS02HostStats &h = DM.hostStats();
+                Serial.printf("# rs02 dm: %s cmdMisses=%lu actions=%lu maxCmdGap=%luus host stalls=%lu maxGap=%luus\n",
+                              dmOn ? "on" : "off", (unsigned long)m.cmdMisses, (unsigned long)m.actions,
+                              (unsigned long)m.maxCmdGapUs, (unsigned long)h.stalls, (unsigned long)h.maxGapUs);
+            }
+            else
+                RS02Instr::handleCommand(line, Serial);
+        }
+        else if (n < sizeof(line) - 1)
+            line[n++] = c;
+    }
 }
 
 void loop()
 {
+    DM.heartbeat();
     M5.update();
 
     if (M5.BtnA.wasPressed())
@@ -335,6 +522,7 @@ void loop()
     }
     if (M5.BtnB.wasPressed())
     {
+        DemoPause pause;
         switch (curMode)
         {
         case Mode::Velocity:
@@ -356,7 +544,7 @@ void loop()
         curMode = static_cast<Mode>((static_cast<uint8_t>(curMode) + 1) % 4);
         drawLayout();
         printLine(0, "Mode changed -> %s", modeName(curMode));
-        spr.pushSprite(0, 0);
+        pushFull();
     }
 
     // Monitor: 200ms周期で Type17 読み
@@ -366,5 +554,13 @@ void loop()
         nextMonUpdate = millis() + 200;
     }
 
+    // プロット: 60fps
+    if (monitorOn && (int32_t)(millis() - nextPlotMs) >= 0)
+    {
+        plotTick();
+        nextPlotMs = millis() + 16;
+    }
+
+    serialTick();
     delay(3);
 }
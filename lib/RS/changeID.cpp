@@ -2,6 +2,9 @@
 // ・A/C：値変更（-1 / +1, 切替）
 // ・B短押し：カーソル移動
 // ・B長押し：適用（Apply）→ 新IDで 0x200A を読戻し（Verify）
+// 起動時に 0..127 を一斉に探し（RS02Scanner, 1 秒かからない）、Current ID は見つかった ID から選ぶ
+// シリアル "map 1:101 2:102 u525330320000035A:103" で複数台をまとめて変更（RS02Commission, Type7 + Type22）
+// シリアル "dump" で全モータのパラメータ表を読んで保持（RS02ParamBackup, 16 進でも出す）、"restore" で違う値だけ書き戻す
 //
 // ハード: M5Stack CoreS3 + MCP2515(1Mbps), mcp_can(4引数 readMsgBuf 版)
 // 前提: RS02PrivateCAN に setMotorId / setMotorIdViaParam / saveParams を実装済み
@@ -10,6 +13,9 @@
 #include <SPI.h>
 #include <mcp_can.h>
 #include "RS02PrivateCAN.h"
+#include "RS02Scanner.h"
+#include "RS02Commission.h"
+#include "RS02ParamBackup.h"
 
 // ===== MCP2515 設定 =====
 #define CAN_CS_PIN 6
@@ -23,6 +29,10 @@ static constexpr uint8_t MASTER_ID = 0xFD; // 実機に合わせる
 // ===== CAN / ライブラリ =====
 MCP_CAN CAN(CAN_CS_PIN);
 RS02PrivateCAN RS(CAN, HOST_ID);
+RS02Scanner SCAN(RS);
+RS02Commission COMM(RS);
+RS02ParamBackup BACKUP(RS);
+static RS02ParamSnapshot SNAP; // 直前の dump
 
 // ===== 画面 =====
 M5Canvas spr(&M5.Display);
@@ -76,7 +86,10 @@ static void drawUI()
 
     // 各フィールド文字列
     char v0[32], v1[32], v2[32], v3[32];
-    snprintf(v0, sizeof(v0), "0x%02X", curId);
+    if (SCAN.count())
+        snprintf(v0, sizeof(v0), "0x%02X  (%u found)", curId, SCAN.count());
+    else
+        snprintf(v0, sizeof(v0), "0x%02X", curId);
     snprintf(v1, sizeof(v1), "0x%02X", newId);
     snprintf(v2, sizeof(v2), "%s", (method == Method::Type7_Immediate) ? "Type7 (Immediate)" : "Param (0x200A)");
     snprintf(v3, sizeof(v3), "%s", saveFlag ? "SAVE: ON (Type22)" : "SAVE: OFF");
@@ -104,6 +117,30 @@ static void clampIds()
         newId = 127;
 }
 
+// 見つかった ID の中で curId の前 / 次へ（見つかっていなければ ±1）
+static void stepCurId(int dir)
+{
+    uint8_t n = SCAN.count();
+    if (!n)
+    {
+        if (dir < 0 && curId > 0)
+            curId--;
+        if (dir > 0 && curId < 127)
+            curId++;
+        return;
+    }
+    for (uint8_t k = 0; k < n; k++)
+    {
+        uint8_t id = SCAN.entry(dir > 0 ? k : n - 1 - k).id;
+        if (dir > 0 ? id > curId : id < curId)
+        {
+            curId = id;
+            return;
+        }
+    }
+    curId = SCAN.entry(dir > 0 ? 0 : n - 1).id; // 端で折り返す
+}
+
 static void setStatus(const char *fmt, ...)
 {
     va_list ap;
@@ -167,6 +204,95 @@ static void applyChange()
 }
 
 // ===== Arduino Lifecycle =====
+// "map <今の ID>:<新 ID> u<UID 16 桁>:<新 ID> ..." → まとめて変更して結果を出し、探索し直す
+static void runMap(char *args)
+{
+    COMM.clear();
+    for (char *tok = strtok(args, " "); tok; tok = strtok(nullptr, " "))
+    {
+        char *colon = strchr(tok, ':');
+        if (!colon)
+            continue;
+        *colon = 0;
+        uint8_t to = (uint8_t)strtoul(colon + 1, nullptr, 0);
+        bool ok = (tok[0] == 'u' || tok[0] == 'U') ? COMM.addUid(strtoull(tok + 1, nullptr, 16), to)
+                                                   : COMM.addId((uint8_t)strtoul(tok, nullptr, 0), to);
+        if (!ok)
+            Serial.printf("map: skip %s:%s\n", tok, colon + 1);
+    }
+    if (!COMM.count())
+    {
+        Serial.println("usage: map 1:101 2:102 u525330320000035A:103");
+        return;
+    }
+    setStatus("Commissioning %u row(s) ...", COMM.count());
+    drawUI();
+    uint8_t ok = COMM.run();
+    COMM.print(Serial);
+    setStatus("Map: %u/%u ok in %lums", ok, COMM.count(), (unsigned long)(COMM.stats().totalUs / 1000));
+    if (SCAN.scan() && !SCAN.find(curId))
+        curId = SCAN.entry(0).id;
+    drawUI();
+}
+
+// "dump": 全モータの表を SNAP へ（ID を変える前の控え）。"restore": SNAP と違う値だけ書いて保存
+static void runDump()
+{
+    setStatus("Dumping parameters ...");
+    drawUI();
+    uint8_t n = BACKUP.dump(RS02ParamList::standard(), SNAP);
+    SNAP.print(Serial);
+    static uint8_t buf[4096]; // 標準の表なら 16 台分
+    size_t len = SNAP.encode(buf, sizeof(buf));
+    Serial.printf("# snapshot %u bytes:", (unsigned)len);
+    for (size_t i = 0; i < len; i++)
+        Serial.printf("%s%02X", (i % 32) ? "" : "\n", buf[i]);
+    Serial.println();
+    setStatus("Dump: %u motor(s) in %lums", n, (unsigned long)(BACKUP.stats().totalUs / 1000));
+    drawUI();
+}
+
+static void runRestore()
+{
+    if (!SNAP.count())
+    {
+        Serial.println("restore: dump first");
+        return;
+    }
+    setStatus("Restoring %u motor(s) ...", SNAP.count());
+    drawUI();
+    uint8_t ok = BACKUP.restore(SNAP);
+    BACKUP.print(Serial);
+    setStatus("Restore: %u/%u ok, %u written in %lums", ok, SNAP.count(), BACKUP.stats().writes,
+              (unsigned long)(BACKUP.stats().totalUs / 1000));
+    drawUI();
+}
+
+static void serialTick()
+{
+    static char line[200];
+    static uint8_t n = 0;
+    while (Serial.available() > 0)
+    {
+        char c = (char)Serial.read();
+        if (c == '\r' || c == '\n')
+        {
+            if (n == 0)
+                continue;
+            line[n] = 0;
+            n = 0;
+            if (strncmp(line, "map", 3) == 0)
+                runMap(line + 3);
+            else if (strcmp(line, "dump") == 0)
+                runDump();
+            else if (strcmp(line, "restore") == 0)
+                runRestore();
+        }
+        else if (n < sizeof(line) - 1)
+            line[n++] = c;
+    }
+}
+
 void setup()
 {
     auto cfg = M5.config();
@@ -194,12 +320,26 @@ void setup()
     RS.begin();
     RS.setMasterId(MASTER_ID);
 
+    // モータ探索（Type0 一斉 → UID, Type17 で マスターID 等）
+    setStatus("Scanning 0x00-0x7F ...");
+    drawUI();
+    uint8_t n = SCAN.scan();
+    SCAN.print(Serial);
+    if (n)
+    {
+        curId = SCAN.entry(0).id;
+        setStatus("Scan: %u motor(s) in %lums%s", n, (unsigned long)(SCAN.stats().totalUs / 1000),
+                  SCAN.stats().conflicts ? "  ID CONFLICT!" : "");
+    }
+    else
+        setStatus("Scan: no motor found (enter ID by hand)");
     drawUI();
 }
 
 void loop()
 {
     M5.update();
+    serialTick();
 
     // A/C: 値変更
     if (M5.BtnA.wasPressed())
@@ -207,8 +347,7 @@ void loop()
         switch (cursor)
         {
         case 0:
-            if (curId > 0)
-                curId--;
+            stepCurId(-1);
             break;
         case 1:
             if (newId > 0)
@@ -229,8 +368,7 @@ void loop()
         switch (cursor)
         {
         case 0:
-            if (curId < 127)
-                curId++;
+            stepCurId(+1);
             break;
         case 1:
             if (newId < 127)
@@ -0,0 +1,137 @@
+// main.cpp — 複数モータのダッシュボード（1 台 = 1 タイル: モード / 角度 / 速度 / トルク / 温度 / 故障 / 鮮度）
+// 各モータの Type2 能動報告（Type24）を受けて RS02Telemetry に溜め、タイルはそこから作る。
+// 表示のための Type17 読み出しはしないので、タイルを増やしてもバスの通信は増えない。
+// 描き直すのは内容が変わったタイルだけ（タイルの矩形だけを DMA で送る）
+// ・A：全タイルを描き直す
+//
+// ハード: M5Stack CoreS3 + MCP2515(1Mbps), mcp_can(4引数 readMsgBuf 版)
+
+#include <M5Unified.h>
+#include <SPI.h>
+#include <mcp_can.h>
+#include <string.h>
+#include "RS02PrivateCAN.h"
+#include "RS02Telemetry.h"
+#include "RS02UiDashboard.h"
+
+// ===== MCP2515 設定 =====
+#define CAN_CS_PIN 6
+#define CAN_BAUD CAN_1000KBPS
+#define MCP_CLOCK MCP_8MHZ // 基板に合わせ 16MHzなら MCP_16MHZ
+
+// ===== ID/ホスト設定 =====
+static constexpr uint8_t HOST_ID = 0x00;
+static constexpr uint8_t MASTER_ID = 0xFD;
+static const uint8_t MOTOR_IDS[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12}; // 登録するモータ（最大 16）
+static constexpr uint16_t REPORT_TICKS = 1;                                 // 能動報告の周期（1 = 10ms）
+static constexpr uint32_t REFRESH_MS = 100;
+
+// ===== CAN / ライブラリ =====
+MCP_CAN CAN(CAN_CS_PIN);
+RS02PrivateCAN RS(CAN, HOST_ID);
+RS02Telemetry TM(RS);
+RS02UiDashboard DASH(TM);
+
+// ===== 画面 =====
+static const int W = 320, H = 240, HEAD = 16, COLS = 4, ROWS = 4;
+M5Canvas tileSpr[2] = {M5Canvas(&M5.Display), M5Canvas(&M5.Display)}; // 交互に使う（前の DMA 中に次を描く）
+static uint8_t tileCur = 0;
+static uint32_t nextRefresh = 0;
+
+static void drawHeader()
+{
+    M5.Display.fillScreen(BLACK);
+    M5.Display.setTextColor(WHITE, BLACK);
+    M5.Display.setCursor(4, 4);
+    M5.Display.printf("RS02 Dashboard  %u motors  MASTER=0x%02X", DASH.tiles(), MASTER_ID);
+    DASH.invalidate();
+}
+
+// 1 タイル: 改行区切りの 5 行を行キャンバスに描いて、その矩形だけ送る
+static void pushTile(uint8_t cell, const RS02UiRect &r, const char *text, uint16_t color)
+{
+    (void)cell;
+    M5Canvas &c = tileSpr[tileCur];
+    tileCur ^= 1;
+    c.fillScreen(BLACK);
+    c.drawRect(0, 0, r.w, r.h, 0x39E7);
+    c.setTextColor(color, BLACK);
+    int y = 3;
+    for (const char *p = text; *p; y += 10)
+    {
+        const char *e = strchr(p, '\n');
+        size_t n = e ? (size_t)(e - p) : strlen(p);
+        char line[24];
+        if (n >= sizeof(line))
+            n = sizeof(line) - 1;
+        memcpy(line, p, n);
+        line[n] = 0;
+        c.setCursor(3, y);
+        c.print(line);
+        p += n + (e ? 1 : 0);
+    }
+    M5.Display.pushImageDMA(r.x, r.y, r.w, r.h, (const lgfx::swap565_t *)c.getBuffer());
+}
+
+void setup()
+{
+    auto cfg = M5.config();
+    M5.begin(cfg);
+    M5.Display.setTextWrap(false, false);
+    M5.Display.setTextSize(1);
+
+    SPI.begin();
+    if (CAN.begin(MCP_ANY, CAN_BAUD, MCP_CLOCK) != CAN_OK)
+    {
+        M5.Display.setTextColor(RED, BLACK);
+        M5.Display.println("CAN.begin FAIL");
+        while (1)
+            delay(1000);
+    }
+    CAN.setMode(MCP_NORMAL);
+    CAN.setFastIO(1);
+    RS.begin();
+    RS.setMasterId(MASTER_ID);
+
+    TM.begin();
+    for (uint8_t id : MOTOR_IDS)
+    {
+        TM.watch(id);
+        RS.setReportIntervalTicks(id, REPORT_TICKS);
+        RS.setActiveReport(id, true); // 以降の帰還は Type2 だけ
+    }
+
+    DASH.layout(0, HEAD, W, H - HEAD, COLS, ROWS);
+    DASH.addWatched();
+    for (M5Canvas &c : tileSpr)
+    {
+        c.setColorDepth(16);
+        c.createSprite(W / COLS - 1, (H - HEAD) / ROWS - 1);
+        c.setTextWrap(false, false);
+        c.setTextSize(1);
+    }
+    drawHeader();
+}
+
+void loop()
+{
+    M5.update();
+
+    RS02PrivFrame f;
+    while (RS.readAny(f)) // Type2 → TM
+    {
+    }
+
+    if (M5.BtnA.wasPressed())
+        drawHeader();
+
+    if ((int32_t)(millis() - nextRefresh) >= 0)
+    {
+        nextRefresh = millis() + REFRESH_MS;
+        DASH.update();
+        M5.Display.startWrite();
+        DASH.render(pushTile);
+        M5.Display.endWrite();
+    }
+    delay(2);
+}
@@ -23,20 +23,134 @@
 */
 #include "mcp_can.h"
 
-#define spi_readwrite mcpSPI->transfer
+#define spi_readwrite spi_xfer
 #define spi_read() spi_readwrite(0x00)
 
+/*********************************************************************************************************
+** Function name:           spi_lock / spi_unlock
+** Descriptions:            Take / release the SPI bus (beginTransaction). Nested calls and lockSPI()
+**                          share one transaction, so grouped operations pay the bus lock once.
+*********************************************************************************************************/
+void MCP_CAN::spi_lock(void)
+{
+    if (mcpLockDepth++ == 0)
+    {
+        mcpSPI->beginTransaction(SPISettings(mcpSPIClock, MSBFIRST, SPI_MODE0));
+        mcpCount->locks++;
+    }
+}
+
+void MCP_CAN::spi_unlock(void)
+{
+    if (mcpLockDepth && --mcpLockDepth == 0)
+        mcpSPI->endTransaction();
+}
+
+/*********************************************************************************************************
+** Function name:           spi_begin / spi_end
+** Descriptions:            One MCP2515 instruction: bus lock + chip select. The chip needs /CS to go
+**                          high between instructions, so only the lock can be shared.
+*********************************************************************************************************/
+void MCP_CAN::spi_begin(void)
+{
+    spi_lock();
+    MCP2515_SELECT();
+    mcpCount->selects++;
+}
+
+void MCP_CAN::spi_end(void)
+{
+    MCP2515_UNSELECT();
+    spi_unlock();
+}
+
+INT8U MCP_CAN::spi_xfer(const INT8U data)
+{
+    mcpCount->bytes++;
+    return mcpSPI->transfer(data);
+}
+
+/*********************************************************************************************************
+** Function name:           lockSPI / unlockSPI
+** Descriptions:            Hold the SPI bus across several public calls (e.g. drain all RX buffers).
+**                          Nothing else may use the same SPI bus until unlockSPI().
+*********************************************************************************************************/
+void MCP_CAN::lockSPI(void)
+{
+    spi_lock();
+}
+
+void MCP_CAN::unlockSPI(void)
+{
+    spi_unlock();
+}
+
+/*********************************************************************************************************
+** Function name:           setSPIClock
+** Descriptions:            SPI clock for the following transactions (MCP2515 max 10 MHz)
+*********************************************************************************************************/
+void MCP_CAN::setSPIClock(INT32U hz)
+{
+    mcpSPIClock = hz ? hz : 10000000;
+}
+
+/*********************************************************************************************************
+** Function name:           setFastIO
+** Descriptions:            1: send with READ STATUS + LOAD TX + RTS and read with READ STATUS + READ RX
+**                          (one chip select each, RXnIF cleared by the chip), all under one bus lock.
+**                          0: original register-by-register access.
+*********************************************************************************************************/
+void MCP_CAN::setFastIO(INT8U enable)
+{
+    mcpFastIO = enable ? 1 : 0;
+}
+
+/*********************************************************************************************************
+** Function name:           setTxWait
+** Descriptions:            1: sendMsg returns after the frame left the chip (original behaviour).
+**                          0: sendMsg waits until no TXREQ is set, loads TXB0 and returns after RTS.
+**                          Only one frame is in flight, so frames keep their order and abortTX
+**                          withdraws at most the last one.
+*********************************************************************************************************/
+void MCP_CAN::setTxWait(INT8U enable)
+{
+    mcpTxWait = enable ? 1 : 0;
+}
+
+/*********************************************************************************************************
+** Function name:           txPending
+** Descriptions:            1 if any transmit buffer still has TXREQ set (READ STATUS)
+*********************************************************************************************************/
+INT8U MCP_CAN::txPending(void)
+{
+    return (mcp2515_readStatus() & (MCP_STAT_TX0REQ | MCP_STAT_TX1REQ | MCP_STAT_TX2REQ)) ? 1 : 0;
+}
+
+/*********************************************************************************************************
+** Function name:           resetSpiStats / spiEstimateUs
+** Descriptions:            SPI traffic per frame direction and the estimated bus time of a counter
+*********************************************************************************************************/
+void MCP_CAN::resetSpiStats(void)
+{
+    mcpStats = MCP_SPI_Stats();
+}
+
+float MCP_CAN::spiEstimateUs(const MCP_SPI_Counter &c) const
+{
+    double ns = (double)c.locks * mcpCost.lockNs + (double)c.selects * mcpCost.selectNs +
+                (double)c.bytes * 8.0e9 / (double)mcpSPIClock;
+    return (float)(ns / 1000.0);
+}
+
 /*********************************************************************************************************
 ** Function name:           mcp2515_reset
 ** Descriptions:            Performs a software reset
 *********************************************************************************************************/
 void MCP_CAN::mcp2515_reset(void)
 {
-    mcpSPI->beginTransaction(SPISettings(10000000, MSBFIRST, SPI_MODE0));
-    MCP2515_SELECT();
+    spi_begin();
     spi_readwrite(MCP_RESET);
-    MCP2515_UNSELECT();
-    mcpSPI->endTransaction();
+    spi_end();
     delay(5); // If the MCP2515 was in sleep mode when the reset command was issued then we need to wait a while for it to reset properly
 }
 
@@ -48,13 +162,11 @@ INT8U MCP_CAN::mcp2515_readRegister(const INT8U address)
 {
     INT8U ret;
 
-    mcpSPI->beginTransaction(SPISettings(10000000, MSBFIRST, SPI_MODE0));
-    MCP2515_SELECT();
+    spi_begin();
     spi_readwrite(MCP_READ);
     spi_readwrite(address);
     ret = spi_read();
-    MCP2515_UNSELECT();
-    mcpSPI->endTransaction();
+    spi_end();
 
     return ret;
 }
@@ -66,16 +178,14 @@ INT8U MCP_CAN::mcp2515_readRegister(const INT8U address)
 void MCP_CAN::mcp2515_readRegisterS(const INT8U address, INT8U values[], const INT8U n)
 {
     INT8U i;
-    mcpSPI->beginTransaction(SPISettings(10000000, MSBFIRST, SPI_MODE0));
-    MCP2515_SELECT();
+    spi_begin();
     spi_readwrite(MCP_READ);
     spi_readwrite(address);
     // mcp2515 has auto-increment of address-pointer
     for (i = 0; i < n; i++)
         values[i] = spi_read();
 
-    MCP2515_UNSELECT();
-    mcpSPI->endTransaction();
+    spi_end();
 }
 
 /*********************************************************************************************************
@@ -84,13 +194,11 @@ void MCP_CAN::mcp2515_readRegisterS(const INT8U address, INT8U values[], const I
 *********************************************************************************************************/
 void MCP_CAN::mcp2515_setRegister(const INT8U address, const INT8U value)
 {
-    mcpSPI->beginTransaction(SPISettings(10000000, MSBFIRST, SPI_MODE0));
-    MCP2515_SELECT();
+    spi_begin();
     spi_readwrite(MCP_WRITE);
     spi_readwrite(address);
     spi_readwrite(value);
-    MCP2515_UNSELECT();
-    mcpSPI->endTransaction();
+    spi_end();
 }
 
 /*********************************************************************************************************
@@ -100,16 +208,14 @@ void MCP_CAN::mcp2515_setRegister(const INT8U address, const INT8U value)
 void MCP_CAN::mcp2515_setRegisterS(const INT8U address, const INT8U values[], const INT8U n)
 {
     INT8U i;
-    mcpSPI->beginTransaction(SPISettings(10000000, MSBFIRST, SPI_MODE0));
-    MCP2515_SELECT();
+    spi_begin();
     spi_readwrite(MCP_WRITE);
     spi_readwrite(address);
 
     for (i = 0; i < n; i++)
         spi_readwrite(values[i]);
 
-    MCP2515_UNSELECT();
-    mcpSPI->endTransaction();
+    spi_end();
 }
 
 /*********************************************************************************************************
@@ -118,14 +224,12 @@ void MCP_CAN::mcp2515_setRegisterS(const INT8U address, const INT8U values[], co
 *********************************************************************************************************/
 void MCP_CAN::mcp2515_modifyRegister(const INT8U address, const INT8U mask, const INT8U data)
 {
-    mcpSPI->beginTransaction(SPISettings(10000000, MSBFIRST, SPI_MODE0));
-    MCP2515_SELECT();
+    spi_begin();
     spi_readwrite(MCP_BITMOD);
     spi_readwrite(address);
     spi_readwrite(mask);
     spi_readwrite(data);
-    MCP2515_UNSELECT();
-    mcpSPI->endTransaction();
+    spi_end();
 }
 
 /*********************************************************************************************************
@@ -135,12 +239,10 @@ void MCP_CAN::mcp2515_modifyRegister(const INT8U address, const INT8U mask, cons
 INT8U MCP_CAN::mcp2515_readStatus(void)
 {
     INT8U i;
-    mcpSPI->beginTransaction(SPISettings(10000000, MSBFIRST, SPI_MODE0));
-    MCP2515_SELECT();
+    spi_begin();
     spi_readwrite(MCP_READ_STATUS);
     i = spi_read();
-    MCP2515_UNSELECT();
-    mcpSPI->endTransaction();
+    spi_end();
     return i;
 }
 
@@ -586,6 +688,7 @@ INT8U MCP_CAN::mcp2515_init(const INT8U canIDMode, const INT8U canSpeed, const I
 
         /* init canbuffers              */
         mcp2515_initCANBuffers();
+        mcpRx1First = 0;
 
         /* interrupt mode               */
         mcp2515_setRegister(MCP_CANINTE, MCP_RX0IF | MCP_RX1IF);
@@ -600,7 +703,7 @@ INT8U MCP_CAN::mcp2515_init(const INT8U canIDMode, const INT8U canSpeed, const I
         case (MCP_ANY):
             mcp2515_modifyRegister(MCP_RXB0CTRL,
                                    MCP_RXB_RX_MASK | MCP_RXB_BUKT_MASK,
-                                   MCP_RXB_RX_ANY | MCP_RXB_BUKT_MASK);
+                                   MCP_RXB_RX_ANY | (mcpRollover ? MCP_RXB_BUKT_MASK : 0));
             mcp2515_modifyRegister(MCP_RXB1CTRL, MCP_RXB_RX_MASK,
                                    MCP_RXB_RX_ANY);
             break;
@@ -624,7 +727,7 @@ INT8U MCP_CAN::mcp2515_init(const INT8U canIDMode, const INT8U canSpeed, const I
         case (MCP_STDEXT):
             mcp2515_modifyRegister(MCP_RXB0CTRL,
                                    MCP_RXB_RX_MASK | MCP_RXB_BUKT_MASK,
-                                   MCP_RXB_RX_STDEXT | MCP_RXB_BUKT_MASK);
+                                   MCP_RXB_RX_STDEXT | (mcpRollover ? MCP_RXB_BUKT_MASK : 0));
             mcp2515_modifyRegister(MCP_RXB1CTRL, MCP_RXB_RX_MASK,
                                    MCP_RXB_RX_STDEXT);
             break;
@@ -655,9 +758,20 @@ INT8U MCP_CAN::mcp2515_init(const INT8U canIDMode, const INT8U canSpeed, const I
 *********************************************************************************************************/
 void MCP_CAN::mcp2515_write_id(const INT8U mcp_addr, const INT8U ext, const INT32U id)
 {
-    uint16_t canid;
     INT8U tbufdata[4];
 
+    mcp2515_id_to_buf(ext, id, tbufdata);
+    mcp2515_setRegisterS(mcp_addr, tbufdata, 4);
+}
+
+/*********************************************************************************************************
+** Function name:           mcp2515_id_to_buf
+** Descriptions:            CAN ID -> SIDH, SIDL, EID8, EID0 of a TX buffer
+*********************************************************************************************************/
+void MCP_CAN::mcp2515_id_to_buf(const INT8U ext, const INT32U id, INT8U *tbufdata)
+{
+    uint16_t canid;
+
     canid = (uint16_t)(id & 0x0FFFF);
 
     if (ext == 1)
@@ -677,8 +791,6 @@ void MCP_CAN::mcp2515_write_id(const INT8U mcp_addr, const INT8U ext, const INT3
         tbufdata[MCP_EID0] = 0;
         tbufdata[MCP_EID8] = 0;
     }
-
-    mcp2515_setRegisterS(mcp_addr, tbufdata, 4);
 }
 
 /*********************************************************************************************************
@@ -722,11 +834,17 @@ void MCP_CAN::mcp2515_read_id(const INT8U mcp_addr, INT8U *ext, INT32U *id)
 {
     INT8U tbufdata[4];
 
-    *ext = 0;
-    *id = 0;
-
     mcp2515_readRegisterS(mcp_addr, tbufdata, 4);
+    mcp2515_buf_to_id(tbufdata, ext, id);
+}
 
+/*********************************************************************************************************
+** Function name:           mcp2515_buf_to_id
+** Descriptions:            SIDH, SIDL, EID8, EID0 of an RX buffer -> CAN ID
+*********************************************************************************************************/
+void MCP_CAN::mcp2515_buf_to_id(const INT8U *tbufdata, INT8U *ext, INT32U *id)
+{
+    *ext = 0;
     *id = (tbufdata[MCP_SIDH] << 3) + (tbufdata[MCP_SIDL] >> 5);
 
     if ((tbufdata[MCP_SIDL] & MCP_TXB_EXIDE_M) == MCP_TXB_EXIDE_M)
@@ -777,6 +895,8 @@ void MCP_CAN::mcp2515_read_canMsg(const INT8U buffer_sidh_addr) /* read can msg
         m_nRtr = 0;
 
     m_nDlc &= MCP_DLC_MASK;
+    if (m_nDlc > MAX_CHAR_IN_MESSAGE) /* DLC 9..15 still carries 8 bytes */
+        m_nDlc = MAX_CHAR_IN_MESSAGE;
     mcp2515_readRegisterS(mcp_addr + 5, &(m_nDta[0]), m_nDlc);
 }
 
@@ -839,6 +959,10 @@ INT8U MCP_CAN::begin(INT8U idmodeset, INT8U speedset, INT8U clockset)
 {
     INT8U res;
 
+    mcpIdMode = idmodeset;
+    mcpSpeed = speedset;
+    mcpClock = clockset;
+    mcpBegun = 1;
     mcpSPI->begin();
     res = mcp2515_init(idmodeset, speedset, clockset);
     if (res == MCP2515_OK)
@@ -847,6 +971,24 @@ INT8U MCP_CAN::begin(INT8U idmodeset, INT8U speedset, INT8U clockset)
     return CAN_FAILINIT;
 }
 
+/*********************************************************************************************************
+** Function name:           reinit
+** Descriptions:            Reset the chip and run begin() with the last arguments, then return to the
+**                          last mode set with setMode(). Pending frames are lost; masks/filters go back
+**                          to what begin() sets. Used to recover from bus-off or a chip that lost its
+**                          configuration (brown-out, SPI glitch).
+*********************************************************************************************************/
+INT8U MCP_CAN::reinit(void)
+{
+    INT8U mode = mcpMode;
+
+    if (!mcpBegun)
+        return CAN_FAILINIT;
+    if (mcp2515_init(mcpIdMode, mcpSpeed, mcpClock) != MCP2515_OK)
+        return CAN_FAILINIT;
+    return setMode(mode);
+}
+
 /*********************************************************************************************************
 ** Function name:           init_Mask
 ** Descriptions:            Public function to set mask(s).
@@ -1086,8 +1228,8 @@ INT8U MCP_CAN::setMsg(INT32U id, INT8U rtr, INT8U ext, INT8U len, INT8U *pData)
     m_nID = id;
     m_nRtr = rtr;
     m_nExtFlg = ext;
-    m_nDlc = len;
-    for (i = 0; i < MAX_CHAR_IN_MESSAGE; i++)
+    m_nDlc = len > MAX_CHAR_IN_MESSAGE ? MAX_CHAR_IN_MESSAGE : len;
+    for (i = 0; i < m_nDlc; i++) /* copy only len bytes: pData may be shorter than 8 */
         m_nDta[i] = *(pData + i);
 
     return MCP2515_OK;
@@ -1115,6 +1257,40 @@ INT8U MCP_CAN::clearMsg()
 ** Descriptions:            Send message
 *********************************************************************************************************/
 INT8U MCP_CAN::sendMsg()
+{
+    INT8U res;
+
+    mcpCount = &mcpStats.tx;
+    res = CAN_OK;
+    if (!mcpTxWait)
+    {
+        uint32_t temp = micros();
+        while (txPending())
+        {
+            if (micros() - temp >= TIMEOUTVALUE)
+            {
+                res = CAN_GETTXBFTIMEOUT;
+                break;
+            }
+        }
+    }
+    if (res == CAN_OK)
+        res = mcpFastIO ? sendMsgFast() : sendMsgRegs();
+    if (res == CAN_OK)
+    {
+        mcpStats.tx.frames++;
+        mcpStats.txWait.frames++;
+    }
+    mcpCount = &mcpStats.other;
+
+    return res;
+}
+
+/*********************************************************************************************************
+** Function name:           sendMsgRegs
+** Descriptions:            Send message (register access)
+*********************************************************************************************************/
+INT8U MCP_CAN::sendMsgRegs()
 {
     INT8U res, res1, txbuf_n;
     uint32_t uiTimeOut, temp;
@@ -1134,7 +1310,10 @@ INT8U MCP_CAN::sendMsg()
     uiTimeOut = 0;
     mcp2515_write_canMsg(txbuf_n);
     mcp2515_modifyRegister(txbuf_n - 1, MCP_TXB_TXREQ_M, MCP_TXB_TXREQ_M);
+    if (!mcpTxWait)
+        return CAN_OK;
 
+    mcpCount = &mcpStats.txWait;
     temp = micros();
     do
     {
@@ -1151,6 +1330,63 @@ INT8U MCP_CAN::sendMsg()
     return CAN_OK;
 }
 
+/*********************************************************************************************************
+** Function name:           sendMsgFast
+** Descriptions:            Send message: READ STATUS + LOAD TX + RTS under one bus lock,
+**                          then poll READ STATUS (2 bytes) until TXREQ clears
+*********************************************************************************************************/
+INT8U MCP_CAN::sendMsgFast()
+{
+    static const INT8U txreq[MCP_N_TXBUFFERS] = {MCP_STAT_TX0REQ, MCP_STAT_TX1REQ, MCP_STAT_TX2REQ};
+    static const INT8U load[MCP_N_TXBUFFERS] = {MCP_LOAD_TX0, MCP_LOAD_TX1, MCP_LOAD_TX2};
+    static const INT8U rts[MCP_N_TXBUFFERS] = {MCP_RTS_TX0, MCP_RTS_TX1, MCP_RTS_TX2};
+    INT8U tbufdata[5 + MAX_CHAR_IN_MESSAGE];
+    INT8U i, n, res1;
+    uint32_t temp;
+
+    mcp2515_id_to_buf(m_nExtFlg, m_nID, tbufdata);
+    tbufdata[4] = m_nRtr ? (INT8U)(m_nDlc | MCP_RTR_MASK) : m_nDlc;
+    for (i = 0; i < m_nDlc; i++)
+        tbufdata[5 + i] = m_nDta[i];
+
+    temp = micros();
+    for (;;)
+    {
+        spi_lock();
+        res1 = mcp2515_readStatus();
+        for (n = 0; n < MCP_N_TXBUFFERS && (res1 & txreq[n]); n++)
+            ;
+        if (n < MCP_N_TXBUFFERS)
+            break; /* keep the lock for LOAD TX + RTS */
+        spi_unlock();
+        if (micros() - temp >= TIMEOUTVALUE)
+            return CAN_GETTXBFTIMEOUT; /* get tx buff time out         */
+    }
+
+    spi_begin();
+    spi_readwrite(load[n]); /* from TXBnSIDH                */
+    for (i = 0; i < 5 + m_nDlc; i++)
+        spi_readwrite(tbufdata[i]);
+    spi_end();
+    spi_begin();
+    spi_readwrite(rts[n]);
+    spi_end();
+    spi_unlock();
+    if (!mcpTxWait)
+        return CAN_OK;
+
+    mcpCount = &mcpStats.txWait;
+    temp = micros();
+    do
+    {
+        res1 = mcp2515_readStatus() & txreq[n];
+    } while (res1 && (micros() - temp < TIMEOUTVALUE));
+    if (res1)
+        return CAN_SENDMSGTIMEOUT; /* send msg timeout             */
+
+    return CAN_OK;
+}
+
 /*********************************************************************************************************
 ** Function name:           sendMsgBuf
 ** Descriptions:            Send message to transmitt buffer
@@ -1192,17 +1428,39 @@ INT8U MCP_CAN::sendMsgBuf(INT32U id, INT8U len, INT8U *buf)
 *********************************************************************************************************/
 INT8U MCP_CAN::readMsg()
 {
-    INT8U stat, res;
+    MCP_SPI_Counter c;
+    INT8U res;
 
-    stat = mcp2515_readStatus();
+    mcpCount = &c;
+    res = mcpFastIO ? readMsgFast() : readMsgRegs();
+    mcpCount = &mcpStats.other;
 
-    if (stat & MCP_STAT_RX0IF) /* Msg in Buffer 0              */
+    c.frames = 1;
+    if (res == CAN_OK)
+        mcpStats.rx.add(c);
+    else
+        mcpStats.idle.add(c); /* polled, nothing received     */
+
+    return res;
+}
+
+/*********************************************************************************************************
+** Function name:           readMsgRegs
+** Descriptions:            Read message (register access)
+*********************************************************************************************************/
+INT8U MCP_CAN::readMsgRegs()
+{
+    INT8U n, res;
+
+    n = mcp2515_nextRxBuf();
+
+    if (n == 0) /* Msg in Buffer 0              */
     {
         mcp2515_read_canMsg(MCP_RXBUF_0);
         mcp2515_modifyRegister(MCP_CANINTF, MCP_RX0IF, 0);
         res = CAN_OK;
     }
-    else if (stat & MCP_STAT_RX1IF) /* Msg in Buffer 1              */
+    else if (n == 1) /* Msg in Buffer 1              */
     {
         mcp2515_read_canMsg(MCP_RXBUF_1);
         mcp2515_modifyRegister(MCP_CANINTF, MCP_RX1IF, 0);
@@ -1214,6 +1472,101 @@ INT8U MCP_CAN::readMsg()
     return res;
 }
 
+/*********************************************************************************************************
+** Function name:           readMsgFast
+** Descriptions:            Read message: CANINTF/EFLG + READ RX under one bus lock.
+**                          The chip clears RXnIF when /CS goes high after READ RX.
+*********************************************************************************************************/
+INT8U MCP_CAN::readMsgFast()
+{
+    INT8U n, i;
+    INT8U tbufdata[5];
+
+    spi_lock();
+    n = mcp2515_nextRxBuf();
+    if (n > 1)
+    {
+        spi_unlock();
+        return CAN_NOMSG;
+    }
+
+    spi_begin();
+    spi_readwrite(n ? MCP_READ_RX1 : MCP_READ_RX0); /* from RXBnSIDH                */
+    for (i = 0; i < 5; i++)
+        tbufdata[i] = spi_read();
+    m_nDlc = tbufdata[4] & MCP_DLC_MASK;
+    if (m_nDlc > MAX_CHAR_IN_MESSAGE) /* DLC 9..15 still carries 8 bytes */
+        m_nDlc = MAX_CHAR_IN_MESSAGE;
+    for (i = 0; i < m_nDlc; i++)
+        m_nDta[i] = spi_read();
+    spi_end();
+    spi_unlock();
+
+    mcp2515_buf_to_id(tbufdata, &m_nExtFlg, &m_nID);
+    if (m_nExtFlg)
+        m_nRtr = (tbufdata[4] & MCP_RXB_RTR_M) ? 1 : 0;
+    else
+        m_nRtr = (tbufdata[MCP_SIDL] & MCP_STAT_SRR_M) ? 1 : 0;
+
+    return CAN_OK;
+}
+
+/*********************************************************************************************************
+** Function name:           mcp2515_nextRxBuf
+** Descriptions:            RX buffer to read next (0, 1; 0xFF: none). Reads CANINTF and EFLG with one
+**                          READ, counts and clears RX0OVR/RX1OVR. With rollover RXB1 only fills while
+**                          RXB0 is full, so RXB0 holds the older frame unless RXB0 was read (and may
+**                          have refilled) while RXB1 was still pending.
+*********************************************************************************************************/
+INT8U MCP_CAN::mcp2515_nextRxBuf(void)
+{
+    INT8U r[2], n;
+
+    mcp2515_readRegisterS(MCP_CANINTF, r, 2); /* CANINTF, EFLG                */
+    if (r[1] & (MCP_EFLG_RX0OVR | MCP_EFLG_RX1OVR))
+    {
+        if (r[1] & MCP_EFLG_RX0OVR)
+            mcpRxStats.overflow[0]++;
+        if (r[1] & MCP_EFLG_RX1OVR)
+            mcpRxStats.overflow[1]++;
+        mcp2515_modifyRegister(MCP_EFLG, MCP_EFLG_RX0OVR | MCP_EFLG_RX1OVR, 0);
+        mcp2515_modifyRegister(MCP_CANINTF, MCP_ERRIF, 0);
+    }
+
+    switch (r[0] & (MCP_RX0IF | MCP_RX1IF))
+    {
+    case MCP_RX0IF:
+        n = 0;
+        break;
+    case MCP_RX1IF:
+        n = 1;
+        break;
+    case (MCP_RX0IF | MCP_RX1IF):
+        n = mcpRx1First ? 1 : 0;
+        break;
+    default:
+        return 0xFF;
+    }
+    mcpRx1First = (n == 0 && (r[0] & MCP_RX1IF)) ? 1 : 0;
+    mcpRxStats.frames[n]++;
+    return n;
+}
+
+/*********************************************************************************************************
+** Function name:           setRxRollover / getRxRollover
+** Descriptions:            RXB0 -> RXB1 rollover (BUKT). Kept across begin(); get reads the chip.
+*********************************************************************************************************/
+void MCP_CAN::setRxRollover(INT8U enable)
+{
+    mcpRollover = enable ? 1 : 0;
+    mcp2515_modifyRegister(MCP_RXB0CTRL, MCP_RXB_BUKT_MASK, mcpRollover ? MCP_RXB_BUKT_MASK : 0);
+}
+
+INT8U MCP_CAN::getRxRollover(void)
+{
+    return (mcp2515_readRegister(MCP_RXB0CTRL) & MCP_RXB_BUKT_MASK) ? 1 : 0;
+}
+
 /*********************************************************************************************************
 ** Function name:           readMsgBuf
 ** Descriptions:            Public function, Reads message from receive buffer.
@@ -1293,6 +1646,27 @@ INT8U MCP_CAN::getError(void)
     return mcp2515_readRegister(MCP_EFLG);
 }
 
+/*********************************************************************************************************
+** Function name:           errorState
+** Descriptions:            TEC, REC, EFLG and CANSTAT under one bus lock
+*********************************************************************************************************/
+INT8U MCP_CAN::errorState(MCP_Error_State *st)
+{
+    INT8U ec[2];
+
+    if (!st)
+        return CAN_FAIL;
+    spi_lock();
+    mcp2515_readRegisterS(MCP_TEC, ec, 2); /* TEC, REC                     */
+    st->tec = ec[0];
+    st->rec = ec[1];
+    st->eflg = mcp2515_readRegister(MCP_EFLG);
+    st->canstat = mcp2515_readRegister(MCP_CANSTAT);
+    spi_unlock();
+
+    return CAN_OK;
+}
+
 /*********************************************************************************************************
 ** Function name:           mcp2515_errorCountRX
 ** Descriptions:            Returns REC register value
@@ -1339,17 +1713,28 @@ INT8U MCP_CAN::disOneShotTX(void)
 
 /*********************************************************************************************************
 ** Function name:           mcp2515_abortTX
-** Descriptions:            Aborts any queued transmissions
+** Descriptions:            Aborts any queued transmissions. Waits for the TXREQ bits to clear
+**                          (a frame already on the wire finishes) and then releases ABAT, otherwise
+**                          the chip would refuse every later transmission.
 *********************************************************************************************************/
 INT8U MCP_CAN::abortTX(void)
 {
+    INT8U res = CAN_OK;
+    uint32_t temp;
+
     mcp2515_modifyRegister(MCP_CANCTRL, ABORT_TX, ABORT_TX);
+    temp = micros();
+    while (txPending())
+    {
+        if (micros() - temp >= TIMEOUTVALUE)
+        {
+            res = CAN_FAIL;
+            break;
+        }
+    }
+    mcp2515_modifyRegister(MCP_CANCTRL, ABORT_TX, 0);
 
-    // Maybe check to see if the TX buffer transmission request bits are cleared instead?
-    if ((mcp2515_readRegister(MCP_CANCTRL) & ABORT_TX) != ABORT_TX)
-        return CAN_FAIL;
-    else
-        return CAN_OK;
+    return res;
 }
 
 /*********************************************************************************************************
@@ -27,6 +27,54 @@
 #include "mcp_can_dfs.h"
 #define MAX_CHAR_IN_MESSAGE 8
 
+// SPI traffic of one direction (see MCP_CAN::spiStats)
+struct MCP_SPI_Counter
+{
+  INT32U frames = 0;  // frames sent / received (idle: empty polls)
+  INT32U locks = 0;   // beginTransaction (bus lock)
+  INT32U selects = 0; // chip selects (one MCP2515 instruction each)
+  INT32U bytes = 0;   // bytes clocked
+  void add(const MCP_SPI_Counter &o)
+  {
+    frames += o.frames;
+    locks += o.locks;
+    selects += o.selects;
+    bytes += o.bytes;
+  }
+};
+
+struct MCP_SPI_Stats
+{
+  MCP_SPI_Counter tx;     // sendMsgBuf: find a TX buffer, load it, request to send
+  MCP_SPI_Counter txWait; // sendMsgBuf: polling until the frame has left the chip
+  MCP_SPI_Counter rx;     // readMsgBuf that returned a frame
+  MCP_SPI_Counter idle;   // readMsgBuf that found nothing
+  MCP_SPI_Counter other;  // init, mode, filters, checkReceive, ...
+};
+
+// Receive buffers (see MCP_CAN::rxStats)
+struct MCP_RX_Stats
+{
+  INT32U frames[2] = {};   // frames read from RXB0 / RXB1 (RXB1: rollover)
+  INT32U overflow[2] = {}; // RX0OVR / RX1OVR seen and cleared (each: one or more frames lost)
+};
+
+// Error state (see MCP_CAN::errorState)
+struct MCP_Error_State
+{
+  INT8U tec = 0;     // TEC
+  INT8U rec = 0;     // REC
+  INT8U eflg = 0;    // EFLG (TXBO / TXEP / RXEP / EWARN ...)
+  INT8U canstat = 0; // CANSTAT (OPMOD in bits 7..5)
+};
+
+// Cost model for spiEstimateUs: fixed cost per bus lock and per chip select, plus bytes at the SPI clock
+struct MCP_SPI_Cost
+{
+  INT32U lockNs = 1500;
+  INT32U selectNs = 200;
+};
+
 class MCP_CAN
 {
 private:
@@ -40,12 +88,32 @@ private:
   SPIClass *mcpSPI;                  // The SPI-Device used
   INT8U MCPCS;                       // Chip Select pin number
   INT8U mcpMode;                     // Mode to return to after configurations are performed.
+  INT32U mcpSPIClock = 10000000;     // SPI clock
+  INT8U mcpFastIO = 0;               // Use READ STATUS / LOAD TX / RTS / READ RX instructions
+  INT8U mcpTxWait = 1;               // sendMsg waits for the frame to leave the chip
+  INT8U mcpLockDepth = 0;            // Nested spi_lock() count
+  MCP_SPI_Stats mcpStats;            // SPI traffic
+  MCP_SPI_Counter *mcpCount = &mcpStats.other;
+  MCP_SPI_Cost mcpCost;
+  INT8U mcpRollover = 1;             // RXB0 -> RXB1 rollover (BUKT)
+  INT8U mcpRx1First = 0;             // RXB1 holds an older frame than RXB0
+  MCP_RX_Stats mcpRxStats;           // Receive buffer counts
+  INT8U mcpIdMode = MCP_ANY;         // begin() arguments, kept for reinit()
+  INT8U mcpSpeed = 0;
+  INT8U mcpClock = 0;
+  INT8U mcpBegun = 0;
 
   /*********************************************************************************************************
    *  mcp2515 driver function
    *********************************************************************************************************/
   // private:
 private:
+  void spi_lock(void);               // beginTransaction (shared while nested)
+  void spi_unlock(void);
+  void spi_begin(void);              // lock + /CS low
+  void spi_end(void);                // /CS high + unlock
+  INT8U spi_xfer(const INT8U data);  // counted transfer
+
   void mcp2515_reset(void); // Soft Reset MCP2515
 
   INT8U mcp2515_readRegister(const INT8U address); // Read MCP2515 register
@@ -90,6 +158,10 @@ private:
                        INT8U *ext,
                        INT32U *id);
 
+  void mcp2515_id_to_buf(const INT8U ext, const INT32U id, INT8U *tbufdata); // CAN ID -> SIDH..EID0
+  void mcp2515_buf_to_id(const INT8U *tbufdata, INT8U *ext, INT32U *id);    // SIDH..EID0 -> CAN ID
+  INT8U mcp2515_nextRxBuf(void);                                            // RX buffer to read, overflow flags
+
   void mcp2515_write_canMsg(const INT8U buffer_sidh_addr); // Write CAN message
   void mcp2515_read_canMsg(const INT8U buffer_sidh_addr);  // Read CAN message
   INT8U mcp2515_getNextFreeTXBuf(INT8U *txbuf_n);          // Find empty transmit buffer
@@ -101,7 +173,11 @@ private:
   INT8U setMsg(INT32U id, INT8U rtr, INT8U ext, INT8U len, INT8U *pData); // Set message
   INT8U clearMsg();                                                       // Clear all message to zero
   INT8U readMsg();                                                        // Read message
+  INT8U readMsgRegs();                                                    // Read message (register access)
+  INT8U readMsgFast();                                                    // Read message (READ RX)
   INT8U sendMsg();                                                        // Send message
+  INT8U sendMsgRegs();                                                    // Send message (register access)
+  INT8U sendMsgFast();                                                    // Send message (LOAD TX + RTS)
 
 public:
   MCP_CAN(INT8U _CS);
@@ -127,6 +203,24 @@ public:
   INT8U abortTX(void);                                              // Abort queued transmission(s)
   INT8U setGPO(INT8U data);                                         // Sets GPO
   INT8U getGPI(void);                                               // Reads GPI
+
+  void setSPIClock(INT32U hz);                                      // SPI clock (default 10 MHz)
+  void setFastIO(INT8U enable);                                     // Batched send/receive instructions
+  void setTxWait(INT8U enable);                                     // 0: return after RTS, one frame in flight
+  INT8U txPending(void);                                            // Any TXREQ still set
+  INT8U errorState(MCP_Error_State *st);                            // TEC/REC/EFLG/CANSTAT under one bus lock
+  INT8U reinit(void);                                               // Reset and begin() again, back to the last mode
+  INT8U requestedMode(void) const { return mcpMode; }               // Mode last set by setMode() (begin: loopback)
+  void lockSPI(void);                                               // Hold the SPI bus across calls
+  void unlockSPI(void);                                             // Release lockSPI()
+  const MCP_SPI_Stats &spiStats(void) const { return mcpStats; }    // SPI traffic per direction
+  void resetSpiStats(void);                                         // Clear SPI traffic
+  void setSpiCost(const MCP_SPI_Cost &cost) { mcpCost = cost; }     // Cost model for spiEstimateUs
+  float spiEstimateUs(const MCP_SPI_Counter &c) const;              // Estimated SPI time of a counter
+  void setRxRollover(INT8U enable);                                 // RXB0 -> RXB1 rollover (default on)
+  INT8U getRxRollover(void);                                        // BUKT as set in the chip
+  const MCP_RX_Stats &rxStats(void) const { return mcpRxStats; }    // Per-buffer frames / overflows
+  void resetRxStats(void) { mcpRxStats = MCP_RX_Stats(); }          // Clear receive buffer counts
 };
 
 #endif
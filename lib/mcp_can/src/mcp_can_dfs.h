@@ -79,6 +79,10 @@
 #define MCP_STAT_RXIF_MASK   (0x03)
 #define MCP_STAT_RX0IF       (1<<0)
 #define MCP_STAT_RX1IF       (1<<1)
+#define MCP_STAT_TX0REQ      (1<<2)                                     /* TXBnCTRL.TXREQ in READ STATUS */
+#define MCP_STAT_TX1REQ      (1<<4)
+#define MCP_STAT_TX2REQ      (1<<6)
+#define MCP_STAT_SRR_M       0x10                                       /* Standard RTR in RXBnSIDL     */
 
 #define MCP_EFLG_RX1OVR     (1<<7)
 #define MCP_EFLG_RX0OVR     (1<<6)
@@ -0,0 +1,357 @@
+// ArduinoShim.cpp — 時刻 / 協調スケジューラ / Arduino コア関数（native 用）
+#include "Arduino.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+HardwareSerial Serial;
+
+namespace
+{
+    struct ShimThread
+    {
+        uint64_t wakeNs = 0;
+        uint64_t seq = 0;
+        bool sleeping = false;
+        bool done = false;
+    };
+    struct ShimTaskExit
+    {
+    };
+    struct PinSlot
+    {
+        uint8_t value = LOW;
+        ArduinoShim::PinListener fn = nullptr;
+        void *ctx = nullptr;
+    };
+
+    // スケジューラ（仮想時間）
+    std::mutex g_schedMu;
+    std::condition_variable g_schedCv;
+    std::vector<ShimThread *> g_threads;
+    ShimThread *g_running = nullptr;
+    uint64_t g_seq = 0;
+    thread_local ShimThread *t_self = nullptr;
+
+    // 時刻とイベント源
+    std::recursive_mutex g_stateMu;
+    std::recursive_mutex g_critMu;
+    std::atomic<bool> g_virtual{false};
+    uint64_t g_virtNs = 0;
+    uint64_t g_pumpNs = 0;
+    bool g_inPump = false;
+    uint32_t g_autoNs = 50;
+    std::vector<ShimTimeSource *> g_sources;
+    const std::chrono::steady_clock::time_point g_t0 = std::chrono::steady_clock::now();
+
+    std::mutex g_serialMu;
+    std::deque<char> g_serialIn;
+    PinSlot g_pins[256];
+
+    uint64_t realNs()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - g_t0).count();
+    }
+
+    // target までのイベントを時刻順に処理（g_stateMu 保持で呼ぶ）
+    void runSources(uint64_t target)
+    {
+        if (g_inPump)
+            return;
+        g_inPump = true;
+        for (;;)
+        {
+            ShimTimeSource *best = nullptr;
+            uint64_t bestNs = ArduinoShim::NEVER;
+            for (ShimTimeSource *s : g_sources)
+            {
+                uint64_t e = s->nextEventNs();
+                if (e < bestNs)
+                {
+                    bestNs = e;
+                    best = s;
+                }
+            }
+            if (!best || bestNs > target)
+                break;
+            if (g_virtual && bestNs > g_virtNs)
+                g_virtNs = bestNs;
+            g_pumpNs = g_virtual ? g_virtNs : bestNs;
+            best->runUntil(g_pumpNs);
+        }
+        g_inPump = false;
+    }
+
+    ShimThread *self()
+    {
+        if (!t_self)
+        {
+            t_self = new ShimThread();
+            std::lock_guard<std::mutex> lk(g_schedMu);
+            g_threads.push_back(t_self);
+            if (!g_running)
+                g_running = t_self;
+        }
+        return t_self;
+    }
+
+    // 次に走るスレッドを選び、その起床時刻まで時間を進める（g_schedMu 保持で呼ぶ）
+    void dispatchLocked()
+    {
+        ShimThread *next = nullptr;
+        for (ShimThread *t : g_threads)
+        {
+            if (t->done || !t->sleeping)
+                continue;
+            if (!next || t->wakeNs < next->wakeNs || (t->wakeNs == next->wakeNs && t->seq < next->seq))
+                next = t;
+        }
+        if (!next)
+        {
+            g_running = nullptr;
+            return;
+        }
+        {
+            std::lock_guard<std::recursive_mutex> lk(g_stateMu);
+            uint64_t t = next->wakeNs > g_virtNs ? next->wakeNs : g_virtNs;
+            runSources(t);
+            g_virtNs = t;
+        }
+        g_running = next;
+        g_schedCv.notify_all();
+    }
+}
+
+namespace ArduinoShim
+{
+    void useVirtualTime(bool on)
+    {
+        std::lock_guard<std::recursive_mutex> lk(g_stateMu);
+        g_virtual = on;
+        if (on)
+        {
+            g_virtNs = 0;
+            self();
+        }
+    }
+    bool virtualTime() { return g_virtual; }
+
+    uint64_t nowNs()
+    {
+        std::lock_guard<std::recursive_mutex> lk(g_stateMu);
+        if (g_inPump)
+            return g_pumpNs;
+        return g_virtual ? g_virtNs : realNs();
+    }
+
+    void advanceNs(uint64_t ns)
+    {
+        std::lock_guard<std::recursive_mutex> lk(g_stateMu);
+        if (g_inPump)
+            return;
+        if (!g_virtual)
+        {
+            runSources(realNs());
+            return;
+        }
+        uint64_t target = g_virtNs + ns;
+        runSources(target);
+        g_virtNs = target;
+    }
+
+    void pump()
+    {
+        std::lock_guard<std::recursive_mutex> lk(g_stateMu);
+        runSources(g_virtual ? g_virtNs : realNs());
+    }
+
+    void sleepUntilNs(uint64_t ns)
+    {
+        if (!g_virtual)
+        {
+            uint64_t now = realNs();
+            if (ns > now)
+                std::this_thread::sleep_for(std::chrono::nanoseconds(ns - now));
+            else
+                std::this_thread::yield();
+            pump();
+            return;
+        }
+        ShimThread *me = self();
+        std::unique_lock<std::mutex> lk(g_schedMu);
+        me->wakeNs = ns;
+        me->seq = ++g_seq;
+        me->sleeping = true;
+        dispatchLocked();
+        g_schedCv.wait(lk, [me] { return g_running == me; });
+        me->sleeping = false;
+    }
+
+    void yieldTask() { sleepUntilNs(nowNs()); }
+
+    void setAutoAdvanceNs(uint32_t ns) { g_autoNs = ns; }
+
+    void addTimeSource(ShimTimeSource *src)
+    {
+        std::lock_guard<std::recursive_mutex> lk(g_stateMu);
+        g_sources.push_back(src);
+    }
+    void removeTimeSource(ShimTimeSource *src)
+    {
+        std::lock_guard<std::recursive_mutex> lk(g_stateMu);
+        for (size_t i = 0; i < g_sources.size(); i++)
+            if (g_sources[i] == src)
+            {
+                g_sources.erase(g_sources.begin() + (long)i);
+                return;
+            }
+    }
+
+    void *spawnTask(TaskFn fn, void *arg, const char *name)
+    {
+        (void)name;
+        if (!g_virtual)
+        {
+            std::thread([fn, arg] {
+                try
+                {
+                    fn(arg);
+                }
+                catch (const ShimTaskExit &)
+                {
+                }
+            }).detach();
+            return (void *)fn;
+        }
+        self();
+        ShimThread *th = new ShimThread();
+        {
+            std::lock_guard<std::mutex> lk(g_schedMu);
+            th->wakeNs = nowNs();
+            th->seq = ++g_seq;
+            th->sleeping = true;
+            g_threads.push_back(th);
+        }
+        std::thread([th, fn, arg] {
+            t_self = th;
+            {
+                std::unique_lock<std::mutex> lk(g_schedMu);
+                g_schedCv.wait(lk, [th] { return g_running == th; });
+                th->sleeping = false;
+            }
+            try
+            {
+                fn(arg);
+            }
+            catch (const ShimTaskExit &)
+            {
+            }
+            std::lock_guard<std::mutex> lk(g_schedMu);
+            th->done = true;
+            for (size_t i = 0; i < g_threads.size(); i++)
+                if (g_threads[i] == th)
+                {
+                    g_threads.erase(g_threads.begin() + (long)i);
+                    break;
+                }
+            dispatchLocked();
+            // スケジューラからは外したので、ここで解放（ハンドルは「生きているか」の印にしか使わない）
+            t_self = nullptr;
+            delete th;
+        }).detach();
+        return th;
+    }
+
+    void exitTask() { throw ShimTaskExit(); }
+
+    void lock() { g_stateMu.lock(); }
+    void unlock() { g_stateMu.unlock(); }
+
+    void serialInput(const char *text)
+    {
+        std::lock_guard<std::mutex> lk(g_serialMu);
+        while (text && *text)
+            g_serialIn.push_back(*text++);
+    }
+
+    void setPinListener(uint8_t pin, PinListener fn, void *ctx)
+    {
+        g_pins[pin].fn = fn;
+        g_pins[pin].ctx = ctx;
+    }
+}
+
+// ===== Arduino コア =====
+uint32_t micros()
+{
+    if (g_virtual)
+        ArduinoShim::advanceNs(g_autoNs);
+    else
+        ArduinoShim::pump();
+    return (uint32_t)(ArduinoShim::nowNs() / 1000ULL);
+}
+uint32_t millis()
+{
+    if (g_virtual)
+        ArduinoShim::advanceNs(g_autoNs);
+    else
+        ArduinoShim::pump();
+    return (uint32_t)(ArduinoShim::nowNs() / 1000000ULL);
+}
+void delay(uint32_t ms) { ArduinoShim::sleepUntilNs(ArduinoShim::nowNs() + (uint64_t)ms * 1000000ULL); }
+void delayMicroseconds(uint32_t us) { ArduinoShim::sleepUntilNs(ArduinoShim::nowNs() + (uint64_t)us * 1000ULL); }
+void yield() { ArduinoShim::yieldTask(); }
+void ArduinoShim_yield() { ArduinoShim::yieldTask(); }
+
+int64_t esp_timer_get_time() { return (int64_t)(ArduinoShim::nowNs() / 1000ULL); }
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    (void)pin;
+    (void)mode;
+}
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    PinSlot &p = g_pins[pin];
+    p.value = val ? HIGH : LOW;
+    if (p.fn)
+        p.fn(pin, p.value, p.ctx);
+}
+int digitalRead(uint8_t pin) { return g_pins[pin].value; }
+
+void vPortEnterCritical(portMUX_TYPE *mux)
+{
+    (void)mux;
+    g_critMu.lock();
+}
+void vPortExitCritical(portMUX_TYPE *mux)
+{
+    (void)mux;
+    g_critMu.unlock();
+}
+
+// ===== Serial =====
+int HardwareSerial::available()
+{
+    std::lock_guard<std::mutex> lk(g_serialMu);
+    return (int)g_serialIn.size();
+}
+int HardwareSerial::read()
+{
+    std::lock_guard<std::mutex> lk(g_serialMu);
+    if (g_serialIn.empty())
+        return -1;
+    char c = g_serialIn.front();
+    g_serialIn.pop_front();
+    return (uint8_t)c;
+}
+int HardwareSerial::peek()
+{
+    std::lock_guard<std::mutex> lk(g_serialMu);
+    return g_serialIn.empty() ? -1 : (uint8_t)g_serialIn.front();
+}
@@ -0,0 +1,65 @@
+#pragma once
+// ArduinoShim.h — native(Linux) 用の時刻/スケジューラ制御
+//
+// 実時間モード（既定）: millis/micros は steady_clock、delay は sleep。
+// 仮想時間モード      : useVirtualTime(true)。時刻は delay/SPI転送などでのみ進み、
+//                       FreeRTOS タスク（std::thread）は1本ずつ協調実行される（決定的）。
+// 仮想CANバスやシミュレータは ShimTimeSource として登録し、時刻が進むたびに駆動される。
+
+#include <stdint.h>
+
+class ShimTimeSource
+{
+public:
+    virtual ~ShimTimeSource() {}
+    // 次に処理すべきイベント時刻 [ns]（なければ UINT64_MAX）
+    virtual uint64_t nextEventNs() = 0;
+    // nowNs までのイベントを処理
+    virtual void runUntil(uint64_t nowNs) = 0;
+};
+
+namespace ArduinoShim
+{
+    static constexpr uint64_t NEVER = 0xFFFFFFFFFFFFFFFFULL;
+
+    void useVirtualTime(bool on);
+    bool virtualTime();
+
+    // 現在時刻 [ns]（イベント処理中はそのイベント時刻）
+    uint64_t nowNs();
+    // 仮想時間: 時刻を進めて途中のイベントを処理（他タスクへは切り替えない）
+    // 実時間  : nowNs までのイベント処理のみ
+    void advanceNs(uint64_t ns);
+    void pump();
+    // 現在のスレッドを ns まで眠らせる（仮想時間では他タスクが走る）
+    void sleepUntilNs(uint64_t ns);
+    void yieldTask();
+    // micros()/millis() 1回ごとに進める仮想時間 [ns]（忙待ちループ対策, 既定 50ns）
+    void setAutoAdvanceNs(uint32_t ns);
+
+    void addTimeSource(ShimTimeSource *src);
+    void removeTimeSource(ShimTimeSource *src);
+
+    // FreeRTOS タスク用（freertos_shim.cpp から使用）
+    typedef void (*TaskFn)(void *);
+    void *spawnTask(TaskFn fn, void *arg, const char *name);
+    void exitTask();
+
+    // 共有状態の排他（バス/エミュレータ）。保持したまま sleep しないこと
+    void lock();
+    void unlock();
+
+    // Serial 入力の注入（stdin の代わり）
+    void serialInput(const char *text);
+
+    // digitalWrite の通知先（SPI の CS など）
+    typedef void (*PinListener)(uint8_t pin, uint8_t value, void *ctx);
+    void setPinListener(uint8_t pin, PinListener fn, void *ctx);
+}
+
+class ShimLock
+{
+public:
+    ShimLock() { ArduinoShim::lock(); }
+    ~ShimLock() { ArduinoShim::unlock(); }
+};
@@ -0,0 +1,25 @@
+#pragma once
+// HardwareSerial.h — Serial は stdout へ出力、入力は ArduinoShim::serialInput() で注入
+
+#include "Print.h"
+
+class HardwareSerial : public Stream
+{
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    void end() {}
+    size_t write(uint8_t c) override
+    {
+        fputc(c, stdout);
+        return 1;
+    }
+    size_t write(const uint8_t *buf, size_t n) override { return fwrite(buf, 1, n, stdout); }
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+    void flush() override { fflush(stdout); }
+    operator bool() const { return true; }
+};
+
+extern HardwareSerial Serial;
@@ -0,0 +1,613 @@
+// Mcp2515Emu.cpp — MCP2515 エミュレータ
+#include "Mcp2515Emu.h"
+#include <string.h>
+
+namespace
+{
+    // レジスタ
+    constexpr uint8_t BFPCTRL = 0x0C;
+    constexpr uint8_t TXRTSCTRL = 0x0D;
+    constexpr uint8_t CANSTAT = 0x0E;
+    constexpr uint8_t CANCTRL = 0x0F;
+    constexpr uint8_t TEC = 0x1C;
+    constexpr uint8_t REC = 0x1D;
+    constexpr uint8_t CNF1 = 0x2A;
+    constexpr uint8_t CANINTE = 0x2B;
+    constexpr uint8_t CANINTF = 0x2C;
+    constexpr uint8_t EFLG = 0x2D;
+    constexpr uint8_t TXB0CTRL = 0x30;
+    constexpr uint8_t RXB0CTRL = 0x60;
+    constexpr uint8_t RXB1CTRL = 0x70;
+
+    // ビット
+    constexpr uint8_t MODE_NORMAL = 0x00;
+    constexpr uint8_t MODE_SLEEP = 0x20;
+    constexpr uint8_t MODE_LOOPBACK = 0x40;
+    constexpr uint8_t MODE_LISTEN = 0x60;
+    constexpr uint8_t MODE_CONFIG = 0x80;
+    constexpr uint8_t ABAT = 0x10;
+    constexpr uint8_t OSM = 0x08;
+    constexpr uint8_t ABTF = 0x40;
+    constexpr uint8_t MLOA = 0x20;
+    constexpr uint8_t TXERR = 0x10;
+    constexpr uint8_t TXREQ = 0x08;
+    constexpr uint8_t RX0IF = 0x01;
+    constexpr uint8_t RX1IF = 0x02;
+    constexpr uint8_t ERRIF = 0x20;
+    constexpr uint8_t MERRF = 0x80;
+    constexpr uint8_t RX1OVR = 0x80;
+    constexpr uint8_t RX0OVR = 0x40;
+    constexpr uint8_t BUKT = 0x04;
+    constexpr uint8_t RXM_ANY = 0x60;
+
+    // 命令
+    constexpr uint8_t I_WRITE = 0x02;
+    constexpr uint8_t I_READ = 0x03;
+    constexpr uint8_t I_BITMOD = 0x05;
+    constexpr uint8_t I_READ_STATUS = 0xA0;
+    constexpr uint8_t I_RX_STATUS = 0xB0;
+    constexpr uint8_t I_RESET = 0xC0;
+
+    uint32_t decodeId(const uint8_t *p, bool &ext)
+    {
+        uint32_t sid = ((uint32_t)p[0] << 3) | (p[1] >> 5);
+        ext = (p[1] & 0x08) != 0;
+        if (!ext)
+            return sid;
+        return (sid << 18) | ((uint32_t)(p[1] & 0x03) << 16) | ((uint32_t)p[2] << 8) | p[3];
+    }
+
+    bool bitModifiable(uint8_t a)
+    {
+        if ((a & 0x0F) == 0x0F)
+            return true; // CANCTRL
+        switch (a)
+        {
+        case BFPCTRL:
+        case TXRTSCTRL:
+        case 0x28:
+        case 0x29:
+        case CNF1:
+        case CANINTE:
+        case CANINTF:
+        case EFLG:
+        case 0x30:
+        case 0x40:
+        case 0x50:
+        case RXB0CTRL:
+        case RXB1CTRL:
+            return true;
+        default:
+            return false;
+        }
+    }
+}
+
+Mcp2515Emu::Mcp2515Emu(VirtualCanBus *bus)
+{
+    reset();
+    connect(bus);
+}
+
+Mcp2515Emu::~Mcp2515Emu()
+{
+    if (_bus)
+        _bus->detach(this);
+}
+
+void Mcp2515Emu::connect(VirtualCanBus *bus)
+{
+    if (_bus)
+        _bus->detach(this);
+    _bus = bus;
+    if (_bus)
+        _bus->attach(this);
+}
+
+void Mcp2515Emu::reset()
+{
+    ShimLock lk;
+    memset(_r, 0, sizeof(_r));
+    _r[CANCTRL] = 0x87;
+    _r[CANSTAT] = MODE_CONFIG;
+    _peekBuf = -1;
+    _txBuf = -1;
+    _busOff = false;
+}
+
+// ===== SPI =====
+void Mcp2515Emu::select()
+{
+    pollBusOff();
+    _phase = INSTR;
+    _clearOnDeselect = 0;
+}
+
+void Mcp2515Emu::deselect()
+{
+    if (_clearOnDeselect)
+        _r[CANINTF] &= (uint8_t)~_clearOnDeselect;
+    _clearOnDeselect = 0;
+    _phase = IDLE;
+}
+
+uint8_t Mcp2515Emu::transfer(uint8_t b)
+{
+    switch (_phase)
+    {
+    case INSTR:
+        _instr = b;
+        _stats.spiInstr++;
+        if (b == I_RESET)
+        {
+            reset();
+            _phase = DONE;
+        }
+        else if (b == I_READ || b == I_WRITE)
+            _phase = ADDR;
+        else if (b == I_BITMOD)
+            _phase = BM_ADDR;
+        else if (b == I_READ_STATUS)
+        {
+            uint8_t f = _r[CANINTF];
+            _statusByte = (f & 0x03) | ((_r[0x30] & TXREQ) >> 1) | ((f & 0x04) << 1) |
+                          ((_r[0x40] & TXREQ) << 1) | ((f & 0x08) << 2) |
+                          ((_r[0x50] & TXREQ) << 3) | ((f & 0x10) << 3);
+            _phase = STATUS;
+        }
+        else if (b == I_RX_STATUS)
+        {
+            uint8_t f = _r[CANINTF] & 0x03;
+            uint8_t s = (uint8_t)(f << 6);
+            if (f)
+            {
+                uint8_t base = (f & RX0IF) ? RXB0CTRL : RXB1CTRL;
+                bool ext = (_r[base + 2] & 0x08) != 0;
+                bool rtr = ext ? (_r[base + 5] & 0x40) != 0 : (_r[base + 2] & 0x10) != 0;
+                s |= (ext ? 0x10 : 0) | (rtr ? 0x08 : 0);
+                if (base == RXB0CTRL)
+                    s |= _r[RXB0CTRL] & 0x01;
+                else
+                {
+                    uint8_t fh = _r[RXB1CTRL] & 0x07;
+                    s |= (fh <= 1) ? (uint8_t)(6 + fh) : fh; // 0/1 は RXB0 からのロールオーバー
+                }
+            }
+            _statusByte = s;
+            _phase = STATUS;
+        }
+        else if ((b & 0xF8) == 0x40 && (b & 0x07) <= 5) // LOAD TX BUFFER
+        {
+            uint8_t n = (b >> 1) & 0x03;
+            _addr = (uint8_t)(0x31 + 0x10 * n + ((b & 0x01) ? 5 : 0));
+            _phase = WRITING;
+        }
+        else if ((b & 0xF8) == 0x80) // RTS
+        {
+            for (uint8_t n = 0; n < 3; n++)
+                if (b & (1 << n))
+                    writeReg((uint8_t)(TXB0CTRL + 0x10 * n), _r[TXB0CTRL + 0x10 * n] | TXREQ);
+            _phase = DONE;
+        }
+        else if ((b & 0xF9) == 0x90) // READ RX BUFFER
+        {
+            uint8_t n = (b >> 2) & 0x01;
+            _addr = (uint8_t)((n ? 0x71 : 0x61) + ((b & 0x02) ? 5 : 0));
+            _clearOnDeselect |= n ? RX1IF : RX0IF;
+            _phase = READING;
+        }
+        else
+            _phase = DONE;
+        return 0xFF;
+
+    case ADDR:
+        _addr = b & 0x7F;
+        _phase = (_instr == I_READ) ? READING : WRITING;
+        return 0xFF;
+
+    case READING:
+    {
+        uint8_t a = _addr;
+        if ((a & 0x0F) == 0x0E)
+            a = CANSTAT;
+        else if ((a & 0x0F) == 0x0F)
+            a = CANCTRL;
+        _addr = (_addr + 1) & 0x7F;
+        return _r[a];
+    }
+
+    case WRITING:
+        writeReg(_addr, b);
+        _addr = (_addr + 1) & 0x7F;
+        return 0xFF;
+
+    case BM_ADDR:
+        _addr = b & 0x7F;
+        _phase = BM_MASK;
+        return 0xFF;
+
+    case BM_MASK:
+        _bmMask = bitModifiable(_addr) ? b : 0xFF;
+        _phase = BM_DATA;
+        return 0xFF;
+
+    case BM_DATA:
+    {
+        uint8_t a = ((_addr & 0x0F) == 0x0F) ? CANCTRL : _addr;
+        writeReg(_addr, (uint8_t)((_r[a] & ~_bmMask) | (b & _bmMask)));
+        _phase = DONE;
+        return 0xFF;
+    }
+
+    case STATUS:
+        return _statusByte;
+
+    default:
+        return 0xFF;
+    }
+}
+
+void Mcp2515Emu::writeReg(uint8_t a, uint8_t v)
+{
+    a &= 0x7F;
+    uint8_t lo = a & 0x0F;
+    if (lo == 0x0E || a == TEC || a == REC)
+        return; // 読み出し専用
+    if (lo == 0x0F)
+    {
+        uint8_t old = _r[CANCTRL];
+        _r[CANCTRL] = v;
+        uint8_t req = v & 0xE0;
+        if (req <= MODE_CONFIG)
+            _r[CANSTAT] = (uint8_t)((_r[CANSTAT] & 0x1F) | req); // モード切替は即時
+        if ((v & ABAT) && !(old & ABAT))
+        {
+            for (uint8_t n = 0; n < 3; n++)
+            {
+                uint8_t c = (uint8_t)(TXB0CTRL + 0x10 * n);
+                if ((_r[c] & TXREQ) && _txBuf != (int8_t)n)
+                    _r[c] = (uint8_t)((_r[c] & ~TXREQ) | ABTF);
+            }
+        }
+        if ((old & 0xE0) != req || ((old & ABAT) && !(v & ABAT)))
+            onTxReq();
+        return;
+    }
+    // フィルタ/マスク/CNF は設定モードのみ
+    bool cfgOnly = (a <= 0x0B) || (a >= 0x10 && a <= 0x1B) || (a >= 0x20 && a <= 0x2A);
+    if (cfgOnly && opMode() != MODE_CONFIG)
+        return;
+
+    if (a == TXB0CTRL || a == 0x40 || a == 0x50)
+    {
+        uint8_t old = _r[a];
+        uint8_t nv = (uint8_t)((old & (ABTF | MLOA | TXERR)) | (v & (TXREQ | 0x03)));
+        if ((nv & TXREQ) && !(old & TXREQ))
+            nv &= (uint8_t)~(ABTF | MLOA | TXERR);
+        _r[a] = nv;
+        if ((nv & TXREQ) && !(old & TXREQ))
+            onTxReq();
+        return;
+    }
+    if (a == EFLG)
+    {
+        // RXnOVR のクリアのみ可能
+        _r[EFLG] = (uint8_t)((_r[EFLG] & 0x3F) | (_r[EFLG] & v & 0xC0));
+        return;
+    }
+    if (a == RXB0CTRL)
+    {
+        uint8_t keep = _r[a] & 0x09;
+        _r[a] = (uint8_t)(keep | (v & (RXM_ANY | BUKT)) | ((v & BUKT) ? 0x02 : 0));
+        return;
+    }
+    if (a == RXB1CTRL)
+    {
+        _r[a] = (uint8_t)((_r[a] & 0x0F) | (v & RXM_ANY));
+        return;
+    }
+    _r[a] = v;
+}
+
+void Mcp2515Emu::onTxReq()
+{
+    uint8_t m = opMode();
+    if (m == MODE_LOOPBACK)
+    {
+        for (uint8_t n = 0; n < 3; n++)
+            if (_r[TXB0CTRL + 0x10 * n] & TXREQ)
+                loopback(n);
+    }
+    else if (m == MODE_NORMAL && _bus)
+        _bus->kick();
+}
+
+void Mcp2515Emu::errorFlags()
+{
+    uint8_t tec = _r[TEC];
+    uint8_t rec = _r[REC];
+    uint8_t e = _r[EFLG] & (RX0OVR | RX1OVR);
+    if (tec >= 96)
+        e |= 0x04;
+    if (rec >= 96)
+        e |= 0x02;
+    if (tec >= 96 || rec >= 96)
+        e |= 0x01;
+    if (tec >= 128)
+        e |= 0x10;
+    if (rec >= 128)
+        e |= 0x08;
+    if (_busOff)
+        e |= 0x20; // TXBO
+    _r[EFLG] = e;
+}
+
+// バスオフ: 128 x 11 recessive bit で自動復帰（バスが故障中は数えられない）
+void Mcp2515Emu::pollBusOff()
+{
+    if (!_busOff || ArduinoShim::nowNs() < _recoverAtNs)
+        return;
+    if (_bus && _bus->fault())
+    {
+        _recoverAtNs = ArduinoShim::nowNs() + 128ULL * 11ULL * _bus->bitNs();
+        return;
+    }
+    _busOff = false;
+    _r[TEC] = 0;
+    _r[REC] = 0;
+    errorFlags();
+    if (_bus)
+        _bus->kick();
+}
+
+void Mcp2515Emu::frameFromTxb(const uint8_t *r, uint8_t base, ShimCanFrame &f)
+{
+    f.id = decodeId(&r[base], f.ext);
+    f.dlc = r[base + 4] & 0x0F;
+    f.rtr = (r[base + 4] & 0x40) != 0;
+    uint8_t n = f.dlc > 8 ? 8 : f.dlc;
+    memset(f.data, 0, sizeof(f.data));
+    memcpy(f.data, &r[base + 5], n);
+}
+
+// ===== CAN ノード =====
+bool Mcp2515Emu::txPeek(ShimCanFrame &f)
+{
+    _peekBuf = -1;
+    pollBusOff();
+    if (opMode() != MODE_NORMAL || (_r[CANCTRL] & ABAT) || _busOff)
+        return false;
+    int best = -1;
+    uint8_t bestP = 0;
+    for (uint8_t n = 0; n < 3; n++)
+    {
+        uint8_t c = _r[TXB0CTRL + 0x10 * n];
+        if (!(c & TXREQ))
+            continue;
+        // 同優先度なら番号の大きいバッファが先
+        if (best < 0 || (c & 0x03) >= bestP)
+        {
+            best = n;
+            bestP = c & 0x03;
+        }
+    }
+    if (best < 0)
+        return false;
+    _peekBuf = (int8_t)best;
+    frameFromTxb(_r, (uint8_t)(TXB0CTRL + 0x10 * best + 1), f);
+    return true;
+}
+
+void Mcp2515Emu::txStart() { _txBuf = _peekBuf; }
+
+void Mcp2515Emu::arbLost()
+{
+    if (_peekBuf >= 0)
+        _r[TXB0CTRL + 0x10 * _peekBuf] |= MLOA;
+}
+
+void Mcp2515Emu::txDone(bool ok)
+{
+    int8_t n = _txBuf;
+    _txBuf = -1;
+    if (n < 0)
+        return;
+    uint8_t c = (uint8_t)(TXB0CTRL + 0x10 * n);
+    if (ok)
+    {
+        _r[c] &= (uint8_t)~(TXREQ | TXERR | MLOA);
+        _r[CANINTF] |= (uint8_t)(0x04 << n);
+        if (_r[TEC] > 0)
+            _r[TEC]--;
+        _stats.txFrames++;
+    }
+    else
+    {
+        // ACK エラー: エラーパッシブ到達後は TEC を増やさない（単独ノードはバスオフにならない）
+        _r[c] |= TXERR;
+        _r[CANINTF] |= MERRF;
+        if (_r[TEC] < 128)
+            _r[TEC] = (uint8_t)(_r[TEC] + 8);
+        if (_r[CANCTRL] & (OSM | ABAT)) // 送信中に ABAT → 失敗した時点で取り消し
+            _r[c] = (uint8_t)((_r[c] & ~TXREQ) | ABTF);
+    }
+    errorFlags();
+}
+
+void Mcp2515Emu::txError()
+{
+    int8_t n = _txBuf;
+    _txBuf = -1;
+    if (n < 0)
+        return;
+    uint8_t c = (uint8_t)(TXB0CTRL + 0x10 * n);
+    _r[c] |= TXERR;
+    _r[CANINTF] |= MERRF;
+    if (_r[TEC] > 255 - 8)
+    {
+        _busOff = true;
+        _r[TEC] = 255;
+        _recoverAtNs = ArduinoShim::nowNs() + 128ULL * 11ULL * (_bus ? _bus->bitNs() : 1000);
+    }
+    else
+        _r[TEC] = (uint8_t)(_r[TEC] + 8);
+    if (_r[CANCTRL] & (OSM | ABAT))
+        _r[c] = (uint8_t)((_r[c] & ~TXREQ) | ABTF);
+    errorFlags();
+}
+
+void Mcp2515Emu::rxError()
+{
+    if (opMode() != MODE_NORMAL || _busOff)
+        return;
+    if (_r[REC] < 128)
+        _r[REC]++;
+    errorFlags();
+}
+
+bool Mcp2515Emu::acks() { return opMode() == MODE_NORMAL && !_busOff; }
+
+void Mcp2515Emu::rx(const ShimCanFrame &f, uint64_t tNs)
+{
+    (void)tNs;
+    uint8_t m = opMode();
+    if (m != MODE_NORMAL && m != MODE_LISTEN)
+        return;
+    if (_busOff)
+        return;
+    if (_r[REC] > 0)
+    {
+        _r[REC]--;
+        errorFlags();
+    }
+    deliver(f);
+}
+
+bool Mcp2515Emu::filterMatch(const ShimCanFrame &f, uint8_t maskAddr, uint8_t filtAddr) const
+{
+    bool fext;
+    uint32_t filt = decodeId(&_r[filtAddr], fext);
+    if (fext != f.ext)
+        return false;
+    bool dummy;
+    uint8_t mreg[4] = {_r[maskAddr], (uint8_t)(_r[maskAddr + 1] | 0x08), _r[maskAddr + 2], _r[maskAddr + 3]};
+    uint32_t mask = decodeId(mreg, dummy);
+    if (!f.ext)
+    {
+        mask >>= 18;
+        filt &= 0x7FF;
+        return ((f.id ^ filt) & mask & 0x7FF) == 0;
+    }
+    return ((f.id ^ filt) & mask & 0x1FFFFFFF) == 0;
+}
+
+bool Mcp2515Emu::accept(uint8_t rxb, const ShimCanFrame &f, uint8_t &filhit) const
+{
+    uint8_t ctrl = rxb ? _r[RXB1CTRL] : _r[RXB0CTRL];
+    filhit = rxb ? 2 : 0;
+    if ((ctrl & RXM_ANY) == RXM_ANY)
+        return true;
+    if (rxb == 0)
+    {
+        static const uint8_t filt0[2] = {0x00, 0x04};
+        for (uint8_t i = 0; i < 2; i++)
+            if (filterMatch(f, 0x20, filt0[i]))
+            {
+                filhit = i;
+                return true;
+            }
+        return false;
+    }
+    static const uint8_t filt1[4] = {0x08, 0x10, 0x14, 0x18};
+    for (uint8_t i = 0; i < 4; i++)
+        if (filterMatch(f, 0x24, filt1[i]))
+        {
+            filhit = (uint8_t)(2 + i);
+            return true;
+        }
+    return false;
+}
+
+void Mcp2515Emu::deliver(const ShimCanFrame &f)
+{
+    uint8_t fh;
+    if (accept(0, f, fh))
+    {
+        if (!(_r[CANINTF] & RX0IF))
+            store(0, f, fh, false);
+        else if (_r[RXB0CTRL] & BUKT)
+        {
+            if (!(_r[CANINTF] & RX1IF))
+                store(1, f, fh, true);
+            else
+            {
+                _r[EFLG] |= RX1OVR;
+                _r[CANINTF] |= ERRIF;
+                _stats.rxOverflow++;
+            }
+        }
+        else
+        {
+            _r[EFLG] |= RX0OVR;
+            _r[CANINTF] |= ERRIF;
+            _stats.rxOverflow++;
+        }
+        return;
+    }
+    if (accept(1, f, fh))
+    {
+        if (!(_r[CANINTF] & RX1IF))
+            store(1, f, fh, false);
+        else
+        {
+            _r[EFLG] |= RX1OVR;
+            _r[CANINTF] |= ERRIF;
+            _stats.rxOverflow++;
+        }
+        return;
+    }
+    _stats.rxFiltered++;
+}
+
+void Mcp2515Emu::store(uint8_t rxb, const ShimCanFrame &f, uint8_t filhit, bool rollover)
+{
+    uint8_t base = rxb ? RXB1CTRL : RXB0CTRL;
+    uint8_t *p = &_r[base + 1];
+    if (f.ext)
+    {
+        uint32_t sid = (f.id >> 18) & 0x7FF;
+        p[0] = (uint8_t)(sid >> 3);
+        p[1] = (uint8_t)(((sid & 0x07) << 5) | 0x08 | ((f.id >> 16) & 0x03));
+        p[2] = (uint8_t)(f.id >> 8);
+        p[3] = (uint8_t)f.id;
+    }
+    else
+    {
+        p[0] = (uint8_t)((f.id >> 3) & 0xFF);
+        p[1] = (uint8_t)(((f.id & 0x07) << 5) | (f.rtr ? 0x10 : 0));
+        p[2] = 0;
+        p[3] = 0;
+    }
+    // DLC は受信値そのまま（9〜15 もあり得る）
+    p[4] = (uint8_t)((f.dlc & 0x0F) | ((f.ext && f.rtr) ? 0x40 : 0));
+    memcpy(&p[5], f.data, 8);
+
+    uint8_t rtr = f.rtr ? 0x08 : 0;
+    if (rxb == 0)
+        _r[base] = (uint8_t)((_r[base] & (RXM_ANY | BUKT | 0x02)) | rtr | (filhit & 0x01));
+    else
+        _r[base] = (uint8_t)((_r[base] & RXM_ANY) | rtr | (rollover ? (filhit & 0x01) : (filhit & 0x07)));
+    _r[CANINTF] |= rxb ? RX1IF : RX0IF;
+    _stats.rxFrames++;
+}
+
+void Mcp2515Emu::loopback(uint8_t n)
+{
+    uint8_t c = (uint8_t)(TXB0CTRL + 0x10 * n);
+    ShimCanFrame f;
+    frameFromTxb(_r, (uint8_t)(c + 1), f);
+    _r[c] &= (uint8_t)~TXREQ;
+    _r[CANINTF] |= (uint8_t)(0x04 << n);
+    _stats.txFrames++;
+    deliver(f);
+}
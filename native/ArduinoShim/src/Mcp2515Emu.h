@@ -0,0 +1,91 @@
+#pragma once
+// Mcp2515Emu.h — MCP2515 のレジスタ/SPI 命令エミュレータ（native 用）
+// SPI.attach(csPin, &emu) で MCP_CAN から実チップと同じ手順で操作できる。
+// 対応: RESET / READ / WRITE / BIT MODIFY / READ STATUS / RX STATUS / LOAD TX / RTS / READ RX,
+//       モード切替（即時）, TXB0-2 の TXP 優先度, ABAT, OSM, マスク/フィルタ, BUKT,
+//       RX0OVR/RX1OVR, ACK エラー時の TEC と EFLG, ループバック,
+//       エラーフレーム（VirtualCanBus の故障注入）で TEC > 255 → バスオフ（TXBO）と 128x11bit 後の自動復帰
+
+#include <stdint.h>
+#include "SPI.h"
+#include "VirtualCanBus.h"
+
+struct Mcp2515EmuStats
+{
+    uint32_t txFrames = 0;
+    uint32_t rxFrames = 0;
+    uint32_t rxOverflow = 0;
+    uint32_t rxFiltered = 0;
+    uint32_t spiInstr = 0;
+};
+
+class Mcp2515Emu : public ShimSpiDevice, public VirtualCanNode
+{
+public:
+    explicit Mcp2515Emu(VirtualCanBus *bus = nullptr);
+    ~Mcp2515Emu();
+
+    void connect(VirtualCanBus *bus);
+    void reset();
+
+    uint8_t reg(uint8_t addr) const { return _r[addr & 0x7F]; }
+    const Mcp2515EmuStats &stats() const { return _stats; }
+
+    // ShimSpiDevice
+    void select() override;
+    void deselect() override;
+    uint8_t transfer(uint8_t mosi) override;
+
+    // VirtualCanNode
+    bool txPeek(ShimCanFrame &f) override;
+    void txStart() override;
+    void txDone(bool ok) override;
+    void arbLost() override;
+    void txError() override;
+    void rxError() override;
+    void rx(const ShimCanFrame &f, uint64_t tNs) override;
+    bool acks() override;
+
+    bool busOff() const { return _busOff; }
+
+private:
+    enum Phase : uint8_t
+    {
+        IDLE,
+        INSTR,
+        ADDR,
+        READING,
+        WRITING,
+        BM_ADDR,
+        BM_MASK,
+        BM_DATA,
+        STATUS,
+        DONE
+    };
+
+    uint8_t _r[128];
+    VirtualCanBus *_bus = nullptr;
+    Phase _phase = IDLE;
+    uint8_t _instr = 0;
+    uint8_t _addr = 0;
+    uint8_t _bmMask = 0;
+    uint8_t _statusByte = 0;
+    uint8_t _clearOnDeselect = 0; // READ RX 後に落とす CANINTF ビット
+    int8_t _peekBuf = -1;
+    int8_t _txBuf = -1;
+    bool _busOff = false;
+    uint64_t _recoverAtNs = 0;
+    Mcp2515EmuStats _stats;
+
+    uint8_t opMode() const { return _r[0x0E] & 0xE0; }
+    void writeReg(uint8_t addr, uint8_t value);
+    void onTxReq();
+    void errorFlags();
+    void pollBusOff();
+    bool filterMatch(const ShimCanFrame &f, uint8_t maskAddr, uint8_t filtAddr) const;
+    bool accept(uint8_t rxb, const ShimCanFrame &f, uint8_t &filhit) const;
+    void store(uint8_t rxb, const ShimCanFrame &f, uint8_t filhit, bool rollover);
+    void deliver(const ShimCanFrame &f);
+    void loopback(uint8_t txb);
+    static void frameFromTxb(const uint8_t *r, uint8_t base, ShimCanFrame &f);
+};
@@ -0,0 +1,64 @@
+// SPI.cpp — native 用 SPI（接続デバイスへのバイト転送 + 仮想時間の消費）
+#include "SPI.h"
+#include "Arduino.h"
+
+SPIClass SPI;
+
+void SPIClass::beginTransaction(const SPISettings &s)
+{
+    _clock = s.clock ? s.clock : 1000000;
+    _stats.transactions++;
+    _stats.busyNs += _overheadNs;
+    ArduinoShim::advanceNs(_overheadNs);
+}
+
+uint8_t SPIClass::transfer(uint8_t data)
+{
+    uint8_t r = 0xFF;
+    {
+        ShimLock lk;
+        if (_active)
+            r = _active->transfer(data);
+    }
+    uint64_t ns = 8000000000ULL / _clock;
+    _stats.bytes++;
+    _stats.busyNs += ns;
+    ArduinoShim::advanceNs(ns);
+    return r;
+}
+
+void SPIClass::transfer(void *buf, size_t n)
+{
+    uint8_t *p = (uint8_t *)buf;
+    for (size_t i = 0; i < n; i++)
+        p[i] = transfer(p[i]);
+}
+
+bool SPIClass::attach(uint8_t csPin, ShimSpiDevice *dev)
+{
+    if (_nSlots >= 8)
+        return false;
+    Slot &s = _slots[_nSlots++];
+    s.spi = this;
+    s.pin = csPin;
+    s.dev = dev;
+    ArduinoShim::setPinListener(csPin, &SPIClass::onCs, &s);
+    return true;
+}
+
+void SPIClass::onCs(uint8_t pin, uint8_t value, void *ctx)
+{
+    (void)pin;
+    Slot *s = (Slot *)ctx;
+    ShimLock lk;
+    if (value == LOW)
+    {
+        s->spi->_active = s->dev;
+        s->dev->select();
+    }
+    else if (s->spi->_active == s->dev)
+    {
+        s->dev->deselect();
+        s->spi->_active = nullptr;
+    }
+}
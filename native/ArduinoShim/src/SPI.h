@@ -0,0 +1,84 @@
+#pragma once
+// SPI.h — native 用 SPI。CS ピンに ShimSpiDevice（MCP2515 エミュレータ等）を接続する
+// 転送は仮想時間を消費する（1byte = 8/clock 秒 + トランザクション毎のオーバーヘッド）
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef MSBFIRST
+#define LSBFIRST 0
+#define MSBFIRST 1
+#endif
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x01
+#define SPI_MODE2 0x02
+#define SPI_MODE3 0x03
+
+class ShimSpiDevice
+{
+public:
+    virtual ~ShimSpiDevice() {}
+    virtual void select() = 0;   // CS=LOW
+    virtual void deselect() = 0; // CS=HIGH
+    virtual uint8_t transfer(uint8_t mosi) = 0;
+};
+
+class SPISettings
+{
+public:
+    SPISettings(uint32_t clock = 1000000, uint8_t bitOrder = MSBFIRST, uint8_t dataMode = SPI_MODE0)
+        : clock(clock), bitOrder(bitOrder), dataMode(dataMode) {}
+    uint32_t clock;
+    uint8_t bitOrder;
+    uint8_t dataMode;
+};
+
+struct ShimSpiStats
+{
+    uint32_t transactions = 0;
+    uint32_t bytes = 0;
+    uint64_t busyNs = 0;
+};
+
+class SPIClass
+{
+public:
+    void begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1)
+    {
+        (void)sck;
+        (void)miso;
+        (void)mosi;
+        (void)ss;
+    }
+    void end() {}
+    void beginTransaction(const SPISettings &s);
+    void endTransaction() {}
+    void setFrequency(uint32_t hz) { _clock = hz; }
+
+    uint8_t transfer(uint8_t data);
+    void transfer(void *buf, size_t n);
+
+    // native 専用: CS ピンへデバイスを接続（最大 8）
+    bool attach(uint8_t csPin, ShimSpiDevice *dev);
+    void setTransactionOverheadNs(uint32_t ns) { _overheadNs = ns; }
+    const ShimSpiStats &stats() const { return _stats; }
+    void resetStats() { _stats = ShimSpiStats(); }
+
+private:
+    struct Slot
+    {
+        SPIClass *spi;
+        uint8_t pin;
+        ShimSpiDevice *dev;
+    };
+    Slot _slots[8] = {};
+    uint8_t _nSlots = 0;
+    ShimSpiDevice *_active = nullptr;
+    uint32_t _clock = 1000000;
+    uint32_t _overheadNs = 1500;
+    ShimSpiStats _stats;
+
+    static void onCs(uint8_t pin, uint8_t value, void *ctx);
+};
+
+extern SPIClass SPI;
@@ -0,0 +1,245 @@
+// VirtualCanBus.cpp — 仮想 CAN バス
+#include "VirtualCanBus.h"
+
+namespace
+{
+    // 調停フィールドを比較用の整数に（小さいほど優先）
+    // 標準: ID11 | RTR | IDE=0,  拡張: ID上位11 | SRR=1 | IDE=1 | ID下位18 | RTR
+    uint64_t arbKey(const ShimCanFrame &f)
+    {
+        if (f.ext)
+        {
+            uint64_t base = (f.id >> 18) & 0x7FF;
+            uint64_t low = f.id & 0x3FFFF;
+            return (base << 21) | (1ULL << 20) | (1ULL << 19) | (low << 1) | (f.rtr ? 1 : 0);
+        }
+        uint64_t base = f.id & 0x7FF;
+        return (base << 21) | ((f.rtr ? 1ULL : 0ULL) << 20);
+    }
+
+    struct BitWriter
+    {
+        uint8_t bits[160];
+        uint32_t n = 0;
+        void put(uint32_t v, uint8_t width)
+        {
+            for (int i = width - 1; i >= 0; i--)
+                bits[n++] = (v >> i) & 1;
+        }
+    };
+}
+
+VirtualCanBus::VirtualCanBus(uint32_t bitrate) : _bitrate(bitrate ? bitrate : 1000000)
+{
+    _bitNs = 1000000000ULL / _bitrate;
+    ArduinoShim::addTimeSource(this);
+}
+
+VirtualCanBus::~VirtualCanBus() { ArduinoShim::removeTimeSource(this); }
+
+bool VirtualCanBus::attach(VirtualCanNode *node)
+{
+    ShimLock lk;
+    if (_nNodes >= MAX_NODES)
+        return false;
+    _nodes[_nNodes++] = node;
+    return true;
+}
+
+void VirtualCanBus::detach(VirtualCanNode *node)
+{
+    ShimLock lk;
+    for (uint8_t i = 0; i < _nNodes; i++)
+    {
+        if (_nodes[i] != node)
+            continue;
+        for (uint8_t j = i + 1; j < _nNodes; j++)
+            _nodes[j - 1] = _nodes[j];
+        _nNodes--;
+        if (_txNode == node)
+            _txNode = nullptr;
+        return;
+    }
+}
+
+void VirtualCanBus::kick()
+{
+    ShimLock lk;
+    if (_busy || _arbPending)
+        return;
+    uint64_t now = ArduinoShim::nowNs();
+    _arbPending = true;
+    _arbNs = now > _idleFromNs ? now : _idleFromNs;
+}
+
+void VirtualCanBus::injectErrors(uint32_t n)
+{
+    ShimLock lk;
+    _errorsLeft = n;
+}
+
+void VirtualCanBus::setFault(bool on)
+{
+    ShimLock lk;
+    _fault = on;
+}
+
+uint32_t VirtualCanBus::frameBits(const ShimCanFrame &f)
+{
+    uint8_t dlc = f.dlc > 8 ? 8 : f.dlc;
+    uint8_t nData = f.rtr ? 0 : dlc;
+    BitWriter w;
+    w.put(0, 1); // SOF
+    if (f.ext)
+    {
+        w.put((f.id >> 18) & 0x7FF, 11);
+        w.put(1, 1); // SRR
+        w.put(1, 1); // IDE
+        w.put(f.id & 0x3FFFF, 18);
+        w.put(f.rtr ? 1 : 0, 1);
+        w.put(0, 2); // r1 r0
+    }
+    else
+    {
+        w.put(f.id & 0x7FF, 11);
+        w.put(f.rtr ? 1 : 0, 1);
+        w.put(0, 2); // IDE r0
+    }
+    w.put(f.dlc & 0x0F, 4);
+    for (uint8_t i = 0; i < nData; i++)
+        w.put(f.data[i], 8);
+
+    uint16_t crc = 0;
+    for (uint32_t i = 0; i < w.n; i++)
+    {
+        uint16_t nxt = (uint16_t)(w.bits[i] ^ ((crc >> 14) & 1));
+        crc = (uint16_t)((crc << 1) & 0x7FFF);
+        if (nxt)
+            crc ^= 0x4599;
+    }
+    w.put(crc, 15);
+
+    // SOF〜CRC にスタッフビット（同値5連続の後に反転1bit）
+    uint32_t stuff = 0;
+    uint8_t last = 2;
+    uint8_t run = 0;
+    for (uint32_t i = 0; i < w.n; i++)
+    {
+        uint8_t b = w.bits[i];
+        if (b == last)
+            run++;
+        else
+        {
+            last = b;
+            run = 1;
+        }
+        if (run == 5)
+        {
+            stuff++;
+            last = b ^ 1;
+            run = 1;
+        }
+    }
+    // CRC delimiter + ACK slot + ACK delimiter + EOF7
+    return w.n + stuff + 1 + 2 + 7;
+}
+
+uint64_t VirtualCanBus::nextEventNs()
+{
+    if (_busy)
+        return _endNs;
+    if (_arbPending)
+        return _arbNs;
+    return ArduinoShim::NEVER;
+}
+
+void VirtualCanBus::runUntil(uint64_t nowNs)
+{
+    if (_busy && _endNs <= nowNs)
+        complete(_endNs);
+    else if (!_busy && _arbPending && _arbNs <= nowNs)
+        arbitrate(_arbNs);
+}
+
+void VirtualCanBus::arbitrate(uint64_t t)
+{
+    _arbPending = false;
+    VirtualCanNode *win = nullptr;
+    ShimCanFrame best;
+    uint64_t bestKey = 0;
+    bool contenders[MAX_NODES] = {};
+    for (uint8_t i = 0; i < _nNodes; i++)
+    {
+        ShimCanFrame f;
+        if (!_nodes[i]->txPeek(f))
+            continue;
+        contenders[i] = true;
+        uint64_t k = arbKey(f);
+        if (!win || k < bestKey)
+        {
+            win = _nodes[i];
+            best = f;
+            bestKey = k;
+        }
+    }
+    if (!win)
+        return; // アイドル
+
+    for (uint8_t i = 0; i < _nNodes; i++)
+        if (contenders[i] && _nodes[i] != win)
+            _nodes[i]->arbLost();
+    win->txStart();
+    _txNode = win;
+    _cur = best;
+    uint32_t bits = frameBits(best);
+    _busy = true;
+    _endNs = t + bits * _bitNs;
+    _stats.bits += bits;
+    _stats.busyNs += bits * _bitNs;
+}
+
+void VirtualCanBus::complete(uint64_t t)
+{
+    _busy = false;
+    VirtualCanNode *tx = _txNode;
+    _txNode = nullptr;
+
+    if (_fault || _errorsLeft)
+    {
+        // エラーフレーム: 誰も受信せず、送信側は再送（エラーフラグ 6 + デリミタ 8 + IFS 3）
+        if (!_fault)
+            _errorsLeft--;
+        _stats.errorFrames++;
+        for (uint8_t i = 0; i < _nNodes; i++)
+            if (_nodes[i] != tx)
+                _nodes[i]->rxError();
+        if (tx)
+            tx->txError();
+        _idleFromNs = t + 17 * _bitNs;
+        _arbPending = true;
+        _arbNs = _idleFromNs;
+        return;
+    }
+
+    bool acked = false;
+    for (uint8_t i = 0; i < _nNodes; i++)
+        if (_nodes[i] != tx && _nodes[i]->acks())
+            acked = true;
+
+    if (acked)
+    {
+        _stats.frames++;
+        for (uint8_t i = 0; i < _nNodes; i++)
+            if (_nodes[i] != tx)
+                _nodes[i]->rx(_cur, t);
+    }
+    else
+        _stats.ackErrors++; // ACK エラー: エラーフレーム後に再調停
+    if (tx)
+        tx->txDone(acked);
+
+    // IFS 3bit（ACK エラー時はエラーフレーム 14bit + IFS）
+    _idleFromNs = t + (acked ? 3 : 17) * _bitNs;
+    _arbPending = true;
+    _arbNs = _idleFromNs;
+}
@@ -0,0 +1,98 @@
+#pragma once
+// VirtualCanBus.h — 仮想 CAN バス（ビット時間ベース, native 用）
+// ・フレーム長はスタッフビット/CRC15 込みで正確に計算（bitrate 既定 1Mbps）
+// ・送信待ちノードの中から ID 最小（調停順）のフレームを送る
+// ・送信元以外に ACK を返すノードがなければ ACK エラー（送信ノードが再送を判断）
+// ・故障注入: injectErrors(n) で次の n フレーム、setFault(true) で解除までの全フレームをエラーフレームにする
+// ShimTimeSource としてスケジューラに登録され、時刻が進むたびに駆動される。
+
+#include <stdint.h>
+#include "ArduinoShim.h"
+
+struct ShimCanFrame
+{
+    uint32_t id = 0;
+    bool ext = false;
+    bool rtr = false;
+    uint8_t dlc = 0;
+    uint8_t data[8] = {0};
+};
+
+class VirtualCanNode
+{
+public:
+    virtual ~VirtualCanNode() {}
+    // 送信待ちの最優先フレーム（なければ false）
+    virtual bool txPeek(ShimCanFrame &f) = 0;
+    // 調停に勝った（直前に peek したフレームを送信開始）
+    virtual void txStart() {}
+    // 送信完了（ok=ACKあり）
+    virtual void txDone(bool ok) = 0;
+    virtual void arbLost() {}
+    // エラーフレームで終わった（故障注入）。ACK エラーと違い送信側はエラーパッシブ中も TEC を数える
+    virtual void txError() { txDone(false); }
+    virtual void rxError() {}
+    // 受信（EOF 時刻）
+    virtual void rx(const ShimCanFrame &f, uint64_t tNs) = 0;
+    // 正常受信時に ACK を返すか（listen-only / 停止中は false）
+    virtual bool acks() { return true; }
+};
+
+struct VirtualCanStats
+{
+    uint32_t frames = 0;
+    uint32_t ackErrors = 0;
+    uint32_t errorFrames = 0; // 故障注入
+    uint64_t bits = 0;   // 送信ビット（スタッフ込み, IFS 除く）
+    uint64_t busyNs = 0; // バス占有時間
+};
+
+class VirtualCanBus : public ShimTimeSource
+{
+public:
+    static constexpr uint8_t MAX_NODES = 64;
+
+    explicit VirtualCanBus(uint32_t bitrate = 1000000);
+    ~VirtualCanBus();
+
+    bool attach(VirtualCanNode *node);
+    void detach(VirtualCanNode *node);
+    // ノードに新しい送信要求が入ったら呼ぶ
+    void kick();
+
+    uint32_t bitrate() const { return _bitrate; }
+    uint64_t bitNs() const { return _bitNs; }
+    const VirtualCanStats &stats() const { return _stats; }
+    void resetStats() { _stats = VirtualCanStats(); }
+
+    // 故障注入
+    void injectErrors(uint32_t n);
+    void setFault(bool on);
+    bool fault() const { return _fault; }
+
+    // SOF〜EOF のビット数（スタッフビット込み, IFS 3bit は含まない）
+    static uint32_t frameBits(const ShimCanFrame &f);
+
+    uint64_t nextEventNs() override;
+    void runUntil(uint64_t nowNs) override;
+
+private:
+    uint32_t _bitrate;
+    uint64_t _bitNs;
+    VirtualCanNode *_nodes[MAX_NODES] = {};
+    uint8_t _nNodes = 0;
+
+    bool _busy = false;
+    bool _arbPending = false;
+    uint64_t _arbNs = 0;
+    uint64_t _endNs = 0;
+    uint64_t _idleFromNs = 0;
+    VirtualCanNode *_txNode = nullptr;
+    ShimCanFrame _cur;
+    VirtualCanStats _stats;
+    uint32_t _errorsLeft = 0;
+    bool _fault = false;
+
+    void arbitrate(uint64_t t);
+    void complete(uint64_t t);
+};
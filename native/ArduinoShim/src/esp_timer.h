@@ -0,0 +1,6 @@
+#pragma once
+// esp_timer.h — esp_timer_get_time()（起動からの µs, native 用）
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time();
@@ -0,0 +1,19 @@
+#pragma once
+// freertos/task.h — タスクは std::thread（仮想時間では協調実行）
+
+#include "FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *arg,
+                       UBaseType_t prio, TaskHandle_t *outHandle);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *arg,
+                                   UBaseType_t prio, TaskHandle_t *outHandle, BaseType_t core);
+void vTaskDelete(TaskHandle_t task); // native は自タスク（NULL/自ハンドル）のみ対応
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t *prevWake, TickType_t period);
+TickType_t xTaskGetTickCount();
+TaskHandle_t xTaskGetCurrentTaskHandle();
+#define taskYIELD() ArduinoShim_yield()
+void ArduinoShim_yield();
@@ -0,0 +1,279 @@
+// freertos_shim.cpp — タスク / セマフォ / キュー（native 用）
+// 待ちはすべてポーリング（仮想時間では待つ間に他タスクが走る）
+#include "Arduino.h"
+
+#include <mutex>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    std::mutex g_objMu;
+    constexpr uint64_t WAIT_STEP_NS = 20000; // ポーリング間隔 20us
+
+    // ticks(ms) 待ちの締切。portMAX_DELAY は無期限
+    uint64_t deadlineOf(TickType_t ticks)
+    {
+        if (ticks == portMAX_DELAY)
+            return ArduinoShim::NEVER;
+        return ArduinoShim::nowNs() + (uint64_t)ticks * 1000000ULL;
+    }
+    // 次のポーリングまで待つ。締切を過ぎていれば false
+    bool waitStep(uint64_t deadline)
+    {
+        uint64_t now = ArduinoShim::nowNs();
+        if (now >= deadline)
+            return false;
+        uint64_t next = now + WAIT_STEP_NS;
+        ArduinoShim::sleepUntilNs(next < deadline ? next : deadline);
+        return true;
+    }
+}
+
+struct ShimSemaphore
+{
+    enum Kind : uint8_t
+    {
+        MUTEX,
+        RECURSIVE,
+        COUNTING
+    } kind;
+    UBaseType_t count;
+    UBaseType_t maxCount;
+    std::thread::id owner;
+    UBaseType_t depth;
+};
+
+struct ShimQueue
+{
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    UBaseType_t head;
+    UBaseType_t count;
+    std::vector<uint8_t> buf;
+};
+
+// ===== tasks =====
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *arg,
+                       UBaseType_t prio, TaskHandle_t *outHandle)
+{
+    (void)stackDepth;
+    (void)prio;
+    void *h = ArduinoShim::spawnTask(fn, arg, name);
+    if (outHandle)
+        *outHandle = h;
+    return h ? pdPASS : pdFAIL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *arg,
+                                   UBaseType_t prio, TaskHandle_t *outHandle, BaseType_t core)
+{
+    (void)core;
+    return xTaskCreate(fn, name, stackDepth, arg, prio, outHandle);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == nullptr)
+        ArduinoShim::exitTask();
+    // 他タスクの削除は未対応（各タスクは停止フラグで自ら抜ける前提）
+    fprintf(stderr, "[shim] vTaskDelete(other) is not supported\n");
+}
+
+void vTaskDelay(TickType_t ticks) { delay(ticks); }
+
+void vTaskDelayUntil(TickType_t *prevWake, TickType_t period)
+{
+    *prevWake += period;
+    ArduinoShim::sleepUntilNs((uint64_t)(*prevWake) * 1000000ULL);
+}
+
+TickType_t xTaskGetTickCount() { return (TickType_t)(ArduinoShim::nowNs() / 1000000ULL); }
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    static thread_local int tag;
+    return &tag;
+}
+
+// ===== semaphores =====
+static SemaphoreHandle_t newSem(ShimSemaphore::Kind kind, UBaseType_t maxCount, UBaseType_t initial)
+{
+    ShimSemaphore *s = new ShimSemaphore();
+    s->kind = kind;
+    s->count = initial;
+    s->maxCount = maxCount;
+    s->depth = 0;
+    return s;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex() { return newSem(ShimSemaphore::MUTEX, 1, 1); }
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() { return newSem(ShimSemaphore::RECURSIVE, 1, 1); }
+SemaphoreHandle_t xSemaphoreCreateBinary() { return newSem(ShimSemaphore::COUNTING, 1, 0); }
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t maxCount, UBaseType_t initial)
+{
+    return newSem(ShimSemaphore::COUNTING, maxCount, initial);
+}
+void vSemaphoreDelete(SemaphoreHandle_t s) { delete s; }
+
+static bool tryTake(ShimSemaphore *s)
+{
+    std::lock_guard<std::mutex> lk(g_objMu);
+    std::thread::id me = std::this_thread::get_id();
+    if (s->kind == ShimSemaphore::RECURSIVE && s->depth > 0 && s->owner == me)
+    {
+        s->depth++;
+        return true;
+    }
+    if (s->count == 0)
+        return false;
+    s->count--;
+    if (s->kind != ShimSemaphore::COUNTING)
+    {
+        s->owner = me;
+        s->depth = 1;
+    }
+    return true;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks)
+{
+    if (!s)
+        return pdFALSE;
+    uint64_t deadline = deadlineOf(ticks);
+    while (!tryTake(s))
+    {
+        if (!waitStep(deadline))
+            return pdFALSE;
+    }
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s)
+{
+    if (!s)
+        return pdFALSE;
+    std::lock_guard<std::mutex> lk(g_objMu);
+    if (s->kind == ShimSemaphore::RECURSIVE && s->depth > 1)
+    {
+        s->depth--;
+        return pdTRUE;
+    }
+    if (s->count >= s->maxCount)
+        return pdFALSE;
+    s->count++;
+    s->depth = 0;
+    s->owner = std::thread::id();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t s, TickType_t ticks) { return xSemaphoreTake(s, ticks); }
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t s) { return xSemaphoreGive(s); }
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t s, BaseType_t *woken)
+{
+    if (woken)
+        *woken = pdFALSE;
+    return xSemaphoreGive(s);
+}
+
+// ===== queues =====
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    if (length == 0 || itemSize == 0)
+        return nullptr;
+    ShimQueue *q = new ShimQueue();
+    q->length = length;
+    q->itemSize = itemSize;
+    q->head = 0;
+    q->count = 0;
+    q->buf.resize((size_t)length * itemSize);
+    return q;
+}
+void vQueueDelete(QueueHandle_t q) { delete q; }
+
+static bool tryPush(ShimQueue *q, const void *item, bool front)
+{
+    std::lock_guard<std::mutex> lk(g_objMu);
+    if (q->count >= q->length)
+        return false;
+    UBaseType_t slot;
+    if (front)
+    {
+        q->head = (q->head + q->length - 1) % q->length;
+        slot = q->head;
+    }
+    else
+        slot = (q->head + q->count) % q->length;
+    memcpy(&q->buf[(size_t)slot * q->itemSize], item, q->itemSize);
+    q->count++;
+    return true;
+}
+
+static bool tryPop(ShimQueue *q, void *out)
+{
+    std::lock_guard<std::mutex> lk(g_objMu);
+    if (q->count == 0)
+        return false;
+    memcpy(out, &q->buf[(size_t)q->head * q->itemSize], q->itemSize);
+    q->head = (q->head + 1) % q->length;
+    q->count--;
+    return true;
+}
+
+static BaseType_t pushWait(QueueHandle_t q, const void *item, TickType_t ticks, bool front)
+{
+    if (!q)
+        return pdFAIL;
+    uint64_t deadline = deadlineOf(ticks);
+    while (!tryPush(q, item, front))
+    {
+        if (!waitStep(deadline))
+            return errQUEUE_FULL;
+    }
+    return pdPASS;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks) { return pushWait(q, item, ticks, false); }
+BaseType_t xQueueSendToFront(QueueHandle_t q, const void *item, TickType_t ticks) { return pushWait(q, item, ticks, true); }
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *out, TickType_t ticks)
+{
+    if (!q)
+        return pdFAIL;
+    uint64_t deadline = deadlineOf(ticks);
+    while (!tryPop(q, out))
+    {
+        if (!waitStep(deadline))
+            return errQUEUE_EMPTY;
+    }
+    return pdPASS;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken)
+{
+    if (woken)
+        *woken = pdFALSE;
+    return (q && tryPush(q, item, false)) ? pdPASS : errQUEUE_FULL;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    std::lock_guard<std::mutex> lk(g_objMu);
+    return q ? q->count : 0;
+}
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q)
+{
+    std::lock_guard<std::mutex> lk(g_objMu);
+    return q ? q->length - q->count : 0;
+}
+BaseType_t xQueueReset(QueueHandle_t q)
+{
+    std::lock_guard<std::mutex> lk(g_objMu);
+    if (q)
+    {
+        q->head = 0;
+        q->count = 0;
+    }
+    return pdPASS;
+}
@@ -0,0 +1,464 @@
+// twai_shim.cpp — TWAI ドライバ互換（送信キュー + 送信中1枠, 受信キュー, アラート）
+#include "driver/twai.h"
+#include "Arduino.h"
+#include "VirtualCanBus.h"
+
+#include <deque>
+
+namespace
+{
+    constexpr uint64_t WAIT_STEP_NS = 20000;
+
+    class TwaiNode : public VirtualCanNode
+    {
+    public:
+        bool installed = false;
+        twai_general_config_t g = {};
+        twai_filter_config_t filt = {};
+        twai_state_t state = TWAI_STATE_STOPPED;
+        uint32_t alertsEnabled = 0;
+        uint32_t alerts = 0;
+        std::deque<twai_message_t> txq;
+        std::deque<twai_message_t> rxq;
+        bool hasCur = false; // 送信バッファ（調停待ち/送信中）
+        bool sending = false;
+        twai_message_t cur = {};
+        uint32_t tec = 0;
+        uint32_t rec = 0;
+        uint32_t txFailed = 0;
+        uint32_t rxMissed = 0;
+        uint32_t arbLost_ = 0;
+        uint32_t busErrors = 0;
+        uint64_t recoverAtNs = 0;
+        VirtualCanBus *bus = nullptr;
+
+        void raise(uint32_t a) { alerts |= a & alertsEnabled; }
+
+        // バスオフ回復（128 x 11 recessive bit, バスが故障中は数えられない）の完了確認
+        void pollRecovery()
+        {
+            if (state == TWAI_STATE_RECOVERING && ArduinoShim::nowNs() >= recoverAtNs)
+            {
+                if (bus && bus->fault())
+                {
+                    recoverAtNs = ArduinoShim::nowNs() + 128ULL * 11ULL * bus->bitNs();
+                    return;
+                }
+                state = TWAI_STATE_STOPPED;
+                tec = 0;
+                rec = 0;
+                raise(TWAI_ALERT_BUS_RECOVERED);
+            }
+        }
+
+        void errorCount(bool up)
+        {
+            uint32_t before = tec;
+            if (up)
+            {
+                if (tec < 128) // ACK エラーはエラーパッシブ以降カウントしない
+                    tec += 8;
+            }
+            else if (tec > 0)
+                tec--;
+            if (before < 96 && tec >= 96)
+                raise(TWAI_ALERT_ABOVE_ERR_WARN);
+            if (before >= 96 && tec < 96)
+                raise(TWAI_ALERT_BELOW_ERR_WARN);
+            if (before < 128 && tec >= 128)
+                raise(TWAI_ALERT_ERR_PASS);
+            if (before >= 128 && tec < 128)
+                raise(TWAI_ALERT_ERR_ACTIVE);
+        }
+
+        // エラーフレーム（故障注入）: TEC > 255 でバスオフ。回復は twai_initiate_recovery
+        void txError() override
+        {
+            sending = false;
+            busErrors++;
+            raise(TWAI_ALERT_BUS_ERROR);
+            if (state != TWAI_STATE_RUNNING)
+                return;
+            uint32_t before = tec;
+            tec += 8;
+            if (before < 96 && tec >= 96)
+                raise(TWAI_ALERT_ABOVE_ERR_WARN);
+            if (before < 128 && tec >= 128)
+                raise(TWAI_ALERT_ERR_PASS);
+            if (tec > 255)
+            {
+                tec = 256;
+                state = TWAI_STATE_BUS_OFF;
+                raise(TWAI_ALERT_BUS_OFF);
+                return;
+            }
+            if (hasCur && cur.ss)
+            {
+                hasCur = false;
+                txFailed++;
+                raise(TWAI_ALERT_TX_FAILED);
+            }
+        }
+
+        void rxError() override
+        {
+            if (state != TWAI_STATE_RUNNING)
+                return;
+            busErrors++;
+            if (rec < 128)
+                rec++;
+        }
+
+        bool filterAccepts(const ShimCanFrame &f) const
+        {
+            uint32_t code = filt.acceptance_code;
+            uint32_t mask = filt.acceptance_mask; // 1=don't care
+            if (filt.single_filter)
+            {
+                uint32_t bits = f.ext ? ((f.id << 3) | (f.rtr ? 0x4 : 0)) : ((f.id << 21) | (f.rtr ? 0x100000 : 0));
+                return ((bits ^ code) & ~mask) == 0;
+            }
+            // デュアルフィルタ: ID 上位16bit（拡張）/ 11bit+RTR（標準）を2組で比較
+            uint32_t hi = f.ext ? (f.id >> 13) & 0xFFFF : ((f.id << 5) | (f.rtr ? 0x10 : 0)) & 0xFFFF;
+            bool m1 = ((hi ^ (code >> 16)) & ~(mask >> 16) & 0xFFFF) == 0;
+            bool m2 = ((hi ^ code) & ~mask & 0xFFFF) == 0;
+            return m1 || m2;
+        }
+
+        bool txPeek(ShimCanFrame &f) override
+        {
+            if (state != TWAI_STATE_RUNNING || g.mode == TWAI_MODE_LISTEN_ONLY)
+                return false;
+            if (!hasCur)
+            {
+                if (txq.empty())
+                    return false;
+                cur = txq.front();
+                txq.pop_front();
+                hasCur = true;
+            }
+            f.id = cur.identifier & (cur.extd ? TWAI_EXTD_ID_MASK : TWAI_STD_ID_MASK);
+            f.ext = cur.extd;
+            f.rtr = cur.rtr;
+            f.dlc = cur.data_length_code & 0x0F;
+            memcpy(f.data, cur.data, 8);
+            return true;
+        }
+
+        void txStart() override { sending = true; }
+
+        void arbLost() override
+        {
+            arbLost_++;
+            raise(TWAI_ALERT_ARB_LOST);
+        }
+
+        void txDone(bool ok) override
+        {
+            sending = false;
+            if (!hasCur)
+                return;
+            if (ok || g.mode == TWAI_MODE_NO_ACK)
+            {
+                hasCur = false;
+                errorCount(false);
+                raise(TWAI_ALERT_TX_SUCCESS);
+                if (txq.empty())
+                    raise(TWAI_ALERT_TX_IDLE);
+                return;
+            }
+            busErrors++;
+            raise(TWAI_ALERT_BUS_ERROR);
+            errorCount(true);
+            if (cur.ss)
+            {
+                hasCur = false;
+                txFailed++;
+                raise(TWAI_ALERT_TX_FAILED);
+                if (txq.empty())
+                    raise(TWAI_ALERT_TX_IDLE);
+            }
+            // 通常は自動再送（hasCur のまま次の調停へ）
+        }
+
+        void rx(const ShimCanFrame &f, uint64_t tNs) override
+        {
+            (void)tNs;
+            if (state != TWAI_STATE_RUNNING)
+                return;
+            if (rec > 0)
+                rec--;
+            if (!filterAccepts(f))
+                return;
+            if (rxq.size() >= g.rx_queue_len)
+            {
+                rxMissed++;
+                raise(TWAI_ALERT_RX_QUEUE_FULL);
+                return;
+            }
+            twai_message_t m = {};
+            m.extd = f.ext;
+            m.rtr = f.rtr;
+            m.dlc_non_comp = f.dlc > 8;
+            m.identifier = f.id;
+            m.data_length_code = f.dlc;
+            memcpy(m.data, f.data, 8);
+            rxq.push_back(m);
+            raise(TWAI_ALERT_RX_DATA);
+        }
+
+        bool acks() override { return state == TWAI_STATE_RUNNING && g.mode != TWAI_MODE_LISTEN_ONLY; }
+    };
+
+    TwaiNode g_twai;
+
+    uint64_t deadlineOf(TickType_t ticks)
+    {
+        if (ticks == portMAX_DELAY)
+            return ArduinoShim::NEVER;
+        return ArduinoShim::nowNs() + (uint64_t)ticks * 1000000ULL;
+    }
+    bool waitStep(uint64_t deadline)
+    {
+        uint64_t now = ArduinoShim::nowNs();
+        if (now >= deadline)
+            return false;
+        uint64_t next = now + WAIT_STEP_NS;
+        ArduinoShim::sleepUntilNs(next < deadline ? next : deadline);
+        return true;
+    }
+}
+
+namespace ArduinoShim
+{
+    void attachTwai(VirtualCanBus *bus)
+    {
+        ShimLock lk;
+        if (g_twai.bus)
+            g_twai.bus->detach(&g_twai);
+        g_twai.bus = bus;
+        if (bus)
+            bus->attach(&g_twai);
+    }
+
+    bool injectTwaiRx(const twai_message_t &msg)
+    {
+        ShimLock lk;
+        if (!g_twai.installed || g_twai.rxq.size() >= g_twai.g.rx_queue_len)
+            return false;
+        g_twai.rxq.push_back(msg);
+        return true;
+    }
+}
+
+esp_err_t twai_driver_install(const twai_general_config_t *g_config, const twai_timing_config_t *t_config,
+                              const twai_filter_config_t *f_config)
+{
+    if (!g_config || !t_config || !f_config || g_config->rx_queue_len == 0)
+        return ESP_ERR_INVALID_ARG;
+    ShimLock lk;
+    if (g_twai.installed)
+        return ESP_ERR_INVALID_STATE;
+    g_twai.installed = true;
+    g_twai.g = *g_config;
+    g_twai.filt = *f_config;
+    g_twai.alertsEnabled = g_config->alerts_enabled;
+    g_twai.alerts = 0;
+    g_twai.state = TWAI_STATE_STOPPED;
+    g_twai.txq.clear();
+    g_twai.rxq.clear();
+    g_twai.hasCur = false;
+    g_twai.tec = g_twai.rec = 0;
+    // 統計はドライバごと（入れ直すと 0 から）
+    g_twai.txFailed = g_twai.rxMissed = g_twai.arbLost_ = g_twai.busErrors = 0;
+    return ESP_OK;
+}
+
+esp_err_t twai_driver_uninstall()
+{
+    ShimLock lk;
+    if (!g_twai.installed || (g_twai.state != TWAI_STATE_STOPPED && g_twai.state != TWAI_STATE_BUS_OFF))
+        return ESP_ERR_INVALID_STATE;
+    g_twai.installed = false;
+    return ESP_OK;
+}
+
+esp_err_t twai_start()
+{
+    ShimLock lk;
+    g_twai.pollRecovery();
+    if (!g_twai.installed || g_twai.state != TWAI_STATE_STOPPED)
+        return ESP_ERR_INVALID_STATE;
+    g_twai.state = TWAI_STATE_RUNNING;
+    g_twai.rxq.clear();
+    return ESP_OK;
+}
+
+esp_err_t twai_stop()
+{
+    ShimLock lk;
+    if (!g_twai.installed || g_twai.state != TWAI_STATE_RUNNING)
+        return ESP_ERR_INVALID_STATE;
+    g_twai.state = TWAI_STATE_STOPPED;
+    g_twai.txq.clear();
+    if (!g_twai.sending)
+        g_twai.hasCur = false;
+    return ESP_OK;
+}
+
+esp_err_t twai_transmit(const twai_message_t *message, TickType_t ticks_to_wait)
+{
+    if (!message)
+        return ESP_ERR_INVALID_ARG;
+    if (message->data_length_code > TWAI_FRAME_MAX_DLC && !message->dlc_non_comp)
+        return ESP_ERR_INVALID_ARG;
+    uint64_t deadline = deadlineOf(ticks_to_wait);
+    for (;;)
+    {
+        {
+            ShimLock lk;
+            if (!g_twai.installed || g_twai.state != TWAI_STATE_RUNNING)
+                return ESP_ERR_INVALID_STATE;
+            if (g_twai.g.mode == TWAI_MODE_LISTEN_ONLY)
+                return ESP_ERR_NOT_SUPPORTED;
+            // 送信バッファが空ならキューを経由しない（tx_queue_len=0 でも送れる）
+            if (!g_twai.hasCur && g_twai.txq.empty())
+            {
+                g_twai.cur = *message;
+                g_twai.hasCur = true;
+                if (g_twai.bus)
+                    g_twai.bus->kick();
+                return ESP_OK;
+            }
+            if (g_twai.txq.size() < g_twai.g.tx_queue_len)
+            {
+                g_twai.txq.push_back(*message);
+                if (g_twai.bus)
+                    g_twai.bus->kick();
+                return ESP_OK;
+            }
+        }
+        if (!waitStep(deadline))
+            return ESP_ERR_TIMEOUT;
+    }
+}
+
+esp_err_t twai_receive(twai_message_t *message, TickType_t ticks_to_wait)
+{
+    if (!message)
+        return ESP_ERR_INVALID_ARG;
+    uint64_t deadline = deadlineOf(ticks_to_wait);
+    for (;;)
+    {
+        ArduinoShim::pump();
+        {
+            ShimLock lk;
+            if (!g_twai.installed)
+                return ESP_ERR_INVALID_STATE;
+            if (!g_twai.rxq.empty())
+            {
+                *message = g_twai.rxq.front();
+                g_twai.rxq.pop_front();
+                return ESP_OK;
+            }
+        }
+        if (!waitStep(deadline))
+            return ESP_ERR_TIMEOUT;
+    }
+}
+
+esp_err_t twai_read_alerts(uint32_t *alerts, TickType_t ticks_to_wait)
+{
+    if (!alerts)
+        return ESP_ERR_INVALID_ARG;
+    uint64_t deadline = deadlineOf(ticks_to_wait);
+    for (;;)
+    {
+        ArduinoShim::pump();
+        {
+            ShimLock lk;
+            if (!g_twai.installed)
+                return ESP_ERR_INVALID_STATE;
+            g_twai.pollRecovery();
+            if (g_twai.alerts)
+            {
+                *alerts = g_twai.alerts;
+                g_twai.alerts = 0;
+                return ESP_OK;
+            }
+        }
+        if (!waitStep(deadline))
+        {
+            *alerts = 0;
+            return ESP_ERR_TIMEOUT;
+        }
+    }
+}
+
+esp_err_t twai_reconfigure_alerts(uint32_t alerts_enabled, uint32_t *current_alerts)
+{
+    ShimLock lk;
+    if (!g_twai.installed)
+        return ESP_ERR_INVALID_STATE;
+    if (current_alerts)
+        *current_alerts = g_twai.alerts;
+    g_twai.alerts = 0;
+    g_twai.alertsEnabled = alerts_enabled;
+    return ESP_OK;
+}
+
+esp_err_t twai_initiate_recovery()
+{
+    ShimLock lk;
+    if (!g_twai.installed || g_twai.state != TWAI_STATE_BUS_OFF)
+        return ESP_ERR_INVALID_STATE;
+    g_twai.state = TWAI_STATE_RECOVERING;
+    uint64_t bitNs = g_twai.bus ? g_twai.bus->bitNs() : 1000;
+    g_twai.recoverAtNs = ArduinoShim::nowNs() + 128ULL * 11ULL * bitNs;
+    g_twai.txq.clear();
+    g_twai.hasCur = false;
+    g_twai.raise(TWAI_ALERT_RECOVERY_IN_PROGRESS);
+    return ESP_OK;
+}
+
+esp_err_t twai_get_status_info(twai_status_info_t *status_info)
+{
+    if (!status_info)
+        return ESP_ERR_INVALID_ARG;
+    ShimLock lk;
+    if (!g_twai.installed)
+        return ESP_ERR_INVALID_STATE;
+    g_twai.pollRecovery();
+    twai_status_info_t &s = *status_info;
+    s.state = g_twai.state;
+    s.msgs_to_tx = (uint32_t)g_twai.txq.size() + (g_twai.hasCur ? 1 : 0);
+    s.msgs_to_rx = (uint32_t)g_twai.rxq.size();
+    s.tx_error_counter = g_twai.tec;
+    s.rx_error_counter = g_twai.rec;
+    s.tx_failed_count = g_twai.txFailed;
+    s.rx_missed_count = g_twai.rxMissed;
+    s.rx_overrun_count = 0;
+    s.arb_lost_count = g_twai.arbLost_;
+    s.bus_error_count = g_twai.busErrors;
+    return ESP_OK;
+}
+
+esp_err_t twai_clear_transmit_queue()
+{
+    ShimLock lk;
+    if (!g_twai.installed)
+        return ESP_ERR_INVALID_STATE;
+    g_twai.txq.clear();
+    if (!g_twai.sending) // 送信中の1フレームは止まらない
+        g_twai.hasCur = false;
+    return ESP_OK;
+}
+
+esp_err_t twai_clear_receive_queue()
+{
+    ShimLock lk;
+    if (!g_twai.installed)
+        return ESP_ERR_INVALID_STATE;
+    g_twai.rxq.clear();
+    return ESP_OK;
+}
@@ -0,0 +1,84 @@
+#pragma once
+// RS02SimBench.h — 仮想バス 1 本に シミュレータ 2 ノード（sim と、ID 重複用の dup）/ TWAI（シム）/ MCP2515（エミュレータ）を
+// つないだ試験台。どちらのバックエンドからも同じモータ群が見え、受信あふれは lost(useMcp) に数える
+// TWAI シムの状態は全体で 1 つなので、同時に作れるのは 1 台だけ
+
+#include <Arduino.h>
+#include <SPI.h>
+#include <mcp_can.h>
+#include <driver/twai.h>
+#include <Mcp2515Emu.h>
+#include <VirtualCanBus.h>
+#include "RS02SimBus.h"
+#include "RS02SimCheck.h"
+#include "RS02PrivateCAN.h"
+#include "RS02PrivateTWAI.h"
+
+// 受信あふれ（onRxLost）の数
+class RS02LostCount : public RS02FrameListener
+{
+public:
+    uint32_t lost = 0;
+    void onRxLost(uint32_t n, uint32_t tUs) override
+    {
+        (void)tUs;
+        lost += n;
+    }
+};
+
+inline RS02SimBusConfig rs02SimConfig(uint32_t replyUs)
+{
+    RS02SimBusConfig c;
+    c.replyLatencyUs = replyUs;
+    return c;
+}
+
+struct RS02SimBench
+{
+    static constexpr uint8_t HOST_ID = 0xFD;
+    static constexpr uint8_t CS_PIN = 6;
+
+    VirtualCanBus bus{1000000};
+    RS02SimBus sim;
+    RS02SimBus dup; // 重複 ID のモータ（別ノード。応答の遅れは sim と同じ）
+    Mcp2515Emu emu{&bus};
+    MCP_CAN mcp{CS_PIN};
+    RS02PrivateTWAI twai{HOST_ID, 1, 2};
+    RS02PrivateCAN can{mcp, HOST_ID};
+    RS02LostCount lostTwai, lostCan;
+
+    // twaiMotors: TWAI のキュー長（setQueueForMotors）
+    explicit RS02SimBench(uint32_t replyUs = 100, uint8_t twaiMotors = 32)
+        : sim(&bus, rs02SimConfig(replyUs)), dup(&bus, rs02SimConfig(replyUs))
+    {
+        SPI.attach(CS_PIN, &emu);
+        SPI.begin();
+        mcp.setFastIO(1);
+        mcp.begin(MCP_ANY, CAN_1000KBPS, MCP_8MHZ);
+        mcp.setMode(MCP_NORMAL);
+        can.begin();
+        can.setMasterId(HOST_ID);
+        ArduinoShim::attachTwai(&bus);
+        twai.setQueueForMotors(twaiMotors);
+        twai.begin();
+        twai.addListener(&lostTwai);
+        can.addListener(&lostCan);
+    }
+    ~RS02SimBench()
+    {
+        delay(1); // 送信中のフレームを出し切ってから外す（TWAI の状態は次の台に残る）
+        ArduinoShim::attachTwai(nullptr);
+    }
+
+    RS02PrivateBase &rs(bool useMcp) { return useMcp ? (RS02PrivateBase &)can : (RS02PrivateBase &)twai; }
+    uint32_t lost(bool useMcp) const { return useMcp ? lostCan.lost : lostTwai.lost; }
+
+    // 両方の受信を捨てる（使っていない側に溜まった応答も）
+    void drain()
+    {
+        RS02PrivFrame f;
+        while (twai.readAny(f) || can.readAny(f))
+        {
+        }
+    }
+};
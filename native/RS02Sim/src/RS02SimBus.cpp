@@ -0,0 +1,195 @@
+// RS02SimBus.cpp — 仮想CANバス上のモータ群
+#include "RS02SimBus.h"
+
+RS02SimBus::RS02SimBus(VirtualCanBus *bus, const RS02SimBusConfig &cfg) : _bus(bus), _cfg(cfg)
+{
+    _nextTickNs = ArduinoShim::nowNs() + (uint64_t)_cfg.physicsPeriodUs * 1000ULL;
+    _bus->attach(this);
+    ArduinoShim::addTimeSource(this);
+}
+
+RS02SimBus::~RS02SimBus()
+{
+    ArduinoShim::removeTimeSource(this);
+    _bus->detach(this);
+}
+
+RS02SimMotor *RS02SimBus::add(uint8_t motorId, uint64_t uid, const RS02SimModel &model)
+{
+    ShimLock lk;
+    if (_byId[motorId])
+        return nullptr;
+    if (uid == 0)
+        uid = 0x5253303200000000ULL | ((uint64_t)motorId << 8) | 0x5A; // "RS02" + ID
+    _motors.emplace_back(new RS02SimMotor(motorId, uid, model));
+    RS02SimMotor *m = _motors.back().get();
+    _byId[motorId] = m;
+    return m;
+}
+
+RS02SimMotor *RS02SimBus::motor(uint8_t motorId) { return _byId[motorId]; }
+
+void RS02SimBus::reindex()
+{
+    for (auto &p : _byId)
+        p = nullptr;
+    // ID が重複したら先に追加した方が応答する（実機では両方応答して衝突）
+    for (auto &m : _motors)
+        if (!_byId[m->id()])
+            _byId[m->id()] = m.get();
+}
+
+void RS02SimBus::powerCycleAll()
+{
+    ShimLock lk;
+    for (auto &m : _motors)
+        m->powerCycle();
+    reindex();
+    _pending.clear();
+    // 送信中のフレームは残す（バスが txDone を呼ぶ）
+    if (_sendIdx >= 0)
+    {
+        ShimCanFrame cur = _ready[_sendIdx];
+        _ready.clear();
+        _ready.push_back(cur);
+        _sendIdx = 0;
+    }
+    else
+        _ready.clear();
+    _peekIdx = -1;
+}
+
+void RS02SimBus::enqueueReady(const RS02PrivFrame &f)
+{
+    if (_ready.size() + _pending.size() >= _cfg.maxQueued)
+    {
+        _stats.dropped++;
+        return;
+    }
+    ShimCanFrame c;
+    c.id = (uint32_t)f.id;
+    c.ext = true;
+    c.dlc = f.dlc;
+    memcpy(c.data, f.data, 8);
+    _ready.push_back(c);
+    if (_ready.size() > _stats.maxQueued)
+        _stats.maxQueued = (uint16_t)_ready.size();
+    _bus->kick();
+}
+
+// ===== VirtualCanNode =====
+bool RS02SimBus::txPeek(ShimCanFrame &f)
+{
+    _peekIdx = -1;
+    for (size_t i = 0; i < _ready.size(); i++)
+        if (_peekIdx < 0 || _ready[i].id < _ready[_peekIdx].id)
+            _peekIdx = (int)i;
+    if (_peekIdx < 0)
+        return false;
+    f = _ready[_peekIdx];
+    return true;
+}
+
+void RS02SimBus::txStart() { _sendIdx = _peekIdx; }
+
+void RS02SimBus::txDone(bool ok)
+{
+    if (_sendIdx < 0)
+        return;
+    if (!ok)
+    {
+        _stats.ackErrors++; // 実機同様に再送（送信待ちに残す）
+        _sendIdx = -1;
+        return;
+    }
+    _ready.erase(_ready.begin() + _sendIdx);
+    _sendIdx = -1;
+    _peekIdx = -1;
+    _stats.txFrames++;
+}
+
+void RS02SimBus::rx(const ShimCanFrame &f, uint64_t tNs)
+{
+    _stats.rxFrames++;
+    if (!f.ext || f.rtr)
+        return;
+    RS02SimMotor *m = _byId[f.id & 0xFF];
+    if (!m)
+        return;
+    RS02PrivFrame in;
+    in.id = f.id;
+    in.dlc = f.dlc > 8 ? 8 : f.dlc;
+    in.isExt = true;
+    memcpy(in.data, f.data, in.dlc);
+
+    uint8_t before = m->id();
+    RS02PrivFrame out[RS02SimMotor::MAX_REPLIES];
+    uint8_t n = m->handle(in, out);
+    if (m->id() != before)
+        reindex();
+    _stats.rxHandled++;
+
+    uint64_t due = tNs + (uint64_t)_cfg.replyLatencyUs * 1000ULL;
+    for (uint8_t i = 0; i < n; i++)
+    {
+        if (_ready.size() + _pending.size() >= _cfg.maxQueued)
+        {
+            _stats.dropped++;
+            continue;
+        }
+        Pending p;
+        p.dueNs = due;
+        p.f.id = (uint32_t)out[i].id;
+        p.f.ext = true;
+        p.f.dlc = out[i].dlc;
+        memcpy(p.f.data, out[i].data, 8);
+        _pending.push_back(p);
+    }
+}
+
+// ===== ShimTimeSource =====
+uint64_t RS02SimBus::nextEventNs()
+{
+    uint64_t t = _cfg.physicsPeriodUs ? _nextTickNs : ArduinoShim::NEVER;
+    if (!_pending.empty() && _pending.front().dueNs < t)
+        t = _pending.front().dueNs;
+    return t;
+}
+
+void RS02SimBus::runUntil(uint64_t nowNs)
+{
+    bool moved = false;
+    while (!_pending.empty() && _pending.front().dueNs <= nowNs)
+    {
+        _ready.push_back(_pending.front().f);
+        _pending.pop_front();
+        moved = true;
+    }
+    if (moved)
+    {
+        if (_ready.size() > _stats.maxQueued)
+            _stats.maxQueued = (uint16_t)_ready.size();
+        _bus->kick();
+    }
+    if (_cfg.physicsPeriodUs && _nextTickNs <= nowNs)
+    {
+        physicsTick();
+        _nextTickNs += (uint64_t)_cfg.physicsPeriodUs * 1000ULL;
+        // 実時間モードで大きく遅れたら追いかけない
+        if (_nextTickNs < nowNs)
+            _nextTickNs = nowNs + (uint64_t)_cfg.physicsPeriodUs * 1000ULL;
+    }
+}
+
+void RS02SimBus::physicsTick()
+{
+    _stats.physicsTicks++;
+    const float dt = (float)_cfg.physicsPeriodUs * 1e-6f;
+    RS02PrivFrame rep;
+    for (auto &m : _motors)
+    {
+        m->step(dt);
+        if (m->takeReport(rep))
+            enqueueReady(rep);
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+// RS02SimBus.h — 複数の RS02SimMotor を1つの仮想CANノードとして VirtualCanBus に載せる
+// ・受信フレームは宛先IDの表引きで該当モータへ（モータ数に依存しない）
+// ・応答は replyLatencyUs 後に送信待ちへ。送信待ちは ID 最小から出す（各モータ個別ノードと同じ調停順）
+// ・physicsPeriodUs ごとに全モータの物理を進め、アクティブレポートを送信待ちへ
+// 実機と同じ経路（MCP2515 エミュレータ / TWAI シム）でライブラリから見える。
+//
+// 仮想時間モードでは協調実行なので motor() の状態をそのまま読んでよい。
+// 実時間モードで状態を読む/書くときは ShimLock を取ること。
+
+#include <stdint.h>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <VirtualCanBus.h>
+#include "RS02SimMotor.h"
+
+struct RS02SimBusConfig
+{
+    uint32_t replyLatencyUs = 100;  // 受信(EOF)〜応答の送信要求
+    uint32_t physicsPeriodUs = 1000; // 物理/レポート周期（0=物理を止める）
+    uint16_t maxQueued = 256;        // 送信待ち上限（超えたら捨てる）
+};
+
+struct RS02SimBusStats
+{
+    uint32_t rxFrames = 0;   // バス上の全受信
+    uint32_t rxHandled = 0;  // いずれかのモータ宛て
+    uint32_t txFrames = 0;   // 送信完了
+    uint32_t ackErrors = 0;  // 送信失敗（再送する）
+    uint32_t dropped = 0;    // 送信待ちあふれ
+    uint32_t physicsTicks = 0;
+    uint16_t maxQueued = 0;
+};
+
+class RS02SimBus : public VirtualCanNode, public ShimTimeSource
+{
+public:
+    explicit RS02SimBus(VirtualCanBus *bus, const RS02SimBusConfig &cfg = RS02SimBusConfig());
+    ~RS02SimBus();
+
+    // モータ追加（同じIDがあれば nullptr）。uid=0 なら ID から生成
+    RS02SimMotor *add(uint8_t motorId, uint64_t uid = 0, const RS02SimModel &model = RS02SimModel::rs02());
+    RS02SimMotor *motor(uint8_t motorId);
+    size_t count() const { return _motors.size(); }
+    RS02SimMotor *at(size_t i) { return i < _motors.size() ? _motors[i].get() : nullptr; }
+
+    // 全モータの電源再投入（保存済み CAN_ID / プロトコル切替を反映）
+    void powerCycleAll();
+
+    const RS02SimBusConfig &config() const { return _cfg; }
+    const RS02SimBusStats &stats() const { return _stats; }
+    void resetStats() { _stats = RS02SimBusStats(); }
+    size_t queued() const { return _ready.size() + _pending.size(); }
+
+    // VirtualCanNode
+    bool txPeek(ShimCanFrame &f) override;
+    void txStart() override;
+    void txDone(bool ok) override;
+    void rx(const ShimCanFrame &f, uint64_t tNs) override;
+
+    // ShimTimeSource
+    uint64_t nextEventNs() override;
+    void runUntil(uint64_t nowNs) override;
+
+private:
+    struct Pending
+    {
+        uint64_t dueNs;
+        ShimCanFrame f;
+    };
+
+    VirtualCanBus *_bus;
+    RS02SimBusConfig _cfg;
+    RS02SimBusStats _stats;
+    std::vector<std::unique_ptr<RS02SimMotor>> _motors;
+    RS02SimMotor *_byId[256] = {};
+
+    std::deque<Pending> _pending; // 応答（due 昇順: 遅延一定なので末尾追加で整列）
+    std::vector<ShimCanFrame> _ready;
+    int _peekIdx = -1;
+    int _sendIdx = -1;
+    uint64_t _nextTickNs;
+
+    void reindex();
+    void enqueueReady(const RS02PrivFrame &f);
+    void physicsTick();
+};
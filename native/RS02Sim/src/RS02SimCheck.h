@@ -0,0 +1,31 @@
+#pragma once
+// RS02SimCheck.h — tools/native_* の合否判定（[ OK ] / [FAIL] を出して数え、最後に PASSED / FAILED と exit コード）
+//   using RS02SimCheck::check;
+//   check(a == b, "what");
+//   return RS02SimCheck::finish();
+
+#include <Arduino.h>
+
+namespace RS02SimCheck
+{
+    inline int &failures()
+    {
+        static int n = 0;
+        return n;
+    }
+
+    inline void check(bool ok, const char *what)
+    {
+        Serial.printf("[%s] %s\n", ok ? " OK " : "FAIL", what);
+        if (!ok)
+            failures()++;
+    }
+
+    // main の戻り値（失敗があれば 1）
+    inline int finish()
+    {
+        Serial.printf("%s\n", failures() ? "FAILED" : "PASSED");
+        Serial.flush();
+        return failures() ? 1 : 0;
+    }
+}
@@ -0,0 +1,542 @@
+// RS02SimMotor.cpp — RS02/RS05 モータモデル
+#include "RS02SimMotor.h"
+#include <math.h>
+
+namespace
+{
+    constexpr double SIM_TWO_PI = 6.283185307179586;
+    constexpr float SUBSTEP_S = 0.00025f;
+
+    uint16_t toU(float x, float lo, float hi)
+    {
+        float c = x < lo ? lo : (x > hi ? hi : x);
+        return (uint16_t)((c - lo) * 65535.0f / (hi - lo));
+    }
+    float toF(uint16_t u, float lo, float hi) { return (float)u * (hi - lo) / 65535.0f + lo; }
+    uint32_t f2raw(float f)
+    {
+        uint32_t u;
+        memcpy(&u, &f, 4);
+        return u;
+    }
+    float raw2f(uint32_t u)
+    {
+        float f;
+        memcpy(&f, &u, 4);
+        return f;
+    }
+    float clampf(float x, float lim)
+    {
+        lim = fabsf(lim);
+        return x > lim ? lim : (x < -lim ? -lim : x);
+    }
+    uint32_t buildId(uint8_t type, uint16_t da2, uint8_t dst)
+    {
+        return ((uint32_t)(type & 0x1F) << 24) | ((uint32_t)da2 << 8) | dst;
+    }
+}
+
+RS02SimModel RS02SimModel::rs02()
+{
+    RS02SimModel m;
+    m.name = "RS02";
+    m.posMax = 12.57f;
+    m.velMax = 44.0f;
+    m.torqueMax = 17.0f;
+    m.kpMax = 500.0f;
+    m.kdMax = 5.0f;
+    m.peakCurA = 23.0f;
+    m.kt = 0.74f;
+    m.inertia = 0.0025f;
+    m.viscous = 0.01f;
+    m.coulomb = 0.05f;
+    m.curTauS = 0.0004f;
+    m.resistance = 0.3f;
+    m.thermalTauS = 300.0f;
+    m.overTempC = 110.0f;
+    return m;
+}
+
+RS02SimModel RS02SimModel::rs05()
+{
+    RS02SimModel m = rs02();
+    m.name = "RS05";
+    m.velMax = 50.0f;
+    m.torqueMax = 5.5f;
+    m.peakCurA = 11.0f;
+    m.kt = 0.5f;
+    m.inertia = 0.0008f;
+    m.viscous = 0.004f;
+    m.coulomb = 0.02f;
+    m.resistance = 0.6f;
+    return m;
+}
+
+RS02SimMotor::RS02SimMotor(uint8_t motorId, uint64_t uid, const RS02SimModel &model)
+    : _model(model), _id(motorId), _uid(uid)
+{
+    using namespace RS02Idx;
+    addParam(RUN_MODE, P_U8, true, 0);
+    addParam(IQ_REF, P_F32, true, f2raw(0.0f));
+    addParam(SPD_REF, P_F32, true, f2raw(0.0f));
+    addParam(LIMIT_TORQUE, P_F32, true, f2raw(model.torqueMax));
+    addParam(CUR_KP, P_F32, true, f2raw(0.125f));
+    addParam(CUR_KI, P_F32, true, f2raw(0.0158f));
+    addParam(LOC_REF, P_F32, true, f2raw(0.0f));
+    addParam(LIMIT_SPD, P_F32, true, f2raw(2.0f));
+    addParam(LIMIT_CUR, P_F32, true, f2raw(model.peakCurA));
+    addParam(MECH_POS, P_F32, false, 0);
+    addParam(MECH_VEL, P_F32, false, 0);
+    addParam(SPD_KP, P_F32, true, f2raw(2.0f));
+    addParam(SPD_KI, P_F32, true, f2raw(0.021f));
+    addParam(LOC_KP, P_F32, true, f2raw(30.0f));
+    addParam(ACC_RAD, P_F32, true, f2raw(20.0f));
+    addParam(LIMIT_CUR_OLD, P_F32, true, f2raw(model.peakCurA));
+    addParam(CAN_ID, P_U8, true, motorId);
+    addParam(CAN_MASTER, P_U16, true, 0xFD);
+    addParam(IDX_ROTATION, P_F32, false, 0);
+    addParam(IDX_MODPOS, P_F32, false, 0);
+    addParam(IDX_MECH_ANGLE_ROT, P_F32, false, 0);
+    addParam(IDX_EPSCAN_TIME, P_U16, true, 1);
+    for (uint8_t i = 0; i < _nParams; i++)
+        _p[i].saved = _p[i].raw;
+}
+
+// ===== パラメータ =====
+void RS02SimMotor::addParam(uint16_t index, ParamType type, bool writable, uint32_t raw)
+{
+    if (_nParams >= MAX_PARAMS)
+        return;
+    Param &p = _p[_nParams++];
+    p.index = index;
+    p.type = type;
+    p.writable = writable;
+    p.raw = raw;
+    p.saved = raw;
+}
+
+RS02SimMotor::Param *RS02SimMotor::findParam(uint16_t index)
+{
+    for (uint8_t i = 0; i < _nParams; i++)
+        if (_p[i].index == index)
+            return &_p[i];
+    return nullptr;
+}
+
+const RS02SimMotor::Param *RS02SimMotor::findParam(uint16_t index) const
+{
+    for (uint8_t i = 0; i < _nParams; i++)
+        if (_p[i].index == index)
+            return &_p[i];
+    return nullptr;
+}
+
+float RS02SimMotor::paramF(uint16_t index) const
+{
+    const Param *p = findParam(index);
+    return p ? raw2f(liveValue(*p)) : 0.0f;
+}
+
+void RS02SimMotor::setF(uint16_t index, float v)
+{
+    Param *p = findParam(index);
+    if (p)
+        p->raw = f2raw(v);
+}
+
+uint32_t RS02SimMotor::liveValue(const Param &p) const
+{
+    using namespace RS02Idx;
+    double turns = floor(_st.posRad / SIM_TWO_PI);
+    switch (p.index)
+    {
+    case MECH_POS:
+    {
+        double w = _st.posRad - SIM_TWO_PI * floor((_st.posRad + M_PI) / SIM_TWO_PI); // [-π, π)
+        return f2raw((float)w);
+    }
+    case MECH_VEL:
+        return f2raw(_st.velRadS);
+    case IDX_ROTATION:
+    case IDX_MECH_ANGLE_ROT:
+        return f2raw((float)turns);
+    case IDX_MODPOS:
+        return f2raw((float)(_st.posRad - turns * SIM_TWO_PI));
+    case RUN_MODE:
+        return _st.runMode;
+    default:
+        return p.raw;
+    }
+}
+
+bool RS02SimMotor::readParam(uint16_t index, uint8_t out4LE[4]) const
+{
+    const Param *p = findParam(index);
+    if (!p)
+        return false;
+    uint32_t v = liveValue(*p);
+    out4LE[0] = (uint8_t)v;
+    out4LE[1] = (uint8_t)(v >> 8);
+    out4LE[2] = (uint8_t)(v >> 16);
+    out4LE[3] = (uint8_t)(v >> 24);
+    return true;
+}
+
+bool RS02SimMotor::writeParam(uint16_t index, const uint8_t v4LE[4])
+{
+    Param *p = findParam(index);
+    if (!p || !p->writable)
+        return false;
+    uint32_t v = (uint32_t)v4LE[0] | ((uint32_t)v4LE[1] << 8) | ((uint32_t)v4LE[2] << 16) | ((uint32_t)v4LE[3] << 24);
+    if (p->type == P_U8)
+        v &= 0xFF;
+    else if (p->type == P_U16)
+        v &= 0xFFFF;
+    else if (isnan(raw2f(v)))
+        return false;
+
+    if (index == RS02Idx::RUN_MODE)
+    {
+        if (v > 5 || v == 4)
+            return false;
+        if (v != _st.runMode)
+        {
+            _st.runMode = (uint8_t)v;
+            resetControllers();
+        }
+    }
+    p->raw = v;
+    return true;
+}
+
+// ===== 状態遷移 =====
+void RS02SimMotor::resetControllers()
+{
+    _spdInteg = 0.0f;
+    _spdRamp = _st.velRadS;
+    _ppVel = _st.velRadS;
+    // 位置系モードは現在位置を保持して開始（有効化直後に飛ばない）
+    if (_st.runMode == 1 || _st.runMode == 5)
+        setF(RS02Idx::LOC_REF, (float)_st.posRad);
+}
+
+void RS02SimMotor::enable()
+{
+    if (_st.faultBits)
+        return; // 故障中は有効化しない
+    if (_st.state != RS02MotorState::RUN)
+    {
+        _st.state = RS02MotorState::RUN;
+        resetControllers();
+    }
+}
+
+void RS02SimMotor::disable()
+{
+    _st.state = RS02MotorState::RESET;
+    _st.iqRefA = 0.0f;
+    _spdInteg = 0.0f;
+}
+
+void RS02SimMotor::powerCycle()
+{
+    for (uint8_t i = 0; i < _nParams; i++)
+        _p[i].raw = _p[i].saved;
+    const Param *pid = findParam(RS02Idx::CAN_ID);
+    if (pid)
+        _id = (uint8_t)pid->raw;
+    Param *rm = findParam(RS02Idx::RUN_MODE);
+    _st.runMode = rm ? (uint8_t)rm->raw : 0;
+    _protocol = _pendingProtocol;
+    _report = false;
+    _reportAccS = 0.0f;
+    _st.faultBits = 0;
+    _st.velRadS = 0.0f;
+    _st.iqA = 0.0f;
+    // 多回転カウントは失われる
+    _st.posRad -= SIM_TWO_PI * floor((_st.posRad + M_PI) / SIM_TWO_PI);
+    disable();
+}
+
+// ===== 通信 =====
+void RS02SimMotor::feedback(RS02PrivFrame &out) const
+{
+    const float pm = _model.posMax;
+    double p = _st.posRad;
+    // Type2 角度は ±posMax で折り返す
+    if (p >= pm || p < -pm)
+        p -= 2.0 * pm * floor((p + pm) / (2.0 * pm));
+    out.id = ((uint32_t)RS02Type::FEEDBACK << 24) | ((uint32_t)(_st.state & 0x03) << 22) |
+             ((uint32_t)(_st.faultBits & 0x3F) << 16) | ((uint32_t)_id << 8) | _host;
+    out.dlc = 8;
+    out.isExt = true;
+    out.tsUs = 0;
+    uint16_t uP = toU((float)p, -pm, pm);
+    uint16_t uV = toU(_st.velRadS, -_model.velMax, _model.velMax);
+    uint16_t uT = toU(_st.torqueNm, -_model.torqueMax, _model.torqueMax);
+    uint16_t uC = (uint16_t)(_st.tempC * 10.0f);
+    out.data[0] = (uint8_t)(uP >> 8);
+    out.data[1] = (uint8_t)uP;
+    out.data[2] = (uint8_t)(uV >> 8);
+    out.data[3] = (uint8_t)uV;
+    out.data[4] = (uint8_t)(uT >> 8);
+    out.data[5] = (uint8_t)uT;
+    out.data[6] = (uint8_t)(uC >> 8);
+    out.data[7] = (uint8_t)uC;
+}
+
+uint8_t RS02SimMotor::handle(const RS02PrivFrame &in, RS02PrivFrame out[MAX_REPLIES])
+{
+    if (!in.isExt || (in.id & 0xFF) != _id || _protocol != 0)
+        return 0;
+    uint8_t type = (uint8_t)((in.id >> 24) & 0x1F);
+    uint16_t da2 = (uint16_t)((in.id >> 8) & 0xFFFF);
+    _stats.rxFrames++;
+    // 応答先ホストは bit8-15（Type1 は DA2 がトルクなので更新しない）
+    if (type != RS02Type::OP_CONTROL)
+        _host = (uint8_t)(da2 & 0xFF);
+
+    uint8_t n = 0;
+    switch (type)
+    {
+    case RS02Type::GET_ID:
+    {
+        RS02PrivFrame &r = out[n++];
+        r.id = buildId(RS02Type::GET_ID, _id, 0xFE);
+        r.dlc = 8;
+        r.isExt = true;
+        r.tsUs = 0;
+        for (uint8_t i = 0; i < 8; i++)
+            r.data[i] = (uint8_t)(_uid >> (8 * i));
+        break;
+    }
+    case RS02Type::OP_CONTROL:
+        if (in.dlc >= 8)
+        {
+            const RS02SimModel &m = _model;
+            _opT = toF(da2, -m.torqueMax, m.torqueMax);
+            _opP = toF((uint16_t)((in.data[0] << 8) | in.data[1]), -m.posMax, m.posMax);
+            _opV = toF((uint16_t)((in.data[2] << 8) | in.data[3]), -m.velMax, m.velMax);
+            _opKp = toF((uint16_t)((in.data[4] << 8) | in.data[5]), 0.0f, m.kpMax);
+            _opKd = toF((uint16_t)((in.data[6] << 8) | in.data[7]), 0.0f, m.kdMax);
+        }
+        feedback(out[n++]);
+        break;
+    case RS02Type::ENABLE:
+        enable();
+        feedback(out[n++]);
+        break;
+    case RS02Type::STOP:
+        // 故障クリア: 仕様は data[0]=1。ライブラリは data[1]=1 で送るので両方受け付ける
+        if (in.data[0] == 1 || in.data[1] == 1)
+            _st.faultBits = 0;
+        disable();
+        feedback(out[n++]);
+        break;
+    case RS02Type::SET_ID:
+    {
+        uint8_t newId = (uint8_t)(da2 >> 8);
+        if (newId > 0x7F || _st.state == RS02MotorState::RUN)
+        {
+            _stats.rejected++;
+            return 0;
+        }
+        _id = newId;
+        Param *p = findParam(RS02Idx::CAN_ID);
+        if (p)
+            p->raw = newId;
+        // 新IDから Type0 応答
+        RS02PrivFrame &r = out[n++];
+        r.id = buildId(RS02Type::GET_ID, _id, 0xFE);
+        r.dlc = 8;
+        r.isExt = true;
+        r.tsUs = 0;
+        for (uint8_t i = 0; i < 8; i++)
+            r.data[i] = (uint8_t)(_uid >> (8 * i));
+        break;
+    }
+    case RS02Type::READ_PARAM:
+    {
+        uint16_t index = (uint16_t)(in.data[0] | (in.data[1] << 8));
+        RS02PrivFrame &r = out[n++];
+        uint8_t v[4] = {0, 0, 0, 0};
+        bool ok = readParam(index, v);
+        _stats.paramReads++;
+        if (!ok)
+            _stats.rejected++;
+        // bit16-23: 0=成功 / 1=失敗
+        r.id = buildId(RS02Type::READ_PARAM, (uint16_t)(((ok ? 0 : 1) << 8) | _id), _host);
+        r.dlc = 8;
+        r.isExt = true;
+        r.tsUs = 0;
+        r.data[0] = in.data[0];
+        r.data[1] = in.data[1];
+        r.data[2] = 0;
+        r.data[3] = 0;
+        memcpy(&r.data[4], v, 4);
+        break;
+    }
+    case RS02Type::WRITE_PARAM:
+    {
+        uint16_t index = (uint16_t)(in.data[0] | (in.data[1] << 8));
+        _stats.paramWrites++;
+        if (!writeParam(index, &in.data[4]))
+            _stats.rejected++;
+        feedback(out[n++]);
+        break;
+    }
+    case RS02Type::SAVE_PARAMS:
+        for (uint8_t i = 0; i < _nParams; i++)
+            _p[i].saved = _p[i].raw;
+        feedback(out[n++]);
+        break;
+    case RS02Type::ACTIVE_REPORT:
+        _report = in.data[6] != 0;
+        _reportAccS = 0.0f;
+        break;
+    case RS02Type::PROTOCOL:
+        if (in.data[6] <= 2)
+            _pendingProtocol = in.data[6]; // 再起動後に反映
+        break;
+    default:
+        _stats.rejected++;
+        break;
+    }
+    _stats.txFrames += n;
+    return n;
+}
+
+float RS02SimMotor::reportIntervalS() const
+{
+    // EPScan_time: 1=10ms, 以降 1 増えるごとに +5ms
+    const Param *p = findParam(RS02Idx::IDX_EPSCAN_TIME);
+    uint32_t t = p ? p->raw : 1;
+    if (t < 1)
+        t = 1;
+    return 0.010f + 0.005f * (float)(t - 1);
+}
+
+bool RS02SimMotor::takeReport(RS02PrivFrame &out)
+{
+    if (!_report || _protocol != 0)
+        return false;
+    float iv = reportIntervalS();
+    if (_reportAccS < iv)
+        return false;
+    _reportAccS -= iv;
+    if (_reportAccS > iv)
+        _reportAccS = 0.0f; // 取りこぼしは追いかけない
+    feedback(out);
+    _stats.reports++;
+    _stats.txFrames++;
+    return true;
+}
+
+// ===== 物理 =====
+void RS02SimMotor::control(float dt)
+{
+    using namespace RS02Idx;
+    if (_st.state != RS02MotorState::RUN || _st.faultBits)
+    {
+        _st.iqRefA = 0.0f;
+        return;
+    }
+    const float kt = _model.kt;
+    float limCur = fminf(paramF(LIMIT_CUR), _model.peakCurA);
+    float limTq = fminf(paramF(LIMIT_TORQUE), _model.torqueMax);
+    limCur = fminf(limCur, limTq / kt);
+    float iq = 0.0f;
+
+    // 速度 PI（SPD_KI は 1ms サンプル当たりのゲイン）
+    auto speedLoop = [&](float vRef) {
+        float err = vRef - _st.velRadS;
+        _spdInteg = clampf(_spdInteg + paramF(SPD_KI) * err * (dt / 0.001f), limCur);
+        return paramF(SPD_KP) * err + _spdInteg;
+    };
+
+    switch (_st.runMode)
+    {
+    case 0: // Operation（Type1: MIT）
+    {
+        float tq = _opT + _opKp * (_opP - (float)_st.posRad) + _opKd * (_opV - _st.velRadS);
+        iq = clampf(tq, limTq) / kt;
+        break;
+    }
+    case 1: // PP: 加速度・速度上限つきで目標位置へ
+    {
+        float err = paramF(LOC_REF) - (float)_st.posRad;
+        float vmax = fabsf(paramF(LIMIT_SPD));
+        float acc = fabsf(paramF(ACC_RAD));
+        // 減速距離を考慮した速度指令
+        float vStop = sqrtf(2.0f * acc * fabsf(err));
+        float vCmd = clampf(copysignf(fminf(vStop, vmax), err), vmax);
+        vCmd = clampf(vCmd, fabsf(paramF(LOC_KP) * err));
+        float dv = clampf(vCmd - _ppVel, acc * dt);
+        _ppVel += dv;
+        iq = speedLoop(_ppVel);
+        break;
+    }
+    case 2: // Velocity: ACC_RAD でランプ
+    {
+        float ref = paramF(SPD_REF);
+        float acc = fabsf(paramF(ACC_RAD));
+        _spdRamp += clampf(ref - _spdRamp, acc * dt);
+        iq = speedLoop(_spdRamp);
+        break;
+    }
+    case 3: // Current
+        iq = paramF(IQ_REF);
+        break;
+    case 5: // CSP
+    {
+        float err = paramF(LOC_REF) - (float)_st.posRad;
+        float vCmd = clampf(paramF(LOC_KP) * err, paramF(LIMIT_SPD));
+        iq = speedLoop(vCmd);
+        break;
+    }
+    default:
+        break;
+    }
+    _st.iqRefA = clampf(iq, limCur);
+}
+
+void RS02SimMotor::step(float dt)
+{
+    if (dt <= 0.0f)
+        return;
+    if (_report)
+        _reportAccS += dt;
+    const RS02SimModel &m = _model;
+    while (dt > 0.0f)
+    {
+        float h = dt > SUBSTEP_S ? SUBSTEP_S : dt;
+        dt -= h;
+        control(h);
+
+        // 電流ループ（一次遅れの厳密離散化）
+        _st.iqA += (_st.iqRefA - _st.iqA) * (1.0f - expf(-h / m.curTauS));
+        _st.torqueNm = m.kt * _st.iqA;
+
+        // 剛体: 半陰的オイラー + クーロン摩擦（静止摩擦で停止）
+        float drive = _st.torqueNm - _loadNm - m.viscous * _st.velRadS;
+        float v = _st.velRadS;
+        if (fabsf(v) < 1e-4f && fabsf(drive) <= m.coulomb)
+            v = 0.0f;
+        else
+        {
+            float fr = v != 0.0f ? copysignf(m.coulomb, v) : copysignf(m.coulomb, drive);
+            float vn = v + (drive - fr) / m.inertia * h;
+            if (v != 0.0f && (vn > 0.0f) != (v > 0.0f))
+                vn = 0.0f; // 摩擦で反転しない
+            v = vn;
+        }
+        _st.velRadS = v;
+        _st.posRad += (double)v * h;
+
+        // 発熱（I^2R）と放熱
+        float heat = _st.iqA * _st.iqA * m.resistance * 0.02f;
+        _st.tempC += (heat - (_st.tempC - 25.0f) / m.thermalTauS) * h;
+        if (_st.tempC > m.overTempC)
+            _st.faultBits |= RS02Fault::OVERTEMP;
+    }
+}
@@ -0,0 +1,149 @@
+#pragma once
+// RS02SimMotor.h — RS02/RS05 モータのソフトウェアモデル（プライベートプロトコル応答 + 物理）
+// 送受信路には依存しない: handle() に受信フレームを渡すと応答フレームを返し、
+// step(dt) で物理を進める。仮想CANバスへの接続は RS02SimBus。
+//
+// 対応: Type0(ID/UID) / 1(運転制御) / 3(有効) / 4(停止, 故障クリア) / 7(ID変更) /
+//       17(読出) / 18(書込) / 22(保存) / 24(アクティブレポート) / 25(プロトコル切替)
+// 物理: 剛体（慣性 + 粘性 + クーロン摩擦 + 外部負荷）+ 電流ループ（一次遅れ）
+
+#include <stdint.h>
+#include "RS02Types.h"
+
+struct RS02SimModel
+{
+    const char *name;
+    // Type1/Type2 の符号化範囲
+    float posMax;
+    float velMax;
+    float torqueMax;
+    float kpMax;
+    float kdMax;
+    // 電気/機械
+    float peakCurA;   // LIMIT_CUR 既定値
+    float kt;         // トルク定数 [Nm/A]
+    float inertia;    // 出力軸換算 [kg m^2]
+    float viscous;    // [Nm/(rad/s)]
+    float coulomb;    // [Nm]
+    float curTauS;    // 電流ループ時定数 [s]
+    float resistance; // 巻線抵抗 [ohm]（発熱）
+    float thermalTauS;
+    float overTempC;
+
+    static RS02SimModel rs02();
+    static RS02SimModel rs05();
+};
+
+// 物理状態（観測用）
+struct RS02SimState
+{
+    double posRad = 0.0; // 多回転
+    float velRadS = 0.0f;
+    float iqA = 0.0f;
+    float iqRefA = 0.0f;
+    float torqueNm = 0.0f;
+    float tempC = 25.0f;
+    uint8_t state = RS02MotorState::RESET; // Type2 モードビット
+    uint8_t runMode = 0;
+    uint16_t faultBits = 0;
+};
+
+struct RS02SimStats
+{
+    uint32_t rxFrames = 0; // 自分宛て
+    uint32_t txFrames = 0;
+    uint32_t reports = 0;
+    uint32_t paramReads = 0;
+    uint32_t paramWrites = 0;
+    uint32_t rejected = 0; // 未知 index / 読み出し専用への書込
+};
+
+class RS02SimMotor
+{
+public:
+    static constexpr uint8_t MAX_REPLIES = 2;
+    static constexpr uint8_t MAX_PARAMS = 32;
+
+    enum ParamType : uint8_t
+    {
+        P_U8,
+        P_U16,
+        P_F32
+    };
+
+    RS02SimMotor(uint8_t motorId, uint64_t uid, const RS02SimModel &model = RS02SimModel::rs02());
+
+    uint8_t id() const { return _id; }
+    uint64_t uid() const { return _uid; }
+    const RS02SimModel &model() const { return _model; }
+    const RS02SimState &state() const { return _st; }
+    const RS02SimStats &stats() const { return _stats; }
+    bool activeReport() const { return _report; }
+    uint8_t protocol() const { return _protocol; }
+
+    // 受信フレームを処理。応答を out[] に書いて個数を返す（自分宛てでなければ 0）
+    uint8_t handle(const RS02PrivFrame &in, RS02PrivFrame out[MAX_REPLIES]);
+
+    // 物理を dt 秒進める（内部で 250us 以下に分割）
+    void step(float dt);
+    // アクティブレポートの周期が来ていれば Type2 を1枚返す（step() の後に呼ぶ）
+    bool takeReport(RS02PrivFrame &out);
+
+    // 外乱/故障注入
+    void setLoadTorque(float nm) { _loadNm = nm; }
+    void injectFault(uint16_t bits) { _st.faultBits |= bits & RS02Fault::ALL; }
+    void setPosition(double rad) { _st.posRad = rad; }
+
+    // 電源再投入: 保存済みパラメータ（CAN_ID 含む）と保留中のプロトコル切替を反映
+    void powerCycle();
+
+    // パラメータ（テスト用の直接アクセス）
+    bool readParam(uint16_t index, uint8_t out4LE[4]) const;
+    bool writeParam(uint16_t index, const uint8_t v4LE[4]);
+    float paramF(uint16_t index) const;
+
+private:
+    struct Param
+    {
+        uint16_t index;
+        ParamType type;
+        bool writable;
+        uint32_t raw;   // RAM 値（LE 4byte を整数で保持）
+        uint32_t saved; // Type22 で保存した値
+    };
+
+    RS02SimModel _model;
+    uint8_t _id;
+    uint64_t _uid;
+    uint8_t _host = 0xFD;
+    uint8_t _protocol = 0; // 0=private（1=CANopen, 2=MIT は再起動後に無応答）
+    uint8_t _pendingProtocol = 0;
+    bool _report = false;
+    float _reportAccS = 0.0f;
+
+    Param _p[MAX_PARAMS];
+    uint8_t _nParams = 0;
+
+    RS02SimState _st;
+    RS02SimStats _stats;
+    float _loadNm = 0.0f;
+    // 制御器
+    float _spdInteg = 0.0f;
+    float _spdRamp = 0.0f;
+    float _ppVel = 0.0f;
+    // Type1 指令
+    float _opT = 0.0f, _opP = 0.0f, _opV = 0.0f, _opKp = 0.0f, _opKd = 0.0f;
+
+    void addParam(uint16_t index, ParamType type, bool writable, uint32_t raw);
+    Param *findParam(uint16_t index);
+    const Param *findParam(uint16_t index) const;
+    void setF(uint16_t index, float v);
+    uint32_t liveValue(const Param &p) const;
+
+    void enable();
+    void disable();
+    void resetControllers();
+    void control(float dt);
+    float reportIntervalS() const;
+    void feedback(RS02PrivFrame &out) const;
+};
@@ -0,0 +1,83 @@
+// gateway — TWAI ⇔ MCP2515 ゲートウェイのファームウェア（M5Stack CoreS3 + CAN ユニット + MCP2515 基板）
+// 片側（PC ツール / 上位機のバス）で受けたフレームをもう片側（モータのバス）へ、応答を逆向きに転送する。
+// 既定はすべて転送。GW_MOTOR_FIRST..GW_MOTOR_LAST を指定すると TWAI → MCP2515 はその範囲のモータ宛てだけ
+// 1 秒ごとに方向ごとの 受信 / 転送 / 落ちた数 / 遅れ をシリアルへ
+//   pio run -e m5stack-cores3-gateway -t upload
+#include <M5Unified.h>
+#include <SPI.h>
+#include <mcp_can.h>
+#include "RS02PrivateCAN.h"
+#include "RS02PrivateTWAI.h"
+#include "RS02Gateway.h"
+
+constexpr uint8_t HOST_ID = 0xFD; // ゲートウェイ自身は要求を出さない（sendExt で中継するだけ）
+
+#ifndef TWAI_TX_GPIO
+#define TWAI_TX_GPIO 17 // CoreS3 Port C
+#endif
+#ifndef TWAI_RX_GPIO
+#define TWAI_RX_GPIO 18
+#endif
+#define CAN_CS_PIN 6
+#define CAN_BAUD CAN_1000KBPS
+#define MCP_CLOCK MCP_8MHZ // 16MHz基板なら MCP_16MHZ
+
+RS02PrivateTWAI RS_A(HOST_ID, TWAI_TX_GPIO, TWAI_RX_GPIO);
+MCP_CAN CAN(CAN_CS_PIN);
+RS02PrivateCAN RS_B(CAN, HOST_ID);
+RS02Gateway GW(RS_A, RS_B);
+
+static uint32_t nextPrintMs = 0;
+
+static void printStats(const char *name, const RS02GatewayStats &s)
+{
+  Serial.printf("[GW] %s rx=%lu fwd=%lu filt=%lu rate=%lu full=%lu stale=%lu depth=%u lat=%.0f/%luus\n", name,
+                (unsigned long)s.rx, (unsigned long)s.forwarded, (unsigned long)s.filtered, (unsigned long)s.rateDropped,
+                (unsigned long)s.ringFull, (unsigned long)s.stale, s.maxDepth,
+                s.forwarded ? (double)s.totalLatencyUs / s.forwarded : 0.0, (unsigned long)s.maxLatencyUs);
+}
+
+void setup()
+{
+  auto cfg = M5.config();
+  M5.begin(cfg);
+  Serial.begin(115200);
+  delay(50);
+
+  RS_A.setQueueForMotors(16); // 転送は待たずに渡し、渡せなければリングに残して次の service で
+  RS_A.setTxTimeoutMs(0);
+  if (!RS_A.begin())
+  {
+    Serial.println("[TWAI] begin FAIL");
+    while (1)
+      delay(1000);
+  }
+  SPI.begin();
+  if (CAN.begin(MCP_ANY, CAN_BAUD, MCP_CLOCK) != CAN_OK)
+  {
+    Serial.println("[CAN] begin FAIL");
+    while (1)
+      delay(1000);
+  }
+  CAN.setMode(MCP_NORMAL);
+  RS_B.begin();
+
+#if defined(GW_MOTOR_FIRST) && defined(GW_MOTOR_LAST)
+  for (uint8_t id = GW_MOTOR_FIRST; id <= GW_MOTOR_LAST; id++)
+    GW.addFilter(RS02GwDir::AtoB, RS02GwFilter::toMotor(id));
+#endif
+  GW.begin();
+  Serial.println("[GW] TWAI <-> MCP2515 running");
+}
+
+void loop()
+{
+  GW.service();
+
+  if ((int32_t)(millis() - nextPrintMs) >= 0)
+  {
+    nextPrintMs = millis() + 1000;
+    printStats("TWAI->MCP", GW.stats(RS02GwDir::AtoB));
+    printStats("MCP->TWAI", GW.stats(RS02GwDir::BtoA));
+  }
+}
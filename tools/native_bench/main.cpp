@@ -0,0 +1,338 @@
+// native_bench — RS02 プロトコルのホットパスのマイクロベンチマーク（ns/op, 確保回数/op, SPI バイト・時間/op）
+// バスはモック（RS02PrivateBase 派生）、MCP2515 は SPI モック（全バイト 0 応答 = 送信バッファ常に空き）
+//   pio run -e native-bench && .pio/build/native-bench/program [--csv] [--filter str] [--min-ms N]
+//                                                            [--compare old.json [--threshold pct]]
+// 既定出力は JSON（1行1ベンチ）。--compare は前回結果と比べ、threshold% 以上遅くなったら exit 1
+#include <Arduino.h>
+#include <SPI.h>
+#include <mcp_can.h>
+#include "RS02PrivateBase.h"
+#include "RS02PrivateCAN.h"
+
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// ===== 確保回数（global new を数える） =====
+static std::atomic<uint64_t> g_allocs{0};
+
+void *operator new(size_t n)
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    void *p = malloc(n ? n : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+void *operator new[](size_t n) { return operator new(n); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+template <typename T>
+static inline void keep(const T &v)
+{
+    asm volatile("" : : "r,m"(v) : "memory");
+}
+
+// ===== モック =====
+// protected な静的ヘルパを外から呼ぶためのプローブ + 送受信モック
+class MockBus : public RS02PrivateBase
+{
+public:
+    using RS02PrivateBase::buildExId;
+    using RS02PrivateBase::float_to_uint;
+    using RS02PrivateBase::packF32LE;
+    using RS02PrivateBase::uint_to_float;
+
+    MockBus() : RS02PrivateBase(0xFD) {}
+    bool begin() override { return true; }
+
+    // Type17 要求に対し、無関係フレーム noise 枚の後に応答を返す
+    uint8_t noise = 0;
+    uint32_t sent = 0;
+
+protected:
+    bool hwSend(unsigned long id, const uint8_t *payload, uint8_t len) override
+    {
+        sent++;
+        keep(payload[len ? len - 1 : 0]);
+        if (rs02FrameType(id) == RS02Type::READ_PARAM)
+        {
+            _n = 0;
+            _head = 0;
+            uint8_t dst = rs02FrameDst(id);
+            for (uint8_t i = 0; i < noise && _n < QN; i++)
+            {
+                RS02PrivFrame &f = _q[_n++];
+                f.id = ((uint32_t)RS02Type::FEEDBACK << 24) | ((uint32_t)(dst + 1) << 8) | 0xFD;
+                f.dlc = 8;
+                f.isExt = true;
+            }
+            RS02PrivFrame &r = _q[_n++];
+            r.id = ((uint32_t)RS02Type::READ_PARAM << 24) | ((uint32_t)dst << 8) | 0xFD;
+            r.dlc = 8;
+            r.isExt = true;
+            r.data[0] = payload[0];
+            r.data[1] = payload[1];
+            float v = 1.25f;
+            memcpy(&r.data[4], &v, 4);
+        }
+        return true;
+    }
+    bool hwRead(RS02PrivFrame &out) override
+    {
+        if (_head >= _n)
+            return false;
+        out = _q[_head++];
+        return true;
+    }
+
+private:
+    static constexpr uint8_t QN = 16;
+    RS02PrivFrame _q[QN];
+    uint8_t _n = 0;
+    uint8_t _head = 0;
+};
+
+// MCP2515 の SPI モック: 何を読んでも 0（TXREQ=0, 受信なし）
+class MockSpi : public ShimSpiDevice
+{
+public:
+    void select() override {}
+    void deselect() override {}
+    uint8_t transfer(uint8_t mosi) override
+    {
+        keep(mosi);
+        return 0x00;
+    }
+};
+
+// ===== 計測 =====
+struct Result
+{
+    std::string name;
+    uint64_t iters = 0;
+    double nsPerOp = 0.0; // 中央値
+    double nsMin = 0.0;
+    double allocsPerOp = 0.0;
+    double spiBytesPerOp = 0.0;
+    double spiTransPerOp = 0.0;
+    double spiNsPerOp = 0.0; // SPI クロック + トランザクション間隔から見積もった実機の SPI 時間
+};
+
+static double g_minMs = 200.0;
+static const int REPEATS = 5;
+
+template <typename Fn>
+static Result runBench(const char *name, Fn fn)
+{
+    using clk = std::chrono::steady_clock;
+    Result r;
+    r.name = name;
+
+    // 1回あたり ~g_minMs/REPEATS になる反復数を探す
+    uint64_t n = 16;
+    for (;;)
+    {
+        auto t0 = clk::now();
+        for (uint64_t i = 0; i < n; i++)
+            fn(i);
+        double ms = std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+        if (ms >= g_minMs / REPEATS || n >= (1ULL << 32))
+            break;
+        n = ms < 0.01 ? n * 16 : (uint64_t)(n * (g_minMs / REPEATS) / ms * 1.1) + 1;
+    }
+
+    std::vector<double> ns;
+    uint64_t a0 = g_allocs.load();
+    SPI.resetStats();
+    for (int rep = 0; rep < REPEATS; rep++)
+    {
+        auto t0 = clk::now();
+        for (uint64_t i = 0; i < n; i++)
+            fn(i);
+        ns.push_back(std::chrono::duration<double, std::nano>(clk::now() - t0).count() / (double)n);
+    }
+    uint64_t total = n * REPEATS;
+    std::sort(ns.begin(), ns.end());
+    r.iters = total;
+    r.nsPerOp = ns[REPEATS / 2];
+    r.nsMin = ns[0];
+    r.allocsPerOp = (double)(g_allocs.load() - a0) / (double)total;
+    r.spiBytesPerOp = (double)SPI.stats().bytes / (double)total;
+    r.spiTransPerOp = (double)SPI.stats().transactions / (double)total;
+    r.spiNsPerOp = (double)SPI.stats().busyNs / (double)total;
+    return r;
+}
+
+// ===== 前回結果との比較 =====
+static bool loadJson(const char *path, std::vector<Result> &out)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return false;
+    char line[512];
+    while (fgets(line, sizeof(line), fp))
+    {
+        char name[128];
+        double ns = 0.0;
+        const char *p = strstr(line, "\"name\":\"");
+        const char *q = strstr(line, "\"ns_per_op\":");
+        if (!p || !q || sscanf(p, "\"name\":\"%127[^\"]\"", name) != 1 || sscanf(q, "\"ns_per_op\":%lf", &ns) != 1)
+            continue;
+        Result r;
+        r.name = name;
+        r.nsPerOp = ns;
+        out.push_back(r);
+    }
+    fclose(fp);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    bool csv = false;
+    const char *filter = nullptr;
+    const char *compare = nullptr;
+    double threshold = 10.0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--csv"))
+            csv = true;
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+            filter = argv[++i];
+        else if (!strcmp(argv[i], "--min-ms") && i + 1 < argc)
+            g_minMs = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--compare") && i + 1 < argc)
+            compare = argv[++i];
+        else if (!strcmp(argv[i], "--threshold") && i + 1 < argc)
+            threshold = atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--csv] [--filter str] [--min-ms N] [--compare old.json [--threshold pct]]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // 仮想時間: mcp_can のタイムアウト待ちや SPI 転送で実時間を使わない
+    ArduinoShim::useVirtualTime(true);
+    MockSpi spiMock;
+    SPI.attach(6, &spiMock);
+    SPI.begin();
+    MCP_CAN mcp(6);
+    RS02PrivateCAN mcpBus(mcp, 0xFD);
+    MockBus bus;
+
+    // Type2 の実フレーム（parseFeedback 用）
+    RS02PrivFrame fb;
+    fb.id = ((uint32_t)RS02Type::FEEDBACK << 24) | (2UL << 22) | (0x7FUL << 8) | 0xFD;
+    fb.dlc = 8;
+    fb.isExt = true;
+    const uint8_t fbData[8] = {0x80, 0x12, 0x7F, 0xA0, 0x80, 0x40, 0x01, 0x2C};
+    memcpy(fb.data, fbData, 8);
+    const uint8_t payload[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+    std::vector<Result> results;
+    auto want = [&](const char *name) { return !filter || strstr(name, filter); };
+    auto add = [&](const Result &r) { results.push_back(r); };
+
+    volatile float fin = 1.2345f;
+    if (want("buildExId"))
+        add(runBench("buildExId", [&](uint64_t i) { keep(MockBus::buildExId(0x12, (uint16_t)(0xFD00 + (i & 0xFF)), (uint8_t)i)); }));
+    if (want("packF32LE"))
+        add(runBench("packF32LE", [&](uint64_t i) {
+            uint8_t p[4];
+            MockBus::packF32LE(fin + (float)(i & 7), p);
+            keep(p[3]);
+        }));
+    if (want("float_to_uint"))
+        add(runBench("float_to_uint", [&](uint64_t i) { keep(MockBus::float_to_uint(fin * (float)(i & 15) - 10.0f, -12.57f, 12.57f)); }));
+    if (want("opControl"))
+        add(runBench("opControl", [&](uint64_t i) { bus.opControl(0x7F, 1.0f, fin, 2.0f + (float)(i & 3), 10.0f, 0.5f); }));
+    if (want("writeFloatParam"))
+        add(runBench("writeFloatParam", [&](uint64_t i) { bus.writeFloatParam(0x7F, RS02Idx::SPD_REF, fin + (float)(i & 3)); }));
+    if (want("parseFeedback"))
+        add(runBench("parseFeedback", [&](uint64_t i) {
+            RS02Feedback out;
+            fb.data[1] = (uint8_t)i;
+            bus.parseFeedback(fb, out);
+            keep(out.angleRad);
+        }));
+    if (want("readParamRaw"))
+    {
+        bus.noise = 0;
+        add(runBench("readParamRaw", [&](uint64_t) {
+            uint8_t v[4];
+            keep(bus.readParamRaw(0x7F, RS02Idx::MECH_POS, v));
+        }));
+        bus.noise = 8;
+        add(runBench("readParamRaw_noise8", [&](uint64_t) {
+            uint8_t v[4];
+            keep(bus.readParamRaw(0x7F, RS02Idx::MECH_POS, v));
+        }));
+    }
+    if (want("sendExt_mock"))
+        add(runBench("sendExt_mock", [&](uint64_t i) { keep(bus.sendExt(0x12FD007FUL, payload, (uint8_t)(8 - (i & 1)))); }));
+    if (want("sendExt_mcp"))
+        add(runBench("sendExt_mcp", [&](uint64_t) { keep(mcpBus.sendExt(0x12FD007FUL, payload, 8)); }));
+    if (want("mcp_sendMsgBuf"))
+        add(runBench("mcp_sendMsgBuf", [&](uint64_t) { keep(mcp.sendMsgBuf(0x12FD007FUL, 1, 8, const_cast<uint8_t *>(payload))); }));
+    if (want("readAny_mcp_empty"))
+        add(runBench("readAny_mcp_empty", [&](uint64_t) {
+            RS02PrivFrame f;
+            keep(mcpBus.readAny(f));
+        }));
+
+    if (csv)
+    {
+        printf("name,iters,ns_per_op,ns_min,allocs_per_op,spi_bytes_per_op,spi_trans_per_op,spi_ns_per_op\n");
+        for (const Result &r : results)
+            printf("%s,%llu,%.2f,%.2f,%.3f,%.2f,%.2f,%.0f\n", r.name.c_str(), (unsigned long long)r.iters, r.nsPerOp, r.nsMin,
+                   r.allocsPerOp, r.spiBytesPerOp, r.spiTransPerOp, r.spiNsPerOp);
+    }
+    else
+    {
+        printf("[\n");
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const Result &r = results[i];
+            printf("  {\"name\":\"%s\",\"iters\":%llu,\"ns_per_op\":%.2f,\"ns_min\":%.2f,\"allocs_per_op\":%.3f,"
+                   "\"spi_bytes_per_op\":%.2f,\"spi_trans_per_op\":%.2f,\"spi_ns_per_op\":%.0f}%s\n",
+                   r.name.c_str(), (unsigned long long)r.iters, r.nsPerOp, r.nsMin, r.allocsPerOp, r.spiBytesPerOp,
+                   r.spiTransPerOp, r.spiNsPerOp, i + 1 < results.size() ? "," : "");
+        }
+        printf("]\n");
+    }
+
+    if (!compare)
+        return 0;
+    std::vector<Result> old;
+    if (!loadJson(compare, old))
+    {
+        fprintf(stderr, "cannot read %s\n", compare);
+        return 2;
+    }
+    int regressions = 0;
+    for (const Result &r : results)
+    {
+        for (const Result &o : old)
+        {
+            if (o.name != r.name || o.nsPerOp <= 0.0)
+                continue;
+            double pct = (r.nsPerOp - o.nsPerOp) / o.nsPerOp * 100.0;
+            bool bad = pct > threshold;
+            fprintf(stderr, "%-22s %10.2f -> %10.2f ns  %+6.1f%%%s\n", r.name.c_str(), o.nsPerOp, r.nsPerOp, pct,
+                    bad ? "  REGRESSION" : "");
+            regressions += bad;
+        }
+    }
+    return regressions ? 1 : 0;
+}
@@ -0,0 +1,177 @@
+// native_commission — ID の一括変更（RS02Commission）を 1Mbps の仮想バスで確かめる
+// 1) 衝突: 入れ替え（1↔2）/ 玉突き（3→4→5→30）/ 見つからない / ID 21 に 2 台 / 同じ新 ID が 2 行 /
+//    新 ID に動かないモータ / 運転中（Type7 が効かない）を混ぜた対応表。電源を入れ直して保存されたかも見る
+// 2) 時間: 応答の遅いモータ（2ms）16 台を 1..16 → 101..116 へ。changeID.cpp の applyChange と同じ手順
+//    （Type7 → 20ms ごとに 0x200A を読み戻し → Type22 を 1 台ずつ）と比べる（TWAI / MCP2515）
+// （結果が表と違う / 保存されていない / 受信あふれ / 1 台ずつより遅い なら exit 1）
+//   pio run -e native-commission && .pio/build/native-commission/program
+#include <Arduino.h>
+#include <RS02SimBench.h>
+#include "RS02Commission.h"
+
+static constexpr uint8_t N_TIMING = 16;
+static constexpr uint32_t SLOW_REPLY_US = 2000;
+
+using RS02SimCheck::check;
+using Bench = RS02SimBench;
+
+// changeID.cpp の applyChange と同じ: Type7 → 20ms ごとに 0x200A を 800ms まで読み戻し → Type22
+static bool applyChangeLike(RS02PrivateBase &rs, uint8_t curId, uint8_t newId)
+{
+    if (!rs.setMotorId(curId, newId))
+        return false;
+    uint32_t t0 = millis();
+    bool ok = false;
+    while (millis() - t0 < 800)
+    {
+        uint8_t le[4];
+        if (rs.readParamRaw(newId, RS02Idx::CAN_ID, le) && le[0] == newId)
+        {
+            ok = true;
+            break;
+        }
+        delay(20);
+    }
+    return ok && rs.saveParams(newId);
+}
+
+static uint64_t uidOf(RS02SimBus &sim, uint8_t id) { return sim.motor(id) ? sim.motor(id)->uid() : 0; }
+
+static void conflicts()
+{
+    using R = RS02CommissionResult;
+    Bench b(100);
+    for (uint8_t id = 1; id <= 9; id++)
+        b.sim.add(id);
+    b.sim.add(21);
+    b.dup.add(21, 0x0123456789ABCDEFULL);
+    b.sim.add(40);
+    b.sim.add(50);
+    const uint64_t u1 = uidOf(b.sim, 1), u2 = uidOf(b.sim, 2), u6 = uidOf(b.sim, 6);
+    const uint64_t u3 = uidOf(b.sim, 3), u4 = uidOf(b.sim, 4), u5 = uidOf(b.sim, 5);
+    delay(5);
+    // 運転中のモータ（Type7 が効かない）
+    b.twai.enable(9);
+    delay(5);
+    b.drain();
+
+    RS02Commission cm(b.twai);
+    cm.addUid(u1, 2);               // 0: 入れ替え
+    cm.addUid(u2, 1);               // 1
+    cm.addId(3, 4);                 // 2: 玉突き 3→4→5→30
+    cm.addId(4, 5);                 // 3
+    cm.addId(5, 30);                // 4
+    cm.addUid(0x1111222233334444ULL, 60); // 5: 居ない UID
+    cm.addId(21, 61);               // 6: ID 21 に 2 台
+    cm.addUid(u6, 62);              // 7: 同じ新 ID が 2 行
+    cm.addId(7, 62);                // 8
+    cm.addId(8, 40);                // 9: 40 は動かない
+    cm.addId(9, 63);                // 10: 運転中
+    cm.addId(50, 50);               // 11: そのまま
+    cm.run();
+    b.drain();
+    cm.print(Serial);
+
+    const R want[] = {R::Ok, R::Ok, R::Ok, R::Ok, R::Ok, R::NotFound, R::SourceConflict, R::TargetConflict,
+                      R::TargetConflict, R::TargetBusy, R::NoReply, R::Unchanged};
+    bool match = cm.count() == sizeof(want) / sizeof(want[0]);
+    for (uint8_t i = 0; match && i < cm.count(); i++)
+        match = cm.item(i).result == want[i];
+    check(match, "each row gets the expected outcome");
+    check(cm.stats().cycles == 1 && cm.item(0).viaId != 0xFF, "the 1<->2 swap goes through one free ID");
+    bool saved = true;
+    for (uint8_t i = 0; i < 5; i++)
+        saved &= cm.item(i).saved;
+    check(saved && cm.stats().ok == 5, "every changed motor acknowledged the Type22 save");
+
+    // 電源を入れ直して、保存した ID で居るか
+    b.twai.stop(9, false);
+    delay(5);
+    b.sim.powerCycleAll();
+    b.dup.powerCycleAll();
+    delay(5);
+    b.drain();
+    RS02Scanner sc(b.twai);
+    sc.scan();
+    b.drain();
+    auto at = [&](uint8_t id, uint64_t uid) {
+        const RS02ScanEntry *e = sc.find(id);
+        return e && e->uid == uid;
+    };
+    check(at(2, u1) && at(1, u2) && at(4, u3) && at(5, u4) && at(30, u5) && !sc.find(3) && at(6, u6) &&
+              at(9, uidOf(b.sim, 9)) && sc.find(21) && sc.find(21)->conflict,
+          "after a power cycle the new IDs stick and the rejected motors did not move");
+}
+
+struct Timing
+{
+    uint32_t us;
+    uint8_t ok;
+    uint32_t lost;
+};
+
+static Timing timing(bool mcp, bool engine)
+{
+    Bench b(SLOW_REPLY_US);
+    for (uint8_t id = 1; id <= N_TIMING; id++)
+        b.sim.add(id);
+    delay(5);
+    b.drain();
+    RS02PrivateBase &rs = mcp ? (RS02PrivateBase &)b.can : (RS02PrivateBase &)b.twai;
+    uint32_t lost0 = mcp ? b.lostCan.lost : b.lostTwai.lost;
+    Timing t = {0, 0, 0};
+    uint32_t t0 = micros();
+    if (engine)
+    {
+        RS02Commission cm(rs);
+        for (uint8_t id = 1; id <= N_TIMING; id++)
+            cm.addId(id, (uint8_t)(100 + id));
+        RS02CommissionConfig cfg;
+        cfg.scan.expect = N_TIMING;
+        t.ok = cm.run(cfg);
+        t.us = micros() - t0;
+        for (uint8_t i = 0; i < cm.count(); i++)
+            if (!cm.item(i).saved)
+                t.ok--;
+        if (!mcp)
+            cm.print(Serial);
+    }
+    else
+    {
+        for (uint8_t id = 1; id <= N_TIMING; id++)
+            t.ok += applyChangeLike(rs, id, (uint8_t)(100 + id));
+        t.us = micros() - t0;
+    }
+    t.lost = (mcp ? b.lostCan.lost : b.lostTwai.lost) - lost0;
+    b.drain();
+    // 全台が新 ID に居るか
+    bool moved = true;
+    for (uint8_t id = 1; id <= N_TIMING; id++)
+        moved &= b.sim.motor((uint8_t)(100 + id)) != nullptr;
+    if (!moved)
+        t.ok = 0;
+    return t;
+}
+
+int main()
+{
+    ArduinoShim::useVirtualTime(true);
+
+    conflicts();
+
+    Timing seqT = timing(false, false), engT = timing(false, true);
+    Timing seqM = timing(true, false), engM = timing(true, true);
+    Serial.printf("\n%u motors 1..%u -> 101..%u, motor reply latency %luus\n", N_TIMING, N_TIMING, 100 + N_TIMING,
+                  (unsigned long)SLOW_REPLY_US);
+    Serial.printf("  %-44s %10s %6s\n", "", "time", "ok");
+    Serial.printf("  %-44s %8.1fms %6u\n", "applyChange one by one (twai, IDs known)", seqT.us / 1000.0f, seqT.ok);
+    Serial.printf("  %-44s %8.1fms %6u\n", "RS02Commission (twai, incl. scan + save)", engT.us / 1000.0f, engT.ok);
+    Serial.printf("  %-44s %8.1fms %6u\n", "applyChange one by one (mcp2515, IDs known)", seqM.us / 1000.0f, seqM.ok);
+    Serial.printf("  %-44s %8.1fms %6u\n", "RS02Commission (mcp2515, incl. scan + save)", engM.us / 1000.0f, engM.ok);
+    check(engT.ok == N_TIMING && engM.ok == N_TIMING && seqT.ok == N_TIMING && seqM.ok == N_TIMING,
+          "every motor moved and saved in all four runs");
+    check(engT.lost == 0 && engM.lost == 0, "no receive overruns while commissioning");
+    check(engT.us < seqT.us && engM.us < seqM.us, "the concurrent engine beats one-by-one even including the scan");
+
+    return RS02SimCheck::finish();
+}
@@ -0,0 +1,197 @@
+// native_dashboard — 複数モータのダッシュボード（RS02Telemetry + RS02UiDashboard）
+// 1Mbps 仮想バスに 16 台のシミュレータ（Type2 能動報告 10ms）。ダッシュボードを 100ms ごとに更新し、
+// タイル 16 枚 / 1 枚で表示のためのホスト送信が 0 か（比較: タイルごとに Type17 で 5 項目読む方式）、
+// 止まっているモータのタイルを描き直さないか、動いている / 故障 / 報告が止まった モータのタイルだけ変わるかを確かめる
+// （表示でバスに送る / 変わらないタイルを描く / 故障・鮮度が出ない なら exit 1）
+//   pio run -e native-dashboard && .pio/build/native-dashboard/program
+#include <Arduino.h>
+#include <RS02SimCheck.h>
+#include <driver/twai.h>
+#include <VirtualCanBus.h>
+#include <RS02SimBus.h>
+#include "RS02PrivateTWAI.h"
+#include "RS02Telemetry.h"
+#include "RS02UiDashboard.h"
+
+#include <string.h>
+
+static constexpr uint8_t HOST_ID = 0xFD;
+static constexpr uint8_t N = 16;
+static constexpr int W = 320, H = 240, HEAD = 16;
+
+using RS02SimCheck::check;
+
+// ホストが送ったフレーム
+class TxCount : public RS02FrameListener
+{
+public:
+    uint32_t tx = 0;
+    void onTxFrame(const RS02PrivFrame &f, bool ok) override
+    {
+        (void)f;
+        tx += ok;
+    }
+};
+
+// パネル代役: 描いたタイルを数え、文字列がタイルに収まるか（6px 幅のフォントで 12 文字, 5 行）を見る
+struct Panel
+{
+    uint32_t tiles = 0;
+    uint64_t pixels = 0;
+    bool fits = true;
+    uint8_t drawn[N] = {};
+    char last[N][RS02_UI_TEXT] = {};
+    uint16_t color[N] = {};
+    void draw(uint8_t cell, const RS02UiRect &r, const char *text, uint16_t c)
+    {
+        tiles++;
+        pixels += (uint32_t)r.w * r.h;
+        drawn[cell]++;
+        strncpy(last[cell], text, RS02_UI_TEXT - 1);
+        color[cell] = c;
+        int lines = 1, col = 0;
+        for (const char *p = text; *p; p++)
+        {
+            if (*p == '\n')
+            {
+                lines++;
+                col = 0;
+            }
+            else if (++col > (r.w - 6) / 6)
+                fits = false;
+        }
+        if (lines > (r.h - 3) / 10)
+            fits = false;
+    }
+    void clear() { memset(drawn, 0, sizeof(drawn)); }
+};
+
+struct Bench
+{
+    VirtualCanBus bus{1000000};
+    RS02SimBus sim{&bus};
+    RS02PrivateTWAI can{HOST_ID, 1, 2};
+    RS02Telemetry tm{can};
+    TxCount txc;
+
+    Bench()
+    {
+        for (uint8_t id = 1; id <= N; id++)
+            sim.add(id);
+        ArduinoShim::attachTwai(&bus);
+        can.setQueueForMotors(N);
+        can.begin();
+        can.addListener(&txc);
+        tm.begin();
+        for (uint8_t id = 1; id <= N; id++)
+        {
+            tm.watch(id);
+            can.setActiveReport(id, true);
+        }
+    }
+    ~Bench() { ArduinoShim::attachTwai(nullptr); }
+
+    void drain()
+    {
+        RS02PrivFrame f;
+        while (can.readAny(f))
+        {
+        }
+    }
+    // ms のあいだ 1ms ごとに受信を読み、100ms ごとにダッシュボードを更新
+    void run(RS02UiDashboard &dash, Panel &p, uint32_t ms)
+    {
+        for (uint32_t t = 0; t < ms; t++)
+        {
+            drain();
+            if (t % 100 == 0)
+            {
+                dash.update();
+                dash.render([&p](uint8_t c, const RS02UiRect &r, const char *s, uint16_t col) { p.draw(c, r, s, col); });
+            }
+            delay(1);
+        }
+    }
+};
+
+// 比較: タイルごとに Type17 で 5 項目（位置 / 速度 / トルク相当 / 温度相当 / モード）を読む 1 回ぶん
+static uint32_t pollOnce(Bench &b, uint8_t tiles, uint32_t &us)
+{
+    static const uint16_t idx[5] = {RS02Idx::MECH_POS, RS02Idx::MECH_VEL, RS02Idx::IQ_REF, RS02Idx::LIMIT_CUR,
+                                    RS02Idx::RUN_MODE};
+    uint32_t tx0 = b.txc.tx, t0 = micros();
+    for (uint8_t id = 1; id <= tiles; id++)
+        for (uint16_t i : idx)
+        {
+            float v;
+            b.can.readFloatParam(id, i, v);
+        }
+    us = micros() - t0;
+    return b.txc.tx - tx0;
+}
+
+int main()
+{
+    ArduinoShim::useVirtualTime(true);
+    Bench b;
+    delay(20);
+    b.drain();
+
+    // 16 枚 / 1 枚: 表示のためのホスト送信
+    RS02UiDashboard dash16(b.tm), dash1(b.tm);
+    dash16.layout(0, HEAD, W, H - HEAD, 4, 4);
+    dash1.layout(0, HEAD, W, H - HEAD, 4, 4);
+    uint8_t added = dash16.addWatched();
+    dash1.add(1);
+    Panel p16, p1;
+    uint32_t tx0 = b.txc.tx, fr0 = b.tm.frames();
+    b.run(dash16, p16, 2000);
+    uint32_t tx16 = b.txc.tx - tx0, frames = b.tm.frames() - fr0;
+    tx0 = b.txc.tx;
+    b.run(dash1, p1, 2000);
+    uint32_t tx1 = b.txc.tx - tx0;
+    uint32_t poll16Us = 0, poll1Us = 0;
+    uint32_t poll16 = pollOnce(b, 16, poll16Us), poll1 = pollOnce(b, 1, poll1Us);
+    b.drain();
+
+    Serial.printf("%u motors, Type2 report 10ms, dashboard refresh 100ms, 2s per run\n", N);
+    Serial.printf("  %-28s %10s %14s\n", "", "host tx", "per refresh");
+    Serial.printf("  %-28s %10lu %14s\n", "telemetry tiles x16", (unsigned long)tx16, "0 frames");
+    Serial.printf("  %-28s %10lu %14s\n", "telemetry tiles x1", (unsigned long)tx1, "0 frames");
+    Serial.printf("  %-28s %10s %7lu / %4.1fms\n", "Type17 polling x16 (5 each)", "-", (unsigned long)poll16, poll16Us / 1000.0);
+    Serial.printf("  %-28s %10s %7lu / %4.1fms\n", "Type17 polling x1 (5 each)", "-", (unsigned long)poll1, poll1Us / 1000.0);
+    Serial.printf("  Type2 received %lu, tiles drawn %lu over 20 refreshes (first refresh draws all %u)\n", (unsigned long)frames,
+                  (unsigned long)p16.tiles, added);
+
+    check(added == N && b.tm.watched().has(16), "addWatched lays out a tile per watched motor");
+    check(tx16 == 0 && tx1 == 0 && tx16 == tx1, "16 tiles cost the same bus traffic as one (none: fed by Type2 reports)");
+    check(poll16 == 16 * 5 * 1, "per-tile Type17 polling would send one request per field per tile");
+    check(frames >= 2 * 100 * N * 9 / 10, "telemetry keeps up with every motor's 10ms Type2 reports");
+    check(p16.tiles == N && p16.fits, "idle motors: only the first refresh draws, and every tile's text fits");
+
+    // 動いているモータ / 故障 / 報告停止 のタイルだけ変わる
+    Panel p;
+    b.run(dash16, p, 100); // 描き終わった状態から
+    p = Panel();
+    b.can.setRunMode(3, 2);
+    b.can.enable(3);
+    b.can.velocityRef(3, 2.0f);
+    b.sim.motor(5)->injectFault(RS02Fault::OVERTEMP);
+    b.can.setActiveReport(7, false);
+    b.run(dash16, p, 1500);
+    bool othersIdle = true;
+    for (uint8_t i = 0; i < N; i++)
+        if (i != 2 && i != 4 && i != 6)
+            othersIdle &= p.drawn[i] == 0;
+    char what[160];
+    snprintf(what, sizeof(what), "only changed tiles redraw (motor 3: %u, 5: %u, 7: %u draws; %lu total)", p.drawn[2], p.drawn[4],
+             p.drawn[6], (unsigned long)p.tiles);
+    check(othersIdle && p.drawn[2] >= 10 && p.drawn[4] >= 1 && p.drawn[6] >= 2, what);
+    check(strstr(p.last[4], "F04") && p.color[4] == RS02DashConfig().colorFault, "a fault bit turns the tile red with its code");
+    check(strstr(p.last[6], "stale 1s") && p.color[6] == RS02DashConfig().colorStale,
+          "a motor that stops reporting goes grey with its age in seconds");
+    check(strstr(p.last[2], "RUN") != nullptr, "the running motor shows its state");
+    Serial.printf("  tile 3:\n%s\n  tile 5:\n%s\n  tile 7:\n%s\n", p.last[2], p.last[4], p.last[6]);
+
+    return RS02SimCheck::finish();
+}
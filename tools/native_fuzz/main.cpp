@@ -0,0 +1,536 @@
+// native_fuzz — フレーム解析/応答照合のファジング（libFuzzer ターゲット + 単体ドライバ）
+// 先頭 1 バイトで経路を選ぶ:
+//   0 parseFeedback / 1 readAny + listener（故障監視/デッドライン/バス負荷/記録）/ 2 readParamRaw の応答照合
+//   3 TWAI 受信（非準拠 DLC）/ 4 MCP_CAN readMsgBuf（SPI 応答をそのまま入力に, 両方式）/ 5 candump 行の解析 / 6 再生
+// libFuzzer:  clang++ -DRS02_LIBFUZZER=1 -fsanitize=fuzzer,address,undefined ... tools/native_fuzz/main.cpp
+// 単体(gcc):  pio run -e native-fuzz && .pio/build/native-fuzz/program [--runs N] [--seed S] [files...]
+//             （組み込みの種を変異させて回す。ASan/UBSan 付きでビルド）
+#include <Arduino.h>
+#include <SPI.h>
+#include <driver/twai.h>
+#include <mcp_can.h>
+#include "RS02PrivateCAN.h"
+#include "RS02PrivateTWAI.h"
+#include "RS02PrivateReplay.h"
+#include "RS02CanLog.h"
+#include "RS02BusLoad.h"
+#include "RS02FaultSupervisor.h"
+#include "RS02DeadlineMonitor.h"
+
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+// 不変条件が崩れたら落とす（libFuzzer/単体どちらでもクラッシュとして拾う）
+#define FUZZ_ASSERT(c)                                                       \
+    do                                                                       \
+    {                                                                        \
+        if (!(c))                                                            \
+        {                                                                    \
+            fprintf(stderr, "assertion failed: %s (line %d)\n", #c, __LINE__); \
+            abort();                                                         \
+        }                                                                    \
+    } while (0)
+
+// ===== 入力の切り出し =====
+class FuzzInput
+{
+public:
+    FuzzInput(const uint8_t *d, size_t n) : _d(d), _n(n) {}
+    size_t left() const { return _n - _i; }
+    uint8_t u8() { return _i < _n ? _d[_i++] : 0; }
+    uint16_t u16() { return (uint16_t)(u8() | (u8() << 8)); }
+    uint32_t u32() { return (uint32_t)u16() | ((uint32_t)u16() << 16); }
+    const uint8_t *rest() const { return _d + _i; }
+
+    // フレーム 1 枚（dlc は生の 1 バイト: 0..255）
+    bool frame(RS02PrivFrame &f)
+    {
+        if (left() == 0)
+            return false;
+        f = RS02PrivFrame();
+        f.id = u32() & 0x1FFFFFFF;
+        uint8_t flags = u8();
+        f.isExt = (flags & 1) != 0;
+        if (!f.isExt)
+            f.id &= 0x7FF;
+        f.dlc = u8();
+        for (uint8_t i = 0; i < 8; i++)
+            f.data[i] = u8();
+        return true;
+    }
+
+private:
+    const uint8_t *_d;
+    size_t _n;
+    size_t _i = 0;
+};
+
+// 受信を入力から出すバックエンド（送信は捨てる）
+class FuzzBus : public RS02PrivateBase
+{
+public:
+    explicit FuzzBus(FuzzInput &in) : RS02PrivateBase(0xFD), _in(in) {}
+    bool begin() override { return true; }
+    uint32_t sent = 0;
+
+protected:
+    bool hwSend(unsigned long, const uint8_t *, uint8_t len) override
+    {
+        FUZZ_ASSERT(len <= 8);
+        sent++;
+        return true;
+    }
+    bool hwRead(RS02PrivFrame &out) override { return _in.frame(out); }
+
+private:
+    FuzzInput &_in;
+};
+
+// SPI の応答を入力から返す MCP2515（中身は問わない）
+class FuzzSpi : public ShimSpiDevice
+{
+public:
+    FuzzInput *in = nullptr;
+    void select() override {}
+    void deselect() override {}
+    uint8_t transfer(uint8_t) override { return in ? in->u8() : 0xFF; }
+};
+
+// 記録の出力を 1 行ずつ読み戻し、受信行が readAny の順と一致するか（送信行=故障監視の停止は数えるだけ）
+class CheckPrint : public Print
+{
+public:
+    std::vector<RS02PrivFrame> rx;
+    size_t idx = 0;
+    size_t txLines = 0;
+    std::string line;
+    size_t write(uint8_t c) override
+    {
+        if (c != '\n')
+        {
+            line.push_back((char)c);
+            return 1;
+        }
+        RS02CanLogEntry e;
+        FUZZ_ASSERT(RS02CanLog::parseLine(line.c_str(), e));
+        line.clear();
+        if (e.tx)
+        {
+            txLines++;
+            return 1;
+        }
+        FUZZ_ASSERT(idx < rx.size());
+        const RS02PrivFrame &x = rx[idx++];
+        FUZZ_ASSERT(e.f.isExt == x.isExt && e.f.id == x.id);
+        FUZZ_ASSERT(e.f.dlc == x.dlc && memcmp(e.f.data, x.data, e.f.dlc) == 0);
+        return 1;
+    }
+    using Print::write;
+};
+
+static void checkFrame(const RS02PrivFrame &f)
+{
+    FUZZ_ASSERT(f.dlc <= 8);
+    FUZZ_ASSERT(f.id <= 0x1FFFFFFF);
+}
+
+// ===== 経路 =====
+static void fuzzFeedback(FuzzInput &in)
+{
+    FuzzBus bus(in);
+    RS02PrivFrame f;
+    while (in.frame(f))
+    {
+        RS02Feedback fb;
+        if (bus.parseFeedback(f, fb))
+        {
+            FUZZ_ASSERT(f.dlc >= 8 && rs02FrameType(f.id) == RS02Type::FEEDBACK);
+            FUZZ_ASSERT(fb.faultBits <= 0x3F && fb.mode <= 3);
+            FUZZ_ASSERT(fb.angleRad >= -12.58f && fb.angleRad <= 12.58f);
+            FUZZ_ASSERT(fb.velRadS >= -44.01f && fb.velRadS <= 44.01f);
+            FUZZ_ASSERT(fb.torqueNm >= -17.01f && fb.torqueNm <= 17.01f);
+        }
+    }
+}
+
+static void fuzzReadAny(FuzzInput &in)
+{
+    FuzzBus bus(in);
+    RS02FaultSupervisor fs(bus);
+    RS02DeadlineMonitor dm(bus);
+    RS02BusLoad bl(bus);
+    RS02CanLogRecorder rec(bus);
+    fs.begin();
+    dm.begin();
+    bl.begin();
+    rec.begin();
+    RS02DeadlineConfig dc;
+    dm.watch(1, dc);
+    dm.watch(127, dc);
+
+    CheckPrint out;
+    RS02PrivFrame f;
+    while (out.rx.size() < RS02_CANLOG_DEPTH / 2 && bus.readAny(f))
+    {
+        checkFrame(f);
+        out.rx.push_back(f);
+        FUZZ_ASSERT(RS02BusLoad::frameBits(f.id, f.isExt, f.dlc, f.data) <= RS02BusLoad::frameBitsWorst(f.isExt, f.dlc));
+    }
+    rec.flush(out);
+    FUZZ_ASSERT(out.idx == out.rx.size() && out.txLines == bus.sent);
+    bl.snapshot();
+    rec.end();
+    bl.end();
+    dm.end();
+    fs.end();
+}
+
+static void fuzzReadParam(FuzzInput &in)
+{
+    uint8_t target = in.u8();
+    uint16_t index = in.u16();
+    FuzzBus bus(in);
+    uint8_t v[4];
+    bus.readParamRaw(target, index, v);
+    float fv;
+    bus.readFloatParam(target, index, fv);
+    uint8_t mode;
+    bus.readRunMode(target, mode);
+}
+
+static void fuzzTwai(FuzzInput &in)
+{
+    static RS02PrivateTWAI *twai = nullptr;
+    if (!twai)
+    {
+        twai = new RS02PrivateTWAI(0xFD, 1, 2);
+        FUZZ_ASSERT(twai->begin());
+    }
+    RS02PrivFrame f;
+    while (twai->readAny(f)) // 前回の残り
+    {
+    }
+    while (in.left() > 0)
+    {
+        twai_message_t m = {};
+        m.identifier = in.u32();
+        m.flags = in.u8();
+        m.data_length_code = in.u8();
+        for (uint8_t i = 0; i < 8; i++)
+            m.data[i] = in.u8();
+        if (!ArduinoShim::injectTwaiRx(m))
+            break;
+    }
+    while (twai->readAny(f))
+        checkFrame(f);
+}
+
+static void fuzzMcp(FuzzInput &in)
+{
+    static FuzzSpi spi;
+    static MCP_CAN *mcp = nullptr;
+    if (!mcp)
+    {
+        SPI.attach(6, &spi);
+        SPI.begin();
+        mcp = new MCP_CAN(6);
+    }
+    mcp->setFastIO(in.u8() & 1); // レジスタ個別 / READ RX の両方
+    spi.in = &in;
+    RS02PrivateCAN bus(*mcp, 0xFD);
+    for (int i = 0; i < 4 && in.left() > 0; i++)
+    {
+        unsigned long id = 0;
+        uint8_t ext = 0, len = 0, buf[8];
+        if (mcp->readMsgBuf(&id, &ext, &len, buf) == CAN_OK)
+            FUZZ_ASSERT(len <= 8);
+        INT32U id2 = 0;
+        uint8_t len2 = 0;
+        if (mcp->readMsgBuf(&id2, &len2, buf) == CAN_OK)
+            FUZZ_ASSERT(len2 <= 8);
+        RS02PrivFrame f;
+        if (bus.readAny(f))
+            checkFrame(f);
+    }
+    spi.in = nullptr;
+}
+
+static void fuzzLogLine(FuzzInput &in)
+{
+    std::string s((const char *)in.rest(), in.left());
+    size_t pos = 0;
+    while (pos <= s.size())
+    {
+        size_t nl = s.find('\n', pos);
+        std::string line = s.substr(pos, nl == std::string::npos ? std::string::npos : nl - pos);
+        RS02CanLogEntry e;
+        if (RS02CanLog::parseLine(line.c_str(), e))
+        {
+            checkFrame(e.f);
+            char buf[64];
+            size_t n = RS02CanLog::formatLine(e, "can0", true, buf, sizeof(buf));
+            FUZZ_ASSERT(n > 0);
+            RS02CanLogEntry back;
+            FUZZ_ASSERT(RS02CanLog::parseLine(buf, back));
+            FUZZ_ASSERT(back.tx == e.tx && back.f.id == e.f.id && back.f.dlc == e.f.dlc && back.tsUs == e.tsUs &&
+                        memcmp(back.f.data, e.f.data, e.f.dlc) == 0);
+        }
+        if (nl == std::string::npos)
+            break;
+        pos = nl + 1;
+    }
+}
+
+static void fuzzReplay(FuzzInput &in)
+{
+    uint8_t mode = in.u8();
+    std::string text((const char *)in.rest(), in.left());
+    RS02CanLogTextSource src(text.c_str());
+    RS02PrivateReplay rp(0xFD, src);
+    RS02ReplayConfig cfg;
+    cfg.speed = 0.0f;
+    cfg.syncOnTx = (mode & 1) != 0;
+    rp.setConfig(cfg);
+    if (!rp.begin())
+        return;
+    RS02PrivFrame f;
+    for (int i = 0; i < 512 && !rp.done(); i++)
+    {
+        if (rp.readAny(f))
+            checkFrame(f);
+        else if (rp.waitingForTx())
+        {
+            const RS02CanLogEntry &e = rp.next();
+            rp.sendExt(e.f.id, e.f.data, e.f.dlc > 8 ? 8 : e.f.dlc);
+        }
+    }
+    const RS02ReplayStats &st = rp.stats();
+    FUZZ_ASSERT(st.txMatched + st.txMismatch + st.txUnexpected <= st.txSent);
+}
+
+static void initOnce()
+{
+    static bool done = false;
+    if (done)
+        return;
+    done = true;
+    ArduinoShim::useVirtualTime(true);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    initOnce();
+    if (size == 0)
+        return 0;
+    FuzzInput in(data + 1, size - 1);
+    switch (data[0] % 7)
+    {
+    case 0:
+        fuzzFeedback(in);
+        break;
+    case 1:
+        fuzzReadAny(in);
+        break;
+    case 2:
+        fuzzReadParam(in);
+        break;
+    case 3:
+        fuzzTwai(in);
+        break;
+    case 4:
+        fuzzMcp(in);
+        break;
+    case 5:
+        fuzzLogLine(in);
+        break;
+    default:
+        fuzzReplay(in);
+        break;
+    }
+    return 0;
+}
+
+#if !RS02_LIBFUZZER
+// ===== 単体ドライバ（libFuzzer が無い環境向け: 組み込みの種を変異させる）=====
+static uint64_t g_rng = 0x9E3779B97F4A7C15ULL;
+static uint32_t rnd()
+{
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 7;
+    g_rng ^= g_rng << 17;
+    return (uint32_t)(g_rng >> 16);
+}
+
+static void pushFrame(std::vector<uint8_t> &v, uint32_t id, bool ext, uint8_t dlc, const uint8_t *data)
+{
+    for (int i = 0; i < 4; i++)
+        v.push_back((uint8_t)(id >> (8 * i)));
+    v.push_back(ext ? 1 : 0);
+    v.push_back(dlc);
+    for (int i = 0; i < 8; i++)
+        v.push_back(data ? data[i] : 0);
+}
+
+static std::vector<std::vector<uint8_t>> seeds()
+{
+    std::vector<std::vector<uint8_t>> s;
+    const uint8_t fbData[8] = {0x80, 0x12, 0x7F, 0xA0, 0x80, 0x40, 0x01, 0x2C};
+    const uint8_t reply[8] = {0x19, 0x70, 0x00, 0x00, 0x00, 0x00, 0x80, 0x3F};
+    uint32_t fbId = (2UL << 24) | (2UL << 22) | (0x7FUL << 8) | 0xFD;
+    uint32_t rpId = (0x11UL << 24) | (0x7FUL << 8) | 0xFD;
+    for (uint8_t sel = 0; sel < 5; sel++)
+    {
+        std::vector<uint8_t> v{sel};
+        if (sel == 2)
+        {
+            v.push_back(0x7F);
+            v.push_back(0x19);
+            v.push_back(0x70);
+        }
+        if (sel == 3)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                for (int i = 0; i < 4; i++)
+                    v.push_back((uint8_t)(fbId >> (8 * i)));
+                v.push_back(0x01);          // TWAI_MSG_FLAG_EXTD
+                v.push_back((uint8_t)(8 + k * 4)); // 8, 12, 16
+                v.insert(v.end(), fbData, fbData + 8);
+            }
+        }
+        else if (sel == 4)
+        {
+            // READ STATUS=RX0IF, ID(SIDH..EID0), CTRL, DLC, data
+            const uint8_t spi[] = {0, 0, 0x01, 0, 0, 0xFF, 0xEB, 0xFD, 0x7F, 0x00, 0x0F};
+            for (int k = 0; k < 3; k++)
+            {
+                v.insert(v.end(), spi, spi + sizeof(spi));
+                v.insert(v.end(), fbData, fbData + 8);
+            }
+        }
+        else
+        {
+            pushFrame(v, fbId, true, 8, fbData);
+            pushFrame(v, rpId, true, 8, reply);
+            pushFrame(v, 0x123, false, 3, fbData);
+            pushFrame(v, fbId | (0x3FUL << 16), true, 15, fbData);
+        }
+        s.push_back(v);
+    }
+    const char *log = "(1697000000.000000) can0 12FD0002#0570000002000000 T\n"
+                      "(1697000000.000120) can0 027F00FD#8012 7FA0\n"
+                      "(1697000000.000200) can0 117F00FD#1970000000000000 R\n"
+                      "(1.5) vcan0 123#0102\n";
+    for (uint8_t sel = 5; sel < 7; sel++)
+    {
+        std::vector<uint8_t> v{sel};
+        if (sel == 6)
+            v.push_back(1);
+        v.insert(v.end(), log, log + strlen(log));
+        s.push_back(v);
+    }
+    return s;
+}
+
+static void mutate(std::vector<uint8_t> &v)
+{
+    int n = 1 + (int)(rnd() % 4);
+    for (int k = 0; k < n; k++)
+    {
+        uint32_t op = rnd() % 6;
+        size_t sz = v.size();
+        if (sz < 2)
+        {
+            v.push_back((uint8_t)rnd());
+            continue;
+        }
+        size_t at = 1 + rnd() % (sz - 1); // 先頭（経路）は保つ
+        switch (op)
+        {
+        case 0:
+            v[at] ^= (uint8_t)(1u << (rnd() % 8));
+            break;
+        case 1:
+            v[at] = (uint8_t)rnd();
+            break;
+        case 2:
+            v.insert(v.begin() + at, (uint8_t)rnd());
+            break;
+        case 3:
+            v.erase(v.begin() + at);
+            break;
+        case 4:
+            v.resize(at);
+            break;
+        default:
+        {
+            static const uint8_t interesting[] = {0x00, 0x08, 0x09, 0x0F, 0x10, 0x7F, 0x80, 0xFF, '#', '(', ')', '.', ' ', '\n', 'T'};
+            v[at] = interesting[rnd() % sizeof(interesting)];
+            break;
+        }
+        }
+    }
+}
+
+static bool readFile(const char *path, std::vector<uint8_t> &out)
+{
+    FILE *fp = fopen(path, "rb");
+    if (!fp)
+        return false;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+        out.insert(out.end(), buf, buf + n);
+    fclose(fp);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t runs = 200000;
+    std::vector<const char *> files;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+            runs = (uint32_t)strtoul(argv[++i], nullptr, 0);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            g_rng = strtoull(argv[++i], nullptr, 0) | 1;
+        else
+            files.push_back(argv[i]);
+    }
+
+    // ファイル指定: そのまま 1 回ずつ（libFuzzer のクラッシュ入力の再現）
+    if (!files.empty())
+    {
+        for (const char *path : files)
+        {
+            std::vector<uint8_t> v;
+            if (!readFile(path, v))
+            {
+                fprintf(stderr, "cannot read %s\n", path);
+                return 2;
+            }
+            LLVMFuzzerTestOneInput(v.data(), v.size());
+            printf("ok %s (%zu bytes)\n", path, v.size());
+        }
+        return 0;
+    }
+
+    std::vector<std::vector<uint8_t>> corpus = seeds();
+    uint32_t perPath[7] = {};
+    for (uint32_t r = 0; r < runs; r++)
+    {
+        std::vector<uint8_t> v = corpus[rnd() % corpus.size()];
+        if (r >= corpus.size())
+            mutate(v);
+        perPath[v[0] % 7]++;
+        LLVMFuzzerTestOneInput(v.data(), v.size());
+    }
+    printf("%lu runs:", (unsigned long)runs);
+    for (int i = 0; i < 7; i++)
+        printf(" %d=%lu", i, (unsigned long)perPath[i]);
+    printf("\nPASSED\n");
+    return 0;
+}
+#endif
@@ -0,0 +1,270 @@
+// native_gateway — TWAI ⇔ MCP2515 ゲートウェイ（RS02Gateway）を 2 本の仮想バスで確認する
+// バス A（TWAI 側）に PC ツール役のノードとモータ 1-4、バス B（MCP2515 側）にモータ 5-8。
+// PC はバス A だけにつながり、ゲートウェイ経由でバス B のモータにも届く（A→B は ID フィルタでモータ 5-8 宛てだけ）。
+// 250Hz で全 8 台へ Type1 を出して全台の Type2 が PC に戻るか、方向ごとの遅れ（受信 → 反対側へ送信）、
+// フィルタ / レート制限 / リング満杯 / 期限切れ / 標準フレームの扱いを確かめる（合わなければ exit 1）
+//   pio run -e native-gateway && .pio/build/native-gateway/program
+#include <Arduino.h>
+#include <RS02SimCheck.h>
+#include <SPI.h>
+#include <mcp_can.h>
+#include <driver/twai.h>
+#include <Mcp2515Emu.h>
+#include <VirtualCanBus.h>
+#include <RS02SimBus.h>
+#include "RS02PrivateCAN.h"
+#include "RS02PrivateTWAI.h"
+#include "RS02Gateway.h"
+
+#include <deque>
+#include <vector>
+
+static constexpr uint8_t HOST_ID = 0xFD;
+static constexpr uint8_t CS_PIN = 5;
+static constexpr uint32_t CYCLES = 200;
+static constexpr uint32_t PERIOD_US = 4000; // バス A: 8 台の Type1 + Type2 と転送分で 1 周期約 2.2ms
+
+using RS02SimCheck::check;
+
+// PC ツール役: 送信キュー（ACK が返るまで再送）と受信ログ
+class PcNode : public VirtualCanNode
+{
+public:
+    explicit PcNode(VirtualCanBus *bus) : _bus(bus) { bus->attach(this); }
+    ~PcNode() { _bus->detach(this); }
+
+    struct Rx
+    {
+        ShimCanFrame f;
+        uint64_t tNs;
+    };
+    std::vector<Rx> rxLog;
+    uint32_t sent = 0;
+
+    void send(uint32_t id, bool ext = true)
+    {
+        ShimCanFrame f;
+        f.id = id;
+        f.ext = ext;
+        f.dlc = 8;
+        ShimLock lk;
+        _txq.push_back(f);
+        _bus->kick();
+    }
+    // RS02 の要求（ホスト 0xFD → dst）
+    void request(uint8_t type, uint8_t dst) { send(((uint32_t)type << 24) | ((uint32_t)HOST_ID << 16) | dst); }
+    size_t queued() const { return _txq.size(); }
+
+    bool txPeek(ShimCanFrame &f) override
+    {
+        if (_txq.empty())
+            return false;
+        f = _txq.front();
+        return true;
+    }
+    void txDone(bool ok) override
+    {
+        if (!ok)
+            return;
+        _txq.pop_front();
+        sent++;
+    }
+    void rx(const ShimCanFrame &f, uint64_t tNs) override { rxLog.push_back({f, tNs}); }
+
+private:
+    VirtualCanBus *_bus;
+    std::deque<ShimCanFrame> _txq;
+};
+
+struct Bench
+{
+    VirtualCanBus busA{1000000}, busB{1000000};
+    Mcp2515Emu emu{&busB};
+    RS02SimBus simA{&busA}, simB{&busB};
+    PcNode pc{&busA};
+    MCP_CAN mcp{CS_PIN};
+    RS02PrivateTWAI twai{HOST_ID, 1, 2};
+    RS02PrivateCAN can{mcp, HOST_ID};
+
+    Bench()
+    {
+        for (uint8_t id = 1; id <= 4; id++)
+            simA.add(id);
+        for (uint8_t id = 5; id <= 8; id++)
+            simB.add(id);
+        SPI.attach(CS_PIN, &emu);
+        SPI.begin();
+        ArduinoShim::attachTwai(&busA);
+        mcp.setFastIO(1);
+        mcp.begin(MCP_ANY, CAN_1000KBPS, MCP_8MHZ);
+        mcp.setMode(MCP_NORMAL);
+        can.begin();
+        twai.setQueueForMotors(8);
+        twai.setTxTimeoutMs(0);
+        twai.begin();
+    }
+    ~Bench() { ArduinoShim::attachTwai(nullptr); }
+};
+
+// ゲートウェイを回しながら us 待つ
+static void spin(RS02Gateway &gw, uint32_t us)
+{
+    uint32_t tEnd = micros() + us;
+    while ((int32_t)(micros() - tEnd) < 0)
+    {
+        gw.service();
+        delayMicroseconds(10);
+    }
+}
+
+static void printStats(const char *name, const RS02GatewayStats &s)
+{
+    Serial.printf("  %s  rx %5lu  fwd %5lu  filt %4lu  rate %4lu  full %4lu  stale %4lu  retry %4lu  depth %3u  "
+                  "latency mean %6.1f / max %5lu us\n",
+                  name, (unsigned long)s.rx, (unsigned long)s.forwarded, (unsigned long)s.filtered, (unsigned long)s.rateDropped,
+                  (unsigned long)s.ringFull, (unsigned long)s.stale, (unsigned long)s.txRetry, s.maxDepth,
+                  s.forwarded ? (double)s.totalLatencyUs / s.forwarded : 0.0, (unsigned long)s.maxLatencyUs);
+}
+
+// PC → 全 8 台（A 側は直接, B 側はゲートウェイ経由）の往復
+static void roundTrip(Bench &b, RS02Gateway &gw)
+{
+    b.pc.rxLog.clear();
+    for (uint8_t id = 1; id <= 8; id++)
+        b.pc.request(RS02Type::GET_ID, id);
+    spin(gw, 5000);
+    bool seen[9] = {};
+    for (const PcNode::Rx &r : b.pc.rxLog)
+        if (rs02FrameType(r.f.id) == RS02Type::GET_ID)
+            seen[(r.f.id >> 8) & 0xFF] = true;
+    bool all = true;
+    for (uint8_t id = 1; id <= 8; id++)
+        all &= seen[id];
+    check(all, "the PC on bus A gets Type0 replies from motors on both buses");
+    // A 側で見た 8 要求 + モータ 1-4 の 4 応答のうち、モータ 5-8 宛ての 4 つだけ
+    check(gw.stats(RS02GwDir::AtoB).forwarded == 4 && gw.stats(RS02GwDir::AtoB).filtered == 8,
+          "A->B forwards only frames addressed to motors 5-8");
+
+    // 250Hz で全台へ Type1。1 周期の 8 台ぶんの Type2 が次の周期までに PC に戻るか
+    gw.resetStats();
+    uint32_t okCycles = 0;
+    uint64_t rttMaxNs = 0;
+    uint32_t t0 = micros();
+    for (uint32_t k = 0; k < CYCLES; k++)
+    {
+        b.pc.rxLog.clear();
+        uint64_t tSent = ArduinoShim::nowNs();
+        for (uint8_t id = 1; id <= 8; id++)
+            b.pc.request(RS02Type::OP_CONTROL, id);
+        int32_t left = (int32_t)(t0 + (k + 1) * PERIOD_US - micros());
+        if (left > 0)
+            spin(gw, (uint32_t)left);
+        bool got[9] = {};
+        for (const PcNode::Rx &r : b.pc.rxLog)
+        {
+            if (rs02FrameType(r.f.id) != RS02Type::FEEDBACK)
+                continue;
+            got[(r.f.id >> 8) & 0xFF] = true;
+            if (r.tNs - tSent > rttMaxNs)
+                rttMaxNs = r.tNs - tSent;
+        }
+        bool all8 = true;
+        for (uint8_t id = 1; id <= 8; id++)
+            all8 &= got[id];
+        okCycles += all8;
+    }
+    Serial.printf("%lu cycles @ %lu Hz, 8 Type1 from the PC per cycle (4 bridged)\n", (unsigned long)CYCLES,
+                  (unsigned long)(1000000 / PERIOD_US));
+    printStats("A->B", gw.stats(RS02GwDir::AtoB));
+    printStats("B->A", gw.stats(RS02GwDir::BtoA));
+    Serial.printf("  PC: all 8 Type2 back within the cycle %lu/%lu, worst PC round trip %.0f us\n", (unsigned long)okCycles,
+                  (unsigned long)CYCLES, (double)rttMaxNs / 1000.0);
+    char what[128];
+    snprintf(what, sizeof(what), "every cycle returns all 8 Type2 to the PC (%lu/%lu)", (unsigned long)okCycles,
+             (unsigned long)CYCLES);
+    check(okCycles == CYCLES, what);
+    const RS02GatewayStats &ab = gw.stats(RS02GwDir::AtoB);
+    const RS02GatewayStats &ba = gw.stats(RS02GwDir::BtoA);
+    check(ab.forwarded == CYCLES * 4 && ba.forwarded == CYCLES * 4 && ab.ringFull + ab.rateDropped + ab.stale == 0,
+          "each direction forwards every bridged frame with no drops");
+    check(ab.maxLatencyUs < 300 && ba.maxLatencyUs < 300, "gateway latency (RX -> forwarded TX) stays under 300us per direction");
+}
+
+static void limits(Bench &b, RS02Gateway &gw)
+{
+    char what[160];
+    // レート制限: 1000 fps, バースト 4 に 100 フレームを詰めて（約 7400 fps）送る
+    gw.resetStats();
+    gw.setRateLimit(RS02GwDir::AtoB, 1000, 4);
+    uint32_t t0 = micros();
+    for (int i = 0; i < 100; i++)
+        b.pc.request(RS02Type::GET_ID, 5);
+    while (b.pc.queued())
+        spin(gw, 100);
+    uint32_t burstUs = micros() - t0;
+    spin(gw, 3000);
+    const RS02GatewayStats &s = gw.stats(RS02GwDir::AtoB);
+    uint32_t expect = 4 + burstUs / 1000;
+    snprintf(what, sizeof(what), "the A->B rate limit passes burst + 1000 fps and drops the rest (fwd=%lu drop=%lu over %luus)",
+             (unsigned long)s.forwarded, (unsigned long)s.rateDropped, (unsigned long)burstUs);
+    check(s.forwarded + s.rateDropped == 100 && s.forwarded + 2 >= expect && s.forwarded <= expect + 2, what);
+    gw.setRateLimit(RS02GwDir::AtoB, 0);
+
+    // リング満杯: 受信は TWAI の受信タスク（listener → リング）、転送は止めたまま 100 フレーム
+    gw.resetStats();
+    gw.setMaxAgeUs(100000); // 100 フレームがバスに出るまで約 14ms
+    b.twai.startRxTask();
+    for (int i = 0; i < 100; i++)
+        b.pc.request(RS02Type::GET_ID, 5);
+    while (b.pc.queued())
+        delay(1);
+    delay(1);
+    uint16_t depth = gw.depth(RS02GwDir::AtoB);
+    // 送れなかった分は枠に残り、次の forward で続きから送る
+    uint32_t fwd = 0;
+    for (int i = 0; i < 1000 && gw.depth(RS02GwDir::AtoB); i++)
+    {
+        fwd += gw.forward();
+        delayMicroseconds(100);
+    }
+    snprintf(what, sizeof(what), "a stalled forwarder fills the ring and counts overflow (depth=%u full=%lu fwd=%lu retry=%lu)",
+             depth, (unsigned long)s.ringFull, (unsigned long)fwd, (unsigned long)s.txRetry);
+    check(depth == RS02_GW_RING && s.ringFull == 100 - RS02_GW_RING && fwd == RS02_GW_RING && s.stale == 0,
+          what);
+
+    // 期限切れ: 送れないまま maxAgeUs を過ぎた枠は送らずに捨てる
+    gw.resetStats();
+    gw.setMaxAgeUs(1000);
+    for (int i = 0; i < 10; i++)
+        b.pc.request(RS02Type::GET_ID, 5);
+    while (b.pc.queued())
+        delay(1);
+    delay(3);
+    fwd = gw.forward();
+    check(fwd == 0 && s.stale == 10, "frames older than maxAgeUs are dropped as stale, not forwarded");
+    gw.setMaxAgeUs(10000);
+    b.twai.stopRxTask();
+    spin(gw, 5000); // モータ 5 の応答を流し切る
+
+    // 標準フレーム（11bit）は転送しない
+    gw.resetStats();
+    b.pc.send(0x005, false);
+    spin(gw, 1000);
+    check(s.rx == 1 && s.filtered == 1 && s.forwarded == 0, "standard (11-bit) frames are not bridged");
+}
+
+int main()
+{
+    ArduinoShim::useVirtualTime(true);
+    Bench b;
+    RS02Gateway gw(b.twai, b.can);
+    for (uint8_t id = 5; id <= 8; id++)
+        gw.addFilter(RS02GwDir::AtoB, RS02GwFilter::toMotor(id));
+    check(gw.begin(), "gateway attaches to both buses");
+
+    roundTrip(b, gw);
+    limits(b, gw);
+    gw.end();
+
+    return RS02SimCheck::finish();
+}
@@ -0,0 +1,291 @@
+// native_health — バスオフ / エラーパッシブからの自動回復（RS02BusHealth）の回帰確認
+// 仮想バスにエラーフレームを注入（VirtualCanBus::injectErrors / setFault）して、MCP2515 / TWAI それぞれで
+//   1) 一時的なエラー → Warning / Passive を数えるだけ（送信不能にはしない）
+//   2) 1kHz で速度指令を出しながら 20ms バス故障 → バスオフ → 故障解除後すぐ回復し、
+//      故障中に止まったモータ 1 へランモード / enable / 最後の速度指令を再送する
+//   3) 監視なし（比較）: TWAI はバスオフのまま、MCP2515 は自動復帰してもモータ 1 は止まったまま
+//   4) MCP2515 のリセット（設定喪失）→ Stopped → 再初期化
+// を確認する（回復しない / 再送しない / 統計が合わない なら exit 1）
+//   pio run -e native-health && .pio/build/native-health/program
+#include <Arduino.h>
+#include <RS02SimCheck.h>
+#include <SPI.h>
+#include <mcp_can.h>
+#include <driver/twai.h>
+#include <Mcp2515Emu.h>
+#include <VirtualCanBus.h>
+#include <RS02SimBus.h>
+#include "RS02PrivateCAN.h"
+#include "RS02PrivateTWAI.h"
+#include "RS02BusHealth.h"
+
+static constexpr uint8_t MCP_CS_PIN = 6;
+static constexpr uint8_t HOST_ID = 0xFD;
+static constexpr uint8_t N_MOTORS = 2;
+static constexpr uint32_t CYCLES = 150;
+static constexpr uint32_t PERIOD_US = 1000;
+static constexpr uint32_t FAULT_ON = 40;     // この周期からバス故障
+static constexpr uint32_t FAULT_US = 20000;  // 故障の長さ（MCP2515 は送信が詰まると周期が延びるので時間で測る）
+static constexpr uint32_t MAX_RECOVER_US = 5000;
+
+using RS02SimCheck::check;
+
+struct Bench
+{
+    VirtualCanBus bus{1000000};
+    Mcp2515Emu emu{&bus};
+    RS02SimBus sim{&bus};
+    MCP_CAN mcp{MCP_CS_PIN};
+    RS02PrivateCAN mcpHost{mcp, HOST_ID};
+    RS02PrivateTWAI twaiHost{HOST_ID, 1, 2};
+
+    Bench()
+    {
+        for (uint8_t m = 1; m <= N_MOTORS; m++)
+            sim.add(m);
+        SPI.attach(MCP_CS_PIN, &emu);
+        SPI.begin();
+        ArduinoShim::attachTwai(&bus);
+        mcp.setFastIO(1);
+        mcp.begin(MCP_ANY, CAN_1000KBPS, MCP_8MHZ);
+        mcp.setMode(MCP_NORMAL);
+        mcpHost.begin();
+        twaiHost.begin();
+    }
+    ~Bench() { ArduinoShim::attachTwai(nullptr); }
+
+    // 故障中にモータ側の CAN タイムアウト等で止まった、を模擬（Type4 を直接渡す）
+    void stopMotor(uint8_t m)
+    {
+        RS02PrivFrame in, out[RS02SimMotor::MAX_REPLIES];
+        in.id = ((unsigned long)RS02Type::STOP << 24) | ((unsigned long)HOST_ID << 8) | m;
+        in.dlc = 8;
+        in.isExt = true;
+        memset(in.data, 0, sizeof(in.data));
+        sim.motor(m)->handle(in, out);
+    }
+    bool motorRunning(uint8_t m, float spd)
+    {
+        const RS02SimState &s = sim.motor(m)->state();
+        return s.state == RS02MotorState::RUN && s.runMode == 2 && fabsf(sim.motor(m)->paramF(RS02Idx::SPD_REF) - spd) < 1e-3f;
+    }
+};
+
+// 受信を捨てつつ監視を回す（送信が詰まって周期を過ぎていても 1 回は回す）
+static void spinUntil(RS02PrivateBase &can, RS02BusHealth *h, uint32_t tUs)
+{
+    RS02PrivFrame f;
+    do
+    {
+        while (can.readAny(f))
+            ;
+        if (h)
+            h->service();
+        delayMicroseconds(50);
+    } while ((int32_t)(micros() - tUs) < 0);
+}
+
+static void printStats(const char *label, const RS02BusHealthStats &s)
+{
+    Serial.printf("  %-10s warn=%lu passive=%lu busOff=%lu stopped=%lu outages=%lu recovered=%lu recoverCalls=%lu "
+                  "resent=%lu outage last/max/total=%.2f/%.2f/%.2f ms maxTec=%u maxRec=%u\n",
+                  label, (unsigned long)s.warnings, (unsigned long)s.passives, (unsigned long)s.busOffs,
+                  (unsigned long)s.stops, (unsigned long)s.outages, (unsigned long)s.recoveries,
+                  (unsigned long)s.recoverCalls, (unsigned long)s.resentFrames, s.lastOutageUs / 1000.0,
+                  s.maxOutageUs / 1000.0, s.totalOutageUs / 1000.0, s.maxTec, s.maxRec);
+}
+
+// エラーカウンタが下がりきるまで普通に送る
+static void settle(Bench &b, RS02PrivateBase &can, RS02BusHealth *h)
+{
+    for (int i = 0; i < 300; i++)
+    {
+        RS02CanStatus st;
+        if (can.canStatus(st) && st.tec == 0 && st.rec == 0)
+            break;
+        can.ping(1);
+        spinUntil(can, h, micros() + 300);
+    }
+    spinUntil(can, h, micros() + 2000);
+    (void)b;
+}
+
+// 1) 注入したエラーは Warning / Passive として数え、送信不能とはしない
+static void transient(Bench &b, RS02PrivateBase &can, const char *name)
+{
+    RS02BusHealth h(can);
+    h.begin();
+    settle(b, can, &h);
+    h.resetStats();
+
+    b.bus.injectErrors(13); // TEC 104 → Warning
+    can.ping(1);
+    spinUntil(can, &h, micros() + 15000); // pollMs 以上
+    bool warn = h.state() == RS02CanState::Warning;
+    b.bus.injectErrors(4); // TEC 136 → Passive
+    can.ping(1);
+    spinUntil(can, &h, micros() + 15000);
+    bool passive = h.state() == RS02CanState::Passive;
+    settle(b, can, &h);
+
+    const RS02BusHealthStats &s = h.stats();
+    printStats("transient", s);
+    char what[96];
+    snprintf(what, sizeof(what), "%s: injected errors are tracked as warning -> passive", name);
+    check(warn && passive && s.warnings >= 1 && s.passives == 1 && s.maxTec >= 128, what);
+    snprintf(what, sizeof(what), "%s: no outage / recovery for error-passive", name);
+    check(s.outages == 0 && s.recoverCalls == 0 && h.state() == RS02CanState::Active, what);
+    h.end();
+}
+
+struct RunResult
+{
+    bool recovered = false;
+    uint32_t recoverUs = 0; // 故障解除から送信可能になるまで
+    bool motorsRunning = false;
+    RS02CanState finalState = RS02CanState::Unknown;
+    RS02BusHealthStats s;
+};
+
+// 2) / 3) 1kHz 速度指令中の 20ms バス故障（h = nullptr なら監視なし）
+static RunResult faultRun(Bench &b, RS02PrivateBase &can, RS02BusHealth *h)
+{
+    settle(b, can, h);
+    for (uint8_t m = 1; m <= N_MOTORS; m++)
+    {
+        can.setRunMode(m, 2);
+        can.enable(m);
+    }
+    spinUntil(can, h, micros() + 2000);
+    if (h)
+        h->resetStats();
+
+    RunResult r;
+    uint32_t tFault = 0, tClear = 0;
+    bool stopped = false;
+    uint32_t t0 = micros();
+    for (uint32_t k = 0; k < CYCLES; k++)
+    {
+        spinUntil(can, h, t0 + k * PERIOD_US);
+        if (k == FAULT_ON)
+        {
+            b.bus.setFault(true);
+            tFault = micros();
+        }
+        if (tFault && !stopped && micros() - tFault >= FAULT_US / 2)
+        {
+            b.stopMotor(1);
+            stopped = true;
+        }
+        if (tFault && !tClear && micros() - tFault >= FAULT_US)
+        {
+            b.bus.setFault(false);
+            tClear = micros();
+        }
+        if (h && tClear && !r.recovered && !h->inOutage())
+        {
+            r.recovered = true;
+            r.recoverUs = micros() - tClear;
+        }
+        // 目標値は一定（モータ 1 は enable を再送しない限り止まったまま）
+        for (uint8_t m = 1; m <= N_MOTORS; m++)
+                can.velocityRef(m, 1.0f * m);
+    }
+    spinUntil(can, h, micros() + 5000);
+
+    r.motorsRunning = true;
+    for (uint8_t m = 1; m <= N_MOTORS; m++)
+        r.motorsRunning &= b.motorRunning(m, 1.0f * m);
+    RS02CanStatus st;
+    if (can.canStatus(st))
+        r.finalState = st.state;
+    if (h)
+        r.s = h->stats();
+    for (uint8_t m = 1; m <= N_MOTORS; m++)
+        can.stop(m, false);
+    spinUntil(can, h, micros() + 2000);
+    return r;
+}
+
+static void busOff(Bench &b, RS02PrivateBase &can, const char *name, bool autoRecovers)
+{
+    RS02BusHealth h(can);
+    h.begin();
+    RunResult on = faultRun(b, can, &h);
+    h.end();
+    printStats("bus-off", on.s);
+    Serial.printf("  %-10s recovered %.2f ms after the fault cleared, final=%s, motors %s\n", "", on.recoverUs / 1000.0,
+                  RS02BusHealth::stateName(on.finalState), on.motorsRunning ? "running" : "stopped");
+
+    // 比較: 監視なし（回復の確認のため最後に手動で戻す）
+    RunResult off = faultRun(b, can, nullptr);
+    Serial.printf("  %-10s final=%s, motors %s\n", "no monitor", RS02BusHealth::stateName(off.finalState),
+                  off.motorsRunning ? "running" : "stopped");
+    RS02CanState offState = off.finalState;
+    for (int i = 0; i < 10 && off.finalState != RS02CanState::Active; i++)
+    {
+        can.recoverBus();
+        spinUntil(can, nullptr, micros() + 3000);
+        RS02CanStatus st;
+        if (can.canStatus(st))
+            off.finalState = st.state;
+    }
+
+    char what[96];
+    snprintf(what, sizeof(what), "%s: bus fault drives the controller bus-off", name);
+    check(on.s.busOffs >= 1 && on.s.outages >= 1 && on.s.maxTec >= 255, what);
+    snprintf(what, sizeof(what), "%s: recovers within %lu us of the fault clearing", name, (unsigned long)MAX_RECOVER_US);
+    check(on.recovered && on.recoverUs <= MAX_RECOVER_US && on.s.recoveries == on.s.outages, what);
+    snprintf(what, sizeof(what), "%s: outage duration covers the fault", name);
+    check(on.s.totalOutageUs >= FAULT_US / 2 && on.s.maxOutageUs <= FAULT_US + MAX_RECOVER_US, what);
+    snprintf(what, sizeof(what), "%s: run mode / enable / last setpoint resent after recovery", name);
+    check(on.motorsRunning && on.s.resentFrames >= 3 * N_MOTORS, what);
+    snprintf(what, sizeof(what), "%s: without the monitor the stopped motor stays stopped", name);
+    check(!off.motorsRunning, what);
+    snprintf(what, sizeof(what), "%s: without the monitor the controller %s", name,
+             autoRecovers ? "leaves bus-off by itself" : "stays bus-off");
+    check(autoRecovers ? offState != RS02CanState::BusOff : offState == RS02CanState::BusOff, what);
+    snprintf(what, sizeof(what), "%s: recoverBus() brings it back by hand", name);
+    check(off.finalState == RS02CanState::Active, what);
+}
+
+int main()
+{
+    ArduinoShim::useVirtualTime(true);
+    Bench b;
+
+    Serial.printf("1kHz x %u motors, bus fault %lu ms\n", N_MOTORS, (unsigned long)(FAULT_US / 1000));
+    Serial.printf("MCP2515\n");
+    transient(b, b.mcpHost, "MCP2515");
+    busOff(b, b.mcpHost, "MCP2515", true);
+    {
+        // 4) チップのリセット（設定喪失）→ Stopped → 再初期化
+        RS02BusHealth h(b.mcpHost);
+        h.begin();
+        settle(b, b.mcpHost, &h);
+        h.resetStats();
+        b.emu.reset();
+        spinUntil(b.mcpHost, &h, micros() + 15000); // pollMs 以内に検出
+        b.mcpHost.ping(1);
+        RS02PrivFrame f;
+        bool reply = false;
+        uint32_t t0 = micros();
+        while (!reply && micros() - t0 < 5000)
+        {
+            if (b.mcpHost.readAny(f))
+                reply = rs02FrameType(f.id) == RS02Type::GET_ID && ((f.id >> 8) & 0xFF) == 1;
+            else
+                delayMicroseconds(50);
+        }
+        printStats("reset", h.stats());
+        check(h.stats().stops == 1 && h.stats().recoveries == 1 && h.state() == RS02CanState::Active && reply,
+              "MCP2515: lost configuration is detected and re-initialised");
+        h.end();
+    }
+
+    Serial.printf("TWAI\n");
+    transient(b, b.twaiHost, "TWAI");
+    busOff(b, b.twaiHost, "TWAI", false);
+
+    return RS02SimCheck::finish();
+}
@@ -0,0 +1,263 @@
+// native_loopback — MCP2515(エミュレータ) と TWAI(シム) を1本の仮想バスでつなぎ、
+// RS02 ライブラリの送受信が両方向で一致することを確認する（不一致なら exit 1）
+// デッドライン監視（専用タスク / readParamRaw の待ち中 / 送信キュー有効でバスが塞がれたときの ZeroRef → Stop）も見る
+//   pio run -e native && .pio/build/native/program
+#include <Arduino.h>
+#include <RS02SimCheck.h>
+#include <SPI.h>
+#include <mcp_can.h>
+#include <driver/twai.h>
+#include <Mcp2515Emu.h>
+#include <VirtualCanBus.h>
+#include "RS02PrivateCAN.h"
+#include "RS02PrivateTWAI.h"
+#include "RS02DeadlineMonitor.h"
+
+#include <vector>
+
+static constexpr uint8_t MCP_CS_PIN = 6;
+
+class TxRecorder : public RS02FrameListener
+{
+public:
+    std::vector<RS02PrivFrame> frames;
+    void onTxFrame(const RS02PrivFrame &f, bool ok) override
+    {
+        if (ok)
+            frames.push_back(f);
+    }
+};
+
+using RS02SimCheck::check;
+
+// 最優先 ID を流し続けてバスを塞ぐ（left フレーム分）
+class Babbler : public VirtualCanNode
+{
+public:
+    uint32_t left = 0;
+    bool txPeek(ShimCanFrame &f) override
+    {
+        f.id = 0x001;
+        f.ext = false;
+        f.dlc = 8;
+        return left > 0;
+    }
+    void txDone(bool ok) override
+    {
+        (void)ok;
+        if (left)
+            left--;
+    }
+    void rx(const ShimCanFrame &f, uint64_t tNs) override
+    {
+        (void)f;
+        (void)tNs;
+    }
+};
+
+// バス上に出た Type1 ゼロトルク / Type4 の時刻（見ていなければ 0）
+class StopSniffer : public VirtualCanNode
+{
+public:
+    uint8_t motor = 0;
+    uint32_t zeroUs = 0, stopUs = 0;
+    bool txPeek(ShimCanFrame &f) override
+    {
+        (void)f;
+        return false;
+    }
+    void txDone(bool ok) override { (void)ok; }
+    void rx(const ShimCanFrame &f, uint64_t tNs) override
+    {
+        if (!f.ext || rs02FrameDst(f.id) != motor)
+            return;
+        uint32_t t = (uint32_t)(tNs / 1000);
+        if (rs02FrameType(f.id) == RS02Type::OP_CONTROL && ((f.id >> 8) & 0xFFFF) == 0x7FFF && !zeroUs)
+            zeroUs = t;
+        if (rs02FrameType(f.id) == RS02Type::STOP && !stopUs)
+            stopUs = t;
+    }
+};
+
+// 1コマンドずつ送信し、送信側で記録したフレームが受信側に同じ内容で届くか
+// （TWAI の受信キューは既定 5 枠なので溜めずに読む）
+static bool expectSame(RS02PrivateBase &rx, TxRecorder &rec, size_t from)
+{
+    size_t n = 0;
+    uint32_t t0 = millis();
+    while (from + n < rec.frames.size() && millis() - t0 < 100)
+    {
+        RS02PrivFrame b;
+        if (!rx.readAny(b))
+        {
+            delayMicroseconds(50);
+            continue;
+        }
+        const RS02PrivFrame &a = rec.frames[from + n];
+        if (a.id != b.id || a.dlc != b.dlc || !b.isExt || memcmp(a.data, b.data, a.dlc) != 0)
+        {
+            Serial.printf("  #%u id %08lX/%08lX dlc %u/%u\n", (unsigned)(from + n), (unsigned long)a.id,
+                          (unsigned long)b.id, a.dlc, b.dlc);
+            return false;
+        }
+        n++;
+    }
+    return from + n == rec.frames.size();
+}
+
+static bool sendBatch(RS02PrivateBase &tx, RS02PrivateBase &rx, TxRecorder &rec)
+{
+    bool ok = true;
+    size_t from = rec.frames.size();
+    tx.ping(0x7F);
+    ok &= expectSame(rx, rec, from);
+    from = rec.frames.size();
+    tx.enable(0x01);
+    ok &= expectSame(rx, rec, from);
+    from = rec.frames.size();
+    tx.opControl(0x01, 1.0f, 0.5f, 2.0f, 10.0f, 0.5f);
+    ok &= expectSame(rx, rec, from);
+    from = rec.frames.size();
+    tx.writeFloatParam(0x01, RS02Idx::SPD_REF, 3.0f);
+    ok &= expectSame(rx, rec, from);
+    from = rec.frames.size();
+    tx.setActiveReport(0x02, true);
+    ok &= expectSame(rx, rec, from);
+    from = rec.frames.size();
+    tx.stop(0x01, true);
+    ok &= expectSame(rx, rec, from);
+    return ok && rec.frames.size() == 6;
+}
+
+int main()
+{
+    ArduinoShim::useVirtualTime(true);
+
+    VirtualCanBus bus(1000000);
+    Mcp2515Emu emu(&bus);
+    SPI.attach(MCP_CS_PIN, &emu);
+    ArduinoShim::attachTwai(&bus);
+
+    MCP_CAN mcp(MCP_CS_PIN);
+    RS02PrivateCAN canA(mcp, 0xFD);
+    RS02PrivateTWAI canB(0xFD, 1, 2);
+
+    SPI.begin();
+    check(mcp.begin(MCP_ANY, CAN_1000KBPS, MCP_8MHZ) == CAN_OK, "MCP_CAN begin");
+    mcp.setMode(MCP_NORMAL);
+    check(canA.begin(), "RS02PrivateCAN begin");
+    check(canB.begin(), "RS02PrivateTWAI begin");
+
+    TxRecorder recA, recB;
+    canA.addListener(&recA);
+    canB.addListener(&recB);
+
+    // MCP2515 -> TWAI
+    uint32_t t0 = micros();
+    check(sendBatch(canA, canB, recA), "MCP2515 -> TWAI");
+    Serial.printf("  %u frames in %lu us\n", (unsigned)recA.frames.size(), (unsigned long)(micros() - t0));
+
+    // TWAI -> MCP2515
+    check(sendBatch(canB, canA, recB), "TWAI -> MCP2515");
+
+    // FreeRTOS タスク: 指令途絶でデッドライン監視が Type1 ゼロトルクを送る
+    RS02DeadlineMonitor dm(canA);
+    dm.begin();
+    RS02DeadlineConfig cfg;
+    cfg.cmdTimeoutMs = 20;
+    cfg.cmdAction = RS02DeadlineAction::ZeroRef;
+    dm.watch(0x01, cfg);
+    check(dm.startTask(5), "deadline task start");
+    canA.opControl(0x01, 2.0f, 0.0f, 0.0f, 0.0f, 0.3f);
+    delay(60);
+    dm.stopTask();
+    bool zeroSeen = false;
+    RS02PrivFrame f;
+    while (canB.readAny(f))
+    {
+        if (rs02FrameType(f.id) == RS02Type::OP_CONTROL && rs02FrameDst(f.id) == 0x01 && ((f.id >> 8) & 0xFFFF) == 0x7FFF)
+            zeroSeen = true;
+    }
+    check(zeroSeen && dm.stats(0x01).cmdMisses == 1, "deadline monitor task (ZeroRef)");
+
+    // readParamRaw の応答待ち（居ないモータで 300ms）の間も監視タスクは送れる
+    check(dm.startTask(5), "deadline task restart");
+    size_t from = recA.frames.size();
+    canA.opControl(0x01, 2.0f, 0.0f, 0.0f, 0.0f, 0.3f);
+    uint32_t tCmd = micros();
+    float v = 0.0f;
+    bool readOk = canA.readFloatParam(0x55, RS02Idx::MECH_POS, v);
+    dm.stopTask();
+    uint32_t zeroUs = 0;
+    for (size_t i = from; i < recA.frames.size(); i++)
+    {
+        const RS02PrivFrame &r = recA.frames[i];
+        if (rs02FrameType(r.id) == RS02Type::OP_CONTROL && ((r.id >> 8) & 0xFFFF) == 0x7FFF)
+        {
+            zeroUs = r.tsUs - tCmd;
+            break;
+        }
+    }
+    Serial.printf("  ZeroRef %lu us after the last command (readFloatParam on an absent ID: %s)\n",
+                  (unsigned long)zeroUs, readOk ? "reply?" : "timeout");
+    check(!readOk && zeroUs > 20000 && zeroUs < 40000, "deadline monitor fires while readParamRaw waits for a reply");
+    while (canB.readAny(f))
+    {
+    }
+
+    // 送信キュー有効 + バスが塞がれている間に指令が途絶: ZeroRef がキューに残って後から出ても、
+    // 監視が自分の送ったフレームをアプリの指令と数えず、stopAfterMs で Type4 まで進む
+    {
+        Babbler babbler;
+        StopSniffer sniff;
+        sniff.motor = 0x02;
+        bus.attach(&babbler);
+        bus.attach(&sniff);
+        RS02TxQueueConfig q;
+        q.enabled = true;
+        q.deadlineUs = 100000;
+        canA.setTxQueue(q);
+        RS02DeadlineConfig c2;
+        c2.cmdTimeoutMs = 20;
+        c2.stopAfterMs = 40;
+        c2.cmdAction = RS02DeadlineAction::ZeroRef;
+        dm.unwatch(0x01);
+        dm.watch(0x02, c2);
+        ShimCanFrame jf;
+        babbler.txPeek(jf);
+        uint32_t frameNs = (VirtualCanBus::frameBits(jf) + 3) * bus.bitNs();
+        babbler.left = (uint32_t)(30000000ULL / frameNs); // 30ms 塞ぐ
+        bus.kick();
+        delayMicroseconds(200);
+        // 最後の指令は塞がれて送信中のまま → ZeroRef は送信キューに入るとその後ろ
+        canA.opControl(0x02, 2.0f, 0.0f, 0.0f, 0.0f, 0.3f);
+        uint32_t t0 = micros();
+        for (uint32_t ms = 0; ms < 80; ms++)
+        {
+            dm.service();
+            while (canA.readAny(f)) // 送信キューもここで回る
+            {
+            }
+            while (canB.readAny(f))
+            {
+            }
+            delay(1);
+        }
+        q.enabled = false;
+        canA.setTxQueue(q);
+        dm.unwatch(0x02);
+        bus.detach(&babbler);
+        bus.detach(&sniff);
+        uint32_t zUs = sniff.zeroUs ? sniff.zeroUs - t0 : 0, sUs = sniff.stopUs ? sniff.stopUs - t0 : 0;
+        Serial.printf("  queue on, bus jammed 30ms: ZeroRef on the bus at %lu us, Stop at %lu us\n",
+                      (unsigned long)zUs, (unsigned long)sUs);
+        check(sniff.zeroUs && sniff.stopUs && sUs > 40000 && sUs < 50000 && dm.stats(0x02).cmdMisses == 1,
+              "deadline monitor escalates ZeroRef -> Stop with the TX queue on and the bus jammed");
+    }
+
+    const VirtualCanStats &st = bus.stats();
+    Serial.printf("bus: frames=%lu ackErr=%lu busy=%.3f ms  spi: trans=%lu bytes=%lu\n",
+                  (unsigned long)st.frames, (unsigned long)st.ackErrors, st.busyNs / 1e6,
+                  (unsigned long)SPI.stats().transactions, (unsigned long)SPI.stats().bytes);
+    return RS02SimCheck::finish();
+}
@@ -0,0 +1,247 @@
+// native_multibus — 2 本の CAN バスにモータを振り分けて（RS02MultiBus）制御周期の上限が倍になるかを確かめる
+// 1Mbps 仮想バス 3 本（TWAI, MCP2515 #1, MCP2515 #2。MCP2515 2 個は同じ SPI を CS で共有）に
+// それぞれシミュレータを載せ、N 台へ毎周期 Type1 を出して全台の Type2 が次の周期までに揃うかを見る。
+// 構成 1xMCP2515 / 2xMCP2515 / 1xTWAI / TWAI+MCP2515 で周期を上げていき、99% の周期で揃う上限を表示する
+// （2 本の上限が 1 本の 1.8 倍未満 / 振り分け・グループ API が合わない なら exit 1）
+//   pio run -e native-multibus && .pio/build/native-multibus/program [motors]
+#include <Arduino.h>
+#include <RS02SimCheck.h>
+#include <SPI.h>
+#include <mcp_can.h>
+#include <driver/twai.h>
+#include <Mcp2515Emu.h>
+#include <VirtualCanBus.h>
+#include <RS02SimBus.h>
+#include "RS02PrivateCAN.h"
+#include "RS02PrivateTWAI.h"
+#include "RS02MultiBus.h"
+
+#include <stdlib.h>
+
+static constexpr uint8_t HOST_ID = 0xFD;
+static constexpr uint8_t CS1 = 5;
+static constexpr uint8_t CS2 = 6;
+static constexpr uint32_t CYCLES = 300;
+static constexpr float OK_RATIO = 0.99f;
+
+using RS02SimCheck::check;
+
+struct Bench
+{
+    VirtualCanBus busT{1000000}, busM1{1000000}, busM2{1000000};
+    Mcp2515Emu emu1{&busM1}, emu2{&busM2};
+    RS02SimBus simT{&busT}, simM1{&busM1}, simM2{&busM2};
+    MCP_CAN mcp1{CS1}, mcp2{CS2};
+    RS02PrivateCAN m1{mcp1, HOST_ID}, m2{mcp2, HOST_ID};
+    RS02PrivateTWAI twai{HOST_ID, 1, 2};
+
+    // どのバスに割り当てても応答できるよう、全台を各バスのシミュレータに置く
+    explicit Bench(uint8_t n)
+    {
+        for (uint8_t id = 1; id <= n; id++)
+        {
+            simT.add(id);
+            simM1.add(id);
+            simM2.add(id);
+        }
+        SPI.attach(CS1, &emu1);
+        SPI.attach(CS2, &emu2);
+        SPI.begin();
+        ArduinoShim::attachTwai(&busT);
+        for (MCP_CAN *m : {&mcp1, &mcp2})
+        {
+            m->setFastIO(1);
+            m->begin(MCP_ANY, CAN_1000KBPS, MCP_8MHZ);
+            m->setMode(MCP_NORMAL);
+        }
+        m1.begin();
+        m2.begin();
+        twai.begin();
+    }
+    ~Bench() { ArduinoShim::attachTwai(nullptr); }
+};
+
+struct Config
+{
+    const char *name;
+    RS02PrivateBase *buses[2];
+    uint8_t nBus;
+};
+
+// 受信を読み捨てながら us 待つ
+static void spin(RS02MultiBus &mb, uint32_t us)
+{
+    uint32_t tEnd = micros() + us;
+    while ((int32_t)(micros() - tEnd) < 0)
+    {
+        mb.service();
+        delayMicroseconds(20);
+    }
+}
+
+// 送信キュー（期限 = 1 周期）を有効にして、送信完了を待たずに次のバスへ
+static void setQueue(RS02PrivateBase &bus, bool on, uint32_t deadlineUs)
+{
+    RS02TxQueueConfig q;
+    q.enabled = on;
+    q.deadlineUs = deadlineUs;
+    bus.setTxQueue(q);
+}
+
+// rateHz で CYCLES 周期回し、全台の Type2 が次の周期までに揃った割合
+static float runRate(const Config &c, const uint8_t *ids, uint8_t n, uint32_t rateHz)
+{
+    RS02MultiBus mb;
+    for (uint8_t b = 0; b < c.nBus; b++)
+        mb.addBus(*c.buses[b]);
+    mb.balance(ids, n);
+    uint32_t periodUs = 1000000 / rateHz;
+    for (uint8_t b = 0; b < c.nBus; b++)
+        setQueue(*c.buses[b], true, periodUs);
+
+    static RS02OpCmd cmd[128];
+    uint32_t ok = 0;
+    uint32_t t0 = micros() + 1000;
+    uint32_t tSent = 0;
+    for (uint32_t k = 0; k <= CYCLES; k++)
+    {
+        uint32_t tk = t0 + k * periodUs;
+        while ((int32_t)(micros() - tk) < 0)
+        {
+            if (!mb.service())
+                delayMicroseconds(2);
+        }
+        if (k > 0)
+        {
+            bool all = true;
+            for (uint8_t i = 0; i < n; i++)
+                all &= (int32_t)(mb.feedbackUs(ids[i]) - tSent) >= 0 && mb.feedbackUs(ids[i]) != 0;
+            ok += all;
+        }
+        if (k == CYCLES)
+            break;
+        for (uint8_t i = 0; i < n; i++)
+            cmd[i].posRad = 0.001f * (float)k;
+        tSent = micros();
+        mb.opControl(ids, cmd, n);
+    }
+    // 後片付け: 残りを流して次の計測へ持ち越さない
+    for (uint8_t b = 0; b < c.nBus; b++)
+        setQueue(*c.buses[b], false, periodUs);
+    spin(mb, 5000);
+    return (float)ok / (float)CYCLES;
+}
+
+// 99% の周期で揃う上限 [Hz]（50Hz 刻み）
+static uint32_t maxRate(const Config &c, const uint8_t *ids, uint8_t n)
+{
+    uint32_t best = 0;
+    for (uint32_t hz = 100; hz <= 5000; hz += 50)
+    {
+        float r = runRate(c, ids, n, hz);
+        if (r < OK_RATIO)
+            break;
+        best = hz;
+    }
+    return best;
+}
+
+// 振り分けとグループ API（2 本にまたがる enable / ランモード / 緊急停止）
+static void functional(Bench &b, const uint8_t *ids, uint8_t n)
+{
+    RS02MultiBus mb;
+    mb.addBus(b.twai);
+    mb.addBus(b.m1);
+    mb.balance(ids, n);
+    RS02SimBus *sims[2] = {&b.simT, &b.simM1};
+
+    bool split = mb.motors(0).has(ids[0]) && mb.motors(1).has(ids[1]) && mb.busIndexOf(ids[0]) == 0 &&
+                 mb.busIndexOf(ids[1]) == 1 && mb.busFor(200) == nullptr && !mb.enable(200);
+    check(split, "balance alternates motors across buses, unassigned ids are refused");
+
+    RS02MotorSet all;
+    for (uint8_t i = 0; i < n; i++)
+        all.add(ids[i]);
+    uint8_t sentMode = mb.setRunMode(all, 2);
+    spin(mb, 3000); // 応答を読んでから（MCP2515 の受信 2 面があふれないように）
+    uint8_t sentEn = mb.enable(all);
+    spin(mb, 3000);
+    // 担当バスのシミュレータだけが動き、もう一方の同じ ID は止まったまま
+    bool routed = sentMode == n && sentEn == n;
+    for (uint8_t i = 0; i < n; i++)
+    {
+        int8_t bi = mb.busIndexOf(ids[i]);
+        routed &= sims[bi]->motor(ids[i])->state().state == RS02MotorState::RUN;
+        routed &= sims[1 - bi]->motor(ids[i])->state().state != RS02MotorState::RUN;
+    }
+    check(routed, "group enable / run mode reach each motor on its own bus only");
+
+    bool fb = true;
+    for (uint8_t i = 0; i < n; i++)
+    {
+        RS02Feedback f;
+        uint32_t age = 0;
+        fb &= mb.feedback(ids[i], f, &age) && f.motorId == ids[i] && f.mode == RS02MotorState::RUN && age < 10000;
+    }
+    check(fb && mb.stats(0).stray == 0 && mb.stats(1).stray == 0, "replies are kept per motor from the bus they arrive on");
+
+    uint8_t stopped = mb.stopUrgent(all, false);
+    spin(mb, 3000);
+    bool halted = stopped == n;
+    for (uint8_t i = 0; i < n; i++)
+        halted &= sims[mb.busIndexOf(ids[i])]->motor(ids[i])->state().state == RS02MotorState::RESET;
+    check(halted, "group stopUrgent stops every motor on both buses");
+
+    // 割り当て違い: 相手のバスに届いた応答を stray に数える
+    mb.assign(ids[0], 1);
+    mb.ping(ids[0]);
+    mb.assign(ids[0], 0); // 応答が来る前に戻す → バス 1 に来た応答は stray
+    spin(mb, 2000);
+    check(mb.stats(1).stray == 1, "a reply on the wrong bus is counted as stray");
+    // Type2 でも同じ。別のバスで受けた応答は feedback() に入れない
+    uint32_t fbUs = mb.feedbackUs(ids[0]);
+    mb.assign(ids[0], 1);
+    mb.stop(ids[0], false);
+    mb.assign(ids[0], 0);
+    spin(mb, 2000);
+    check(mb.stats(1).stray == 2 && mb.feedbackUs(ids[0]) == fbUs, "a stray Type2 is counted but not stored as feedback");
+}
+
+int main(int argc, char **argv)
+{
+    int n = argc > 1 ? atoi(argv[1]) : 8;
+    if (n < 2)
+        n = 2;
+    if (n > 32)
+        n = 32;
+    ArduinoShim::useVirtualTime(true);
+    Bench b((uint8_t)n);
+    uint8_t ids[32];
+    for (int i = 0; i < n; i++)
+        ids[i] = (uint8_t)(i + 1);
+
+    functional(b, ids, (uint8_t)n);
+
+    const Config cfgs[] = {
+        {"1x MCP2515", {&b.m1, nullptr}, 1},
+        {"2x MCP2515", {&b.m1, &b.m2}, 2},
+        {"1x TWAI", {&b.twai, nullptr}, 1},
+        {"TWAI+MCP2515", {&b.twai, &b.m1}, 2},
+    };
+    uint32_t hz[4];
+    Serial.printf("%d motors, Type1 -> Type2 every cycle, 1Mbps per bus\n", n);
+    for (int i = 0; i < 4; i++)
+    {
+        hz[i] = maxRate(cfgs[i], ids, (uint8_t)n);
+        Serial.printf("  %-13s max %5lu Hz (%6lu motor updates/s)\n", cfgs[i].name, (unsigned long)hz[i],
+                      (unsigned long)hz[i] * n);
+    }
+    char what[96];
+    snprintf(what, sizeof(what), "2x MCP2515 sustains >= 1.8x the rate of one (%.2fx)", hz[0] ? (float)hz[1] / hz[0] : 0.0f);
+    check(hz[0] > 0 && hz[1] * 10 >= hz[0] * 18, what);
+    uint32_t single = hz[0] < hz[2] ? hz[0] : hz[2];
+    snprintf(what, sizeof(what), "TWAI+MCP2515 sustains >= 1.8x the slower single bus (%.2fx)", single ? (float)hz[3] / single : 0.0f);
+    check(single > 0 && hz[3] * 10 >= single * 18, what);
+
+    return RS02SimCheck::finish();
+}
@@ -0,0 +1,229 @@
+// native_params — パラメータ表のバックアップ / 復元（RS02ParamBackup）を 1Mbps の仮想バスで確かめる
+// 1) 往復: 12 台（1 台は RS05）の表を読み（RS02Idx の表 + 0x7000..0x7025 の範囲。シミュレータに無い index は落ちる）、
+//    バイナリにして戻す（壊れたデータ / 違う版は受け付けない）。設定を書き換えて保存し、1 台は ID も変えてから
+//    復元して、違っていた index だけ Type18 を送り、変えたモータだけ Type22 を 1 回送るか / 電源を入れ直しても戻っているかを見る
+// 2) 時間: 応答の遅いモータ（1ms）16 台の表を、1 つずつ readParamRaw で読むのと比べる（TWAI / MCP2515）
+// （値が違う / 余計な書き込み / 保存されていない / 受信あふれ / 1 つずつより遅い / 1 秒を超える なら exit 1）
+//   pio run -e native-params && .pio/build/native-params/program
+#include <Arduino.h>
+#include <RS02SimBench.h>
+#include "RS02ParamBackup.h"
+
+static constexpr uint8_t N_FLEET = 12;
+static constexpr uint8_t RS05_ID = 7;
+static constexpr uint8_t N_TIMING = 16;
+static constexpr uint32_t SLOW_REPLY_US = 1000;
+
+using RS02SimCheck::check;
+using Bench = RS02SimBench;
+
+// スナップショットの値がシミュレータのモータと同じか
+static bool snapMatchesSim(const RS02ParamSnapshot &s, RS02SimBus &sim, uint16_t expectParams)
+{
+    if (s.count() != sim.count())
+        return false;
+    for (uint8_t i = 0; i < s.count(); i++)
+    {
+        const RS02ParamMotor &m = s.motor(i);
+        const RS02SimMotor *sm = sim.motor(m.id);
+        if (!sm || sm->uid() != m.uid || m.n != expectParams)
+            return false;
+        for (uint16_t k = 0; k < m.n; k++)
+        {
+            uint8_t v[4];
+            if (!sm->readParam(m.p[k].index, v) || !m.p[k].sameValue(v))
+                return false;
+        }
+    }
+    return true;
+}
+
+static float simF(RS02SimBus &sim, uint8_t id, uint16_t index)
+{
+    return sim.motor(id) ? sim.motor(id)->paramF(index) : NAN;
+}
+
+static void roundTrip(bool useMcp)
+{
+    using R = RS02RestoreResult;
+    const char *name = useMcp ? "mcp2515" : "twai";
+    char what[160];
+    Bench b(100);
+    for (uint8_t id = 1; id <= N_FLEET; id++)
+        b.sim.add(id, 0, id == RS05_ID ? RS02SimModel::rs05() : RS02SimModel::rs02());
+    delay(5);
+    b.drain();
+    RS02PrivateBase &rs = b.rs(useMcp);
+
+    // 1) 読む（RS02Idx の表 + 0x7000 台の範囲）
+    RS02ParamList list = RS02ParamList::standard();
+    uint16_t nStd = list.count();
+    uint16_t nRange = list.addRange(0x7000, 0x7025, RS02ParamType::F32);
+    RS02ParamBackup pb(rs);
+    RS02ParamSnapshot snap;
+    uint32_t lost0 = b.lost(useMcp);
+    pb.dump(list, snap);
+    uint32_t lostDump = b.lost(useMcp) - lost0;
+    b.drain();
+    if (!useMcp)
+        Serial.printf("dump: %u motor(s) x %u index in %.1fms (scan %.1fms, %u Type17, %u unsupported)\n", snap.count(),
+                      list.count(), pb.stats().totalUs / 1000.0f, pb.stats().scanUs / 1000.0f, pb.stats().reads,
+                      pb.stats().unsupported);
+    snprintf(what, sizeof(what), "%s: dump of %u motors holds the %u sim params each, matching the motors", name, N_FLEET,
+             nStd);
+    check(snapMatchesSim(snap, b.sim, nStd), what);
+    snprintf(what, sizeof(what), "%s: unknown indices in the range sweep are dropped (%u of %u x %u), no timeouts", name,
+             pb.stats().unsupported, nRange, N_FLEET);
+    check(pb.stats().unsupported == nRange * N_FLEET && pb.stats().timeouts == 0, what);
+    const RS02ParamMotor *m5 = snap.findUid(b.sim.motor(RS05_ID)->uid());
+    snprintf(what, sizeof(what), "%s: RS05 keeps its own torque limit (5.5Nm)", name);
+    check(m5 && m5->find(RS02Idx::LIMIT_TORQUE) && m5->find(RS02Idx::LIMIT_TORQUE)->f() == 5.5f, what);
+
+    // 2) バイナリで往復
+    static uint8_t buf[RS02_PARAM_MOTORS * (16 + RS02_PARAM_MAX * 8) + 16], buf2[sizeof(buf)];
+    size_t len = snap.encode(buf, sizeof(buf));
+    static RS02ParamSnapshot back;
+    bool dec = back.decode(buf, len);
+    size_t len2 = back.encode(buf2, sizeof(buf2));
+    snprintf(what, sizeof(what), "%s: %u-byte snapshot decodes and re-encodes to the same bytes", name, (unsigned)len);
+    check(len == snap.encodedSize() && dec && len2 == len && !memcmp(buf, buf2, len) && !snap.encode(buf2, len - 1), what);
+    static RS02ParamSnapshot bad;
+    buf2[len / 2] ^= 0x04;
+    bool badCrc = bad.decode(buf2, len);
+    memcpy(buf2, buf, len);
+    buf2[4] = RS02ParamSnapshot::VERSION + 1;
+    bool badVer = bad.decode(buf2, len);
+    bool badLen = bad.decode(buf, len - 1);
+    snprintf(what, sizeof(what), "%s: a flipped bit, another version or a short buffer is rejected", name);
+    check(!badCrc && !badVer && !badLen && bad.count() == 0, what);
+
+    // 3) 設定を書き換えて保存。モータ 4 は ID 40 へ、モータ 1 は回しておく（読むだけの値）
+    rs.writeFloatParam(2, RS02Idx::LIMIT_TORQUE, 9.0f);
+    rs.writeFloatParam(2, RS02Idx::SPD_KP, 3.5f);
+    rs.writeFloatParam(2, RS02Idx::LOC_KP, 12.0f);
+    rs.saveParams(2);
+    rs.writeFloatParam(5, RS02Idx::LIMIT_SPD, 8.0f);
+    rs.saveParams(5);
+    uint8_t one[4] = {1, 0, 0, 0};
+    rs.writeParamLE(RS05_ID, RS02Idx::RUN_MODE, one);
+    rs.writeFloatParam(RS05_ID, RS02Idx::LIMIT_CUR, 4.0f);
+    rs.saveParams(RS05_ID);
+    rs.setMotorId(4, 40);
+    delay(2);
+    rs.saveParams(40);
+    b.sim.motor(1)->setPosition(1.25);
+    delay(5);
+    b.drain();
+    const uint16_t changed = 6; // 2: 3 個, 5: 1 個, RS05: 2 個
+
+    // 4) 復元（UID で探すのでモータ 4 は 40 に居ても見つかる。居ない UID の行も 1 つ足す）
+    back.addMotor(0x1111222233334444ULL, 99)->n = 0;
+    lost0 = b.lost(useMcp);
+    uint8_t ok = pb.restore(back);
+    uint32_t lostRestore = b.lost(useMcp) - lost0;
+    b.drain();
+    if (!useMcp)
+        pb.print(Serial);
+    bool results = back.count() == N_FLEET + 1 && pb.restoreCount() == back.count();
+    for (uint8_t i = 0; results && i < back.count(); i++)
+    {
+        const RS02RestoreItem &r = pb.restoreItem(i);
+        uint8_t id0 = back.motor(i).id;
+        R want = id0 == 2 || id0 == 5 || id0 == RS05_ID ? R::Ok : id0 == 99 ? R::NotFound : R::Unchanged;
+        results = r.result == want && (want != R::Ok || r.saved) && (id0 != 4 || r.id == 40);
+    }
+    snprintf(what, sizeof(what), "%s: changed motors restored and saved, the moved motor found at ID 40, missing UID reported",
+             name);
+    check(results && ok == N_FLEET, what);
+    snprintf(what, sizeof(what), "%s: only the %u differing values written (%u Type18), one Type22 per changed motor (%u)",
+             name, changed, pb.stats().writes, pb.stats().saves);
+    check(pb.stats().differ == changed && pb.stats().writes == changed && pb.stats().saves == 3 &&
+              pb.stats().verifyFails == 0,
+          what);
+    snprintf(what, sizeof(what), "%s: no receive overruns (%lu lost)", name, (unsigned long)(lostDump + lostRestore));
+    check(lostDump + lostRestore == 0, what);
+
+    // 5) 電源を入れ直しても戻っているか（ID と位置はそのまま）
+    b.sim.powerCycleAll();
+    delay(5);
+    b.drain();
+    bool back2 = simF(b.sim, 2, RS02Idx::LIMIT_TORQUE) == 17.0f && simF(b.sim, 2, RS02Idx::SPD_KP) == 2.0f &&
+                 simF(b.sim, 2, RS02Idx::LOC_KP) == 30.0f && simF(b.sim, 5, RS02Idx::LIMIT_SPD) == 2.0f &&
+                 simF(b.sim, RS05_ID, RS02Idx::LIMIT_CUR) == RS02SimModel::rs05().peakCurA;
+    uint8_t rm[4] = {};
+    b.sim.motor(RS05_ID)->readParam(RS02Idx::RUN_MODE, rm);
+    snprintf(what, sizeof(what), "%s: after a power cycle the restored values stick; motor 4 stays at ID 40", name);
+    check(back2 && rm[0] == 0 && b.sim.motor(40) && !b.sim.motor(4), what);
+}
+
+struct Timing
+{
+    uint32_t us;
+    uint16_t values;
+    uint32_t lost;
+};
+
+static Timing timing(bool useMcp, bool engine)
+{
+    Bench b(SLOW_REPLY_US);
+    for (uint8_t id = 1; id <= N_TIMING; id++)
+        b.sim.add(id);
+    delay(5);
+    b.drain();
+    RS02PrivateBase &rs = b.rs(useMcp);
+    RS02ParamList list = RS02ParamList::standard();
+    Timing t = {0, 0, 0};
+    uint32_t lost0 = b.lost(useMcp);
+    uint32_t t0 = micros();
+    if (engine)
+    {
+        RS02ParamBackup pb(rs);
+        static RS02ParamSnapshot snap;
+        RS02ParamBackupConfig cfg;
+        cfg.scan.expect = N_TIMING;
+        pb.dump(list, snap, cfg);
+        t.us = micros() - t0;
+        for (uint8_t i = 0; i < snap.count(); i++)
+            t.values += snap.motor(i).n;
+    }
+    else
+    {
+        // ID は分かっている前提で 1 つずつ
+        for (uint8_t id = 1; id <= N_TIMING; id++)
+            for (uint16_t j = 0; j < list.count(); j++)
+            {
+                uint8_t le[4];
+                t.values += rs.readParamRaw(id, list.spec(j).index, le);
+            }
+        t.us = micros() - t0;
+    }
+    t.lost = b.lost(useMcp) - lost0;
+    b.drain();
+    return t;
+}
+
+int main()
+{
+    ArduinoShim::useVirtualTime(true);
+
+    roundTrip(false);
+    roundTrip(true);
+
+    Timing seqT = timing(false, false), engT = timing(false, true);
+    Timing seqM = timing(true, false), engM = timing(true, true);
+    const uint16_t want = N_TIMING * RS02ParamList::standard().count();
+    Serial.printf("\n%u motors x %u params, motor reply latency %luus\n", N_TIMING, RS02ParamList::standard().count(),
+                  (unsigned long)SLOW_REPLY_US);
+    Serial.printf("  %-44s %10s %6s\n", "", "time", "values");
+    Serial.printf("  %-44s %8.1fms %6u\n", "readParamRaw one by one (twai, IDs known)", seqT.us / 1000.0f, seqT.values);
+    Serial.printf("  %-44s %8.1fms %6u\n", "RS02ParamBackup dump (twai, incl. scan)", engT.us / 1000.0f, engT.values);
+    Serial.printf("  %-44s %8.1fms %6u\n", "readParamRaw one by one (mcp2515, IDs known)", seqM.us / 1000.0f, seqM.values);
+    Serial.printf("  %-44s %8.1fms %6u\n", "RS02ParamBackup dump (mcp2515, incl. scan)", engM.us / 1000.0f, engM.values);
+    check(seqT.values == want && engT.values == want && seqM.values == want && engM.values == want,
+          "every value read in all four runs");
+    check(engT.lost == 0 && engM.lost == 0, "no receive overruns while dumping");
+    check(engT.us < seqT.us && engM.us < seqM.us, "the pipelined dump beats one-by-one reads even including the scan");
+    check(engT.us < 1000000 && engM.us < 1000000, "fleet-wide dump stays under a second");
+
+    return RS02SimCheck::finish();
+}
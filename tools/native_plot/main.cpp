@@ -0,0 +1,177 @@
+// native_plot — スクロールプロット（RS02UiPlot）: 列ごとの min / max 間引き, スクロール描画, 自動スケール
+// 1kHz の 位置 / 速度 / トルク（トルクに 1 サンプルだけのスパイク）を 16 サンプル / 列で入れ、60fps で描く。
+// 描画先は M5Canvas と同じ fillRect / drawFastVLine / scroll を持つピクセルバッファ（M5GFX の SDL パネルは native 環境に無い）。
+// 間引きでスパイクが残るか、スクロールで描いた画面が全体の描き直しと 1 ピクセルも違わないか、1 フレームの書き込み量を確かめる
+// （スパイクが消える / 画面が食い違う / スクロールのフレームが全体の 1/10 以上書く なら exit 1）
+//   pio run -e native-plot && .pio/build/native-plot/program [seconds]
+#include <Arduino.h>
+#include <RS02SimCheck.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "RS02UiPlot.h"
+
+static constexpr int16_t W = 308, H = 52; // allFunction のモニタ下段と同じ
+static constexpr uint16_t SPC = 16;       // 1kHz → 62.5 列/s（約 5s ぶん表示）
+static constexpr uint16_t C_POS = 0x07E0, C_VEL = 0x001F, C_TQ = 0xF800;
+
+using RS02SimCheck::check;
+
+// M5Canvas の代役（16bit ピクセルバッファ, 書いたピクセル数を数える）
+class Canvas
+{
+public:
+    std::vector<uint16_t> px;
+    uint64_t written = 0;
+    uint64_t moved = 0;
+    Canvas() : px((size_t)W * H, 0) {}
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t c)
+    {
+        for (int32_t j = y; j < y + h; j++)
+            for (int32_t i = x; i < x + w; i++)
+                set(i, j, c);
+    }
+    void drawFastVLine(int32_t x, int32_t y, int32_t h, uint16_t c) { fillRect(x, y, 1, h, c); }
+    void scroll(int32_t dx, int32_t dy)
+    {
+        (void)dy; // 横だけ（左へ: dx < 0）
+        for (int32_t j = 0; j < H; j++)
+        {
+            uint16_t *row = &px[(size_t)j * W];
+            memmove(row, row - dx, (size_t)(W + dx) * sizeof(uint16_t));
+        }
+        moved += (uint64_t)(W + dx) * H;
+    }
+    uint16_t at(int32_t x, int32_t y) const { return px[(size_t)y * W + x]; }
+
+private:
+    void set(int32_t x, int32_t y, uint16_t c)
+    {
+        if (x < 0 || y < 0 || x >= W || y >= H)
+            return;
+        px[(size_t)y * W + x] = c;
+        written++;
+    }
+};
+
+static void signals(uint32_t k, float v[3], uint32_t spikeAt)
+{
+    float t = (float)k * 0.001f;
+    v[0] = 3.0f * sinf(2.0f * (float)M_PI * 0.5f * t);
+    v[1] = 3.0f * (float)M_PI * cosf(2.0f * (float)M_PI * 0.5f * t);
+    v[2] = 0.4f * sinf(2.0f * (float)M_PI * 3.0f * t);
+    if (k == spikeAt)
+        v[2] = 6.0f;
+}
+
+static void setup3(RS02UiPlot &p, uint16_t spc)
+{
+    p.begin(W, H, spc);
+    p.addTrace(C_POS);
+    p.addTrace(C_VEL);
+    p.addTrace(C_TQ);
+}
+
+// トレースの色が y <= yMax にあるか
+static bool hasColorAbove(const Canvas &c, uint16_t color, int yMax)
+{
+    for (int y = 0; y <= yMax; y++)
+        for (int x = 0; x < W; x++)
+            if (c.at(x, y) == color)
+                return true;
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t seconds = argc > 1 ? (uint32_t)atoi(argv[1]) : 10;
+    if (seconds < 6)
+        seconds = 6;
+    ArduinoShim::useVirtualTime(false); // render の所要時間はホストの実時間で
+
+    const uint32_t total = seconds * 1000;
+    const uint32_t spikeAt = total - 1500; // 最後に表示中の範囲に入る位置
+    RS02UiPlot plot, naive;
+    setup3(plot, SPC);
+    setup3(naive, 1); // 比較: 16 サンプルに 1 つだけ拾う間引き
+    Canvas a, n;
+    uint64_t scrollWritten = 0;
+    uint32_t scrollFrames = 0;
+    bool spikeSeen = false;
+
+    uint32_t frame = 0;
+    for (uint32_t k = 0; k < total; k++)
+    {
+        float v[3];
+        signals(k, v, spikeAt);
+        plot.addSample(v);
+        if (k % SPC == 0)
+            naive.addSample(v);
+        if ((k + 1) * 60 / 1000 == frame)
+            continue;
+        frame = (k + 1) * 60 / 1000; // 60fps
+        uint32_t full0 = plot.stats().fullRedraws;
+        uint64_t w0 = a.written;
+        plot.render(a);
+        naive.render(n);
+        if (plot.stats().fullRedraws == full0)
+        {
+            scrollWritten += a.written - w0;
+            scrollFrames++;
+        }
+        if (k > spikeAt && k < spikeAt + 100)
+            spikeSeen |= hasColorAbove(a, C_TQ, H / 10); // スケール上端（+10% の余白）付近
+    }
+    const RS02PlotStats &s = plot.stats();
+    double perScroll = scrollFrames ? (double)scrollWritten / scrollFrames : 0.0;
+    Serial.printf("%lus at 1kHz, %u samples/column, %dx%d, 3 traces, 60fps\n", (unsigned long)seconds, SPC, W, H);
+    Serial.printf("  frames %lu (scroll %lu, full redraw %lu, rescale %lu), columns %lu\n", (unsigned long)s.frames,
+                  (unsigned long)s.scrolled, (unsigned long)s.fullRedraws, (unsigned long)s.rescales,
+                  (unsigned long)s.columns);
+    Serial.printf("  px written per scroll frame %.0f (full %d), render mean %.1f / max %lu us (host)\n", perScroll, W * H,
+                  s.frames ? (double)s.totalFrameUs / s.frames : 0.0, (unsigned long)s.maxFrameUs);
+    Serial.printf("  torque scale: min/max %.2f..%.2f, every-16th-sample %.2f..%.2f\n", plot.lo(2), plot.hi(2), naive.lo(2),
+                  naive.hi(2));
+
+    check(spikeSeen && plot.hi(2) > 6.0f, "a one-sample torque spike survives 16:1 decimation (min/max per column)");
+    check(naive.hi(2) < 1.0f, "picking every 16th sample instead would have hidden it");
+    check(perScroll * 10 < (double)W * H, "a scrolled frame writes under 1/10 of the plot area");
+    check(s.scrolled > s.fullRedraws * 10, "most frames scroll instead of redrawing");
+
+    // スクロールで描いた画面 = 同じ列を全体で描き直した画面
+    Canvas b;
+    plot.invalidate();
+    plot.render(b);
+    check(a.px == b.px, "the scrolled canvas is pixel-identical to a full redraw");
+
+    // 一定値でもスケールが潰れず、フレームごとに描き直さない
+    RS02UiPlot flat;
+    flat.begin(W, H, 1);
+    flat.addTrace(C_POS);
+    Canvas f;
+    for (int i = 0; i < 200; i++)
+    {
+        float v = 1.0f;
+        flat.addSample(&v);
+        flat.render(f);
+    }
+    check(flat.stats().fullRedraws <= 2 && flat.hi(0) > flat.lo(0), "a constant trace settles on one scale");
+
+    // 固定範囲: はみ出しは端に張り付き、描き直さない
+    RS02UiPlot fixed;
+    fixed.begin(W, H, 1);
+    fixed.addTrace(C_TQ);
+    fixed.setRange(0, -1.0f, 1.0f);
+    Canvas g;
+    for (int i = 0; i < 100; i++)
+    {
+        float v = (i == 50) ? 10.0f : 0.0f;
+        fixed.addSample(&v);
+        fixed.render(g);
+    }
+    check(fixed.stats().rescales == 0 && fixed.stats().fullRedraws == 1 && hasColorAbove(g, C_TQ, 0),
+          "a fixed range clips instead of rescaling");
+
+    return RS02SimCheck::finish();
+}
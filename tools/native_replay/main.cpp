@@ -0,0 +1,261 @@
+// native_replay — 送受信の記録（RS02CanLogRecorder）と再生（RS02PrivateReplay）の回帰確認
+// シミュレータ相手の一連の操作を candump 形式で記録し、同じ操作を再生バックエンドに通して
+// 解析結果（パラメータ読み/Type2）が一致するかを 待たない/記録どおり/10倍速 で確認する（不一致なら exit 1）
+//   pio run -e native-replay && .pio/build/native-replay/program [out.log]
+//   .pio/build/native-replay/program --play field.log [speed]   // 現場ログを流して Type2/Type17 を表示
+#include <Arduino.h>
+#include <RS02SimCheck.h>
+#include <driver/twai.h>
+#include <VirtualCanBus.h>
+#include <RS02SimBus.h>
+#include "RS02PrivateTWAI.h"
+#include "RS02PrivateReplay.h"
+#include "RS02CanLog.h"
+
+#include <stdlib.h>
+
+using RS02SimCheck::check;
+
+// FILE* を Print / ログ読み出し元に
+class FilePrint : public Print
+{
+public:
+    explicit FilePrint(FILE *fp) : _fp(fp) {}
+    size_t write(uint8_t c) override { return fputc(c, _fp) == EOF ? 0 : 1; }
+    size_t write(const uint8_t *buf, size_t n) override { return fwrite(buf, 1, n, _fp); }
+    using Print::write;
+
+private:
+    FILE *_fp;
+};
+
+class FileSource : public RS02CanLogSource
+{
+public:
+    explicit FileSource(FILE *fp) : _fp(fp) {}
+    bool readLine(char *buf, size_t n) override
+    {
+        if (!fgets(buf, (int)n, _fp))
+            return false;
+        buf[strcspn(buf, "\r\n")] = 0;
+        return true;
+    }
+
+private:
+    FILE *_fp;
+};
+
+// ===== 記録/再生で同じ操作 =====
+static const uint16_t PARAMS[] = {RS02Idx::MECH_POS, RS02Idx::MECH_VEL, RS02Idx::SPD_REF, RS02Idx::LIMIT_CUR, RS02Idx::IQ_REF};
+static constexpr int N_PARAMS = sizeof(PARAMS) / sizeof(PARAMS[0]);
+static constexpr int N_FEEDBACK = 30;
+
+struct SessionResult
+{
+    bool okEnter = false;
+    uint8_t runMode = 0xFF;
+    float params[N_PARAMS] = {};
+    bool paramOk[N_PARAMS] = {};
+    RS02Feedback fb[N_FEEDBACK];
+    int nFeedback = 0;
+    uint32_t durationUs = 0;
+};
+
+static void runSession(RS02PrivateBase &can, uint8_t motorId, SessionResult &r)
+{
+    uint32_t t0 = micros();
+    r.okEnter = can.enterVelocity(motorId, 8.0f, 40.0f);
+    r.okEnter &= can.enable(motorId);
+    r.okEnter &= can.velocityRef(motorId, 4.0f);
+
+    // Type2 を N_FEEDBACK 個（アクティブレポート 10ms）
+    can.setReportIntervalTicks(motorId, 1);
+    can.setActiveReport(motorId, true);
+    RS02PrivFrame f;
+    uint32_t w0 = millis();
+    while (r.nFeedback < N_FEEDBACK && millis() - w0 < 2000)
+    {
+        if (!can.readAny(f))
+        {
+            delayMicroseconds(100);
+            continue;
+        }
+        if (rs02FrameType(f.id) == RS02Type::FEEDBACK && ((f.id >> 8) & 0xFF) == motorId)
+            can.parseFeedback(f, r.fb[r.nFeedback++]);
+    }
+    can.setActiveReport(motorId, false);
+
+    for (int i = 0; i < N_PARAMS; i++)
+        r.paramOk[i] = can.readFloatParam(motorId, PARAMS[i], r.params[i]);
+    can.readRunMode(motorId, r.runMode);
+    can.stop(motorId, false);
+    r.durationUs = micros() - t0;
+}
+
+static bool sameResult(const SessionResult &a, const SessionResult &b)
+{
+    if (a.okEnter != b.okEnter || a.runMode != b.runMode || a.nFeedback != b.nFeedback)
+        return false;
+    for (int i = 0; i < N_PARAMS; i++)
+        if (a.paramOk[i] != b.paramOk[i] || memcmp(&a.params[i], &b.params[i], sizeof(float)) != 0)
+            return false;
+    for (int i = 0; i < a.nFeedback; i++)
+    {
+        const RS02Feedback &x = a.fb[i], &y = b.fb[i];
+        if (x.motorId != y.motorId || x.faultBits != y.faultBits || x.mode != y.mode || x.angleRad != y.angleRad ||
+            x.velRadS != y.velRadS || x.torqueNm != y.torqueNm || x.tempC != y.tempC)
+            return false;
+    }
+    return true;
+}
+
+// 記録を最後まで流し、送信もすべて一致したか
+static bool replayOnce(const char *path, float speed, const SessionResult &ref, uint8_t motorId, const char *label)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return false;
+    FileSource src(fp);
+    RS02PrivateReplay rp(0xFD, src);
+    RS02ReplayConfig cfg;
+    cfg.speed = speed;
+    rp.setConfig(cfg);
+    bool ok = rp.begin();
+
+    SessionResult r;
+    runSession(rp, motorId, r);
+    fclose(fp);
+
+    const RS02ReplayStats &s = rp.stats();
+    Serial.printf("  %-8s rx=%lu tx=%lu matched=%lu mismatch=%lu unexpected=%lu  %.1f ms (rec %.1f ms)\n", label,
+                  (unsigned long)s.rxFed, (unsigned long)s.txSent, (unsigned long)s.txMatched, (unsigned long)s.txMismatch,
+                  (unsigned long)s.txUnexpected, r.durationUs / 1000.0, ref.durationUs / 1000.0);
+    if (s.txMismatch)
+    {
+        const RS02CanLogEntry &e = rp.firstMismatchExpected();
+        Serial.printf("  first mismatch: log %08lX sent %08lX\n", (unsigned long)e.f.id, (unsigned long)rp.firstMismatchSent().id);
+    }
+    return ok && rp.done() && s.txMismatch == 0 && s.txUnexpected == 0 && s.txSent == s.txMatched && sameResult(ref, r);
+}
+
+// 現場ログを流して表示（送信は同期しない）
+static int play(const char *path, float speed)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+    {
+        Serial.printf("cannot open %s\n", path);
+        return 2;
+    }
+    FileSource src(fp);
+    RS02PrivateReplay rp(0xFD, src);
+    RS02ReplayConfig cfg;
+    cfg.speed = speed;
+    cfg.syncOnTx = false;
+    rp.setConfig(cfg);
+    if (!rp.begin())
+    {
+        Serial.printf("empty log\n");
+        return 2;
+    }
+    RS02PrivFrame f;
+    while (!rp.done())
+    {
+        if (!rp.readAny(f))
+        {
+            delayMicroseconds(100);
+            continue;
+        }
+        uint8_t type = rs02FrameType(f.id);
+        RS02Feedback fb;
+        if (type == RS02Type::FEEDBACK && rp.parseFeedback(f, fb))
+            Serial.printf("%10lu  T2  id=%3u mode=%u fault=%04X pos=%8.3f vel=%8.3f tq=%7.3f temp=%.1f\n", (unsigned long)f.tsUs,
+                          fb.motorId, fb.mode, fb.faultBits, fb.angleRad, fb.velRadS, fb.torqueNm, fb.tempC);
+        else if (type == RS02Type::READ_PARAM)
+        {
+            float v;
+            memcpy(&v, &f.data[4], 4);
+            Serial.printf("%10lu  T17 id=%3u idx=%04X val=%g\n", (unsigned long)f.tsUs, (unsigned)((f.id >> 8) & 0xFF),
+                          (unsigned)(f.data[0] | (f.data[1] << 8)), v);
+        }
+    }
+    fclose(fp);
+    const RS02ReplayStats &s = rp.stats();
+    Serial.printf("# rx=%lu txSkipped=%lu badLines=%lu\n", (unsigned long)s.rxFed, (unsigned long)s.txSkipped,
+                  (unsigned long)s.badLines);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    ArduinoShim::useVirtualTime(true);
+    if (argc > 2 && strcmp(argv[1], "--play") == 0)
+        return play(argv[2], argc > 3 ? (float)atof(argv[3]) : 1.0f);
+
+    const char *path = argc > 1 ? argv[1] : "/tmp/rs02_session.log";
+    const uint8_t MOTOR = 2;
+
+    // 形式: 整形 → 解析で元に戻る
+    {
+        RS02CanLogEntry e, back;
+        e.f.id = 0x0200FD01;
+        e.f.isExt = true;
+        e.f.dlc = 8;
+        for (uint8_t i = 0; i < 8; i++)
+            e.f.data[i] = (uint8_t)(0xA0 + i);
+        e.tsUs = 1697012345123456ULL;
+        e.tx = true;
+        char line[64];
+        size_t n = RS02CanLog::formatLine(e, "can0", true, line, sizeof(line));
+        bool ok = n > 0 && strcmp(line, "(1697012345.123456) can0 0200FD01#A0A1A2A3A4A5A6A7 T") == 0;
+        ok &= RS02CanLog::parseLine(line, back) && back.tx && back.tsUs == e.tsUs && back.f.id == e.f.id &&
+              back.f.dlc == 8 && memcmp(back.f.data, e.f.data, 8) == 0;
+        // candump の生ログ（方向なし = 受信, 短いデータ, 標準ID）
+        ok &= RS02CanLog::parseLine("(1.5) vcan0 123#0102", back) && !back.tx && !back.f.isExt && back.f.id == 0x123 &&
+              back.f.dlc == 2 && back.tsUs == 1500000ULL;
+        ok &= !RS02CanLog::parseLine("(1.0) can0 123#R", back) && !RS02CanLog::parseLine("# comment", back);
+        check(ok, "candump line format round trip");
+    }
+
+    // 記録: シミュレータ相手
+    SessionResult ref;
+    {
+        VirtualCanBus bus(1000000);
+        ArduinoShim::attachTwai(&bus);
+        RS02SimBus sim(&bus);
+        sim.add(1);
+        sim.add(MOTOR);
+
+        RS02PrivateTWAI can(0xFD, 1, 2);
+        can.begin();
+        RS02CanLogRecorder rec(can);
+        rec.setEpochUs(1697000000000000ULL);
+        rec.begin();
+
+        FILE *fp = fopen(path, "w");
+        if (!fp)
+        {
+            Serial.printf("cannot write %s\n", path);
+            return 2;
+        }
+        FilePrint out(fp);
+        runSession(can, MOTOR, ref);
+        rec.flush(out);
+        fclose(fp);
+        rec.end();
+        ArduinoShim::attachTwai(nullptr);
+
+        const RS02CanLogStats &s = rec.stats();
+        Serial.printf("  recorded %lu frames (%lu written, %lu dropped) -> %s\n", (unsigned long)s.recorded,
+                      (unsigned long)s.written, (unsigned long)s.dropped, path);
+        check(s.dropped == 0 && s.written == s.recorded && ref.okEnter && ref.nFeedback == N_FEEDBACK,
+              "record session against simulator");
+    }
+
+    // 再生: 待たない / 記録どおり / 10倍速
+    check(replayOnce(path, 0.0f, ref, MOTOR, "x0"), "replay (no wait) decodes the same state");
+    check(replayOnce(path, 1.0f, ref, MOTOR, "x1"), "replay (recorded timing) decodes the same state");
+    check(replayOnce(path, 10.0f, ref, MOTOR, "x10"), "replay (10x) decodes the same state");
+
+    return RS02SimCheck::finish();
+}
@@ -0,0 +1,362 @@
+// native_scale — 多軸スケール試験: N 台のシミュレータ（1 本の 1Mbps 仮想バス）を TWAI(シム) から制御し、
+// モータ数 × 制御周期 × テレメトリ負荷 を掃引して、どこで設計が破綻するかを数字で出す
+//   pio run -e native-scale && .pio/build/native-scale/program [--motors 8,16,24,32] [--rates 100,250,500,1000]
+//                                  [--telemetry none,report,poll] [--ms 1000] [--rxq 5] [--txq 5] [--csv]
+// 1 周期 = 全モータへ Type1(opControl) → 受信を吸い出して Type2 を解析（+ テレメトリ）
+//   none  : Type1 への Type2 応答のみ
+//   report: アクティブレポート（Type24, 10ms）を全モータで有効
+//   poll  : 1 周期に 1 台ずつ Type17 で MECH_POS を読む（ラウンドロビン）
+// 出力: 達成周期 / 周期超過 / 帰還の鮮度（周期開始時点の最終 Type2 からの経過, listener で見る）/
+//       1 周期あたりの Type2 数 / 受信取りこぼし（TWAI rx_missed）/ 送信失敗 / シミュレータの送信待ちあふれ /
+//       1 周期あたりの CPU 時間（ライブラリ+ドライバ と シミュレータ を分けて, ホスト CPU）/ バス利用率
+#include <Arduino.h>
+#include <driver/twai.h>
+#include <VirtualCanBus.h>
+#include <RS02SimBus.h>
+#include "RS02PrivateTWAI.h"
+#include "RS02BusLoad.h"
+
+#include <time.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+static uint64_t threadCpuNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// 時刻源の CPU 時間を数える（シミュレータ/バスの分をライブラリ側から差し引くため）
+class CpuMeter : public ShimTimeSource
+{
+public:
+    explicit CpuMeter(ShimTimeSource *inner) : _inner(inner) {}
+    uint64_t nextEventNs() override { return _inner->nextEventNs(); }
+    void runUntil(uint64_t nowNs) override
+    {
+        uint64_t t0 = threadCpuNs();
+        _inner->runUntil(nowNs);
+        cpuNs += threadCpuNs() - t0;
+    }
+    uint64_t cpuNs = 0;
+
+private:
+    ShimTimeSource *_inner;
+};
+
+// 帰還の到着（readParamRaw が読み捨てる Type2 も listener には来る）
+class FeedbackTracker : public RS02FrameListener
+{
+public:
+    explicit FeedbackTracker(int n) : lastUs(n + 1, 0), seen(n + 1, false) {}
+    std::vector<uint32_t> lastUs;
+    std::vector<bool> seen;
+    uint32_t frames = 0;
+    void onRxFrame(const RS02PrivFrame &f) override
+    {
+        if (!f.isExt || rs02FrameType(f.id) != RS02Type::FEEDBACK)
+            return;
+        uint8_t id = (uint8_t)((f.id >> 8) & 0xFF);
+        if (id == 0 || id >= lastUs.size())
+            return;
+        lastUs[id] = f.tsUs;
+        seen[id] = true;
+        frames++;
+    }
+};
+
+enum class Telemetry : uint8_t
+{
+    None,
+    Report,
+    Poll
+};
+static const char *telemetryName(Telemetry t) { return t == Telemetry::None ? "none" : (t == Telemetry::Report ? "report" : "poll"); }
+
+struct RunResult
+{
+    int motors = 0;
+    uint32_t rateHz = 0;
+    Telemetry tel = Telemetry::None;
+    float achievedHz = 0.0f;
+    uint32_t cycles = 0;
+    uint32_t overruns = 0;
+    float cycleP50Us = 0.0f, cycleP99Us = 0.0f, cycleMaxUs = 0.0f;
+    float freshMeanUs = 0.0f, freshP99Us = 0.0f, freshMaxUs = 0.0f;
+    float fbPerCycle = 0.0f;  // 1 周期に受け取った Type2（理想は N, report なら +α）
+    uint32_t staleMotors = 0; // 一度も Type2 が来なかったモータ
+    uint32_t rxMissed = 0;
+    uint32_t txFailed = 0;
+    uint32_t simDropped = 0;
+    uint32_t pollFail = 0;
+    float libCpuUsPerCycle = 0.0f;
+    float simCpuUsPerCycle = 0.0f;
+    float busPct = 0.0f;
+};
+
+static float pct(std::vector<float> &v, float p)
+{
+    if (v.empty())
+        return 0.0f;
+    size_t k = (size_t)((float)(v.size() - 1) * p / 100.0f);
+    std::nth_element(v.begin(), v.begin() + (long)k, v.end());
+    return v[k];
+}
+
+struct QueueCfg
+{
+    uint16_t rx = 5;
+    uint16_t tx = 5;
+};
+
+static RunResult runOne(int nMotors, uint32_t rateHz, Telemetry tel, uint32_t runMs, const QueueCfg &q)
+{
+    RunResult r;
+    r.motors = nMotors;
+    r.rateHz = rateHz;
+    r.tel = tel;
+
+    VirtualCanBus bus(1000000);
+    ArduinoShim::attachTwai(&bus);
+    RS02SimBus sim(&bus);
+    for (int i = 1; i <= nMotors; i++)
+        sim.add((uint8_t)i);
+    // 時刻源をメータ経由に差し替え（登録順は保つ）
+    CpuMeter busMeter(&bus), simMeter(&sim);
+    ArduinoShim::removeTimeSource(&bus);
+    ArduinoShim::removeTimeSource(&sim);
+    ArduinoShim::addTimeSource(&busMeter);
+    ArduinoShim::addTimeSource(&simMeter);
+
+    RS02PrivateTWAI can(0xFD, 1, 2);
+    can.setQueueLength(q.rx, q.tx);
+    can.begin();
+    RS02BusLoad bl(can);
+    bl.begin();
+    FeedbackTracker fbt(nMotors);
+    can.addListener(&fbt);
+
+    // Operation モードで有効化
+    RS02PrivFrame f;
+    for (int i = 1; i <= nMotors; i++)
+    {
+        can.setRunMode((uint8_t)i, 0);
+        can.enable((uint8_t)i);
+        if (tel == Telemetry::Report)
+        {
+            can.setReportIntervalTicks((uint8_t)i, 1);
+            can.setActiveReport((uint8_t)i, true);
+        }
+        while (can.readAny(f))
+        {
+        }
+    }
+    delay(20);
+    while (can.readAny(f))
+    {
+    }
+
+    twai_status_info_t st0;
+    twai_get_status_info(&st0);
+    sim.resetStats();
+    bl.reset();
+    fbt = FeedbackTracker(nMotors);
+
+    std::vector<float> cycleUs, freshUs;
+    cycleUs.reserve(runMs * rateHz / 1000 + 16);
+    freshUs.reserve((runMs * rateHz / 1000 + 16) * nMotors);
+
+    const uint32_t periodUs = 1000000 / rateHz;
+    const uint32_t t0 = micros();
+    uint32_t next = t0;
+    uint64_t cpuTotal = 0;
+    uint64_t simCpu = 0;
+    int pollIdx = 0;
+    double freshSum = 0.0;
+
+    while ((uint32_t)(micros() - t0) < runMs * 1000UL)
+    {
+        int32_t wait = (int32_t)(next - micros());
+        if (wait > 0)
+            delayMicroseconds((uint32_t)wait);
+
+        uint32_t cs = micros();
+        uint64_t c0 = threadCpuNs();
+        uint64_t s0 = busMeter.cpuNs + simMeter.cpuNs;
+        for (int i = 1; i <= nMotors; i++)
+        {
+            if (fbt.seen[i])
+            {
+                float age = (float)(uint32_t)(cs - fbt.lastUs[i]);
+                freshUs.push_back(age);
+                freshSum += age;
+            }
+        }
+
+        float phase = (float)(cs - t0) * 1e-6f;
+        for (int i = 1; i <= nMotors; i++)
+            can.opControl((uint8_t)i, 0.0f, 0.5f * sinf(phase * 6.28f + (float)i), 0.0f, 20.0f, 0.5f);
+
+        while (can.readAny(f))
+        {
+            RS02Feedback fb;
+            can.parseFeedback(f, fb); // アプリ側の解析コストも周期に含める
+        }
+
+        if (tel == Telemetry::Poll)
+        {
+            float pos;
+            pollIdx = pollIdx % nMotors + 1;
+            if (!can.readFloatParam((uint8_t)pollIdx, RS02Idx::MECH_POS, pos))
+                r.pollFail++;
+        }
+
+        cpuTotal += threadCpuNs() - c0;
+        simCpu += busMeter.cpuNs + simMeter.cpuNs - s0;
+        uint32_t ce = micros();
+        cycleUs.push_back((float)(uint32_t)(ce - cs));
+        r.cycles++;
+
+        next += periodUs;
+        if ((int32_t)(ce - next) > 0)
+        {
+            r.overruns++;
+            next = ce; // 遅れは取り戻さない（次の周期は今から）
+        }
+    }
+    uint32_t elapsedUs = micros() - t0;
+
+    twai_status_info_t st1;
+    twai_get_status_info(&st1);
+    RS02BusLoadSnapshot bs = bl.snapshot();
+
+    r.achievedHz = (float)r.cycles * 1e6f / (float)elapsedUs;
+    r.cycleP50Us = pct(cycleUs, 50.0f);
+    r.cycleP99Us = pct(cycleUs, 99.0f);
+    r.cycleMaxUs = cycleUs.empty() ? 0.0f : *std::max_element(cycleUs.begin(), cycleUs.end());
+    r.freshMeanUs = freshUs.empty() ? 0.0f : (float)(freshSum / (double)freshUs.size());
+    r.freshP99Us = pct(freshUs, 99.0f);
+    r.freshMaxUs = freshUs.empty() ? 0.0f : *std::max_element(freshUs.begin(), freshUs.end());
+    for (int i = 1; i <= nMotors; i++)
+        if (!fbt.seen[i])
+            r.staleMotors++;
+    r.fbPerCycle = r.cycles ? (float)fbt.frames / (float)r.cycles : 0.0f;
+    r.rxMissed = st1.rx_missed_count - st0.rx_missed_count;
+    r.txFailed = st1.tx_failed_count - st0.tx_failed_count;
+    r.simDropped = sim.stats().dropped;
+    // ライブラリ+ドライバ = 周期内のスレッド CPU − 周期内の時刻源（バス/シミュレータ）
+    uint64_t libCpu = cpuTotal > simCpu ? cpuTotal - simCpu : 0;
+    r.libCpuUsPerCycle = r.cycles ? (float)libCpu / 1000.0f / (float)r.cycles : 0.0f;
+    r.simCpuUsPerCycle = r.cycles ? (float)simCpu / 1000.0f / (float)r.cycles : 0.0f;
+    r.busPct = bs.utilPct;
+
+    can.removeListener(&fbt);
+    bl.end();
+    ArduinoShim::removeTimeSource(&busMeter);
+    ArduinoShim::removeTimeSource(&simMeter);
+    ArduinoShim::addTimeSource(&bus); // デストラクタで外す
+    ArduinoShim::addTimeSource(&sim);
+    twai_stop();
+    twai_driver_uninstall();
+    ArduinoShim::attachTwai(nullptr);
+    return r;
+}
+
+static std::vector<uint32_t> parseList(const char *s)
+{
+    std::vector<uint32_t> v;
+    while (*s)
+    {
+        char *end;
+        unsigned long x = strtoul(s, &end, 10);
+        if (end == s)
+            break;
+        v.push_back((uint32_t)x);
+        s = *end == ',' ? end + 1 : end;
+    }
+    return v;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<uint32_t> motors = {8, 16, 24, 32};
+    std::vector<uint32_t> rates = {100, 250, 500, 1000};
+    std::vector<Telemetry> tels = {Telemetry::None, Telemetry::Report, Telemetry::Poll};
+    uint32_t runMs = 1000;
+    QueueCfg q;
+    bool csv = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--motors") == 0 && i + 1 < argc)
+            motors = parseList(argv[++i]);
+        else if (strcmp(argv[i], "--rates") == 0 && i + 1 < argc)
+            rates = parseList(argv[++i]);
+        else if (strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc)
+        {
+            tels.clear();
+            std::string s = argv[++i];
+            if (s.find("none") != std::string::npos)
+                tels.push_back(Telemetry::None);
+            if (s.find("report") != std::string::npos)
+                tels.push_back(Telemetry::Report);
+            if (s.find("poll") != std::string::npos)
+                tels.push_back(Telemetry::Poll);
+        }
+        else if (strcmp(argv[i], "--ms") == 0 && i + 1 < argc)
+            runMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--rxq") == 0 && i + 1 < argc)
+            q.rx = (uint16_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--txq") == 0 && i + 1 < argc)
+            q.tx = (uint16_t)strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--csv") == 0)
+            csv = true;
+        else
+        {
+            fprintf(stderr, "usage: %s [--motors 8,16] [--rates 100,500] [--telemetry none,report,poll] [--ms 1000] [--rxq 5] [--txq 5] [--csv]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    ArduinoShim::useVirtualTime(true);
+    printf("# rx_queue=%u tx_queue=%u run=%lu ms (virtual time, 1 Mbps)\n", q.rx, q.tx, (unsigned long)runMs);
+    if (csv)
+        printf("motors,rate_hz,telemetry,achieved_hz,cycles,overruns,cycle_p50_us,cycle_p99_us,cycle_max_us,"
+               "fresh_mean_us,fresh_p99_us,fresh_max_us,fb_per_cycle,stale_motors,rx_missed,tx_failed,sim_dropped,poll_fail,"
+               "lib_cpu_us,sim_cpu_us,bus_pct\n");
+    else
+        printf("%3s %5s %-6s | %8s %5s | %6s %6s | %7s %7s %7s | %6s %5s %6s %4s %5s %4s | %7s %7s | %5s\n", "N", "Hz", "tel",
+               "achieved", "overr", "cyc50", "cyc99", "frMean", "frP99", "frMax", "fb/cyc", "stale", "rxMiss", "txF", "simDr",
+               "poll", "libCPU", "simCPU", "bus%");
+
+    int fail = 0;
+    for (uint32_t n : motors)
+        for (Telemetry t : tels)
+            for (uint32_t hz : rates)
+            {
+                if (n == 0 || n > 100 || hz == 0)
+                    continue;
+                RunResult r = runOne((int)n, hz, t, runMs, q);
+                if (csv)
+                    printf("%d,%lu,%s,%.1f,%lu,%lu,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.2f,%lu,%lu,%lu,%lu,%lu,%.2f,%.2f,%.1f\n", r.motors,
+                           (unsigned long)r.rateHz, telemetryName(r.tel), r.achievedHz, (unsigned long)r.cycles,
+                           (unsigned long)r.overruns, r.cycleP50Us, r.cycleP99Us, r.cycleMaxUs, r.freshMeanUs, r.freshP99Us,
+                           r.freshMaxUs, r.fbPerCycle, (unsigned long)r.staleMotors, (unsigned long)r.rxMissed,
+                           (unsigned long)r.txFailed, (unsigned long)r.simDropped, (unsigned long)r.pollFail, r.libCpuUsPerCycle,
+                           r.simCpuUsPerCycle, r.busPct);
+                else
+                    printf("%3d %5lu %-6s | %8.1f %5lu | %6.0f %6.0f | %7.0f %7.0f %7.0f | %6.1f %5lu %6lu %4lu %5lu %4lu | %7.2f %7.2f | %5.1f\n",
+                           r.motors, (unsigned long)r.rateHz, telemetryName(r.tel), r.achievedHz, (unsigned long)r.overruns,
+                           r.cycleP50Us, r.cycleP99Us, r.freshMeanUs, r.freshP99Us, r.freshMaxUs, r.fbPerCycle,
+                           (unsigned long)r.staleMotors, (unsigned long)r.rxMissed, (unsigned long)r.txFailed,
+                           (unsigned long)r.simDropped, (unsigned long)r.pollFail, r.libCpuUsPerCycle, r.simCpuUsPerCycle,
+                           r.busPct);
+                fflush(stdout);
+                // 最小構成（8台 100Hz, テレメトリなし）で周期が出ないのは回帰
+                if (n == 8 && hz == 100 && t == Telemetry::None && r.achievedHz < 99.0f)
+                    fail++;
+            }
+    return fail ? 1 : 0;
+}
@@ -0,0 +1,171 @@
+// native_scan — バス上のモータ探索（RS02Scanner）を 1Mbps の仮想バスで確かめる
+// ID をばらけさせた 12 台（1 台は RS05）と、同じ ID 21 に別 UID のモータがもう 1 台いる（ID の重複）。
+// TWAI / MCP2515（受信 2 面）の両方で 0..127 を一斉に探し、1 ID ずつ 0x200A を読む方式（changeID.cpp の確認と同じ
+// readParamRaw, 居ない ID は 300ms 待ち）と時間を比べる。127 台つないだバスの全数探索の時間も出す。
+// 応答の遅いモータ（2ms）でも MCP2515 で取りこぼさないか（送信待ちのあいだに応答が続けて届く）も見る
+// （見落とし / UID 違い / 重複の見逃し / 受信あふれ / 1 秒を超える なら exit 1）
+//   pio run -e native-scan && .pio/build/native-scan/program
+#include <Arduino.h>
+#include <RS02SimBench.h>
+#include "RS02Scanner.h"
+
+static constexpr uint8_t HOST_ID = RS02SimBench::HOST_ID;
+static const uint8_t FLEET[] = {1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 100, 127};
+static constexpr uint8_t N_FLEET = sizeof(FLEET);
+static constexpr uint8_t RS05_ID = 34;
+static constexpr uint8_t DUP_ID = 21;
+static constexpr uint64_t DUP_UID = 0x0123456789ABCDEFULL;
+static constexpr uint32_t SLOW_REPLY_US = 2000;
+
+using RS02SimCheck::check;
+
+// fleet: ID をばらけさせた 12 台 + 重複 ID / false: 1..127 の全部
+struct Bench : RS02SimBench
+{
+    explicit Bench(bool fleet, uint32_t replyUs = 100) : RS02SimBench(replyUs, fleet ? N_FLEET : 127)
+    {
+        if (fleet)
+        {
+            for (uint8_t id : FLEET)
+                sim.add(id, 0, id == RS05_ID ? RS02SimModel::rs05() : RS02SimModel::rs02());
+            dup.add(DUP_ID, DUP_UID);
+        }
+        else
+            for (uint8_t id = 1; id <= 127; id++)
+                sim.add(id);
+        delay(5);
+    }
+};
+
+static bool uidsMatch(const RS02Scanner &sc, RS02SimBus &sim)
+{
+    for (size_t i = 0; i < sim.count(); i++)
+    {
+        const RS02ScanEntry *e = sc.find(sim.at(i)->id());
+        if (!e || e->uid != sim.at(i)->uid())
+            return false;
+    }
+    return sc.count() == sim.count();
+}
+
+static void fleetChecks(const char *name, Bench &b, RS02Scanner &sc, uint32_t lost)
+{
+    char what[160];
+    const RS02ScanEntry *d = sc.find(DUP_ID);
+    const RS02ScanEntry *r5 = sc.find(RS05_ID);
+    const RS02ScanEntry *m1 = sc.find(1);
+    snprintf(what, sizeof(what), "%s: all %u motors found with their UIDs, nothing else", name, N_FLEET);
+    check(uidsMatch(sc, b.sim), what);
+    snprintf(what, sizeof(what), "%s: ID %u reported as a conflict with both UIDs", name, DUP_ID);
+    check(d && d->conflict && sc.stats().conflicts == 1 &&
+              ((d->uid == DUP_UID) != (d->uidAlt == DUP_UID)),
+          what);
+    snprintf(what, sizeof(what), "%s: info read for every motor (master 0x%02X, RS05 told apart by its torque limit)", name,
+             HOST_ID);
+    check(m1 && r5 && m1->infoOk == 0x0F && r5->infoOk == 0x0F && m1->infoU(0) == HOST_ID &&
+              !strcmp(sc.modelName(*m1), "RS02") && !strcmp(sc.modelName(*r5), "RS05") && sc.stats().infoTimeouts == 0,
+          what);
+    snprintf(what, sizeof(what), "%s: no receive overruns (%lu lost)", name, (unsigned long)lost);
+    check(lost == 0, what);
+    snprintf(what, sizeof(what), "%s: full 0..127 scan in %.1fms (< 1s)", name, sc.stats().totalUs / 1000.0f);
+    check(sc.stats().totalUs < 1000000, what);
+}
+
+int main()
+{
+    ArduinoShim::useVirtualTime(true);
+
+    uint32_t seqUs = 0, twaiUs = 0, mcpUs = 0, expectUs = 0, fullUs = 0, listenUs = 0;
+    uint8_t seqFound = 0;
+    {
+        Bench b(true);
+        RS02Scanner sc(b.twai);
+
+        // TWAI: 0..127 一斉（受信あふれは探索のあいだだけ数える）
+        b.drain();
+        uint32_t lost0 = b.lostTwai.lost;
+        sc.scan();
+        uint32_t lost = b.lostTwai.lost - lost0;
+        b.drain();
+        sc.print(Serial);
+        twaiUs = sc.stats().totalUs;
+        listenUs = sc.stats().pingUs;
+        fleetChecks("twai", b, sc, lost);
+
+        // 台数が分かっていれば待ちを打ち切る
+        RS02ScanConfig cfg;
+        cfg.expect = N_FLEET;
+        cfg.readInfo = false;
+        sc.scan(cfg);
+        b.drain();
+        expectUs = sc.stats().pingUs;
+        char what[128];
+        snprintf(what, sizeof(what), "expect=%u ends the listen window early (%.1fms vs %.1fms)", N_FLEET, expectUs / 1000.0f,
+                 listenUs / 1000.0f);
+        check(sc.count() == N_FLEET && expectUs < listenUs, what);
+
+        // MCP2515: 同じ探索（受信 2 面を溢れさせない）
+        RS02Scanner sm(b.can);
+        b.drain();
+        lost0 = b.lostCan.lost;
+        sm.scan();
+        lost = b.lostCan.lost - lost0;
+        b.drain();
+        mcpUs = sm.stats().totalUs;
+        fleetChecks("mcp2515", b, sm, lost);
+
+        // 比較: 1 ID ずつ 0x200A を読む（changeID.cpp の確認と同じ）
+        uint32_t t0 = micros();
+        for (uint8_t id = 0; id < 128; id++)
+        {
+            uint8_t le[4];
+            if (b.twai.readParamRaw(id, RS02Idx::CAN_ID, le))
+                seqFound++;
+        }
+        seqUs = micros() - t0;
+        b.drain();
+    }
+    uint8_t fullFound = 0;
+    uint32_t fullLost = 0;
+    {
+        Bench b(false);
+        RS02Scanner sc(b.twai);
+        b.drain();
+        uint32_t lost0 = b.lostTwai.lost;
+        fullFound = sc.scan();
+        fullLost = b.lostTwai.lost - lost0;
+        b.drain();
+        fullUs = sc.stats().totalUs;
+        Serial.printf("127 motors: ping %.1fms + info %.1fms (%u Type17 reads)\n", sc.stats().pingUs / 1000.0f,
+                      sc.stats().infoUs / 1000.0f, sc.stats().infoReads);
+        check(fullFound == 127 && uidsMatch(sc, b.sim) && sc.stats().infoTimeouts == 0 && fullLost == 0,
+              "127 motors: every motor found and read");
+    }
+
+    uint32_t slowUs = 0;
+    {
+        // 応答の遅いモータ: MCP2515 の送信待ちのあいだに Type0 応答が続けて届く
+        Bench b(true, SLOW_REPLY_US);
+        RS02Scanner sc(b.can);
+        b.drain();
+        uint32_t lost0 = b.lostCan.lost;
+        sc.scan();
+        uint32_t lost = b.lostCan.lost - lost0;
+        b.drain();
+        slowUs = sc.stats().totalUs;
+        fleetChecks("mcp2515, 2ms replies", b, sc, lost);
+    }
+
+    Serial.printf("\nscan 0..127 on 1Mbps, %u motors (+1 duplicate ID)\n", N_FLEET);
+    Serial.printf("  %-34s %10s %8s\n", "", "time", "found");
+    Serial.printf("  %-34s %8.1fms %8u\n", "one ID at a time (0x200A, 300ms)", seqUs / 1000.0f, seqFound);
+    Serial.printf("  %-34s %8.1fms %8u\n", "RS02Scanner twai", twaiUs / 1000.0f, N_FLEET);
+    Serial.printf("  %-34s %8.1fms %8u\n", "RS02Scanner mcp2515", mcpUs / 1000.0f, N_FLEET);
+    Serial.printf("  %-34s %8.1fms %8u\n", "RS02Scanner mcp2515, 2ms replies", slowUs / 1000.0f, N_FLEET);
+    Serial.printf("  %-34s %8.1fms %8u\n", "RS02Scanner twai, expect, no info", expectUs / 1000.0f, N_FLEET);
+    Serial.printf("  %-34s %8.1fms %8u\n", "RS02Scanner twai, 127 motors", fullUs / 1000.0f, fullFound);
+    check(seqUs > 100 * twaiUs, "the one-ID-at-a-time check takes over 100x longer");
+    check(fullUs < 1000000, "127-motor scan with info stays under a second");
+
+    return RS02SimCheck::finish();
+}
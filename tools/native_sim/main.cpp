@@ -0,0 +1,327 @@
+// native_sim — RS02 モータシミュレータ（RS02SimBus）に TWAI(シム) から RS02 ライブラリで接続し、
+// 各モードの応答と物理を確認する（不一致なら exit 1）
+//   pio run -e native-sim && .pio/build/native-sim/program [motors]
+#include <Arduino.h>
+#include <RS02SimCheck.h>
+#include <driver/twai.h>
+#include <VirtualCanBus.h>
+#include <RS02SimBus.h>
+#include "RS02PrivateTWAI.h"
+#include "RS02BusLoad.h"
+#include "RS02FaultSupervisor.h"
+
+#include <chrono>
+#include <stdlib.h>
+
+using RS02SimCheck::check;
+
+// 条件に合うフレームが来るまで受信（最大 ms）
+template <typename Pred>
+static bool waitFrame(RS02PrivateBase &can, uint32_t ms, Pred pred, RS02PrivFrame *out = nullptr)
+{
+    uint32_t t0 = millis();
+    RS02PrivFrame f;
+    while (millis() - t0 < ms)
+    {
+        if (!can.readAny(f))
+        {
+            delayMicroseconds(50);
+            continue;
+        }
+        if (pred(f))
+        {
+            if (out)
+                *out = f;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void drain(RS02PrivateBase &can)
+{
+    RS02PrivFrame f;
+    while (can.readAny(f))
+    {
+    }
+}
+
+// バスに出た Type4 の宛先（onTxDone）
+class StopLog : public RS02FrameListener
+{
+public:
+    uint8_t dst[8];
+    uint8_t n = 0;
+    uint8_t dropped = 0;
+    void onTxDone(const RS02PrivFrame &f, bool ok) override
+    {
+        if (rs02FrameType(f.id) != RS02Type::STOP)
+            return;
+        if (!ok)
+            dropped++;
+        else if (n < sizeof(dst))
+            dst[n++] = rs02FrameDst(f.id);
+    }
+};
+
+static bool near(float a, float b, float tol) { return fabsf(a - b) <= tol; }
+
+int main(int argc, char **argv)
+{
+    int nMotors = argc > 1 ? atoi(argv[1]) : 4;
+    if (nMotors < 4)
+        nMotors = 4;
+    if (nMotors > 100)
+        nMotors = 100;
+
+    ArduinoShim::useVirtualTime(true);
+    VirtualCanBus bus(1000000);
+    ArduinoShim::attachTwai(&bus);
+    RS02SimBus sim(&bus);
+    for (int i = 1; i <= nMotors; i++)
+        sim.add((uint8_t)i);
+
+    RS02PrivateTWAI can(0xFD, 1, 2);
+    check(can.begin(), "RS02PrivateTWAI begin");
+
+    // Type0: UID 応答
+    {
+        can.ping(3);
+        RS02PrivFrame f;
+        bool ok = waitFrame(can, 10, [](const RS02PrivFrame &r) {
+            return rs02FrameType(r.id) == RS02Type::GET_ID && ((r.id >> 8) & 0xFF) == 3;
+        }, &f);
+        uint64_t uid = 0;
+        for (uint8_t i = 0; i < 8; i++)
+            uid |= (uint64_t)f.data[i] << (8 * i);
+        check(ok && uid == sim.motor(3)->uid(), "Type0 ping -> UID");
+    }
+
+    // Velocity: 5 rad/s
+    {
+        bool ok = can.enterVelocity(1, 10.0f, 50.0f);
+        ok &= can.enable(1);
+        ok &= can.velocityRef(1, 5.0f);
+        delay(800);
+        drain(can);
+        float v = 0.0f;
+        ok &= can.readFloatParam(1, RS02Idx::MECH_VEL, v);
+        Serial.printf("  vel=%.3f rad/s\n", v);
+        check(ok && near(v, 5.0f, 0.2f), "Velocity mode reaches SPD_REF");
+    }
+
+    // PP: 2 rad へ
+    {
+        bool ok = can.enterPP(2, 4.0f);
+        ok &= can.enable(2);
+        ok &= can.ppLocRef(2, 2.0f);
+        delay(1500);
+        drain(can);
+        float p = 0.0f;
+        ok &= can.readFloatParam(2, RS02Idx::MECH_POS, p);
+        Serial.printf("  pos=%.3f rad\n", p);
+        check(ok && near(p, 2.0f, 0.05f), "PP mode reaches LOC_REF");
+    }
+
+    // Operation（Type1）: kp/kd で 1 rad に保持
+    {
+        can.setRunMode(3, 0);
+        can.enable(3);
+        RS02Feedback fb;
+        for (int i = 0; i < 500; i++)
+        {
+            can.opControl(3, 0.0f, 1.0f, 0.0f, 20.0f, 0.5f);
+            delay(2);
+            drain(can);
+        }
+        RS02PrivFrame f;
+        can.opControl(3, 0.0f, 1.0f, 0.0f, 20.0f, 0.5f);
+        bool ok = waitFrame(can, 10, [](const RS02PrivFrame &r) {
+            return rs02FrameType(r.id) == RS02Type::FEEDBACK && ((r.id >> 8) & 0xFF) == 3;
+        }, &f);
+        ok &= can.parseFeedback(f, fb);
+        Serial.printf("  angle=%.3f mode=%u\n", fb.angleRad, fb.mode);
+        check(ok && near(fb.angleRad, 1.0f, 0.05f) && fb.mode == RS02MotorState::RUN, "Operation mode (Type1) holds position");
+    }
+
+    // Current: iq=1A → トルク kt
+    {
+        bool ok = can.enterCurrent(4, 5.0f);
+        ok &= can.enable(4);
+        ok &= can.currentIqRef(4, 1.0f);
+        delay(20);
+        const RS02SimState &s = sim.motor(4)->state();
+        Serial.printf("  iq=%.3f torque=%.3f vel=%.3f\n", s.iqA, s.torqueNm, s.velRadS);
+        check(ok && near(s.torqueNm, sim.motor(4)->model().kt, 0.02f) && s.velRadS > 0.0f, "Current mode follows IQ_REF");
+        can.stop(4, false);
+    }
+
+    // アクティブレポート 10ms 周期
+    {
+        drain(can);
+        can.setReportIntervalTicks(1, 1);
+        can.setActiveReport(1, true);
+        uint32_t n = 0;
+        uint32_t t0 = millis();
+        RS02PrivFrame f;
+        while (millis() - t0 < 200)
+        {
+            if (!can.readAny(f))
+            {
+                delayMicroseconds(100);
+                continue;
+            }
+            if (rs02FrameType(f.id) == RS02Type::FEEDBACK && ((f.id >> 8) & 0xFF) == 1)
+                n++;
+        }
+        can.setActiveReport(1, false);
+        Serial.printf("  reports=%u in 200 ms\n", (unsigned)n);
+        check(n >= 19 && n <= 21, "Type24 active report period");
+    }
+
+    // 故障: 次の Type2 に載る
+    {
+        drain(can);
+        sim.motor(1)->injectFault(RS02Fault::OVERTEMP);
+        can.enable(1);
+        RS02PrivFrame f;
+        RS02Feedback fb;
+        bool ok = waitFrame(can, 10, [](const RS02PrivFrame &r) {
+            return rs02FrameType(r.id) == RS02Type::FEEDBACK && ((r.id >> 8) & 0xFF) == 1;
+        }, &f);
+        ok &= can.parseFeedback(f, fb);
+        check(ok && (fb.faultBits & RS02Fault::OVERTEMP), "fault bits in Type2");
+        can.stop(1, true);
+        ok = waitFrame(can, 10, [](const RS02PrivFrame &r) {
+            return rs02FrameType(r.id) == RS02Type::FEEDBACK && ((r.id >> 8) & 0xFF) == 1;
+        }, &f);
+        ok &= can.parseFeedback(f, fb);
+        check(ok && fb.faultBits == 0 && fb.mode == RS02MotorState::RESET, "Type4 clear fault");
+    }
+
+    // 故障監視: 故障したモータとそのグループに Type4。続けて別のモータが故障しても先の Type4 を破棄しない
+    {
+        StopLog log;
+        can.addListener(&log);
+        RS02FaultSupervisor fs(can);
+        RS02FaultConfig fc;
+        fc.stopGroup = true;
+        fs.setConfig(fc);
+        fs.setGroup(2, 1);
+        fs.setGroup(3, 1);
+        fs.begin();
+        for (uint8_t id = 1; id <= 4; id++)
+            can.enable(id);
+        delay(2);
+        drain(can);
+        sim.motor(2)->injectFault(RS02Fault::OVERCURRENT);
+        sim.motor(1)->injectFault(RS02Fault::ENCODER);
+        // 2 台分の故障フレームを受信キューに溜めてから読む（2 台目は 1 台目の Type4 がまだ送信待ちのうちに）
+        can.enable(2);
+        can.enable(1);
+        delay(2);
+        uint32_t t0 = micros();
+        RS02PrivFrame f;
+        while (micros() - t0 < 2000) // 送信完了を回収し続ける
+            if (!can.readAny(f))
+                delayMicroseconds(20);
+        auto st = [&](uint8_t id) { return sim.motor(id)->state().state; };
+        Serial.printf("  stops on bus: %u (", log.n);
+        for (uint8_t i = 0; i < log.n; i++)
+            Serial.printf("%s%u", i ? " " : "", log.dst[i]);
+        Serial.printf(")  latency bus avg %.0fus max %luus, submit avg %.0fus\n", fs.latency().avgUs(),
+                      (unsigned long)fs.latency().maxUs, fs.submitLatency().avgUs());
+        check(fs.tripCount() == 2 && fs.tripped(1) && fs.tripped(2) && !fs.tripped(3), "supervisor trips on both faulting motors");
+        check(log.n == 3 && log.dst[0] == 2 && log.dst[1] == 3 && log.dst[2] == 1 && log.dropped == 0 && fs.stopsResent() == 0,
+              "Type4 reaches the faulting motor, its group, then the second motor (none flushed)");
+        check(st(1) == RS02MotorState::RESET && st(2) == RS02MotorState::RESET && st(3) == RS02MotorState::RESET &&
+                  st(4) == RS02MotorState::RUN,
+              "faulting motors and the group are stopped, the others keep running");
+        check(fs.latency().count == 2 && fs.submitLatency().count == 2 && fs.latency().minUs > 0 &&
+                  fs.latency().avgUs() >= fs.submitLatency().avgUs(),
+              "fault -> stop-on-bus latency recorded");
+        fs.end();
+        can.removeListener(&log);
+        for (uint8_t id = 1; id <= 4; id++)
+            can.stop(id, true);
+        delay(2);
+        drain(can);
+    }
+
+    // Type7: ID 変更（即時, 新IDから Type0）
+    {
+        drain(can);
+        uint8_t newId = (uint8_t)(nMotors + 10);
+        can.setMotorId(4, newId);
+        bool ok = waitFrame(can, 10, [newId](const RS02PrivFrame &r) {
+            return rs02FrameType(r.id) == RS02Type::GET_ID && ((r.id >> 8) & 0xFF) == newId;
+        });
+        uint8_t mode = 0xFF;
+        ok &= can.readRunMode(newId, mode);
+        check(ok && mode == 3 && sim.motor(4) == nullptr, "Type7 set ID");
+    }
+
+    // 未知 index: Type17 応答 bit16-23 が失敗(1)
+    {
+        drain(can);
+        uint8_t d[8] = {0xFF, 0x7F, 0, 0, 0, 0, 0, 0};
+        can.sendExt(((uint32_t)RS02Type::READ_PARAM << 24) | (0xFDUL << 16) | 2, d, 8);
+        RS02PrivFrame f;
+        bool ok = waitFrame(can, 10, [](const RS02PrivFrame &r) { return rs02FrameType(r.id) == RS02Type::READ_PARAM; }, &f);
+        check(ok && ((f.id >> 16) & 0xFF) == 1 && sim.motor(2)->stats().rejected == 1, "unknown index rejected");
+    }
+
+    // 速度: 全モータ Velocity で 1 秒（シミュレーション時間）。1ms ごとに1台へ SPD_REF を再送
+    // バス負荷の集計（RS02BusLoad）が仮想バスの実ビット数と一致するかも見る
+    {
+        RS02BusLoad bl(can);
+        bl.begin();
+        for (size_t i = 0; i < sim.count(); i++)
+        {
+            uint8_t id = sim.at(i)->id();
+            can.stop(id, true);
+            can.enterVelocity(id, 10.0f, 50.0f);
+            can.enable(id);
+            can.velocityRef(id, 3.0f);
+            drain(can);
+        }
+        delay(5);
+        drain(can);
+        sim.resetStats();
+        bus.resetStats();
+        bl.reset();
+        auto w0 = std::chrono::steady_clock::now();
+        uint32_t t0 = millis();
+        size_t rr = 0;
+        while (millis() - t0 < 1000)
+        {
+            can.velocityRef(sim.at(rr++ % sim.count())->id(), 3.0f);
+            delay(1);
+            drain(can);
+        }
+        delay(2);
+        drain(can);
+        double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - w0).count();
+        uint32_t atSpeed = 0;
+        for (size_t i = 0; i < sim.count(); i++)
+            if (near(sim.at(i)->state().velRadS, 3.0f, 0.2f))
+                atSpeed++;
+        Serial.printf("  %d motors: 1000 ms sim in %.1f ms wall (x%.0f), ticks=%lu\n", nMotors, wallMs, 1000.0 / wallMs,
+                      (unsigned long)sim.stats().physicsTicks);
+        check(atSpeed == sim.count(), "all motors at speed");
+
+        RS02BusLoadSnapshot s = bl.snapshot();
+        uint64_t busBits = bus.stats().bits + 3ULL * bus.stats().frames; // + IFS
+        Serial.printf("  busload: %.1f%% (peak %.1f%%) %.0f f/s  frames=%lu bits=%llu/%llu  T18=%.0f%% T2=%.0f%%\n", s.utilPct,
+                      s.peakBucketPct, s.framesPerSec, (unsigned long)(s.txFrames + s.rxFrames), (unsigned long long)s.bits, (unsigned long long)busBits,
+                      bl.typeSharePct(RS02Type::WRITE_PARAM), bl.typeSharePct(RS02Type::FEEDBACK));
+        check(s.bits == busBits && s.txFrames + s.rxFrames == bus.stats().frames, "bus-load accounting matches bus");
+        bl.end();
+    }
+
+    const VirtualCanStats &st = bus.stats();
+    Serial.printf("bus: frames=%lu ackErr=%lu  sim: rx=%lu tx=%lu dropped=%lu\n", (unsigned long)st.frames,
+                  (unsigned long)st.ackErrors, (unsigned long)sim.stats().rxFrames, (unsigned long)sim.stats().txFrames,
+                  (unsigned long)sim.stats().dropped);
+    return RS02SimCheck::finish();
+}
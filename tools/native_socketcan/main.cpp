@@ -0,0 +1,218 @@
+// native_socketcan — SocketCAN バックエンドの確認。vcan の片側にモータシミュレータ（RS02SimBus）を
+// ブリッジし、反対側から RS02PrivateSocketCAN で操作する（不一致なら exit 1, インタフェースなしは exit 2）
+//   sudo ip link add dev vcan0 type vcan && sudo ip link set up vcan0
+//   pio run -e native-socketcan && .pio/build/native-socketcan/program [vcan0]
+#include <Arduino.h>
+#include <RS02SimCheck.h>
+#include <VirtualCanBus.h>
+#include <RS02SimBus.h>
+#include "RS02PrivateSocketCAN.h"
+
+#include <atomic>
+#include <deque>
+#include <thread>
+#include <errno.h>
+#include <net/if.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+
+// vcan ⇔ 仮想バス: ソケットで受けたフレームを仮想バスへ送り、仮想バスの受信をソケットへ書く
+class SocketBridge : public VirtualCanNode
+{
+public:
+    explicit SocketBridge(VirtualCanBus *bus) : _bus(bus) { _bus->attach(this); }
+    ~SocketBridge()
+    {
+        stop();
+        _bus->detach(this);
+        if (_fd >= 0)
+            close(_fd);
+    }
+
+    bool open(const char *ifname)
+    {
+        _fd = socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK, CAN_RAW);
+        if (_fd < 0)
+            return false;
+        struct ifreq ifr;
+        memset(&ifr, 0, sizeof(ifr));
+        strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+        if (ioctl(_fd, SIOCGIFINDEX, &ifr) != 0)
+            return false;
+        struct sockaddr_can addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.can_family = AF_CAN;
+        addr.can_ifindex = ifr.ifr_ifindex;
+        return bind(_fd, (struct sockaddr *)&addr, sizeof(addr)) == 0;
+    }
+
+    // 実時間モード: ソケット待ち + シミュレータ駆動
+    void start()
+    {
+        _run = true;
+        _th = std::thread([this] {
+            while (_run)
+            {
+                struct pollfd p = {_fd, POLLIN, 0};
+                poll(&p, 1, 1);
+                struct can_frame fr;
+                while (read(_fd, &fr, sizeof(fr)) == (ssize_t)sizeof(fr))
+                {
+                    ShimCanFrame f;
+                    f.ext = (fr.can_id & CAN_EFF_FLAG) != 0;
+                    f.rtr = (fr.can_id & CAN_RTR_FLAG) != 0;
+                    f.id = fr.can_id & (f.ext ? CAN_EFF_MASK : CAN_SFF_MASK);
+                    f.dlc = fr.can_dlc > 8 ? 8 : fr.can_dlc;
+                    memcpy(f.data, fr.data, f.dlc);
+                    ShimLock lk;
+                    _q.push_back(f);
+                    _bus->kick();
+                }
+                ArduinoShim::pump();
+            }
+        });
+    }
+    void stop()
+    {
+        _run = false;
+        if (_th.joinable())
+            _th.join();
+    }
+
+    bool txPeek(ShimCanFrame &f) override
+    {
+        if (_q.empty())
+            return false;
+        f = _q.front();
+        return true;
+    }
+    void txDone(bool ok) override
+    {
+        (void)ok; // ソケット側では送信済みなので ACK 有無に関わらず消す
+        if (!_q.empty())
+            _q.pop_front();
+    }
+    void rx(const ShimCanFrame &f, uint64_t tNs) override
+    {
+        (void)tNs;
+        struct can_frame fr;
+        memset(&fr, 0, sizeof(fr));
+        fr.can_id = f.ext ? (CAN_EFF_FLAG | f.id) : f.id;
+        fr.can_dlc = f.dlc;
+        memcpy(fr.data, f.data, 8);
+        if (write(_fd, &fr, sizeof(fr)) != (ssize_t)sizeof(fr))
+            _txFail++;
+    }
+
+    uint32_t txFail() const { return _txFail; }
+
+private:
+    VirtualCanBus *_bus;
+    int _fd = -1;
+    std::deque<ShimCanFrame> _q;
+    std::atomic<bool> _run{false};
+    std::thread _th;
+    uint32_t _txFail = 0;
+};
+
+using RS02SimCheck::check;
+
+static bool waitType(RS02PrivateSocketCAN &can, uint8_t type, uint8_t motorId, uint32_t ms, RS02PrivFrame *out = nullptr)
+{
+    uint32_t t0 = millis();
+    RS02PrivFrame f;
+    while (millis() - t0 < ms)
+    {
+        if (!can.readAny(f))
+        {
+            can.waitRx(1);
+            continue;
+        }
+        if (rs02FrameType(f.id) == type && ((f.id >> 8) & 0xFF) == motorId)
+        {
+            if (out)
+                *out = f;
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    const char *ifname = argc > 1 ? argv[1] : "vcan0";
+
+    // 実時間モード（既定）: シミュレータは壁時計で動く
+    VirtualCanBus bus(1000000);
+    RS02SimBus sim(&bus);
+    sim.add(1);
+    sim.add(2);
+    SocketBridge bridge(&bus);
+
+    RS02PrivateSocketCAN can(0xFD, ifname);
+    if (!bridge.open(ifname) || !can.begin())
+    {
+        Serial.printf("cannot open %s (%s)\n", ifname, strerror(errno));
+        Serial.printf("  sudo modprobe vcan && sudo ip link add dev %s type vcan && sudo ip link set up %s\n", ifname, ifname);
+        Serial.flush();
+        return 2;
+    }
+    bridge.start();
+
+    // Type0 / Type17
+    can.ping(1);
+    check(waitType(can, RS02Type::GET_ID, 1, 50), "Type0 ping over SocketCAN");
+    float lim = 0.0f;
+    check(can.readFloatParam(2, RS02Idx::LIMIT_TORQUE, lim) && lim == sim.motor(2)->model().torqueMax,
+          "Type17 read LIMIT_TORQUE");
+
+    // Velocity
+    {
+        bool ok = can.enterVelocity(1, 10.0f, 50.0f);
+        ok &= can.enable(1);
+        ok &= can.velocityRef(1, 4.0f);
+        delay(500);
+        float v = 0.0f;
+        ok &= can.readFloatParam(1, RS02Idx::MECH_VEL, v);
+        Serial.printf("  vel=%.3f rad/s\n", v);
+        check(ok && fabsf(v - 4.0f) < 0.3f, "Velocity mode via SocketCAN");
+        can.stop(1, false);
+    }
+
+    // カーネル側フィルタ: モータ1のみ
+    {
+        RS02MotorSet ids;
+        ids.add(1);
+        check(can.setMotorFilter(ids), "CAN_RAW_FILTER set");
+        can.ping(2);
+        bool got2 = waitType(can, RS02Type::GET_ID, 2, 30);
+        can.ping(1);
+        bool got1 = waitType(can, RS02Type::GET_ID, 1, 30);
+        check(!got2 && got1, "filter drops other motors");
+        ids.clear();
+        can.setMotorFilter(ids);
+    }
+
+    // SO_TIMESTAMPING
+    {
+        check(can.enableTimestamps(false), "SO_TIMESTAMPING enable");
+        can.ping(2);
+        RS02PrivFrame f;
+        bool ok = waitType(can, RS02Type::GET_ID, 2, 50, &f);
+        uint32_t age = micros() - f.tsUs;
+        Serial.printf("  ts=%llu ns  age=%lu us\n", (unsigned long long)can.lastRxTimestampNs(), (unsigned long)age);
+        check(ok && can.lastRxTimestampNs() != 0 && age < 50000, "rx timestamp");
+    }
+
+    bridge.stop();
+    const RS02SocketCANStats &st = can.stats();
+    Serial.printf("socketcan: rx=%lu tx=%lu retry=%lu fail=%lu  sim: rx=%lu tx=%lu\n", (unsigned long)st.rxFrames,
+                  (unsigned long)st.txFrames, (unsigned long)st.txRetry, (unsigned long)st.txFail,
+                  (unsigned long)sim.stats().rxHandled, (unsigned long)sim.stats().txFrames);
+    return RS02SimCheck::finish();
+}
@@ -0,0 +1,335 @@
+// native_spi — MCP_CAN の SPI 手順（レジスタ個別 / READ STATUS+LOAD TX+RTS, READ RX の一括）を
+// MCP2515 エミュレータ相手に比べる。送信/受信 1 フレームあたりのロック・CS・バイト・見積もり時間と、
+// シム SPI が実際に消費した時間を SPI クロック別に表示。受信 2 面のロールオーバー/あふれ検出/順序も確認
+// （デコード不一致/見積もりずれ/一括が減らない/あふれの取りこぼし・順序違いなら exit 1）
+//   pio run -e native-spi && .pio/build/native-spi/program [cycles]
+#include <Arduino.h>
+#include <RS02SimCheck.h>
+#include <SPI.h>
+#include <mcp_can.h>
+#include <driver/twai.h>
+#include <Mcp2515Emu.h>
+#include <VirtualCanBus.h>
+#include <RS02SimBus.h>
+#include "RS02PrivateCAN.h"
+#include "RS02PrivateTWAI.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+static constexpr uint8_t MCP_CS_PIN = 6;
+static constexpr uint8_t N_MOTORS = 4;
+static constexpr uint32_t SHIM_LOCK_NS = 1500; // シム SPI のトランザクション毎オーバーヘッド
+
+using RS02SimCheck::check;
+
+struct Bench
+{
+    VirtualCanBus bus{1000000};
+    Mcp2515Emu emu{&bus};
+    RS02SimBus sim{&bus};
+    RS02PrivateTWAI peer{0xFD, 1, 2};
+
+    Bench()
+    {
+        SPI.attach(MCP_CS_PIN, &emu);
+        SPI.setTransactionOverheadNs(SHIM_LOCK_NS);
+        SPI.begin();
+        ArduinoShim::attachTwai(&bus);
+        peer.begin();
+    }
+};
+
+static bool startMcp(MCP_CAN &mcp, uint32_t clock, bool fast)
+{
+    mcp.setSPIClock(clock);
+    mcp.setFastIO(fast ? 1 : 0);
+    MCP_SPI_Cost cost; // シムと同じ条件で見積もる（実機ではロジアナで測った値を入れる）
+    cost.lockNs = SHIM_LOCK_NS;
+    cost.selectNs = 0;
+    mcp.setSpiCost(cost);
+    bool ok = mcp.begin(MCP_ANY, CAN_1000KBPS, MCP_8MHZ) == CAN_OK;
+    mcp.setMode(MCP_NORMAL);
+    mcp.resetSpiStats();
+    return ok;
+}
+
+// ===== 1) デコード: 同じフレーム列を両方式で読んで一致するか =====
+struct RxRec
+{
+    INT32U id;
+    INT8U ext, len, data[8];
+};
+
+static int readVariety(bool fast, RxRec *out, int max)
+{
+    MCP_CAN mcp(MCP_CS_PIN);
+    if (!startMcp(mcp, 10000000, fast))
+        return -1;
+    int n = 0;
+    for (int i = 0; i < max; i++)
+    {
+        twai_message_t m = {};
+        m.extd = (i % 3) != 0;
+        m.rtr = (i % 5) == 4;
+        m.identifier = m.extd ? (0x1ABCDE00u + (uint32_t)i * 0x10101u) & 0x1FFFFFFF : (0x123u + (uint32_t)i * 37) & 0x7FF;
+        m.data_length_code = (uint8_t)(i % 9);
+        for (uint8_t k = 0; k < 8; k++)
+            m.data[k] = (uint8_t)(i * 16 + k);
+        twai_transmit(&m, pdMS_TO_TICKS(10));
+        uint32_t t0 = micros();
+        while (micros() - t0 < 2000)
+        {
+            RxRec &r = out[n];
+            memset(&r, 0, sizeof(r));
+            if (mcp.readMsgBuf(&r.id, &r.len, r.data) == CAN_OK) // 拡張/RTR ビット付きの 3 引数版
+            {
+                n++;
+                break;
+            }
+        }
+    }
+    return n;
+}
+
+// ===== 2) 受信 2 面: ロールオーバー / あふれ検出 / 読む順序 =====
+class LostCounter : public RS02FrameListener
+{
+public:
+    uint32_t n = 0;
+    void onRxLost(uint32_t k, uint32_t tUs) override
+    {
+        (void)tUs;
+        n += k;
+    }
+};
+
+// どのモータ宛てでもない拡張 ID（シミュレータが応答しない）
+static uint32_t tid(uint32_t k) { return 0x1F0000F0u | (k << 8); }
+
+static void peerSend(uint32_t id)
+{
+    twai_message_t m = {};
+    m.extd = 1;
+    m.identifier = id;
+    m.data_length_code = 8;
+    m.data[0] = (uint8_t)id;
+    twai_transmit(&m, pdMS_TO_TICKS(10));
+}
+
+// 届いた順に id を並べる
+static int drain(RS02PrivateCAN &can, uint32_t *ids, int max)
+{
+    int n = 0;
+    RS02PrivFrame f;
+    while (n < max && can.readAny(f))
+        ids[n++] = f.id;
+    return n;
+}
+
+static bool rxBuffers(Bench &b, bool fast)
+{
+    bool ok = true;
+    uint32_t ids[8];
+    {
+        // 5 通まとめて届く: RXB0, RXB1（ロールオーバー）に 1 通ずつ、残り 3 通は RX1OVR
+        MCP_CAN mcp(MCP_CS_PIN);
+        RS02PrivateCAN can(mcp, 0xFD);
+        LostCounter lc;
+        ok &= startMcp(mcp, 10000000, fast) && can.begin() && mcp.getRxRollover() == 1;
+        can.addListener(&lc);
+        uint32_t ovr0 = b.emu.stats().rxOverflow;
+        for (uint32_t i = 0; i < 5; i++)
+            peerSend(tid(0x100 + i));
+        delay(2);
+        int n = drain(can, ids, 8);
+        const MCP_RX_Stats &s = can.rxStats();
+        ok &= n == 2 && ids[0] == tid(0x100) && ids[1] == tid(0x101);
+        ok &= s.frames[0] == 1 && s.frames[1] == 1 && s.overflow[0] == 0 && s.overflow[1] == 1;
+        ok &= b.emu.stats().rxOverflow - ovr0 == 3 && lc.n == 1 && can.lastRxLostUs() != 0;
+        ok &= (mcp.getError() & (MCP_EFLG_RX0OVR | MCP_EFLG_RX1OVR)) == 0; // 読み出しで落としてある
+
+        // RXB0 だけ読んだ後に RXB0 へ新しいフレーム: 古い RXB1 を先に出す
+        peerSend(tid(0x200));
+        peerSend(tid(0x201));
+        delay(1);
+        ok &= drain(can, ids, 1) == 1 && ids[0] == tid(0x200);
+        peerSend(tid(0x202));
+        delay(1);
+        ok &= drain(can, ids, 8) == 2 && ids[0] == tid(0x201) && ids[1] == tid(0x202);
+        can.removeListener(&lc);
+    }
+    {
+        // ロールオーバー無し: RXB0 が埋まると RX0OVR。RS02PrivateCAN::begin は有効に戻す
+        MCP_CAN mcp(MCP_CS_PIN);
+        RS02PrivateCAN can(mcp, 0xFD);
+        ok &= startMcp(mcp, 10000000, fast);
+        mcp.setRxRollover(0);
+        ok &= mcp.getRxRollover() == 0;
+        for (uint32_t i = 0; i < 3; i++)
+            peerSend(tid(0x300 + i));
+        delay(1);
+        INT32U id;
+        INT8U len, buf[8];
+        int n = 0;
+        while (mcp.readMsgBuf(&id, &len, buf) == CAN_OK)
+            n++;
+        ok &= n == 1 && mcp.rxStats().overflow[0] == 1 && mcp.rxStats().frames[1] == 0;
+        ok &= can.begin() && mcp.getRxRollover() == 1;
+    }
+    return ok;
+}
+
+// ===== 3) 制御周期: N 台へ Type1 → Type2 応答を読む =====
+struct Row
+{
+    uint32_t clock;
+    bool fast;
+    MCP_SPI_Stats st;
+    float estTxUs, estWaitUs, estRxUs, estIdleUs;
+    double shimTxUs, shimRxUs, shimIdleUs;
+    uint32_t cycles, replies, lost, overflow;
+    double cycleUs;
+};
+
+static void runCycles(uint32_t clock, bool fast, uint32_t cycles, Row &row)
+{
+    MCP_CAN mcp(MCP_CS_PIN);
+    RS02PrivateCAN can(mcp, 0xFD);
+    row = Row();
+    row.clock = clock;
+    row.fast = fast;
+    if (!startMcp(mcp, clock, fast) || !can.begin())
+        return;
+
+    uint64_t txNs = 0, rxNs = 0, idleNs = 0;
+    uint32_t t0 = micros();
+    for (uint32_t c = 0; c < cycles; c++)
+    {
+        bool got[N_MOTORS + 1] = {};
+        for (uint8_t id = 1; id <= N_MOTORS; id++)
+        {
+            uint64_t s0 = SPI.stats().busyNs;
+            can.opControl(id, 0.0f, 0.5f * sinf(c * 0.05f), 0.0f, 5.0f, 0.2f);
+            txNs += SPI.stats().busyNs - s0;
+        }
+        uint8_t n = 0;
+        uint32_t w0 = micros();
+        while (n < N_MOTORS && micros() - w0 < 3000)
+        {
+            RS02PrivFrame f;
+            uint64_t s0 = SPI.stats().busyNs;
+            bool ok = can.readAny(f);
+            uint64_t d = SPI.stats().busyNs - s0;
+            if (!ok)
+            {
+                idleNs += d;
+                continue;
+            }
+            rxNs += d;
+            uint8_t mid = (uint8_t)((f.id >> 8) & 0xFF);
+            if (rs02FrameType(f.id) == RS02Type::FEEDBACK && mid >= 1 && mid <= N_MOTORS && !got[mid])
+            {
+                got[mid] = true;
+                n++;
+            }
+        }
+        row.replies += n;
+        row.lost += N_MOTORS - n;
+    }
+    row.cycles = cycles;
+    row.cycleUs = (double)(uint32_t)(micros() - t0) / cycles;
+    row.st = mcp.spiStats();
+    row.overflow = can.rxStats().overflow[0] + can.rxStats().overflow[1];
+    row.estTxUs = mcp.spiEstimateUs(row.st.tx);
+    row.estWaitUs = mcp.spiEstimateUs(row.st.txWait);
+    row.estRxUs = mcp.spiEstimateUs(row.st.rx);
+    row.estIdleUs = mcp.spiEstimateUs(row.st.idle);
+    row.shimTxUs = txNs / 1000.0;
+    row.shimRxUs = rxNs / 1000.0;
+    row.shimIdleUs = idleNs / 1000.0;
+}
+
+static double per(double v, uint32_t n) { return n ? v / n : 0.0; }
+
+static void printRow(const Row &r)
+{
+    const MCP_SPI_Stats &s = r.st;
+    Serial.printf("%5.1f %-5s | %5.2f %5.2f %6.1f %7.1f %7.1f %7.1f | %5.2f %5.2f %6.1f %7.1f %7.1f | %5.1f %6.1f | %7.1f %5lu %4lu\n",
+                  r.clock / 1e6, r.fast ? "fast" : "regs",
+                  per(s.tx.locks, s.tx.frames), per(s.tx.selects, s.tx.frames), per(s.tx.bytes, s.tx.frames),
+                  per(r.estTxUs, s.tx.frames), per(r.estWaitUs, s.tx.frames), per(r.shimTxUs, s.tx.frames),
+                  per(s.rx.locks, s.rx.frames), per(s.rx.selects, s.rx.frames), per(s.rx.bytes, s.rx.frames),
+                  per(r.estRxUs, s.rx.frames), per(r.shimRxUs, s.rx.frames),
+                  per(s.idle.bytes, s.idle.frames), per(r.estIdleUs, s.idle.frames),
+                  r.cycleUs, (unsigned long)r.lost, (unsigned long)r.overflow);
+}
+
+static bool near(double a, double b) { return fabs(a - b) <= 0.05 * (b > 1e-9 ? b : 1.0); }
+
+int main(int argc, char **argv)
+{
+    ArduinoShim::useVirtualTime(true);
+    uint32_t cycles = argc > 1 ? (uint32_t)atoi(argv[1]) : 200;
+    if (cycles == 0)
+        cycles = 200;
+
+    Bench b;
+    for (uint8_t id = 1; id <= N_MOTORS; id++)
+        b.sim.add(id);
+
+    // 1) デコード一致（標準/拡張, RTR, DLC 0..8）
+    {
+        static constexpr int N = 36;
+        RxRec a[N], f[N];
+        int na = readVariety(false, a, N);
+        int nf = readVariety(true, f, N);
+        bool ok = na == N && nf == N;
+        for (int i = 0; ok && i < N; i++)
+            ok = a[i].id == f[i].id && a[i].len == f[i].len && memcmp(a[i].data, f[i].data, a[i].len) == 0;
+        check(ok, "READ RX decodes the same frames as register reads (std/ext, RTR, DLC 0..8)");
+    }
+
+    check(rxBuffers(b, false) && rxBuffers(b, true), "RX rollover, overflow detection and read order (regs / fast)");
+
+    // 3) 制御周期（クロック × 方式）
+    static const uint32_t CLOCKS[] = {1000000, 4000000, 8000000, 10000000};
+    Row rows[8];
+    int nr = 0;
+    Serial.printf("\n%u motors, %lu cycles (Type1 x%u -> Type2 x%u)\n", N_MOTORS, (unsigned long)cycles, N_MOTORS,
+                  N_MOTORS);
+    Serial.printf("  MHz mode  | tx/frame: lock    cs  bytes   estUs  waitUs  shimUs | rx/frame: lock    cs  bytes   estUs  shimUs "
+                  "| idle: B  estUs | cycleUs  lost  ovr\n");
+    for (uint32_t clk : CLOCKS)
+        for (int fast = 0; fast <= 1; fast++)
+        {
+            runCycles(clk, fast != 0, cycles, rows[nr]);
+            printRow(rows[nr]);
+            nr++;
+        }
+
+    bool allReplies = true, estOk = true, fewer = true;
+    for (int i = 0; i < nr; i++)
+    {
+        const Row &r = rows[i];
+        if (r.clock >= 4000000)
+            allReplies &= r.lost == 0 && r.replies == r.cycles * N_MOTORS;
+        else
+            allReplies &= r.overflow > 0; // 取りこぼしはあふれとして見えている
+        estOk &= near(r.estTxUs + r.estWaitUs, r.shimTxUs) && near(r.estRxUs + r.estIdleUs, r.shimRxUs + r.shimIdleUs);
+        if (r.fast)
+        {
+            const Row &g = rows[i - 1];
+            fewer &= per(r.st.tx.selects, r.st.tx.frames) < per(g.st.tx.selects, g.st.tx.frames) &&
+                     per(r.st.rx.selects, r.st.rx.frames) < per(g.st.rx.selects, g.st.rx.frames) &&
+                     per(r.estTxUs, r.st.tx.frames) < per(g.estTxUs, g.st.tx.frames) &&
+                     per(r.estRxUs, r.st.rx.frames) < per(g.estRxUs, g.st.rx.frames);
+        }
+    }
+    Serial.printf("\n");
+    check(allReplies, "every Type2 reply read in both modes at 4 MHz and above");
+    check(estOk, "cost model matches shim SPI time within 5%");
+    check(fewer, "batched mode uses fewer chip selects and less SPI time per frame");
+
+    return RS02SimCheck::finish();
+}
@@ -0,0 +1,245 @@
+// native_twairx — TWAI の受信経路の比較: readAny のポーリング vs 受信タスク（startRxTask）, 既定キュー 5 vs モータ数で決めたキュー
+// 1Mbps 仮想バスに N 台のシミュレータ。毎周期 全台へ Type1 を出し、アプリは workMs 他の処理（delay）をしてから受信を読む。
+// 受信を聞くノードで Type2 がバスに出た時刻を取り、listener に届くまでの遅れ / 取りこぼし（rx_missed）を構成ごとに表示する
+// （ポーリング + キュー 5 で取りこぼしが onRxLost に出ない / 受信タスクで遅れが 200us を超える / 取りこぼす なら exit 1）
+//   pio run -e native-twairx && .pio/build/native-twairx/program [motors] [workMs]
+#include <Arduino.h>
+#include <RS02SimCheck.h>
+#include <driver/twai.h>
+#include <VirtualCanBus.h>
+#include <RS02SimBus.h>
+#include "RS02PrivateTWAI.h"
+
+#include <stdlib.h>
+
+static constexpr uint8_t HOST_ID = 0xFD;
+static constexpr uint32_t CYCLES = 200;
+
+using RS02SimCheck::check;
+
+// バス上の Type2 の到着時刻（EOF）をモータごとに覚える
+class Sniffer : public VirtualCanNode
+{
+public:
+    uint64_t arrivedNs[256] = {};
+    bool txPeek(ShimCanFrame &f) override
+    {
+        (void)f;
+        return false;
+    }
+    void txDone(bool ok) override { (void)ok; }
+    void rx(const ShimCanFrame &f, uint64_t tNs) override
+    {
+        if (f.ext && rs02FrameType(f.id) == RS02Type::FEEDBACK)
+            arrivedNs[(f.id >> 8) & 0xFF] = tNs;
+    }
+    bool acks() override { return false; }
+};
+
+// listener に届いた Type2 と、バスに出てからの遅れ
+class Latency : public RS02FrameListener
+{
+public:
+    Sniffer *sniff = nullptr;
+    uint32_t frames = 0;
+    uint32_t lost = 0;
+    double sumUs = 0.0;
+    uint32_t maxUs = 0;
+    void onRxFrame(const RS02PrivFrame &f) override
+    {
+        if (!f.isExt || rs02FrameType(f.id) != RS02Type::FEEDBACK)
+            return;
+        uint32_t arrivedUs = (uint32_t)(sniff->arrivedNs[(f.id >> 8) & 0xFF] / 1000ULL);
+        uint32_t us = f.tsUs - arrivedUs;
+        frames++;
+        sumUs += us;
+        if (us > maxUs)
+            maxUs = us;
+    }
+    void onRxLost(uint32_t n, uint32_t tUs) override
+    {
+        (void)tUs;
+        lost += n;
+    }
+};
+
+struct Result
+{
+    uint32_t expected = 0;
+    uint32_t frames = 0;
+    uint32_t missed = 0;
+    uint32_t notified = 0;
+    float meanUs = 0.0f;
+    uint32_t maxUs = 0;
+    RS02TwaiRxStats rx;
+};
+
+struct Bench
+{
+    VirtualCanBus bus{1000000};
+    RS02SimBus sim{&bus};
+    Sniffer sniff;
+
+    explicit Bench(uint8_t n)
+    {
+        for (uint8_t id = 1; id <= n; id++)
+            sim.add(id);
+        bus.attach(&sniff);
+        ArduinoShim::attachTwai(&bus);
+    }
+    ~Bench() { ArduinoShim::attachTwai(nullptr); }
+};
+
+// ドライバを入れ直す（キュー長を変えるため）
+static void uninstall()
+{
+    twai_stop();
+    twai_driver_uninstall();
+}
+
+static void drain(RS02PrivateTWAI &can)
+{
+    RS02PrivFrame f;
+    while (can.readAny(f))
+    {
+    }
+}
+
+static Result run(Bench &b, uint8_t n, uint32_t workMs, bool sized, bool task)
+{
+    RS02PrivateTWAI can(HOST_ID, 1, 2);
+    if (sized)
+        can.setQueueForMotors(n);
+    can.begin();
+    for (uint8_t id = 1; id <= n; id++)
+    {
+        can.setRunMode(id, 0);
+        can.enable(id);
+        drain(can);
+    }
+    delay(20); // 有効化の応答を読み切ってから
+    drain(can);
+
+    Latency lat;
+    lat.sniff = &b.sniff;
+    can.addListener(&lat);
+    can.resetRxStats();
+    if (task)
+        can.startRxTask();
+
+    const uint32_t periodUs = (workMs + 2) * 1000;
+    uint32_t next = micros();
+    for (uint32_t k = 0; k < CYCLES; k++)
+    {
+        for (uint8_t id = 1; id <= n; id++)
+            can.opControl(id, 0.0f, 0.001f * (float)k, 0.0f, 5.0f, 0.5f);
+        delay(workMs); // 他の処理（この間の受信はドライバのキュー / 受信タスクへ）
+        if (!task)
+            drain(can);
+        next += periodUs;
+        int32_t wait = (int32_t)(next - micros());
+        if (wait > 0)
+            delayMicroseconds((uint32_t)wait);
+    }
+    delay(5);
+    if (task)
+        can.stopRxTask();
+    drain(can);
+    can.removeListener(&lat);
+
+    Result r;
+    r.expected = CYCLES * n;
+    r.frames = lat.frames;
+    r.missed = can.rxStats().rxMissed;
+    r.notified = lat.lost;
+    r.meanUs = lat.frames ? (float)(lat.sumUs / lat.frames) : 0.0f;
+    r.maxUs = lat.maxUs;
+    r.rx = can.rxStats();
+    uninstall();
+    return r;
+}
+
+// 受信タスク動作中の読み出し（readParamRaw は応答までバスを保持する）と、詰まった受信タスクのあふれ通知
+static void taskChecks(Bench &b, uint8_t n)
+{
+    RS02PrivateTWAI can(HOST_ID, 1, 2);
+    can.setQueueForMotors(n);
+    can.begin();
+    bool started = can.startRxTask() && can.rxTaskRunning();
+    float v = 0.0f;
+    bool read = started && can.readFloatParam(1, 0x7005, v); // run_mode
+    check(read, "readFloatParam gets its reply while the RX task is running");
+
+    // バスを握ったまま応答を受ける → 受信タスクは読めず、ドライバのキューがあふれる
+    Latency lat;
+    lat.sniff = &b.sniff;
+    can.addListener(&lat);
+    {
+        RS02BusGuard g(can);
+        for (int rep = 0; rep < can.rxQueueLength() / n + 2; rep++)
+            for (uint8_t id = 1; id <= n; id++)
+                can.ping(id);
+        delay(20);
+    }
+    delay(5);
+    const RS02TwaiRxStats &s = can.rxStats();
+    char what[128];
+    snprintf(what, sizeof(what), "a stalled RX task reports queue-full alerts and misses (full=%lu missed=%lu notified=%lu)",
+             (unsigned long)s.queueFull, (unsigned long)s.rxMissed, (unsigned long)lat.lost);
+    check(s.queueFull > 0 && s.rxMissed > 0 && lat.lost == s.rxMissed && s.maxBacklog == can.rxQueueLength(), what);
+
+    can.stopRxTask();
+    drain(can);
+    can.ping(1);
+    delay(2);
+    RS02PrivFrame f;
+    check(!can.rxTaskRunning() && can.readAny(f) && ((f.id >> 8) & 0xFF) == 1, "after stopRxTask, readAny polling works again");
+    can.removeListener(&lat);
+    uninstall();
+}
+
+int main(int argc, char **argv)
+{
+    int n = argc > 1 ? atoi(argv[1]) : 16;
+    uint32_t workMs = argc > 2 ? (uint32_t)atoi(argv[2]) : 5;
+    if (n < 2)
+        n = 2;
+    if (n > 64)
+        n = 64;
+    ArduinoShim::useVirtualTime(true);
+    Bench b((uint8_t)n);
+
+    struct Mode
+    {
+        const char *name;
+        bool sized;
+        bool task;
+    } modes[] = {
+        {"poll, rxq 5", false, false},
+        {"poll, rxq sized", true, false},
+        {"task, rxq 5", false, true},
+        {"task, rxq sized", true, true},
+    };
+    Result r[4];
+    Serial.printf("%d motors, Type1 -> Type2 every %lu ms, app busy %lu ms per cycle\n", n, (unsigned long)(workMs + 2),
+                  (unsigned long)workMs);
+    Serial.printf("  %-16s %6s %8s %8s %10s %10s %8s\n", "mode", "rxq", "frames", "missed", "mean[us]", "max[us]", "backlog");
+    for (int i = 0; i < 4; i++)
+    {
+        r[i] = run(b, (uint8_t)n, workMs, modes[i].sized, modes[i].task);
+        Serial.printf("  %-16s %6u %3lu/%-4lu %8lu %10.1f %10lu %8u\n", modes[i].name, modes[i].sized ? n * 2 + 8 : 5,
+                      (unsigned long)r[i].frames, (unsigned long)r[i].expected, (unsigned long)r[i].missed, r[i].meanUs,
+                      (unsigned long)r[i].maxUs, r[i].rx.maxBacklog);
+    }
+
+    check(r[0].missed > 0 && r[0].notified == r[0].missed && r[0].frames + r[0].missed == r[0].expected,
+          "polling with the default queue misses replies and reports them via onRxLost");
+    check(r[1].missed == 0 && r[1].frames == r[1].expected, "a queue sized for the motor count holds a whole cycle of replies");
+    check(r[3].missed == 0 && r[3].frames == r[3].expected && r[3].maxUs < 200,
+          "the RX task dispatches every reply within 200us of it hitting the bus");
+    check(r[3].maxUs * 10 < r[1].maxUs, "the RX task cuts worst-case dispatch latency vs polling by >10x");
+
+    taskChecks(b, (uint8_t)n);
+
+    return RS02SimCheck::finish();
+}
@@ -0,0 +1,207 @@
+// native_twaitx — TWAI の送信: 待つ送信（既定 50ms）と待たない送信（setTxTimeoutMs(0)）の比較と、送信完了の追跡
+// 1Mbps 仮想バスに N 台のシミュレータ。全台へ Type1 を一度に出したときの 呼び出し側の所要時間 / 渡せなかった数 /
+// 送信遅れ（渡してから完了まで）を、キュー 5（既定）/ モータ数で決めた長さ、ACK あり / ACK なし（モータ未接続）で表示する。
+// あわせて 単発送信の失敗 / バスオフ回復での破棄 / 受信タスクでの完了回収 を確かめる
+// （待たない送信が 100us 以上止まる / 完了・失敗の数が合わない なら exit 1）
+//   pio run -e native-twaitx && .pio/build/native-twaitx/program [motors]
+#include <Arduino.h>
+#include <RS02SimCheck.h>
+#include <driver/twai.h>
+#include <VirtualCanBus.h>
+#include <RS02SimBus.h>
+#include "RS02PrivateTWAI.h"
+
+#include <stdlib.h>
+
+static constexpr uint8_t HOST_ID = 0xFD;
+
+using RS02SimCheck::check;
+
+struct Bench
+{
+    VirtualCanBus bus{1000000};
+    RS02SimBus sim{&bus};
+
+    explicit Bench(uint8_t n)
+    {
+        for (uint8_t id = 1; id <= n; id++)
+            sim.add(id);
+        ArduinoShim::attachTwai(&bus);
+    }
+    ~Bench() { ArduinoShim::attachTwai(nullptr); }
+};
+
+// ドライバを入れ直す（キュー長を変えるため）
+static void uninstall()
+{
+    twai_stop();
+    twai_driver_uninstall();
+}
+
+static void drain(RS02PrivateTWAI &can)
+{
+    RS02PrivFrame f;
+    while (can.readAny(f))
+    {
+    }
+}
+
+// 読み捨てながら ms 待つ（送信完了もここで回収される）
+static void spin(RS02PrivateTWAI &can, uint32_t ms)
+{
+    uint32_t t0 = millis();
+    while (millis() - t0 < ms)
+    {
+        drain(can);
+        delayMicroseconds(50);
+    }
+    drain(can);
+}
+
+struct Burst
+{
+    uint32_t callUs = 0; // 全台ぶんの opControl を呼び終えるまで
+    uint8_t sent = 0;
+    RS02TwaiTxStats tx;
+};
+
+static Burst burst(Bench &b, uint8_t n, bool sized, bool wait, bool ack)
+{
+    RS02PrivateTWAI can(HOST_ID, 1, 2);
+    if (sized)
+        can.setQueueForMotors(n);
+    can.setTxTimeoutMs(wait ? 50 : 0);
+    can.begin();
+    if (!ack)
+        b.bus.detach(&b.sim);
+
+    Burst r;
+    uint32_t t0 = micros();
+    for (uint8_t id = 1; id <= n; id++)
+        r.sent += can.opControl(id, 0.0f, 0.0f, 0.0f, 5.0f, 0.5f);
+    r.callUs = micros() - t0;
+    spin(can, ack ? 10 : 2);
+    r.tx = can.txStats();
+    if (!ack)
+        b.bus.attach(&b.sim);
+    spin(can, 10);
+    uninstall();
+    return r;
+}
+
+// 単発送信の失敗 / バスオフでの破棄 / 受信タスクでの完了回収
+static void tracking(Bench &b, uint8_t n)
+{
+    RS02PrivateTWAI can(HOST_ID, 1, 2);
+    can.setQueueForMotors(n);
+    can.setTxTimeoutMs(0);
+    can.begin();
+
+    // 単発送信: エラーフレーム 3 回 → 3 フレームは再送せず失敗、残りは完了
+    can.setTxSingleShot(true);
+    b.bus.injectErrors(3);
+    for (uint8_t id = 1; id <= 5; id++)
+        can.ping(id);
+    spin(can, 5);
+    const RS02TwaiTxStats &s = can.txStats();
+    char what[160];
+    snprintf(what, sizeof(what), "single-shot frames hit by error frames are counted as failed (failed=%lu completed=%lu)",
+             (unsigned long)s.failed, (unsigned long)s.completed);
+    check(s.failed == 3 && s.completed == 2 && can.txPending() == 0, what);
+    can.setTxSingleShot(false);
+
+    // バスオフ中に渡した送信待ちは回復操作で消える → dropped
+    can.resetTxStats();
+    b.bus.setFault(true);
+    for (uint8_t id = 1; id <= 4; id++)
+        can.ping(id);
+    spin(can, 5);
+    RS02CanStatus st;
+    bool off = can.canStatus(st) && st.state == RS02CanState::BusOff;
+    uint16_t pendingOff = can.txPending();
+    b.bus.setFault(false);
+    can.recoverBus();
+    delay(3);
+    can.recoverBus();
+    spin(can, 2);
+    snprintf(what, sizeof(what), "frames pending at bus-off are dropped by recovery, not counted as sent (pending=%u dropped=%lu)",
+             pendingOff, (unsigned long)can.txStats().dropped);
+    check(off && pendingOff == 4 && can.txStats().dropped == 4 && can.txStats().completed == 0 && can.txPending() == 0, what);
+
+    // 送信待ちの破棄（sendUrgent）も dropped
+    can.resetTxStats();
+    b.bus.detach(&b.sim); // ACK なし: 送れずに溜まる
+    for (uint8_t id = 1; id <= 4; id++)
+        can.ping(id);
+    delay(1);
+    can.stopUrgent(1, false);
+    uint16_t afterFlush = can.txPending();
+    b.bus.attach(&b.sim);
+    spin(can, 5);
+    snprintf(what, sizeof(what), "stopUrgent drops queued frames from tracking (dropped=%lu completed=%lu)",
+             (unsigned long)can.txStats().dropped, (unsigned long)can.txStats().completed);
+    check(afterFlush == 2 && can.txStats().dropped == 3 && can.txStats().completed == 2, what);
+
+    // 受信タスク: TX_SUCCESS で起きて回収（呼び出し側は送るだけ）
+    can.resetTxStats();
+    can.startRxTask();
+    for (uint8_t id = 1; id <= n; id++)
+        can.opControl(id, 0.0f, 0.0f, 0.0f, 5.0f, 0.5f);
+    delay(10);
+    const RS02TwaiTxStats &t = can.txStats();
+    uint32_t lastFrameUs = (uint32_t)(n * 140); // Type1 は Type2 より ID が小さく連続で出る（1 フレーム約 135us）
+    snprintf(what, sizeof(what), "the RX task collects completions on TX_SUCCESS (completed=%lu max=%luus)",
+             (unsigned long)t.completed, (unsigned long)t.maxLatencyUs);
+    check(t.completed == n && can.txPending() == 0 && t.maxLatencyUs < lastFrameUs + 100, what);
+    can.stopRxTask();
+    drain(can);
+    uninstall();
+}
+
+int main(int argc, char **argv)
+{
+    int n = argc > 1 ? atoi(argv[1]) : 16;
+    if (n < 6)
+        n = 6;
+    if (n > 62)
+        n = 62;
+    ArduinoShim::useVirtualTime(true);
+    Bench b((uint8_t)n);
+
+    struct Mode
+    {
+        const char *name;
+        bool sized;
+        bool wait;
+        bool ack;
+    } modes[] = {
+        {"wait, txq 5", false, true, true},
+        {"no-wait, txq 5", false, false, true},
+        {"no-wait, txq sized", true, false, true},
+        {"wait, no ACK", false, true, false},
+        {"no-wait, no ACK", false, false, false},
+    };
+    Burst r[5];
+    Serial.printf("%d motors, one Type1 to each in a burst, 1Mbps\n", n);
+    Serial.printf("  %-19s %10s %5s %9s %9s %9s %9s\n", "mode", "call[us]", "sent", "rejected", "done", "mean[us]", "max[us]");
+    for (int i = 0; i < 5; i++)
+    {
+        r[i] = burst(b, (uint8_t)n, modes[i].sized, modes[i].wait, modes[i].ack);
+        const RS02TwaiTxStats &t = r[i].tx;
+        Serial.printf("  %-19s %10lu %2u/%-2d %9lu %9lu %9.1f %9lu\n", modes[i].name, (unsigned long)r[i].callUs, r[i].sent, n,
+                      (unsigned long)t.queueFull, (unsigned long)t.completed,
+                      t.completed ? (double)t.totalLatencyUs / t.completed : 0.0, (unsigned long)t.maxLatencyUs);
+    }
+
+    check(r[0].sent == n && r[0].callUs > 1000, "a blocking burst past the 5-slot queue stalls the caller");
+    check(r[1].callUs < 100 && r[1].sent == 6 && r[1].tx.queueFull == (uint32_t)n - 6,
+          "non-blocking submit returns at once and counts what did not fit");
+    check(r[2].callUs < 100 && r[2].sent == n && r[2].tx.completed == (uint32_t)n && r[2].tx.maxPending == n,
+          "a queue sized for the motor count takes the whole burst without blocking");
+    check(r[3].callUs >= 50000 * (uint32_t)(n - 6) && r[4].callUs < 100 && r[4].tx.queueFull == (uint32_t)n - 6,
+          "with no ACK, blocking sends stall 50ms per frame; non-blocking ones do not");
+
+    tracking(b, (uint8_t)n);
+
+    return RS02SimCheck::finish();
+}
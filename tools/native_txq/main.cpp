@@ -0,0 +1,309 @@
+// native_txq — 目標値の送信キュー（RS02PrivateBase::setTxQueue）の回帰確認
+// 1kHz で 2 台に CSP 位置指令を出しながら、ID 0x001 を流し続けるノードでバスを 10ms / 5ms 塞ぐ。
+// キュー無効（そのまま送る）と有効（差し替え + 期限切れ破棄/取り消し）を MCP2515 / TWAI で比べ、
+// モータ側に届いた指令の「古さ」（計算してから届くまで）を表示する
+// 送信完了を待たない区間（RS02AsyncSend）の入れ子と、抜けた後に元の送信に戻るかも見る
+// （キュー有効で期限切れの指令が届く / 最新値が届かない / 停止で捨てない / 非同期区間が戻らない なら exit 1）
+//   pio run -e native-txq && .pio/build/native-txq/program
+#include <Arduino.h>
+#include <RS02SimCheck.h>
+#include <SPI.h>
+#include <mcp_can.h>
+#include <driver/twai.h>
+#include <Mcp2515Emu.h>
+#include <VirtualCanBus.h>
+#include "RS02PrivateCAN.h"
+#include "RS02PrivateTWAI.h"
+
+static constexpr uint8_t MCP_CS_PIN = 6;
+static constexpr uint8_t N_MOTORS = 2;
+static constexpr uint32_t CYCLES = 200;
+static constexpr uint32_t PERIOD_US = 1000;
+static constexpr uint32_t DEADLINE_US = 2000;
+static constexpr uint32_t SLACK_US = 300; // 期限 + 1 フレーム分までは「間に合った」
+
+using RS02SimCheck::check;
+
+// 最優先 ID を left フレーム分送り続けてバスを塞ぐ（ホスト側の遅れに関係なく同じ時間）
+class Babbler : public VirtualCanNode
+{
+public:
+    uint32_t left = 0;
+    bool txPeek(ShimCanFrame &f) override
+    {
+        if (!left)
+            return false;
+        f = frame();
+        return true;
+    }
+    void txDone(bool ok) override
+    {
+        (void)ok;
+        if (left)
+            left--;
+    }
+    void rx(const ShimCanFrame &f, uint64_t tNs) override
+    {
+        (void)f;
+        (void)tNs;
+    }
+    static ShimCanFrame frame()
+    {
+        ShimCanFrame f;
+        f.id = 0x001;
+        f.dlc = 8;
+        return f;
+    }
+};
+
+// モータ側: LOC_REF 書き込み（Type18）の値と到着時刻
+class Sniffer : public VirtualCanNode
+{
+public:
+    static constexpr int MAX = 1024;
+    struct Rec
+    {
+        uint8_t motor;
+        float value;
+        uint32_t tUs;
+    };
+    Rec rec[MAX];
+    int n = 0;
+
+    bool txPeek(ShimCanFrame &f) override
+    {
+        (void)f;
+        return false;
+    }
+    void txDone(bool ok) override { (void)ok; }
+    void rx(const ShimCanFrame &f, uint64_t tNs) override
+    {
+        if (!f.ext || rs02FrameType(f.id) != RS02Type::WRITE_PARAM || f.dlc < 8 || n >= MAX)
+            return;
+        if ((uint16_t)(f.data[0] | (f.data[1] << 8)) != RS02Idx::LOC_REF)
+            return;
+        Rec &r = rec[n++];
+        r.motor = rs02FrameDst(f.id);
+        memcpy(&r.value, &f.data[4], 4);
+        r.tUs = (uint32_t)(tNs / 1000);
+    }
+};
+
+struct Bench
+{
+    VirtualCanBus bus{1000000};
+    Mcp2515Emu emu{&bus};
+    Babbler babbler;
+    Sniffer sniffer;
+    MCP_CAN mcp{MCP_CS_PIN};
+    RS02PrivateCAN mcpHost{mcp, 0xFD};
+    RS02PrivateTWAI twaiHost{0xFD, 1, 2};
+
+    Bench()
+    {
+        SPI.attach(MCP_CS_PIN, &emu);
+        SPI.begin();
+        ArduinoShim::attachTwai(&bus);
+        bus.attach(&babbler);
+        bus.attach(&sniffer);
+        mcp.setFastIO(1);
+        mcp.begin(MCP_ANY, CAN_1000KBPS, MCP_8MHZ);
+        mcp.setMode(MCP_NORMAL);
+        mcpHost.begin();
+        twaiHost.begin();
+    }
+    ~Bench()
+    {
+        bus.detach(&babbler);
+        bus.detach(&sniffer);
+        ArduinoShim::attachTwai(nullptr);
+    }
+    // us だけバスを塞ぐ（0 = 解除）
+    void jam(uint32_t us)
+    {
+        uint64_t frameNs = (VirtualCanBus::frameBits(Babbler::frame()) + 3) * bus.bitNs();
+        babbler.left = (uint32_t)((uint64_t)us * 1000 / frameNs);
+        bus.kick();
+    }
+};
+
+struct RunResult
+{
+    uint32_t delivered = 0;
+    uint32_t lateArrivals = 0; // 計算から DEADLINE+SLACK を過ぎて届いた
+    uint32_t maxAgeUs = 0;
+    bool lastValueOk = false;
+    RS02TxQueueStats q;
+};
+
+// 受信を捨てつつ送信キューを回す
+static void spinUntil(RS02PrivateBase &can, uint32_t tUs)
+{
+    RS02PrivFrame f;
+    while ((int32_t)(micros() - tUs) < 0)
+    {
+        while (can.readAny(f))
+            ;
+        delayMicroseconds(20);
+    }
+}
+
+static RunResult runControl(Bench &b, RS02PrivateBase &can, bool queue)
+{
+    RS02TxQueueConfig cfg;
+    cfg.enabled = queue;
+    cfg.deadlineUs = DEADLINE_US;
+    can.setTxQueue(cfg);
+    can.resetTxQueueStats();
+    b.sniffer.n = 0;
+
+    static uint32_t tCompute[CYCLES];
+    uint32_t t0 = micros();
+    for (uint32_t k = 0; k < CYCLES; k++)
+    {
+        spinUntil(can, t0 + k * PERIOD_US);
+        // 10ms 塞ぐ / 5ms 塞ぎ、その間は新しい指令を出さない（期限切れ）
+        if (k == 50)
+            b.jam(10000);
+        if (k == 120)
+            b.jam(5000);
+        tCompute[k] = micros();
+        if (k > 120 && k < 125)
+            continue;
+        for (uint8_t m = 1; m <= N_MOTORS; m++)
+            can.cspLocRef(m, (float)k);
+    }
+    spinUntil(can, micros() + 10000);
+
+    RunResult r;
+    float last[N_MOTORS + 1] = {};
+    for (int i = 0; i < b.sniffer.n; i++)
+    {
+        const Sniffer::Rec &x = b.sniffer.rec[i];
+        uint32_t k = (uint32_t)x.value;
+        if (x.motor < 1 || x.motor > N_MOTORS || k >= CYCLES)
+            continue;
+        uint32_t age = x.tUs - tCompute[k];
+        r.delivered++;
+        if (age > DEADLINE_US + SLACK_US)
+            r.lateArrivals++;
+        if (age > r.maxAgeUs)
+            r.maxAgeUs = age;
+        last[x.motor] = x.value;
+    }
+    r.lastValueOk = true;
+    for (uint8_t m = 1; m <= N_MOTORS; m++)
+        r.lastValueOk &= last[m] == (float)(CYCLES - 1);
+    r.q = can.txQueueStats();
+
+    cfg.enabled = false;
+    can.setTxQueue(cfg);
+    return r;
+}
+
+static void printRow(const char *label, const RunResult &r)
+{
+    Serial.printf("  %-12s delivered=%4lu late=%3lu maxAge=%6.2f ms | queued=%4lu sent=%4lu superseded=%3lu expired=%2lu "
+                  "aborted=%2lu late=%2lu dropped=%2lu depth=%u\n",
+                  label, (unsigned long)r.delivered, (unsigned long)r.lateArrivals, r.maxAgeUs / 1000.0,
+                  (unsigned long)r.q.queued, (unsigned long)r.q.sent, (unsigned long)r.q.superseded,
+                  (unsigned long)r.q.expired, (unsigned long)r.q.aborted, (unsigned long)r.q.late,
+                  (unsigned long)r.q.dropped, r.q.maxDepth);
+}
+
+// 停止 / 緊急停止でそのモータ宛ての未送信指令を捨てる
+static bool stopDrops(Bench &b, RS02PrivateBase &can)
+{
+    RS02TxQueueConfig cfg;
+    cfg.enabled = true;
+    cfg.deadlineUs = 50000;
+    can.setTxQueue(cfg);
+    can.resetTxQueueStats();
+    b.jam(50000);
+    can.cspLocRef(1, 1.0f); // 送信中（塞がれて出ない）
+    can.cspLocRef(2, 2.0f); // キュー
+    can.cspLocRef(2, 3.0f); // 差し替え
+    bool ok = can.txQueued() == 1 && can.txQueueStats().superseded == 1;
+    b.jam(0);
+    can.stop(2, false);
+    ok &= can.txQueued() == 0 && can.txQueueStats().dropped == 1;
+
+    b.jam(50000);
+    can.cspLocRef(1, 4.0f);
+    can.cspLocRef(2, 5.0f);
+    b.jam(0);
+    can.stopUrgent(1, false);
+    ok &= can.txQueued() == 0;
+    spinUntil(can, micros() + 5000);
+
+    cfg.enabled = false;
+    can.setTxQueue(cfg);
+    return ok;
+}
+
+// RS02AsyncSend: 入れ子の内側を抜けても非同期のまま / 抜けたら送信完了を待つ送信に戻る（送信キューは無効のまま）
+static bool asyncScope(Bench &b, RS02PrivateBase &can, bool blocksWhenSync)
+{
+    bool ok = true;
+    b.jam(5000);
+    {
+        RS02AsyncSend outer(can);
+        {
+            RS02AsyncSend inner(can);
+        }
+        uint32_t t0 = micros();
+        ok &= can.ping(1);
+        ok &= micros() - t0 < 500;      // 塞がれていても待たずに戻る
+        ok &= !can.waitTxIdle(1000);    // まだ出ていない
+        ok &= can.waitTxIdle(10000);
+    }
+    ok &= !can.txQueueConfig().enabled;
+    b.jam(3000);
+    uint32_t t0 = micros();
+    can.ping(1);
+    uint32_t dt = micros() - t0;
+    Serial.printf("  ping while jammed: %lu us after the scope\n", (unsigned long)dt);
+    ok &= !blocksWhenSync || dt > 2000; // 同期に戻った（MCP2515 は送信完了まで待つ）
+    spinUntil(can, micros() + 5000);
+    return ok;
+}
+
+int main()
+{
+    ArduinoShim::useVirtualTime(true);
+    Bench b;
+
+    struct Backend
+    {
+        const char *name;
+        RS02PrivateBase *can;
+        bool canAbort;
+        bool syncWaits; // 既定の送信は完了まで待つ（TWAI は送信キューに入れば戻る）
+    } backends[] = {{"MCP2515", &b.mcpHost, true, true}, {"TWAI", &b.twaiHost, false, false}};
+
+    Serial.printf("1kHz x %u motors, bus jammed 10ms + 5ms, deadline %lu us\n", N_MOTORS, (unsigned long)DEADLINE_US);
+    for (const Backend &be : backends)
+    {
+        Serial.printf("%s\n", be.name);
+        RunResult off = runControl(b, *be.can, false);
+        printRow("direct", off);
+        RunResult on = runControl(b, *be.can, true);
+        printRow("queue", on);
+
+        char what[96];
+        snprintf(what, sizeof(what), "%s: direct sending delivers stale setpoints after the jam", be.name);
+        check(off.lateArrivals > 0, what);
+        snprintf(what, sizeof(what), "%s: queue delivers no stale setpoint it could withdraw", be.name);
+        check(on.lateArrivals == on.q.late && (!be.canAbort || on.q.late == 0) && on.q.late <= 2, what);
+        snprintf(what, sizeof(what), "%s: newer setpoints supersede, expired ones are dropped or withdrawn", be.name);
+        check(on.q.superseded > 0 && on.q.expired + on.q.aborted > 0 && (!be.canAbort || on.q.aborted > 0), what);
+        snprintf(what, sizeof(what), "%s: latest setpoint reaches every motor", be.name);
+        check(on.lastValueOk && off.lastValueOk, what);
+        snprintf(what, sizeof(what), "%s: stop / stopUrgent drop queued setpoints", be.name);
+        check(stopDrops(b, *be.can), what);
+        snprintf(what, sizeof(what), "%s: RS02AsyncSend nests and restores blocking sends", be.name);
+        check(asyncScope(b, *be.can, be.syncWaits), what);
+    }
+
+    return RS02SimCheck::finish();
+}
@@ -0,0 +1,136 @@
+// native_ui — モニタ画面の差分描画（RS02UiCells）: 全面 pushSprite と、変わった行だけ送る方式の比較
+// allFunction のモニタと同じ 6 行（Mode/Vel, Angle∞, Refs, Limit, Bus, Share）に、回転中のモータを模した値を
+// 200ms ごとに入れ、1 フレームで送るピクセル数と転送時間（SPI 40MHz, 16bit/px の見積もり）を表示する。
+// パネルは数えるだけの代役（M5GFX の SDL パネルはこの native 環境に無い）
+// （差分描画の転送が全面の 1/3 を超える / 変化の無いフレームで何か送る / invalidate 後に全行を描かない なら exit 1）
+//   pio run -e native-ui && .pio/build/native-ui/program [ticks]
+#include <Arduino.h>
+#include <RS02SimCheck.h>
+#include <math.h>
+#include <stdlib.h>
+#include "RS02UiCells.h"
+
+static constexpr int W = 320, H = 240;
+static constexpr uint32_t SPI_HZ = 40000000;
+
+using RS02SimCheck::check;
+
+// 送ったピクセルを数え、SPI の転送時間だけ待つ
+struct Panel
+{
+    uint64_t pixels = 0;
+    uint32_t pushes = 0;
+    void push(int16_t w, int16_t h)
+    {
+        uint32_t px = (uint32_t)w * (uint32_t)h;
+        pixels += px;
+        pushes++;
+        delayMicroseconds((uint32_t)((uint64_t)px * 16 * 1000000ULL / SPI_HZ));
+    }
+};
+
+// モータの見かけの値（Velocity 2rad/s 前後でゆれる, 制限値とゲインは固定）
+struct Motor
+{
+    float pos = 0.0f;
+    float vel = 0.0f;
+    double acc = 0.0;
+    void step(uint32_t k)
+    {
+        vel = 2.0f + 0.05f * sinf(0.3f * (float)k);
+        acc += vel * 0.2;
+        pos = (float)fmod(acc, 2.0 * M_PI);
+    }
+};
+
+static void fill(RS02UiCells &ui, const int *row, const Motor &m, uint32_t k)
+{
+    ui.printf(row[1], "Mode=%u(%s)  Vel=%.3f%s rad/s", 2, "Velocity", m.vel, "");
+    ui.printf(row[2], "Angle∞: pos=%.3f%s  ->  turns=%.1f  rad=%.3f  deg=%.1f", m.pos, "", m.acc / (2.0 * M_PI), m.acc,
+              m.acc * (180.0 / M_PI));
+    ui.printf(row[3], "Refs : loc=%.3f  spd=%.3f  iq=%.3f", 0.0f, 2.0f, 0.0f);
+    ui.printf(row[4], "Limit: I=%.1f IO=%.1f T=%.1f S=%.1f  acc=%.1f", 5.0f, 5.0f, 3.0f, 6.0f, 20.0f);
+    ui.printf(row[5], "Bus  : %.1f%% (10ms peak %.1f%%, max %.1f%%)  %.0f f/s  lost %lu", 1.2f + 0.1f * (float)(k % 3),
+              4.0f, 6.5f, 70.0f, 0UL);
+    ui.printf(row[6], "Share: T1 %.0f%%  T2 %.0f%%  T17 %.0f%%  T18 %.0f%%", 0.0f, 0.0f, 100.0f, 0.0f);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t ticks = argc > 1 ? (uint32_t)atoi(argv[1]) : 100;
+    if (ticks < 10)
+        ticks = 10;
+    ArduinoShim::useVirtualTime(true);
+
+    RS02UiCells ui;
+    int row[7] = {};
+    for (int r = 1; r <= 6; r++)
+        row[r] = ui.add(6, 46 + r * 18 - 2, W - 12, 18);
+    auto draw = [](Panel &p)
+    {
+        return [&p](uint8_t, const RS02UiRect &r, const char *, uint16_t) { p.push(r.w, r.h); };
+    };
+
+    // 全面: 毎フレーム 320x240 を送る（これまでの pushSprite(0, 0)）
+    Panel full;
+    uint32_t fullUs = 0;
+    Motor m;
+    for (uint32_t k = 0; k < ticks; k++)
+    {
+        m.step(k);
+        uint32_t t0 = micros();
+        full.push(W, H);
+        fullUs += micros() - t0;
+    }
+
+    // 差分: 変わった行だけ
+    Panel part;
+    m = Motor();
+    for (uint32_t k = 0; k < ticks; k++)
+    {
+        m.step(k);
+        fill(ui, row, m, k);
+        ui.render(draw(part));
+    }
+    const RS02UiStats &s = ui.stats();
+    double fullPx = (double)full.pixels / ticks, partPx = (double)s.pixelsPushed / s.frames;
+    Serial.printf("%lu frames (200ms monitor ticks), 6 text rows, SPI %lu MHz 16bpp\n", (unsigned long)ticks,
+                  (unsigned long)(SPI_HZ / 1000000));
+    Serial.printf("  %-14s %10s %8s %12s\n", "mode", "px/frame", "%full", "us/frame");
+    Serial.printf("  %-14s %10.0f %7.1f%% %12.0f\n", "full push", fullPx, 100.0, (double)fullUs / ticks);
+    Serial.printf("  %-14s %10.0f %7.1f%% %12.0f  (max %lu us, %lu cells drawn / %lu unchanged)\n", "dirty rows", partPx,
+                  100.0 * partPx / fullPx, (double)s.totalFrameUs / s.frames, (unsigned long)s.maxFrameUs,
+                  (unsigned long)s.cellsDrawn, (unsigned long)s.cellsSkipped);
+    ui.dump(Serial, (uint32_t)W * H);
+
+    check(s.pixelsPushed == part.pixels, "pixelsPushed matches what reached the panel");
+    check(partPx * 3 < fullPx, "dirty-row rendering pushes under a third of the full-frame pixels");
+    check(s.totalFrameUs * 3 < (uint64_t)fullUs, "dirty-row rendering takes under a third of the full-frame time");
+    check(s.cellsSkipped >= (ticks - 1) * 3, "static rows (Refs, Limit, Share) are not redrawn");
+
+    // 変化なし → 何も送らない
+    Panel idle;
+    fill(ui, row, m, ticks - 1);
+    uint8_t n = ui.render(draw(idle));
+    check(n == 0 && idle.pixels == 0 && ui.stats().lastPixels == 0, "a frame with no changes pushes nothing");
+
+    // 色だけの変更も描き直す
+    ui.setColor(row[4], 0xF800);
+    n = ui.render(draw(idle));
+    check(n == 1 && idle.pixels == (uint64_t)(W - 12) * 18, "a color change redraws just that row");
+
+    // 全面を送ったあと（他の画面から戻った）は全行
+    ui.invalidate();
+    n = ui.render(draw(idle));
+    check(n == 6 && ui.dirtyCount() == 0, "invalidate() redraws every row once");
+
+    // 長すぎる文字列は切り詰める（比較も切り詰めた内容で）
+    char longText[RS02_UI_TEXT * 2];
+    memset(longText, 'x', sizeof(longText) - 1);
+    longText[sizeof(longText) - 1] = 0;
+    bool first = ui.set(row[1], longText);
+    bool again = ui.set(row[1], longText);
+    check(first && !again && strlen(ui.text(row[1])) == RS02_UI_TEXT - 1, "over-long text is truncated and compared as truncated");
+
+    return RS02SimCheck::finish();
+}